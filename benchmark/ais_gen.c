@@ -0,0 +1,840 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Longest line written: tag block, sentence and newline */
+#define GEN_LINE_MAX 160
+
+/* Payload characters per sentence before a message is split */
+#define GEN_FRAGMENT_CHARS 60
+
+/* Bits of the longest message generated (type 6/8 with binary data) */
+#define GEN_MAX_BITS 1008
+
+/* Lines held back for duplicates and interleaved fragments */
+#define GEN_DELAY_SLOTS 64
+
+/* Furthest a held-back line is moved down the output */
+#define GEN_MAX_DELAY 8
+
+/* Message types the generator can produce */
+#define GEN_TYPES 28
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+/**
+ * @brief Generator settings, filled from the command line
+ */
+typedef struct {
+    uint64_t messages;        /* messages to generate, before duplication */
+    int vessels;
+    int receivers;
+    double duplicate_rate;    /* chance a message is also heard by a second receiver */
+    double interleave_rate;   /* chance a multipart message is interleaved with other lines */
+    double corrupt_rate;      /* chance a line is damaged */
+    double rate;              /* messages per second of simulated time */
+    int64_t start_time;       /* Unix time of the first message */
+    uint64_t seed;
+    bool tag_blocks;
+    unsigned weight[GEN_TYPES];
+    const char *output;
+} GenOptions;
+
+
+/**
+ * @brief One simulated vessel
+ */
+typedef struct {
+    uint32_t mmsi;
+    uint32_t imo;
+    bool class_b;
+    double lat;               /* degrees */
+    double lon;
+    double speed;             /* knots */
+    double course;            /* degrees */
+    double last_time;         /* seconds, when the position was last advanced */
+    int status;
+    int ship_type;
+    int to_bow, to_stern, to_port, to_starboard;
+    char name[21];
+    char callsign[8];
+    char destination[21];
+} GenVessel;
+
+
+/**
+ * @brief Bit buffer a message is packed into before armoring
+ */
+typedef struct {
+    uint8_t bit[GEN_MAX_BITS];
+    int len;
+} GenBits;
+
+
+/**
+ * @brief A line held back to be written a few lines later
+ */
+typedef struct {
+    bool in_use;
+    uint64_t due;             /* output line number to write it at */
+    char line[GEN_LINE_MAX];
+} GenDelayed;
+
+
+/**
+ * @brief Generator state and counters
+ */
+typedef struct {
+    GenOptions opt;
+    uint64_t rng;
+    GenVessel *fleet;
+    int *class_a, *class_b;   /* fleet indices of each class */
+    int n_class_a, n_class_b;
+    unsigned weight_total;
+    double now;
+    int *next_message_id;     /* per receiver, sequential id of multipart messages 0-9 */
+    FILE *out;
+    uint64_t lines;
+    uint64_t duplicates;
+    uint64_t corrupted;
+    uint64_t by_type[GEN_TYPES];
+    GenDelayed delayed[GEN_DELAY_SLOTS];
+} GenState;
+
+
+static const uint32_t mids[] = {
+    211, 219, 227, 230, 235, 244, 257, 265, 273, 303, 309, 316, 338, 351, 366, 370,
+    412, 413, 431, 440, 477, 503, 525, 538, 563, 566, 636
+};
+
+static const char *const name_words[] = {
+    "NORTH", "SOUTH", "SEA", "STAR", "OCEAN", "BLUE", "MAERSK", "NORDIC", "PACIFIC", "ATLANTIC",
+    "EVER", "GRACE", "SPIRIT", "PIONEER", "EXPRESS", "TRADER", "WIND", "ARCTIC", "CORAL", "HARMONY"
+};
+
+static const char *const destinations[] = {
+    "ROTTERDAM", "HAMBURG", "SINGAPORE", "SHANGHAI", "LOS ANGELES", "ANTWERP", "NEW YORK",
+    "BUSAN", "SANTOS", "FELIXSTOWE", "PIRAEUS", "DUBAI", "HOUSTON", "VALENCIA", "GOTHENBURG"
+};
+
+/* Default type mix, weights per 1000 messages */
+static const struct {
+    int type;
+    unsigned weight;
+} default_mix[] = {
+    {1, 560}, {2, 20}, {3, 120}, {18, 170}, {5, 50}, {24, 40}, {6, 10}, {8, 30}
+};
+
+
+/**
+ * @brief Next value of the splitmix64 generator
+ */
+static uint64_t rng_next(GenState *g) {
+    uint64_t z = (g->rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+/**
+ * @brief Uniform double in [0, 1)
+ */
+static double rng_uniform(GenState *g) {
+    return (rng_next(g) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+/**
+ * @brief Uniform integer in [0, n)
+ */
+static uint32_t rng_below(GenState *g, uint32_t n) {
+    return (uint32_t)(((rng_next(g) >> 32) * n) >> 32);
+}
+
+
+/**
+ * @brief True with the given probability
+ */
+static bool rng_chance(GenState *g, double p) {
+    return p > 0 && rng_uniform(g) < p;
+}
+
+
+/**
+ * @brief Append an unsigned field, most significant bit first
+ */
+static void put_uint(GenBits *b, int width, uint64_t value) {
+    for (int i = width - 1; i >= 0; i--) b->bit[b->len++] = (value >> i) & 1;
+}
+
+
+/**
+ * @brief Append a two's complement signed field
+ */
+static void put_int(GenBits *b, int width, int64_t value) {
+    put_uint(b, width, (uint64_t)value & ((1ULL << width) - 1));
+}
+
+
+/**
+ * @brief Append a string as 6-bit characters, padded with '@'
+ */
+static void put_string(GenBits *b, int chars, const char *s) {
+    size_t len = strlen(s);
+    for (int i = 0; i < chars; i++) {
+        int c = i < (int)len ? (unsigned char)s[i] : '@';
+        if (c >= 'a' && c <= 'z') c -= 32;
+        if (c < 32 || c > 95) c = ' ';
+        put_uint(b, 6, c >= 64 ? c - 64 : c);
+    }
+}
+
+
+/**
+ * @brief Armor a bit buffer into 6-bit payload characters
+ *
+ * @param b Bits to armor
+ * @param payload Output, NUL-terminated
+ * @return Fill bits added to the last character
+ */
+static int armor(const GenBits *b, char *payload) {
+    int fill = (6 - b->len % 6) % 6;
+    int chars = (b->len + fill) / 6;
+
+    for (int i = 0; i < chars; i++) {
+        int v = 0;
+        for (int j = 0; j < 6; j++) {
+            int pos = i * 6 + j;
+            v = (v << 1) | (pos < b->len ? b->bit[pos] : 0);
+        }
+        payload[i] = (char)(v < 40 ? v + 48 : v + 56);
+    }
+    payload[chars] = '\0';
+    return fill;
+}
+
+
+/**
+ * @brief XOR checksum of the bytes in [start, end)
+ */
+static unsigned checksum(const char *start, const char *end) {
+    unsigned sum = 0;
+    while (start < end) sum ^= (unsigned char)*start++;
+    return sum;
+}
+
+
+/**
+ * @brief Format one line: optional tag block and a checksummed sentence
+ *
+ * @return Length of the line, without a newline
+ */
+static int format_line(GenState *g, char *line, int receiver, int total, int seq, int message_id,
+                       char channel, const char *payload, int fill) {
+    int n = 0;
+
+    if (g->opt.tag_blocks) {
+        char tag[48];
+        int tlen = snprintf(tag, sizeof(tag), "s:rx%d,c:%lld", receiver, (long long)floor(g->now));
+        n = snprintf(line, GEN_LINE_MAX, "\\%s*%02X\\", tag, checksum(tag, tag + tlen));
+    }
+
+    char id[4] = "";
+    if (total > 1) snprintf(id, sizeof(id), "%d", message_id);
+
+    char *sentence = line + n;
+    int slen = snprintf(sentence, GEN_LINE_MAX - n, "!AIVDM,%d,%d,%s,%c,%s,%d", total, seq, id, channel, payload, fill);
+    slen += snprintf(sentence + slen, GEN_LINE_MAX - n - slen, "*%02X", checksum(sentence + 1, sentence + slen));
+    return n + slen;
+}
+
+
+/**
+ * @brief Damage a line the way a noisy receiver or a cut log would
+ *
+ * Modes: a flipped payload character (bad checksum), a line cut short, or a
+ * payload shortened with a valid checksum so it fails to decode.
+ */
+static void corrupt_line(GenState *g, char *line) {
+    char *sentence = strchr(line, '!');
+    char *star = sentence ? strrchr(sentence, '*') : NULL;
+    if (!star) return;
+
+    /* Payload is the sixth field */
+    char *payload = sentence;
+    for (int i = 0; i < 5 && payload; i++) payload = strchr(payload + 1, ',');
+    if (!payload) return;
+    payload++;
+    char *payload_end = strchr(payload, ',');
+    if (!payload_end || payload_end - payload < 4) return;
+
+    g->corrupted++;
+    switch (rng_below(g, 3)) {
+        case 0:
+            payload[rng_below(g, (uint32_t)(payload_end - payload))] ^= 0x01;
+            break;
+        case 1:
+            line[(sentence - line) + rng_below(g, (uint32_t)(star - sentence))] = '\0';
+            break;
+        default: {
+            int keep = (int)((payload_end - payload) / 3);
+            memmove(payload + keep, payload_end, strlen(payload_end) + 1);
+            star = strrchr(sentence, '*');
+            snprintf(star, 4, "*%02X", checksum(sentence + 1, star));
+            break;
+        }
+    }
+}
+
+
+/**
+ * @brief Write one line now
+ */
+static void emit(GenState *g, const char *line) {
+    fputs(line, g->out);
+    fputc('\n', g->out);
+    g->lines++;
+}
+
+
+/**
+ * @brief Write the held-back lines that are due, or all of them
+ */
+static void flush_delayed(GenState *g, bool all) {
+    bool wrote = true;
+
+    while (wrote) {
+        wrote = false;
+        for (int i = 0; i < GEN_DELAY_SLOTS; i++) {
+            GenDelayed *d = &g->delayed[i];
+            if (d->in_use && (all || d->due <= g->lines)) {
+                emit(g, d->line);
+                d->in_use = false;
+                wrote = true;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Write a line now or hold it back for a number of lines
+ */
+static void schedule(GenState *g, const char *line, int delay) {
+    if (delay > 0) {
+        for (int i = 0; i < GEN_DELAY_SLOTS; i++) {
+            GenDelayed *d = &g->delayed[i];
+            if (!d->in_use) {
+                d->in_use = true;
+                d->due = g->lines + (uint64_t)delay;
+                memcpy(d->line, line, GEN_LINE_MAX);
+                return;
+            }
+        }
+    }
+    emit(g, line);
+    flush_delayed(g, false);
+}
+
+
+/**
+ * @brief Write a packed message as one or more sentences
+ *
+ * Multipart messages may have their later fragments interleaved with other
+ * traffic; a duplicate from a second receiver follows a few lines later.
+ */
+static void send_message(GenState *g, const GenBits *bits) {
+    char payload[GEN_MAX_BITS / 6 + 2];
+    int fill = armor(bits, payload);
+    int len = (int)strlen(payload);
+    int total = (len + GEN_FRAGMENT_CHARS - 1) / GEN_FRAGMENT_CHARS;
+    char channel = rng_below(g, 2) ? 'B' : 'A';
+    int copies = 1 + (g->opt.receivers > 1 && rng_chance(g, g->opt.duplicate_rate));
+    int receiver = (int)rng_below(g, (uint32_t)g->opt.receivers);
+    bool interleave = total > 1 && rng_chance(g, g->opt.interleave_rate);
+
+    for (int copy = 0; copy < copies; copy++) {
+        int base_delay = copy == 0 ? 0 : 1 + (int)rng_below(g, GEN_MAX_DELAY / 2);
+        if (copy > 0) {
+            receiver = (receiver + 1 + (int)rng_below(g, (uint32_t)g->opt.receivers - 1)) % g->opt.receivers;
+            g->duplicates++;
+        }
+
+        /* Each receiver numbers the multipart messages it hears on its own */
+        int message_id = g->next_message_id[receiver];
+        if (total > 1) g->next_message_id[receiver] = (message_id + 1) % 10;
+
+        for (int seq = 1; seq <= total; seq++) {
+            char part[GEN_FRAGMENT_CHARS + 1];
+            char line[GEN_LINE_MAX];
+            int offset = (seq - 1) * GEN_FRAGMENT_CHARS;
+            int plen = len - offset < GEN_FRAGMENT_CHARS ? len - offset : GEN_FRAGMENT_CHARS;
+
+            memcpy(part, payload + offset, plen);
+            part[plen] = '\0';
+            format_line(g, line, receiver, total, seq, message_id, channel, part, seq == total ? fill : 0);
+            if (rng_chance(g, g->opt.corrupt_rate)) corrupt_line(g, line);
+
+            int delay = base_delay;
+            if (interleave && seq > 1) delay += seq - 1 + (int)rng_below(g, GEN_MAX_DELAY / 2);
+            schedule(g, line, delay);
+        }
+    }
+}
+
+
+/**
+ * @brief Advance a vessel along its course to the current time
+ *
+ * Dead reckoning on a sphere with small random course and speed changes.
+ */
+static void advance(GenState *g, GenVessel *v) {
+    double dt = g->now - v->last_time;
+    v->last_time = g->now;
+    if (v->speed <= 0 || dt <= 0) return;
+
+    double distance = v->speed * dt / 3600.0 / 60.0;  /* degrees of arc */
+    double rad = v->course * M_PI / 180.0;
+    v->lat += distance * cos(rad);
+    v->lon += distance * sin(rad) / fmax(cos(v->lat * M_PI / 180.0), 0.05);
+
+    if (v->lat > 80) v->lat = 80, v->course = fmod(180 - v->course + 360, 360);
+    if (v->lat < -80) v->lat = -80, v->course = fmod(180 - v->course + 360, 360);
+    if (v->lon > 180) v->lon -= 360;
+    if (v->lon < -180) v->lon += 360;
+
+    v->course = fmod(v->course + (rng_uniform(g) - 0.5) * 4 + 360, 360);
+    v->speed = fmin(fmax(v->speed + (rng_uniform(g) - 0.5) * 0.4, 0.5), 30);
+}
+
+
+/**
+ * @brief Longitude and latitude fields in 1/10000 minute
+ */
+static void put_position(GenBits *b, const GenVessel *v) {
+    put_int(b, 28, (int64_t)lround(v->lon * 600000.0));
+    put_int(b, 27, (int64_t)lround(v->lat * 600000.0));
+}
+
+
+/**
+ * @brief Type 1, 2 or 3 Class A position report
+ */
+static void pack_position_a(GenState *g, GenBits *b, const GenVessel *v, int type) {
+    int speed = (int)lround(v->speed * 10);
+    int course = (int)lround(v->course * 10) % 3600;
+
+    put_uint(b, 6, type);
+    put_uint(b, 2, 0);
+    put_uint(b, 30, v->mmsi);
+    put_uint(b, 4, v->status);
+    put_int(b, 8, v->speed > 0 ? (int)rng_below(g, 21) - 10 : 0);
+    put_uint(b, 10, speed);
+    put_uint(b, 1, rng_below(g, 2));
+    put_position(b, v);
+    put_uint(b, 12, course);
+    put_uint(b, 9, course / 10);
+    put_uint(b, 6, (uint64_t)g->now % 60);
+    put_uint(b, 2, 0);
+    put_uint(b, 3, 0);
+    put_uint(b, 1, 0);
+    put_uint(b, 19, rng_next(g) & 0x7FFFF);
+}
+
+
+/**
+ * @brief Type 18 Class B position report
+ */
+static void pack_position_b(GenState *g, GenBits *b, const GenVessel *v) {
+    int course = (int)lround(v->course * 10) % 3600;
+
+    put_uint(b, 6, 18);
+    put_uint(b, 2, 0);
+    put_uint(b, 30, v->mmsi);
+    put_uint(b, 8, 0);
+    put_uint(b, 10, (uint64_t)lround(v->speed * 10));
+    put_uint(b, 1, 0);
+    put_position(b, v);
+    put_uint(b, 12, course);
+    put_uint(b, 9, 511);
+    put_uint(b, 6, (uint64_t)g->now % 60);
+    put_uint(b, 2, 0);
+    put_uint(b, 1, 1);        /* carrier sense unit */
+    put_uint(b, 1, 0);
+    put_uint(b, 1, 1);
+    put_uint(b, 1, 1);
+    put_uint(b, 1, 1);
+    put_uint(b, 1, 0);
+    put_uint(b, 1, 0);
+    put_uint(b, 20, rng_next(g) & 0xFFFFF);
+}
+
+
+/**
+ * @brief Four reference-point distances of a static report
+ */
+static void put_dimensions(GenBits *b, const GenVessel *v) {
+    put_uint(b, 9, v->to_bow);
+    put_uint(b, 9, v->to_stern);
+    put_uint(b, 6, v->to_port);
+    put_uint(b, 6, v->to_starboard);
+}
+
+
+/**
+ * @brief Type 5 static and voyage data; 424 bits, always two sentences
+ */
+static void pack_static(GenState *g, GenBits *b, const GenVessel *v) {
+    put_uint(b, 6, 5);
+    put_uint(b, 2, 0);
+    put_uint(b, 30, v->mmsi);
+    put_uint(b, 2, 0);
+    put_uint(b, 30, v->imo);
+    put_string(b, 7, v->callsign);
+    put_string(b, 20, v->name);
+    put_uint(b, 8, v->ship_type);
+    put_dimensions(b, v);
+    put_uint(b, 4, 1);
+    put_uint(b, 4, 1 + rng_below(g, 12));
+    put_uint(b, 5, 1 + rng_below(g, 28));
+    put_uint(b, 5, rng_below(g, 24));
+    put_uint(b, 6, rng_below(g, 60));
+    put_uint(b, 8, 40 + rng_below(g, 120));
+    put_string(b, 20, v->destination);
+    put_uint(b, 1, 0);
+    put_uint(b, 1, 0);
+}
+
+
+/**
+ * @brief Type 24 static data report, part A (name) or B (type, callsign, size)
+ */
+static void pack_static_b(GenBits *b, const GenVessel *v, int part) {
+    put_uint(b, 6, 24);
+    put_uint(b, 2, 0);
+    put_uint(b, 30, v->mmsi);
+    put_uint(b, 2, part);
+    if (part == 0) {
+        put_string(b, 20, v->name);
+        put_uint(b, 8, 0);
+        return;
+    }
+    put_uint(b, 8, v->ship_type);
+    put_string(b, 3, "GEN");
+    put_uint(b, 4, 1);
+    put_uint(b, 20, v->mmsi & 0xFFFFF);
+    put_string(b, 7, v->callsign);
+    put_dimensions(b, v);
+    put_uint(b, 6, 0);
+}
+
+
+/**
+ * @brief Type 6 addressed or type 8 broadcast binary message
+ *
+ * The data length is a whole number of bytes that also fills the last
+ * payload character, so no fill bits end up in the binary data.
+ */
+static void pack_binary(GenState *g, GenBits *b, const GenVessel *v, int type) {
+    const GenVessel *dest = &g->fleet[rng_below(g, (uint32_t)g->opt.vessels)];
+    int header = type == 6 ? 88 : 56;
+    int bytes = 1 + (int)rng_below(g, 100);
+
+    while ((header + bytes * 8) % 6 != 0) bytes++;
+
+    put_uint(b, 6, type);
+    put_uint(b, 2, 0);
+    put_uint(b, 30, v->mmsi);
+    if (type == 6) {
+        put_uint(b, 2, rng_below(g, 4));
+        put_uint(b, 30, dest->mmsi);
+        put_uint(b, 1, 0);
+        put_uint(b, 1, 0);
+    } else {
+        put_uint(b, 2, 0);
+    }
+    put_uint(b, 10, 1);       /* international DAC */
+    put_uint(b, 6, 31);
+    for (int i = 0; i < bytes; i++) put_uint(b, 8, rng_below(g, 256));
+}
+
+
+/**
+ * @brief Random vessel name of one to three words and a number
+ */
+static void make_name(GenState *g, char *out, size_t size) {
+    int words = 1 + (int)rng_below(g, 2);
+    size_t n = 0;
+
+    for (int i = 0; i < words && n < size; i++)
+        n += snprintf(out + n, size - n, "%s%s", i ? " " : "", name_words[rng_below(g, 20)]);
+    if (n < size && rng_chance(g, 0.5)) snprintf(out + n, size - n, " %u", 1 + rng_below(g, 30));
+}
+
+
+/**
+ * @brief Build the fleet; about a third of the vessels carry Class B
+ */
+static void init_fleet(GenState *g) {
+    int n = g->opt.vessels;
+
+    g->fleet = calloc(n, sizeof(GenVessel));
+    g->class_a = malloc(sizeof(int) * n);
+    g->class_b = malloc(sizeof(int) * n);
+    if (!g->fleet || !g->class_a || !g->class_b) {
+        fprintf(stderr, "Out of memory for %d vessels\n", n);
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < n; i++) {
+        GenVessel *v = &g->fleet[i];
+        uint32_t mid = mids[rng_below(g, sizeof(mids) / sizeof(mids[0]))];
+
+        v->mmsi = mid * 1000000 + rng_below(g, 1000000);
+        v->imo = 9000000 + rng_below(g, 999999);
+        v->class_b = rng_chance(g, 0.33);
+        v->lat = (rng_uniform(g) - 0.5) * 120;
+        v->lon = (rng_uniform(g) - 0.5) * 360;
+        v->status = rng_chance(g, 0.15) ? 5 : 0;
+        v->speed = v->status == 5 ? 0 : 2 + rng_uniform(g) * 20;
+        v->course = rng_uniform(g) * 360;
+        v->last_time = (double)g->opt.start_time;
+        v->ship_type = v->class_b ? 37 : 70 + (int)rng_below(g, 20);
+        v->to_bow = 5 + (int)rng_below(g, v->class_b ? 10 : 250);
+        v->to_stern = 3 + (int)rng_below(g, v->class_b ? 5 : 60);
+        v->to_port = 1 + (int)rng_below(g, v->class_b ? 3 : 25);
+        v->to_starboard = 1 + (int)rng_below(g, v->class_b ? 3 : 25);
+        make_name(g, v->name, sizeof(v->name));
+        snprintf(v->callsign, sizeof(v->callsign), "%c%c%c%u",
+                 'A' + rng_below(g, 26), 'A' + rng_below(g, 26), 'A' + rng_below(g, 26), rng_below(g, 10000));
+        snprintf(v->destination, sizeof(v->destination), "%s", destinations[rng_below(g, 15)]);
+
+        if (v->class_b)
+            g->class_b[g->n_class_b++] = i;
+        else
+            g->class_a[g->n_class_a++] = i;
+    }
+}
+
+
+/**
+ * @brief Pick a message type from the weighted mix
+ */
+static int pick_type(GenState *g) {
+    uint32_t r = rng_below(g, g->weight_total);
+
+    for (int t = 0; t < GEN_TYPES; t++) {
+        if (r < g->opt.weight[t]) return t;
+        r -= g->opt.weight[t];
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Generate one message of a random type from a matching vessel
+ */
+static void generate_message(GenState *g) {
+    int type = pick_type(g);
+    bool class_b = type == 18 || type == 24;
+    int *pool = class_b ? g->class_b : g->class_a;
+    int npool = class_b ? g->n_class_b : g->n_class_a;
+    GenVessel *v = npool > 0 ? &g->fleet[pool[rng_below(g, (uint32_t)npool)]]
+                             : &g->fleet[rng_below(g, (uint32_t)g->opt.vessels)];
+    GenBits bits;
+
+    bits.len = 0;
+    advance(g, v);
+    switch (type) {
+        case 1:
+        case 2:
+        case 3: pack_position_a(g, &bits, v, type); break;
+        case 5: pack_static(g, &bits, v); break;
+        case 6:
+        case 8: pack_binary(g, &bits, v, type); break;
+        case 18: pack_position_b(g, &bits, v); break;
+        case 24:
+            /* Part A and B are sent back to back */
+            pack_static_b(&bits, v, 0);
+            send_message(g, &bits);
+            bits.len = 0;
+            pack_static_b(&bits, v, 1);
+            break;
+    }
+    send_message(g, &bits);
+    g->by_type[type]++;
+}
+
+
+/**
+ * @brief Parse a type mix such as "1=560,3=120,18=170,5=50"
+ *
+ * @return false if a type is not supported or the weights are all zero
+ */
+static bool parse_mix(const char *spec, unsigned *weight) {
+    static const int supported[] = {1, 2, 3, 5, 6, 8, 18, 24};
+    size_t len = strlen(spec);
+    char *copy = malloc(len + 1);
+    bool ok = copy != NULL;
+    unsigned total = 0;
+
+    if (copy) memcpy(copy, spec, len + 1);
+    memset(weight, 0, sizeof(unsigned) * GEN_TYPES);
+    for (char *tok = copy ? strtok(copy, ",") : NULL; ok && tok; tok = strtok(NULL, ",")) {
+        int type;
+        unsigned w;
+        bool known = false;
+
+        if (sscanf(tok, "%d=%u", &type, &w) != 2) {
+            ok = false;
+            break;
+        }
+        for (size_t i = 0; i < sizeof(supported) / sizeof(supported[0]); i++) known |= supported[i] == type;
+        if (!known) {
+            fprintf(stderr, "Unsupported message type %d in mix\n", type);
+            ok = false;
+            break;
+        }
+        weight[type] = w;
+        total += w;
+    }
+    free(copy);
+    return ok && total > 0;
+}
+
+
+/**
+ * @brief Print usage
+ */
+static void usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  Writes checksummed !AIVDM sentences from a simulated fleet.\n\n");
+    printf("  -n, --messages N      messages to generate, before duplicates (default 1000000)\n");
+    printf("  -v, --vessels N       fleet size (default 1000)\n");
+    printf("  -m, --mix SPEC        type weights, e.g. 1=560,3=120,18=170,5=50,24=40,6=10,8=30\n");
+    printf("                        supported types: 1 2 3 5 6 8 18 24 (24 sends part A and B)\n");
+    printf("  -r, --receivers N     receiving stations (default 4)\n");
+    printf("  -d, --duplicates P    chance a second receiver also reports a message (default 0.2)\n");
+    printf("  -i, --interleave P    chance a multipart message is interleaved (default 0.3)\n");
+    printf("  -c, --corrupt P       chance a line is damaged (default 0.001)\n");
+    printf("  -R, --rate N          messages per second of simulated time (default 2000)\n");
+    printf("  -t, --start EPOCH     Unix time of the first message (default 1700000000)\n");
+    printf("  -s, --seed N          random seed; equal seeds give identical output (default 1)\n");
+    printf("  -P, --plain           no NMEA 4.0 tag blocks\n");
+    printf("  -o, --output FILE     output file (default stdout)\n");
+}
+
+
+/**
+ * @brief Parse the command line into options
+ *
+ * @return false on an invalid or unknown option
+ */
+static bool parse_args(int argc, char *argv[], GenOptions *opt) {
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        bool flag = strcmp(a, "-P") == 0 || strcmp(a, "--plain") == 0;
+
+        if (flag) {
+            opt->tag_blocks = false;
+            continue;
+        }
+        if (val == NULL) return false;
+        i++;
+
+#define OPT(s, l) (strcmp(a, s) == 0 || strcmp(a, l) == 0)
+        if (OPT("-n", "--messages")) opt->messages = strtoull(val, NULL, 10);
+        else if (OPT("-v", "--vessels")) opt->vessels = atoi(val);
+        else if (OPT("-m", "--mix")) { if (!parse_mix(val, opt->weight)) return false; }
+        else if (OPT("-r", "--receivers")) opt->receivers = atoi(val);
+        else if (OPT("-d", "--duplicates")) opt->duplicate_rate = atof(val);
+        else if (OPT("-i", "--interleave")) opt->interleave_rate = atof(val);
+        else if (OPT("-c", "--corrupt")) opt->corrupt_rate = atof(val);
+        else if (OPT("-R", "--rate")) opt->rate = atof(val);
+        else if (OPT("-t", "--start")) opt->start_time = strtoll(val, NULL, 10);
+        else if (OPT("-s", "--seed")) opt->seed = strtoull(val, NULL, 10);
+        else if (OPT("-o", "--output")) opt->output = val;
+        else return false;
+#undef OPT
+    }
+    return opt->vessels > 0 && opt->receivers > 0 && opt->rate > 0;
+}
+
+
+/**
+ * @brief Generate a realistic, reproducible AIS receiver log.
+ *
+ * Every line is a valid, checksummed sentence unless deliberately
+ * corrupted, so the output exercises tokenizing, reassembly, deduplication
+ * and decoding the way a real feed would. Counts go to stderr.
+ */
+int main(int argc, char *argv[]) {
+    GenState g;
+
+    memset(&g, 0, sizeof(g));
+    g.opt.messages = 1000000;
+    g.opt.vessels = 1000;
+    g.opt.receivers = 4;
+    g.opt.duplicate_rate = 0.2;
+    g.opt.interleave_rate = 0.3;
+    g.opt.corrupt_rate = 0.001;
+    g.opt.rate = 2000;
+    g.opt.start_time = 1700000000;
+    g.opt.seed = 1;
+    g.opt.tag_blocks = true;
+    for (size_t i = 0; i < sizeof(default_mix) / sizeof(default_mix[0]); i++)
+        g.opt.weight[default_mix[i].type] = default_mix[i].weight;
+
+    if (argc == 2 && (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0)) {
+        usage(argv[0]);
+        return EXIT_SUCCESS;
+    }
+    if (!parse_args(argc, argv, &g.opt)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (int t = 0; t < GEN_TYPES; t++) g.weight_total += g.opt.weight[t];
+    g.rng = g.opt.seed;
+    g.now = (double)g.opt.start_time;
+    g.out = g.opt.output ? fopen(g.opt.output, "w") : stdout;
+    if (!g.out) {
+        perror(g.opt.output);
+        return EXIT_FAILURE;
+    }
+    setvbuf(g.out, NULL, _IOFBF, 1 << 20);
+
+    g.next_message_id = calloc(g.opt.receivers, sizeof(int));
+    init_fleet(&g);
+    for (uint64_t i = 0; i < g.opt.messages; i++) {
+        g.now += 1.0 / g.opt.rate;
+        generate_message(&g);
+    }
+    flush_delayed(&g, true);
+
+    if (fflush(g.out) != 0 || (g.out != stdout && fclose(g.out) != 0)) {
+        perror(g.opt.output ? g.opt.output : "stdout");
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stderr, "Wrote %llu lines: %llu messages, %llu duplicates, %llu corrupted lines\n",
+            (unsigned long long)g.lines, (unsigned long long)g.opt.messages,
+            (unsigned long long)g.duplicates, (unsigned long long)g.corrupted);
+    for (int t = 0; t < GEN_TYPES; t++)
+        if (g.by_type[t] > 0) fprintf(stderr, "  type %-2d %llu\n", t, (unsigned long long)g.by_type[t]);
+
+    free(g.fleet);
+    free(g.class_a);
+    free(g.class_b);
+    free(g.next_message_id);
+    return EXIT_SUCCESS;
+}
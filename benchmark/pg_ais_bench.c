@@ -7,17 +7,46 @@
 #include "parse_ais_msg.h"
 #include "pg_ais_core.h"
 #include "pg_ais_metrics.h"
+#include "ais_reader.h"
 
 
 #define MAX_LINE_LEN 1024
 
+/* Decompressed bytes taken from the reader thread per call */
+#define READ_BLOCK_SIZE (4 * 1024 * 1024)
+
+
+/**
+ * @brief Parse one log line through the full pg_ais pipeline
+ *
+ * @param line NUL-terminated line (newline removed)
+ * @param len Line length
+ * @return 1 if the line was an AIS sentence, 0 if skipped
+ */
+static int parse_line(char *line, size_t len) {
+    if (len > 0 && line[len - 1] == '\r') line[--len] = '\0';
+    if (line[0] == '#' || len < 6 || len >= MAX_LINE_LEN)
+        return 0;
+
+    ais *datum = ais_from_cstring_external(line);
+    if (!datum)
+        return 0;
+
+    AISMessage msg = {0};
+    pg_ais_parse(datum, &msg);
+    free_ais_message(&msg);
+    AIS_FREE(datum);
+    return 1;
+}
+
 
 /**
  * @brief Benchmark parser performance using a file of AIS sentences.
  *
- * Reads newline-delimited AIS messages from a text file and parses each using
- * the full pg_ais extension pipeline. Tracks total messages parsed, elapsed time,
- * and throughput, and prints internal parse/reassembly metrics.
+ * Reads newline-delimited AIS messages from a plain, gzip or zstd file and
+ * parses each using the full pg_ais extension pipeline. Decompression runs in
+ * the reader thread, overlapping with parsing. Tracks total messages parsed,
+ * elapsed time, and throughput, and prints internal parse/reassembly metrics.
  *
  * This benchmark reflects real-world use cases such as COPY-based bulk ingest
  * and can be used to measure parser throughput under high-load conditions.
@@ -25,48 +54,75 @@
  * @param filepath Path to the input file containing one AIS sentence per line
  */
 static void benchmark_parse_file(const char *filepath) {
-    FILE *fp = fopen(filepath, "r");
-    if (!fp) {
-        fprintf(stderr, "Failed to open file: %s\n", filepath);
+    char err[512];
+    AISReader *reader = ais_reader_open(filepath, 0, 0, err, sizeof(err));
+    if (!reader) {
+        fprintf(stderr, "Failed to open file: %s\n", err);
         exit(EXIT_FAILURE);
     }
 
-    char line[MAX_LINE_LEN];
+    char *buf = malloc(READ_BLOCK_SIZE + 1);
+    size_t carry = 0;
     size_t count = 0;
 
-    clock_t start = clock();
-
-    while (fgets(line, sizeof(line), fp)) {
-        if (line[0] == '#' || strlen(line) < 6)
-            continue;
-
-        // Strip newline
-        line[strcspn(line, "\r\n")] = 0;
-
-        ais *datum = ais_from_cstring_external(line);
-        if (!datum)
-            continue;
-
-        AISMessage msg = {0};
-        pg_ais_parse(datum, &msg);
-        free_ais_message(&msg);
-        AIS_FREE(datum);
+    // Wall time: clock() would also count the reader thread's decompression
+    struct timespec start, end_ts;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (;;) {
+        size_t n = ais_reader_read(reader, buf + carry, READ_BLOCK_SIZE - carry);
+        size_t avail = carry + n;
+        char *line = buf;
+        char *end = buf + avail;
+        char *nl;
+
+        if (n == 0) {
+            if (carry == 0) break;
+            // Last line without a trailing newline
+            *end++ = '\n';
+        }
+
+        while ((nl = memchr(line, '\n', end - line)) != NULL) {
+            *nl = '\0';
+            count += parse_line(line, nl - line);
+            line = nl + 1;
+        }
+
+        if (n == 0) break;
+        carry = end - line;
+        if (carry == READ_BLOCK_SIZE) carry = 0;  // overlong line, not a sentence
+        else if (carry > 0) memmove(buf, line, carry);
+    }
 
-        count++;
+    if (ais_reader_error(reader)) {
+        fprintf(stderr, "Failed to read %s: %s\n", filepath, ais_reader_error(reader));
+        exit(EXIT_FAILURE);
     }
 
-    clock_t end = clock();
-    fclose(fp);
+    clock_gettime(CLOCK_MONOTONIC, &end_ts);
+    const char *format = ais_reader_format(reader) == AIS_FORMAT_GZIP ? "gzip"
+                       : ais_reader_format(reader) == AIS_FORMAT_ZSTD ? "zstd" : "plain";
+    ais_reader_close(reader);
+    free(buf);
 
-    double elapsed = (double)(end - start) / CLOCKS_PER_SEC;
+    double elapsed = (double)(end_ts.tv_sec - start.tv_sec) + (end_ts.tv_nsec - start.tv_nsec) / 1e9;
     double rate = (elapsed > 0) ? (count / elapsed) : 0;
+    uint64 totals[AIS_METRIC_COUNTERS];
+    uint64 decoded = 0, failed = 0;
+
+    pg_ais_metrics_totals(totals);
+    for (int t = 0; t < AIS_METRIC_TYPES; t++) {
+        decoded += totals[AIS_METRIC_DECODED + t];
+        failed += totals[AIS_METRIC_FAILED + t];
+    }
 
-    printf("Parsed %zu messages in %.2f sec (%.0f msg/sec)\n", count, elapsed, rate);
+    printf("Parsed %zu messages (%s) in %.2f sec (%.0f msg/sec)\n", count, format, elapsed, rate);
     printf("--- Internal Metrics ---\n");
-    printf("%-30s %lu\n", "total_messages_parsed:", total_messages_parsed);
-    printf("%-30s %lu\n", "total_parse_failures:", total_parse_failures);
-    printf("%-30s %lu\n", "total_reassembly_attempts:", total_reassembly_attempts);
-    printf("%-30s %lu\n", "total_reassembly_success:", total_reassembly_success);
+    printf("%-30s %lu\n", "total_messages_parsed:", decoded + failed);
+    printf("%-30s %lu\n", "total_parse_failures:", failed);
+    printf("%-30s %lu\n", "total_reassembly_attempts:",
+           totals[AIS_METRIC_REASSEMBLY + AIS_REASSEMBLY_COMPLETE] + totals[AIS_METRIC_REASSEMBLY + AIS_REASSEMBLY_INCOMPLETE]);
+    printf("%-30s %lu\n", "total_reassembly_success:", totals[AIS_METRIC_REASSEMBLY + AIS_REASSEMBLY_COMPLETE]);
 }
 
 
@@ -84,8 +140,8 @@ static void benchmark_parse_file(const char *filepath) {
  */
 int main(int argc, char *argv[]) {
     if (argc != 2 || strcmp(argv[1], "--help") == 0) {
-        printf("Usage: %s <ais_file.txt>\n", argv[0]);
-        printf("  Each line should be a full !AIVDM sentence.\n");
+        printf("Usage: %s <ais_file.txt[.gz|.zst]>\n", argv[0]);
+        printf("  Each line should be a full !AIVDM sentence; gzip and zstd input is detected.\n");
         return EXIT_SUCCESS;
     }
     
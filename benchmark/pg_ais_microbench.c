@@ -0,0 +1,357 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ais_core.h"
+#include "parse_ais.h"
+#include "bitfield.h"
+#include "shared_ais_utils.h"
+
+
+/* Minimum duration of one timed run */
+#define DEFAULT_MIN_RUN_NS 20000000ULL
+
+/* Timed runs per kernel; the median is reported */
+#define DEFAULT_REPEATS 15
+
+#define MAX_REPEATS 1000
+
+
+/* Type 1 position report, 168 bits */
+static const char POSITION_PAYLOAD[] = "15MMV8U000p3MAh8uu2t69b`01A5";
+static const char POSITION_SENTENCE[] = "!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08";
+
+/* Type 5 static and voyage data in two fragments */
+static const char STATIC_PART1[] = "!AIVDM,2,1,0,B,53KrhPP2@t81=MGC?30l4E9<f3;000000000001;Chk3?6v5rJPUDhCP0000,0*71";
+static const char STATIC_PART2[] = "!AIVDM,2,2,0,B,00000000000,2*27";
+
+/* Type 8 broadcast with 23 bytes of binary data from bit 56 */
+static const char BINARY_PAYLOAD[] = "87Os?>@0Ghmv;seA:=0b;<k8BdnEKg;@@4MSFI@<";
+
+
+/**
+ * @brief One kernel and the input it is timed on
+ *
+ * run calls the kernel iters times and returns a value derived from the
+ * results, so the compiler cannot drop the calls.
+ */
+typedef struct {
+    const char *name;
+    size_t bytes;             /* input bytes per call, for the per-byte columns */
+    int width;                /* field width for parse_uint_safe */
+    uint64_t (*run)(const void *kernel, uint64_t iters);
+} Kernel;
+
+
+/**
+ * @brief Summary of the timed runs of one kernel
+ */
+typedef struct {
+    double median_ns;         /* per call */
+    double min_ns;
+    double stddev_pct;        /* relative standard deviation of the runs */
+    double cycles;            /* per call, 0 without a cycle counter */
+} KernelResult;
+
+
+static volatile uint64_t sink;
+static AISFragmentBuffer static_buffer;
+static AISMessage normalize_inputs[4];
+
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+/**
+ * @brief Time stamp counter, or 0 where there is none
+ *
+ * The TSC ticks at the nominal clock rate, so cycle figures are reference
+ * cycles and drift from core cycles under turbo or frequency scaling.
+ */
+static uint64_t cycles_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return 0;
+#endif
+}
+
+
+/**
+ * @brief parse_uint_safe at the kernel's width, sliding across the payload
+ */
+static uint64_t run_uint(const void *kernel, uint64_t iters) {
+    int width = ((const Kernel *) kernel)->width;
+    int span = (int)strlen(POSITION_PAYLOAD) * 6 - width + 1;
+    uint64_t acc = 0;
+
+    for (uint64_t i = 0; i < iters; i++) {
+        uint32_t value;
+        if (parse_uint_safe(POSITION_PAYLOAD, (int)(i % span), width, &value).ok) acc += value;
+    }
+    return acc;
+}
+
+
+/**
+ * @brief parse_string_utf8 on the 20-character vessel name of a type 5
+ */
+static uint64_t run_string(const void *kernel, uint64_t iters) {
+    const char *payload = static_buffer.parts[0]->payload;
+    uint64_t acc = 0;
+    (void) kernel;
+
+    for (uint64_t i = 0; i < iters; i++) {
+        char *name = NULL;
+        if (parse_string_utf8(payload, 112, 120, &name).ok) {
+            acc += (unsigned char)name[0];
+            free(name);
+        }
+    }
+    return acc;
+}
+
+
+/**
+ * @brief parse_bin_payload on the data of a type 8 broadcast
+ */
+static uint64_t run_binary(const void *kernel, uint64_t iters) {
+    int bits = ((int)strlen(BINARY_PAYLOAD) * 6 - 56) / 8 * 8;
+    uint64_t acc = 0;
+    (void) kernel;
+
+    for (uint64_t i = 0; i < iters; i++) {
+        char *data = NULL;
+        int len = 0;
+        if (parse_bin_payload(BINARY_PAYLOAD, 56, bits, &data, &len)) {
+            acc += (unsigned char)data[len - 1];
+            free(data);
+        }
+    }
+    return acc;
+}
+
+
+/**
+ * @brief parse_ais_fragment on a single-part sentence
+ */
+static uint64_t run_fragment(const void *kernel, uint64_t iters) {
+    uint64_t acc = 0;
+    (void) kernel;
+
+    for (uint64_t i = 0; i < iters; i++) {
+        AISFragment frag;
+        if (parse_ais_fragment(POSITION_SENTENCE, &frag).ok) {
+            acc += (uint64_t)frag.total + frag.fill_bits;
+            AIS_FREE(frag.payload);
+            AIS_FREE(frag.raw);
+        }
+    }
+    return acc;
+}
+
+
+/**
+ * @brief try_reassemble of a two-part type 5, including its decode
+ */
+static uint64_t run_reassemble(const void *kernel, uint64_t iters) {
+    uint64_t acc = 0;
+    (void) kernel;
+
+    for (uint64_t i = 0; i < iters; i++) {
+        AISMessage msg = {0};
+        if (try_reassemble(&static_buffer, &msg).ok) acc += (uint64_t)msg.mmsi;
+        free_ais_message(&msg);
+    }
+    return acc;
+}
+
+
+/**
+ * @brief normalize_position_fields on valid and sentinel positions
+ */
+static uint64_t run_normalize(const void *kernel, uint64_t iters) {
+    uint64_t acc = 0;
+    (void) kernel;
+
+    for (uint64_t i = 0; i < iters; i++) {
+        AISMessage msg = normalize_inputs[i & 3];
+        normalize_position_fields(&msg);
+        acc += (uint64_t)(msg.lat + msg.lon);
+    }
+    return acc;
+}
+
+
+/**
+ * @brief Split a sentence into the shared fragment buffer
+ */
+static void load_fragment(const char *sentence) {
+    AISFragment *frag = AIS_ALLOC(sizeof(AISFragment));
+
+    if (!frag || !parse_ais_fragment(sentence, frag).ok) {
+        fprintf(stderr, "Failed to split benchmark input: %s\n", sentence);
+        exit(EXIT_FAILURE);
+    }
+    static_buffer.parts[frag->seq - 1] = frag;
+    static_buffer.received++;
+}
+
+
+/**
+ * @brief Prepare the inputs shared by the kernels
+ */
+static void setup_inputs(void) {
+    load_fragment(STATIC_PART1);
+    load_fragment(STATIC_PART2);
+
+    normalize_inputs[0] = (AISMessage){ .lat = 51.9f, .lon = 4.1f, .speed = 12.3f, .heading = 90 };
+    normalize_inputs[1] = (AISMessage){ .lat = 91.0f, .lon = 181.0f, .speed = 102.3f, .heading = 511 };
+    normalize_inputs[2] = (AISMessage){ .lat = -33.8f, .lon = 151.2f, .speed = 0.0f, .heading = 0 };
+    normalize_inputs[3] = (AISMessage){ .lat = 1.3f, .lon = 103.8f, .speed = 18.0f, .heading = 511 };
+}
+
+
+/**
+ * @brief Time one kernel
+ *
+ * A warm-up run sizes the iteration count so that each timed run lasts at
+ * least min_run_ns, then repeats runs are timed separately.
+ */
+static KernelResult time_kernel(const Kernel *k, int repeats, uint64_t min_run_ns) {
+    double ns[MAX_REPEATS], cycles[MAX_REPEATS];
+    uint64_t iters = 16;
+    KernelResult r = {0};
+
+    /* Warm-up: caches, branch predictors and the allocator, while sizing the runs */
+    for (;;) {
+        uint64_t start = now_ns();
+        sink += k->run(k, iters);
+        uint64_t elapsed = now_ns() - start;
+        if (elapsed >= min_run_ns) break;
+        iters = elapsed < min_run_ns / 64 ? iters * 8 : iters * 2;
+    }
+
+    for (int i = 0; i < repeats; i++) {
+        uint64_t c0 = cycles_now();
+        uint64_t t0 = now_ns();
+        sink += k->run(k, iters);
+        uint64_t t1 = now_ns();
+        uint64_t c1 = cycles_now();
+        ns[i] = (double)(t1 - t0) / (double)iters;
+        cycles[i] = (double)(c1 - c0) / (double)iters;
+    }
+
+    /* Insertion sort is plenty for a few dozen runs */
+    for (int i = 1; i < repeats; i++) {
+        double n = ns[i], c = cycles[i];
+        int j = i - 1;
+        for (; j >= 0 && ns[j] > n; j--) {
+            ns[j + 1] = ns[j];
+            cycles[j + 1] = cycles[j];
+        }
+        ns[j + 1] = n;
+        cycles[j + 1] = c;
+    }
+
+    double mean = 0, var = 0;
+    for (int i = 0; i < repeats; i++) mean += ns[i];
+    mean /= repeats;
+    for (int i = 0; i < repeats; i++) var += (ns[i] - mean) * (ns[i] - mean);
+    var = repeats > 1 ? var / (repeats - 1) : 0;
+
+    r.median_ns = ns[repeats / 2];
+    r.min_ns = ns[0];
+    r.stddev_pct = mean > 0 ? 100.0 * sqrt(var) / mean : 0;
+    r.cycles = cycles[repeats / 2];
+    return r;
+}
+
+
+/**
+ * @brief Print usage
+ */
+static void usage(const char *prog) {
+    printf("Usage: %s [--repeats N] [--min-time MS] [kernel-filter]\n", prog);
+    printf("  Times the parser's hot functions in isolation and reports the median\n");
+    printf("  of N runs (default %d) of at least MS milliseconds each (default %llu).\n",
+           DEFAULT_REPEATS, DEFAULT_MIN_RUN_NS / 1000000ULL);
+    printf("  A filter runs only kernels whose name contains it, e.g. parse_uint_safe.\n");
+}
+
+
+/**
+ * @brief Micro-benchmark the parser kernels one by one
+ *
+ * Complements pg_ais_bench: each kernel runs on a fixed in-memory input,
+ * so a change to, say, the bit reader shows up without file I/O,
+ * reassembly or allocation noise from the rest of the pipeline. Cycle
+ * columns use the time stamp counter on x86 and are blank elsewhere.
+ */
+int main(int argc, char *argv[]) {
+    int repeats = DEFAULT_REPEATS;
+    uint64_t min_run_ns = DEFAULT_MIN_RUN_NS;
+    const char *filter = NULL;
+
+    Kernel kernels[] = {
+        {"parse_uint_safe/1", 1, 1, run_uint},
+        {"parse_uint_safe/6", 1, 6, run_uint},
+        {"parse_uint_safe/12", 2, 12, run_uint},
+        {"parse_uint_safe/27", 5, 27, run_uint},
+        {"parse_uint_safe/30", 5, 30, run_uint},
+        {"parse_uint_safe/32", 6, 32, run_uint},
+        {"parse_string_utf8/120", 20, 0, run_string},
+        {"parse_bin_payload/184", 31, 0, run_binary},
+        {"parse_ais_fragment", sizeof(POSITION_SENTENCE) - 1, 0, run_fragment},
+        {"try_reassemble/type5", sizeof(STATIC_PART1) + sizeof(STATIC_PART2) - 2, 0, run_reassemble},
+        {"normalize_position_fields", sizeof(AISMessage), 0, run_normalize},
+    };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            usage(argv[0]);
+            return EXIT_SUCCESS;
+        } else if (strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+            repeats = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_run_ns = strtoull(argv[++i], NULL, 10) * 1000000ULL;
+        } else if (argv[i][0] != '-' && filter == NULL) {
+            filter = argv[i];
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (repeats < 1 || repeats > MAX_REPEATS || min_run_ns == 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    setup_inputs();
+    printf("%-28s %6s %10s %10s %7s %12s %12s %10s\n",
+           "kernel", "bytes", "ns/call", "min ns", "+-%", "cycles/call", "cycles/byte", "ns/byte");
+
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+        const Kernel *k = &kernels[i];
+        if (filter && strstr(k->name, filter) == NULL) continue;
+
+        KernelResult r = time_kernel(k, repeats, min_run_ns);
+        printf("%-28s %6zu %10.2f %10.2f %7.2f", k->name, k->bytes, r.median_ns, r.min_ns, r.stddev_pct);
+        if (r.cycles > 0)
+            printf(" %12.1f %12.2f", r.cycles, r.cycles / k->bytes);
+        else
+            printf(" %12s %12s", "-", "-");
+        printf(" %10.3f\n", r.median_ns / k->bytes);
+    }
+
+    reset_buffer(&static_buffer);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,29 @@
+#include "pg_ais_metrics.h"
+
+
+/*
+ * No-op metrics hooks so pg_ais_microbench links the parse kernels without
+ * the PostgreSQL-side metrics code. Timing stays off, so the stage timers
+ * cost one predictable branch, as they do in a backend with the GUC unset.
+ */
+
+bool ais_track_timing = false;
+
+
+void pg_ais_record_parse_result(int type, ParseResult result) {
+    (void) type;
+    (void) result;
+}
+
+
+void pg_ais_record_reassembly(AISReassemblyOutcome outcome, uint64 n) {
+    (void) outcome;
+    (void) n;
+}
+
+
+void pg_ais_record_timing(AISStage stage, int type, uint64 elapsed_ns) {
+    (void) stage;
+    (void) type;
+    (void) elapsed_ns;
+}
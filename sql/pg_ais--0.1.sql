@@ -23,6 +23,17 @@ RETURNS jsonb
 AS 'pg_ais', 'pg_ais_parse'
 LANGUAGE C IMMUTABLE STRICT;
 
+-- Every decoded field for the message type, e.g. SELECT pg_ais_parse_full(sentence)
+CREATE OR REPLACE FUNCTION pg_ais_parse_full(ais)
+RETURNS jsonb
+AS 'MODULE_PATHNAME', 'pg_ais_parse_full'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_parse_full(ais[])
+RETURNS jsonb
+AS 'MODULE_PATHNAME', 'pg_ais_parse_full_parts'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
 -- pg_ais_debug
 CREATE OR REPLACE FUNCTION pg_ais_debug(sentence text, format text DEFAULT 'json')
 RETURNS jsonb
@@ -30,9 +41,8 @@ AS 'MODULE_PATHNAME', 'pg_ais_debug'
 LANGUAGE C STRICT;
 
 
--- Tabular support
-CREATE OR REPLACE FUNCTION pg_ais_fields(text)
-RETURNS TABLE (
+-- Tabular support: one typed row per message, e.g. SELECT (pg_ais_fields(sentence)).*
+CREATE TYPE ais_fields AS (
     type integer,
     mmsi integer,
     nav_status integer,
@@ -52,9 +62,38 @@ RETURNS TABLE (
     fix_type integer,
     radio integer,
     repeat integer,
-    raim boolean
-) AS 'MODULE_PATHNAME', 'pg_ais_fields'
-LANGUAGE C STRICT;
+    raim boolean,
+    station text,
+    receive_time timestamptz,
+    line_count integer
+);
+
+CREATE OR REPLACE FUNCTION pg_ais_fields(ais)
+RETURNS ais_fields
+AS 'MODULE_PATHNAME', 'pg_ais_fields'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- Text columns holding raw sentences share the ais representation
+CREATE OR REPLACE FUNCTION pg_ais_fields(text)
+RETURNS ais_fields
+AS 'MODULE_PATHNAME', 'pg_ais_fields'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- NMEA 4.0 tag block accessors: \s:station,c:unixtime,n:line*hh\!AIVDM,...
+CREATE OR REPLACE FUNCTION pg_ais_station(ais)
+RETURNS text
+AS 'MODULE_PATHNAME', 'pg_ais_station'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_receive_time(ais)
+RETURNS timestamptz
+AS 'MODULE_PATHNAME', 'pg_ais_receive_time'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_line_count(ais)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'pg_ais_line_count'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
 -- Extract lon/lat from AIS message.
 CREATE OR REPLACE FUNCTION pg_ais_point(text)
@@ -62,11 +101,6 @@ RETURNS point
 AS 'MODULE_PATHNAME', 'pg_ais_point'
 LANGUAGE C STRICT;
 
-CREATE OR REPLACE FUNCTION pg_ais_point(text)
-RETURNS bytea
-AS 'MODULE_PATHNAME', 'pg_ais_point_geom'
-LANGUAGE C STRICT;
-
 CREATE OR REPLACE FUNCTION pg_ais_get_text_field(sentence ais, fieldname text)
 RETURNS text
 AS 'MODULE_PATHNAME', 'pg_ais_get_text_field'
@@ -101,4 +135,514 @@ LANGUAGE C STABLE;
 CREATE FUNCTION pg_ais_reset_metrics()
 RETURNS void
 AS 'pg_ais', 'pg_ais_reset_metrics'
-LANGUAGE C VOLATILE;
\ No newline at end of file
+LANGUAGE C VOLATILE;
+
+REVOKE EXECUTE ON FUNCTION pg_ais_reset_metrics() FROM PUBLIC;
+
+-- Every counter, summed over all sessions and workers when preloaded
+CREATE FUNCTION pg_ais_stat(
+    OUT metric text,
+    OUT label text,
+    OUT value bigint)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_ais_stat'
+LANGUAGE C VOLATILE;
+
+CREATE VIEW pg_stat_ais AS
+    SELECT metric, label, value FROM pg_ais_stat();
+
+-- Latency percentiles per parsing stage, collected when pg_ais.track_timing is on
+CREATE FUNCTION pg_ais_timing(
+    OUT stage text,
+    OUT type integer,
+    OUT count bigint,
+    OUT mean_us float8,
+    OUT p50_us float8,
+    OUT p99_us float8,
+    OUT p999_us float8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_ais_timing'
+LANGUAGE C VOLATILE;
+
+CREATE VIEW pg_stat_ais_timing AS
+    SELECT stage, type, count, mean_us, p50_us, p99_us, p999_us FROM pg_ais_timing();
+
+-- Counters and latency histograms in the Prometheus text exposition format
+CREATE FUNCTION pg_ais_metrics_prometheus()
+RETURNS text
+AS 'MODULE_PATHNAME', 'pg_ais_metrics_prometheus'
+LANGUAGE C VOLATILE;
+
+-- Space-filling curve keys for clustering positions
+CREATE OR REPLACE FUNCTION pg_ais_zorder(ais)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'pg_ais_zorder'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_hilbert(sentence ais, bits integer DEFAULT 16)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'pg_ais_hilbert'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_within_box(ais, box)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_within_box'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OPERATOR <@ (
+    LEFTARG = ais,
+    RIGHTARG = box,
+    FUNCTION = pg_ais_within_box,
+    RESTRICT = contsel,
+    JOIN = contjoinsel
+);
+
+-- Fixed-point bounding-box filter; xmin > xmax crosses the antimeridian
+CREATE OR REPLACE FUNCTION pg_ais_in_bbox(sentence ais, xmin double precision, ymin double precision,
+                                          xmax double precision, ymax double precision)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_in_bbox'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_in_bbox(sentences ais[], xmin double precision, ymin double precision,
+                                          xmax double precision, ymax double precision)
+RETURNS boolean[]
+AS 'MODULE_PATHNAME', 'pg_ais_in_bbox_array'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- Spatial partitioning keys computed from the fixed-point position
+CREATE OR REPLACE FUNCTION pg_ais_geohash(sentence ais, precision integer DEFAULT 9)
+RETURNS text
+AS 'MODULE_PATHNAME', 'pg_ais_geohash'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_grid_cell(sentence ais, level integer DEFAULT 16)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'pg_ais_grid_cell'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_grid_parent(cell bigint, level integer)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'pg_ais_grid_parent'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- Position as little-endian EWKB with SRID 4326
+CREATE OR REPLACE FUNCTION pg_ais_ewkb(ais)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'pg_ais_ewkb'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- Position as geometry(Point, 4326), only if PostGIS is installed first
+DO $$
+DECLARE
+    postgis_schema name;
+BEGIN
+    SELECT extnamespace::regnamespace::name INTO postgis_schema FROM pg_extension WHERE extname = 'postgis';
+    IF postgis_schema IS NOT NULL THEN
+        EXECUTE format('CREATE OR REPLACE FUNCTION pg_ais_geometry(ais) RETURNS %I.geometry '
+                       'AS ''MODULE_PATHNAME'', ''pg_ais_geometry'' '
+                       'LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE', postgis_schema);
+    END IF;
+END
+$$;
+
+-- BRIN: per-range min/max Morton key, e.g. CREATE INDEX ... USING brin (sentence ais_zorder_minmax_ops)
+CREATE OR REPLACE FUNCTION pg_ais_brin_zorder_opcinfo(internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'pg_ais_brin_zorder_opcinfo'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_brin_zorder_add_value(internal, internal, internal, internal)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_brin_zorder_add_value'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_brin_zorder_consistent(internal, internal, internal)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_brin_zorder_consistent'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_brin_zorder_union(internal, internal, internal)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_brin_zorder_union'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OPERATOR CLASS ais_zorder_minmax_ops
+FOR TYPE ais USING brin AS
+    OPERATOR 8 <@ (ais, box),
+    FUNCTION 1 pg_ais_brin_zorder_opcinfo(internal),
+    FUNCTION 2 pg_ais_brin_zorder_add_value(internal, internal, internal, internal),
+    FUNCTION 3 pg_ais_brin_zorder_consistent(internal, internal, internal),
+    FUNCTION 4 pg_ais_brin_zorder_union(internal, internal, internal),
+STORAGE bigint;
+
+-- Btree sort helper: order messages along the Z curve (positionless messages last)
+CREATE OR REPLACE FUNCTION pg_ais_zorder_cmp(ais, ais)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'pg_ais_zorder_cmp'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_zorder_sortsupport(internal)
+RETURNS void
+AS 'MODULE_PATHNAME', 'pg_ais_zorder_sortsupport'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_zorder_lt(ais, ais) RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_zorder_lt' LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+CREATE OR REPLACE FUNCTION pg_ais_zorder_le(ais, ais) RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_zorder_le' LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+CREATE OR REPLACE FUNCTION pg_ais_zorder_eq(ais, ais) RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_zorder_eq' LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+CREATE OR REPLACE FUNCTION pg_ais_zorder_ge(ais, ais) RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_zorder_ge' LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+CREATE OR REPLACE FUNCTION pg_ais_zorder_gt(ais, ais) RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_zorder_gt' LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OPERATOR #<# (LEFTARG = ais, RIGHTARG = ais, FUNCTION = pg_ais_zorder_lt,
+    COMMUTATOR = #>#, NEGATOR = #>=#, RESTRICT = scalarltsel, JOIN = scalarltjoinsel);
+CREATE OPERATOR #<=# (LEFTARG = ais, RIGHTARG = ais, FUNCTION = pg_ais_zorder_le,
+    COMMUTATOR = #>=#, NEGATOR = #>#, RESTRICT = scalarlesel, JOIN = scalarlejoinsel);
+CREATE OPERATOR #=# (LEFTARG = ais, RIGHTARG = ais, FUNCTION = pg_ais_zorder_eq,
+    COMMUTATOR = #=#, RESTRICT = eqsel, JOIN = eqjoinsel);
+CREATE OPERATOR #>=# (LEFTARG = ais, RIGHTARG = ais, FUNCTION = pg_ais_zorder_ge,
+    COMMUTATOR = #<=#, NEGATOR = #<#, RESTRICT = scalargesel, JOIN = scalargejoinsel);
+CREATE OPERATOR #># (LEFTARG = ais, RIGHTARG = ais, FUNCTION = pg_ais_zorder_gt,
+    COMMUTATOR = #<#, NEGATOR = #<=#, RESTRICT = scalargtsel, JOIN = scalargtjoinsel);
+
+CREATE OPERATOR CLASS ais_zorder_ops
+FOR TYPE ais USING btree AS
+    OPERATOR 1 #<#,
+    OPERATOR 2 #<=#,
+    OPERATOR 3 #=#,
+    OPERATOR 4 #>=#,
+    OPERATOR 5 #>#,
+    FUNCTION 1 pg_ais_zorder_cmp(ais, ais),
+    FUNCTION 2 pg_ais_zorder_sortsupport(internal);
+
+
+-- Payload hashing and equality for deduplication, hash joins and partitioning
+CREATE OR REPLACE FUNCTION pg_ais_hash64(ais)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'pg_ais_hash64'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_hash(ais)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'pg_ais_hash'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_hash_extended(ais, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'pg_ais_hash_extended'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_eq(ais, ais)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_eq'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_ne(ais, ais)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_ne'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OPERATOR = (
+    LEFTARG = ais,
+    RIGHTARG = ais,
+    FUNCTION = pg_ais_eq,
+    COMMUTATOR = =,
+    NEGATOR = <>,
+    RESTRICT = eqsel,
+    JOIN = eqjoinsel,
+    HASHES
+);
+
+CREATE OPERATOR <> (
+    LEFTARG = ais,
+    RIGHTARG = ais,
+    FUNCTION = pg_ais_ne,
+    COMMUTATOR = <>,
+    NEGATOR = =,
+    RESTRICT = neqsel,
+    JOIN = neqjoinsel
+);
+
+CREATE OPERATOR CLASS ais_hash_ops
+DEFAULT FOR TYPE ais USING hash AS
+    OPERATOR 1 = (ais, ais),
+    FUNCTION 1 pg_ais_hash(ais),
+    FUNCTION 2 pg_ais_hash_extended(ais, bigint);
+
+-- Canonical payload fingerprint for cross-receiver deduplication
+CREATE OR REPLACE FUNCTION pg_ais_fingerprint(ais)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'pg_ais_fingerprint'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_fingerprint(ais, received_at timestamptz, time_window interval)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'pg_ais_fingerprint'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_fingerprint(ais[])
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'pg_ais_fingerprint_parts'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_fingerprint(ais[], received_at timestamptz, time_window interval)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'pg_ais_fingerprint_parts'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+
+-- Server-side bulk loader: one pass from a raw receiver log into a table
+CREATE OR REPLACE FUNCTION pg_ais_load_file(
+    path text,
+    target regclass,
+    batch_size integer DEFAULT 1000,
+    sort_by text DEFAULT 'none',
+    OUT rows bigint,
+    OUT sentences bigint,
+    OUT bad_checksum bigint,
+    OUT malformed bigint,
+    OUT incomplete bigint,
+    OUT decode_errors bigint)
+RETURNS record
+AS 'MODULE_PATHNAME', 'pg_ais_load_file'
+LANGUAGE C VOLATILE STRICT;
+
+REVOKE EXECUTE ON FUNCTION pg_ais_load_file(text, regclass, integer, text) FROM PUBLIC;
+
+-- Foreign data wrapper over directories of raw AIS receiver logs
+CREATE OR REPLACE FUNCTION pg_ais_fdw_handler()
+RETURNS fdw_handler
+AS 'MODULE_PATHNAME', 'pg_ais_fdw_handler'
+LANGUAGE C STRICT;
+
+CREATE OR REPLACE FUNCTION pg_ais_fdw_validator(text[], oid)
+RETURNS void
+AS 'MODULE_PATHNAME', 'pg_ais_fdw_validator'
+LANGUAGE C STRICT;
+
+CREATE FOREIGN DATA WRAPPER pg_ais_fdw
+    HANDLER pg_ais_fdw_handler
+    VALIDATOR pg_ais_fdw_validator;
+
+-- Receiver/decoder ingest pipeline counters (empty unless it is running)
+CREATE OR REPLACE FUNCTION pg_ais_ingest_stats(
+    OUT worker integer,
+    OUT pid integer,
+    OUT depth bigint,
+    OUT capacity bigint,
+    OUT enqueued bigint,
+    OUT stalls bigint,
+    OUT dropped bigint,
+    OUT rows bigint,
+    OUT decode_errors bigint
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_ais_ingest_stats'
+LANGUAGE C VOLATILE;
+
+-- Shared latest-state cache per MMSI (pg_ais.state_cache_size > 0)
+CREATE OR REPLACE FUNCTION pg_ais_vessel_states(
+    OUT mmsi integer,
+    OUT lat double precision,
+    OUT lon double precision,
+    OUT speed double precision,
+    OUT course double precision,
+    OUT heading double precision,
+    OUT nav_status integer,
+    OUT type integer,
+    OUT updated_at timestamptz
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_ais_vessel_states'
+LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION pg_ais_vessel_state(
+    mmsi integer,
+    OUT lat double precision,
+    OUT lon double precision,
+    OUT speed double precision,
+    OUT course double precision,
+    OUT heading double precision,
+    OUT nav_status integer,
+    OUT type integer,
+    OUT updated_at timestamptz
+)
+RETURNS record
+AS 'MODULE_PATHNAME', 'pg_ais_vessel_state'
+LANGUAGE C VOLATILE STRICT;
+
+CREATE OR REPLACE FUNCTION pg_ais_vessel_state_update(sentence ais, received_at timestamptz DEFAULT now())
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_vessel_state_update'
+LANGUAGE C VOLATILE STRICT;
+
+-- Shared static data dictionary of type 5/19/24 data (pg_ais.static_cache_size > 0)
+CREATE OR REPLACE FUNCTION pg_ais_static_data(
+    mmsi integer,
+    OUT imo integer,
+    OUT vessel_name text,
+    OUT callsign text,
+    OUT ship_type integer,
+    OUT to_bow integer,
+    OUT to_stern integer,
+    OUT to_port integer,
+    OUT to_starboard integer,
+    OUT destination text,
+    OUT updated_at timestamptz
+)
+RETURNS record
+AS 'MODULE_PATHNAME', 'pg_ais_static_data'
+LANGUAGE C VOLATILE STRICT;
+
+CREATE OR REPLACE FUNCTION pg_ais_vessel_name(mmsi integer)
+RETURNS text
+AS 'MODULE_PATHNAME', 'pg_ais_vessel_name'
+LANGUAGE C VOLATILE STRICT;
+
+CREATE OR REPLACE FUNCTION pg_ais_static_update(sentence ais, received_at timestamptz DEFAULT now())
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_static_update'
+LANGUAGE C VOLATILE STRICT;
+
+CREATE OR REPLACE FUNCTION pg_ais_static_update(sentences ais[], received_at timestamptz DEFAULT now())
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'pg_ais_static_update_parts'
+LANGUAGE C VOLATILE STRICT;
+
+CREATE OR REPLACE FUNCTION pg_ais_static_snapshot()
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'pg_ais_static_snapshot'
+LANGUAGE C VOLATILE;
+
+REVOKE EXECUTE ON FUNCTION pg_ais_static_snapshot() FROM PUBLIC;
+
+-- Delta-encoded trajectory of one vessel
+CREATE OR REPLACE FUNCTION ais_track_in(cstring)
+RETURNS ais_track
+AS 'MODULE_PATHNAME', 'ais_track_in'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION ais_track_out(ais_track)
+RETURNS cstring
+AS 'MODULE_PATHNAME', 'ais_track_out'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE TYPE ais_track (
+    INPUT = ais_track_in,
+    OUTPUT = ais_track_out,
+    INTERNALLENGTH = VARIABLE,
+    ALIGNMENT = double,
+    STORAGE = EXTENDED
+);
+
+CREATE OR REPLACE FUNCTION pg_ais_track_agg_transfn(internal, ais, timestamptz)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'pg_ais_track_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_track_agg_finalfn(internal)
+RETURNS ais_track
+AS 'MODULE_PATHNAME', 'pg_ais_track_agg_finalfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- e.g. SELECT pg_ais_track_agg(sentence, received_at ORDER BY received_at) ... GROUP BY mmsi
+CREATE AGGREGATE pg_ais_track_agg(ais, timestamptz) (
+    SFUNC = pg_ais_track_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = pg_ais_track_agg_finalfn
+);
+
+CREATE OR REPLACE FUNCTION pg_ais_track_simplify_transfn(internal, ais, timestamptz, double precision, interval)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'pg_ais_track_simplify_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_track_simplify_finalfn(internal)
+RETURNS ais_track
+AS 'MODULE_PATHNAME', 'pg_ais_track_simplify_finalfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Dead-reckoning simplification, e.g. pg_ais_track_simplify_agg(sentence, ts, 50, '10 minutes' ORDER BY ts)
+CREATE AGGREGATE pg_ais_track_simplify_agg(ais, timestamptz, tolerance double precision, max_gap interval) (
+    SFUNC = pg_ais_track_simplify_transfn,
+    STYPE = internal,
+    FINALFUNC = pg_ais_track_simplify_finalfn
+);
+
+
+-- Window kinematics of one vessel, e.g. for spoofing and teleport checks
+CREATE TYPE ais_kinematics AS (
+    fixes integer,
+    distance double precision,
+    avg_speed double precision,
+    max_turn_rate double precision,
+    max_implied_speed double precision
+);
+
+CREATE OR REPLACE FUNCTION pg_ais_kinematics_transfn(internal, ais, timestamptz)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'pg_ais_kinematics_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_kinematics_moving_transfn(internal, ais, timestamptz)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'pg_ais_kinematics_moving_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_kinematics_inverse_transfn(internal, ais, timestamptz)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'pg_ais_kinematics_inverse_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_kinematics_finalfn(internal)
+RETURNS ais_kinematics
+AS 'MODULE_PATHNAME', 'pg_ais_kinematics_finalfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Distance (m), average speed (kn), max turn rate (deg/min) and max implied speed (kn), e.g.
+-- pg_ais_kinematics(sentence, ts) OVER (PARTITION BY mmsi ORDER BY ts ROWS BETWEEN 10 PRECEDING AND CURRENT ROW)
+CREATE AGGREGATE pg_ais_kinematics(ais, timestamptz) (
+    SFUNC = pg_ais_kinematics_transfn,
+    STYPE = internal,
+    FINALFUNC = pg_ais_kinematics_finalfn,
+    MSFUNC = pg_ais_kinematics_moving_transfn,
+    MINVFUNC = pg_ais_kinematics_inverse_transfn,
+    MSTYPE = internal,
+    MFINALFUNC = pg_ais_kinematics_finalfn
+);
+
+CREATE OR REPLACE FUNCTION pg_ais_track_mmsi(ais_track)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'pg_ais_track_mmsi'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_track_length(ais_track)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'pg_ais_track_length'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_track_bbox(ais_track)
+RETURNS box
+AS 'MODULE_PATHNAME', 'pg_ais_track_bbox'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_track_time_range(ais_track)
+RETURNS tstzrange
+AS 'MODULE_PATHNAME', 'pg_ais_track_time_range'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION pg_ais_track_points(
+    track ais_track,
+    OUT ts timestamptz,
+    OUT lat double precision,
+    OUT lon double precision,
+    OUT speed double precision,
+    OUT course double precision
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_ais_track_points'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
@@ -0,0 +1,17 @@
+#ifndef AIS_ASCII_H
+#define AIS_ASCII_H
+
+
+/* 6-bit ASCII to ITU-R M.1371-1 ASCII mapping, shared by the string decoders */
+static const char sixbit_ascii[64] = {
+    '@', 'A', 'B', 'C', 'D', 'E', 'F', 'G',
+    'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O',
+    'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W',
+    'X', 'Y', 'Z', '[', '\\', ']', '^', '_',
+    ' ', '!', '"', '#', '$', '%', '&', '\'',
+    '(', ')', '*', '+', ',', '-', '.', '/',
+    '0', '1', '2', '3', '4', '5', '6', '7',
+    '8', '9', ':', ';', '<', '=', '>', '?'
+};
+
+#endif
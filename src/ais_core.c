@@ -1,19 +1,124 @@
 #include "postgres.h"
 #include "fmgr.h"
+#include "funcapi.h"
+#include "access/htup_details.h"
+#include "miscadmin.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
 #include "utils/builtins.h"
+#include "utils/guc.h"
 #include "utils/jsonb.h"
+#include "utils/numeric.h"
+#include "utils/timestamp.h"
 #include "utils/varlena.h"
 #include "lib/stringinfo.h"
 
+#include <math.h>
+
 #include "pg_ais.h"
 #include "parse_ais.h"
+#include "parse_ais_msg.h"
+#include "ais_payload.h"
+#include "pg_ais_dedup.h"
+#include "pg_ais_exporter.h"
+#include "pg_ais_fields.h"
+#include "pg_ais_ingest.h"
+#include "pg_ais_metrics.h"
+#include "pg_ais_pipeline.h"
+#include "pg_ais_state.h"
+#include "pg_ais_static.h"
 
 PG_MODULE_MAGIC;
 
 
+static shmem_request_hook_type prev_shmem_request_hook = NULL;
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+
+
+/**
+ * @brief Reserve the fixed shared memory of every pg_ais module
+ */
+static void pg_ais_shmem_request(void) {
+    if (prev_shmem_request_hook) prev_shmem_request_hook();
+    pg_ais_metrics_shmem_request();
+    pg_ais_pipeline_shmem_request();
+    pg_ais_state_shmem_request();
+    pg_ais_static_shmem_request();
+}
+
+
+/**
+ * @brief Create or attach the fixed shared memory of every pg_ais module
+ */
+static void pg_ais_shmem_startup(void) {
+    if (prev_shmem_startup_hook) prev_shmem_startup_hook();
+
+    LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+    pg_ais_metrics_shmem_startup();
+    pg_ais_pipeline_shmem_startup();
+    pg_ais_state_shmem_startup();
+    pg_ais_static_shmem_startup();
+    LWLockRelease(AddinShmemInitLock);
+}
+
+
+/**
+ * @brief Module load hook: define GUCs, register background workers and,
+ * when preloaded, request shared memory
+ */
+void _PG_init(void) {
+    pg_ais_metrics_init();
+    pg_ais_exporter_init();
+    pg_ais_ingest_init();
+    pg_ais_state_init();
+    pg_ais_static_init();
+    MarkGUCPrefixReserved("pg_ais");
+
+    if (!process_shared_preload_libraries_in_progress) return;
+
+    prev_shmem_request_hook = shmem_request_hook;
+    shmem_request_hook = pg_ais_shmem_request;
+    prev_shmem_startup_hook = shmem_startup_hook;
+    shmem_startup_hook = pg_ais_shmem_startup;
+}
+
+
 static AISFragmentBuffer frag_buffer;
 
 
+/**
+ * @brief Push an object key onto a JSONB build state
+ *
+ * @param state JSONB parse state
+ * @param key   Field name (static string)
+ */
+static void push_jsonb_key(JsonbParseState **state, const char *key) {
+    JsonbValue k = {.type = jbvString};
+    k.val.string.val = (char *)key;
+    k.val.string.len = strlen(key);
+    pushJsonbValue(state, WJB_KEY, &k);
+}
+
+
+/**
+ * @brief Build an exact numeric from a scaled integer
+ *
+ * Trailing decimal zeros are dropped so 14.0 knots is emitted as 14, the way
+ * a hand-written JSON document would carry it.
+ *
+ * @param scaled Value multiplied by 10^scale
+ * @param scale  Number of decimal digits in scaled
+ * @return Numeric equal to scaled / 10^scale
+ */
+static Numeric decimal_numeric(int64 scaled, int scale) {
+    while (scale > 0 && scaled % 10 == 0) {
+        scaled /= 10;
+        scale--;
+    }
+    return scale > 0 ? int64_div_fast_to_numeric(scaled, scale) : int64_to_numeric(scaled);
+}
+
+
 /**
  * @brief Append a numeric field to a JSONB object.
  *
@@ -25,28 +130,56 @@ static AISFragmentBuffer frag_buffer;
 #define ADD_NUMERIC_FIELD(key, valexpr) \
     do { \
         JsonbValue _v = {.type = jbvNumeric}; \
-        _v.val.numeric = int_to_numeric(valexpr); \
-        pushJsonbValue(&state, WJB_KEY, &((JsonbValue){.type = jbvString, .val.string.val = key, .val.string.len = strlen(key)})); \
+        _v.val.numeric = int64_to_numeric(valexpr); \
+        push_jsonb_key(&state, key); \
         pushJsonbValue(&state, WJB_VALUE, &_v); \
     } while(0)
 
 
 /**
- * @brief Append a floating-point field to a JSONB object.
+ * @brief Append a fractional field to a JSONB object.
  *
- * Emits a key-value pair where the value is a double precision number.
+ * Rounds the value to a fixed number of decimals and stores it as a native
+ * JSON number (not a string), without a text round trip.
  *
  * @param key   Field name
  * @param val   Float or double value
+ * @param scale Decimal digits to keep (0–6)
  */
-#define ADD_FLOAT_FIELD(key, valexpr) \
+#define ADD_FLOAT_FIELD(key, valexpr, scale) \
     do { \
-        char _buf[32]; \
-        snprintf(_buf, sizeof(_buf), "%.6f", valexpr); \
-        JsonbValue _v = {.type = jbvString}; \
-        _v.val.string.val = _buf; \
-        _v.val.string.len = strlen(_buf); \
-        pushJsonbValue(&state, WJB_KEY, &((JsonbValue){.type = jbvString, .val.string.val = key, .val.string.len = strlen(key)})); \
+        static const double _pow10[] = {1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6}; \
+        JsonbValue _v = {.type = jbvNumeric}; \
+        _v.val.numeric = decimal_numeric((int64) llround((valexpr) * _pow10[scale]), scale); \
+        push_jsonb_key(&state, key); \
+        pushJsonbValue(&state, WJB_VALUE, &_v); \
+    } while(0)
+
+
+/**
+ * @brief Append a boolean field to a JSONB object.
+ *
+ * @param key   Field name
+ * @param val   Truth value
+ */
+#define ADD_BOOL_FIELD(key, valexpr) \
+    do { \
+        JsonbValue _v = {.type = jbvBool}; \
+        _v.val.boolean = (valexpr) != 0; \
+        push_jsonb_key(&state, key); \
+        pushJsonbValue(&state, WJB_VALUE, &_v); \
+    } while(0)
+
+
+/**
+ * @brief Append a JSON null to a JSONB object.
+ *
+ * @param key   Field name
+ */
+#define ADD_NULL_FIELD(key) \
+    do { \
+        JsonbValue _v = {.type = jbvNull}; \
+        push_jsonb_key(&state, key); \
         pushJsonbValue(&state, WJB_VALUE, &_v); \
     } while(0)
 
@@ -65,29 +198,133 @@ static AISFragmentBuffer frag_buffer;
             JsonbValue _v = {.type = jbvString}; \
             _v.val.string.val = (char *)valexpr; \
             _v.val.string.len = strlen(valexpr); \
-            pushJsonbValue(&state, WJB_KEY, &((JsonbValue){.type = jbvString, .val.string.val = key, .val.string.len = strlen(key)})); \
+            push_jsonb_key(&state, key); \
             pushJsonbValue(&state, WJB_VALUE, &_v); \
         } \
     } while(0)
 
 
 /**
- * @brief Parse a varlena-encoded AIS value into an AISMessage struct.
+ * @brief Convert a fixed-point coordinate to millionths of a degree
  *
- * This function acts as a shared backend for all pg_ais_get_*_field functions.
- * It unpacks the input, validates it, and populates an in-memory AISMessage.
+ * @param v Coordinate in 1/10000 minute
+ * @return Coordinate in 1e-6 degree, rounded half away from zero
+ */
+static int64 fixed_to_micro_degrees(int32 v) {
+    int64 x = (int64) v * 10;
+    return x >= 0 ? (x + 3) / 6 : (x - 3) / 6;
+}
+
+
+/**
+ * @brief Resolve the position of a decoded message in 1e-6 degree
  *
- * @param ais_input Pointer to PostgreSQL 'ais' type (varlena)
- * @param msg_out   Output struct to populate (caller must free fields)
- * @return ParseResult indicating parse status
+ * Reads the exact fixed-point value from the first fragment when available,
+ * otherwise falls back to the decoder's float fields.
+ *
+ * @param first First fragment view, or NULL if not at hand
+ * @param msg   Decoded message
+ * @param lon   Output longitude
+ * @param lat   Output latitude
+ * @return false if the message has no valid position
+ */
+static bool message_position(const AISPayloadView *first, const AISMessage *msg, int64 *lon, int64 *lat) {
+    int32_t flon, flat;
+
+    if (first) {
+        if (!ais_view_position(first, &flon, &flat)) return false;
+        *lon = fixed_to_micro_degrees(flon);
+        *lat = fixed_to_micro_degrees(flat);
+        return true;
+    }
+    if (msg->lat < -90 || msg->lat > 90 || msg->lon < -180 || msg->lon > 180) return false;
+    *lon = (int64) llround(msg->lon * 1e6);
+    *lat = (int64) llround(msg->lat * 1e6);
+    return true;
+}
+
+
+/**
+ * @brief Build the compact pg_ais_parse() object for a decoded message
+ *
+ * Always carries mmsi, lat, lon, speed and heading; values the message does
+ * not provide are JSON null.
+ *
+ * @param msg   Decoded message
+ * @param first First fragment view, or NULL if not at hand
+ * @return JSONB object
+ */
+static Jsonb *message_to_jsonb(const AISMessage *msg, const AISPayloadView *first) {
+    JsonbParseState *state = NULL;
+    int64 lon, lat;
+
+    pushJsonbValue(&state, WJB_BEGIN_OBJECT, NULL);
+    ADD_NUMERIC_FIELD("mmsi", msg->mmsi);
+    if (message_position(first, msg, &lon, &lat)) {
+        JsonbValue v = {.type = jbvNumeric};
+        v.val.numeric = decimal_numeric(lat, 6);
+        push_jsonb_key(&state, "lat");
+        pushJsonbValue(&state, WJB_VALUE, &v);
+        v.val.numeric = decimal_numeric(lon, 6);
+        push_jsonb_key(&state, "lon");
+        pushJsonbValue(&state, WJB_VALUE, &v);
+    } else {
+        ADD_NULL_FIELD("lat");
+        ADD_NULL_FIELD("lon");
+    }
+    if (msg->speed >= 0) ADD_FLOAT_FIELD("speed", msg->speed, 1);
+    else ADD_NULL_FIELD("speed");
+    if (msg->heading >= 0) ADD_FLOAT_FIELD("heading", msg->heading, 0);
+    else ADD_NULL_FIELD("heading");
+
+    return JsonbValueToJsonb(pushJsonbValue(&state, WJB_END_OBJECT, NULL));
+}
+
+
+/**
+ * @brief Locate the payload of an ais value, timed as the tokenize stage
+ *
+ * @param input Sentence value
+ * @param view Output view
+ * @return false if the sentence is malformed
+ */
+static bool payload_view_timed(const ais *input, AISPayloadView *view) {
+    uint64 started = PG_AIS_TIMING_START();
+    bool ok = ais_payload_view(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), view);
+    PG_AIS_TIMING_END(AIS_STAGE_TOKENIZE, ok && view->total == 1 ? ais_view_type(view) : 0, started);
+    return ok;
+}
+
+
+/**
+ * @brief Decode an ais value and return its core fields as JSONB
+ *
+ * Single-part sentences are decoded straight from the varlena. Fragments of
+ * multipart messages are buffered until the message is complete; NULL is
+ * returned for every fragment but the last.
+ *
+ * Usage: SELECT pg_ais_parse(sentence);
  */
 PG_FUNCTION_INFO_V1(pg_ais_parse);
 Datum
 pg_ais_parse(PG_FUNCTION_ARGS) {
-    if (PG_ARGISNULL(0)) PG_RETURN_NULL();
-
-    const ais *input = (ais *) PG_GETARG_POINTER(0);
-    if (VARSIZE_ANY_EXHDR(input) <= 0) PG_RETURN_NULL();
+    ais *input = PG_GETARG_AIS_PP(0);
+    AISPayloadView view;
+
+    if (!payload_view_timed(input, &view)) PG_RETURN_NULL();
+
+    if (view.total == 1) {
+        AISMessage msg = {0};
+        if (!parse_ais_view(&msg, &view).ok) {
+            free_ais_message(&msg);
+            PG_RETURN_NULL();
+        }
+        uint64 started = PG_AIS_TIMING_START();
+        Jsonb *result = message_to_jsonb(&msg, &view);
+        PG_AIS_TIMING_END(AIS_STAGE_OUTPUT, msg.type, started);
+        free_ais_message(&msg);
+        PG_RETURN_JSONB_P(result);
+    }
 
     char *cstr = ais_to_cstring(input);
     if (!cstr) PG_RETURN_NULL();
@@ -110,24 +347,20 @@ pg_ais_parse(PG_FUNCTION_ARGS) {
     frag_buffer.parts[idx] = frag;
     frag_buffer.received++;
 
-    AISMessage msg;
+    AISMessage msg = {0};
     if (!try_reassemble(&frag_buffer, &msg)) {
         AIS_FREE(cstr);
         PG_RETURN_NULL();
     }
 
     reset_buffer(&frag_buffer);
-
-    StringInfoData json;
-    initStringInfo(&json);
-    appendStringInfo(&json, "{\"mmsi\":%d,\"lat\":%f,\"lon\":%f,\"speed\":%f,\"heading\":%f}",
-                     msg.mmsi, msg.lat, msg.lon, msg.speed, msg.heading);
-
     AIS_FREE(cstr);
-    free_ais_message(&msg);
 
-    Datum result = DirectFunctionCall1(jsonb_in, CStringGetDatum(json.data));
-    PG_RETURN_DATUM(result);
+    uint64 started = PG_AIS_TIMING_START();
+    Jsonb *result = message_to_jsonb(&msg, NULL);
+    PG_AIS_TIMING_END(AIS_STAGE_OUTPUT, msg.type, started);
+    free_ais_message(&msg);
+    PG_RETURN_JSONB_P(result);
 }
 
 
@@ -234,48 +467,197 @@ pg_ais_debug(PG_FUNCTION_ARGS) {
 
 
 /**
- * @brief Return a set of named fields for a given AIS message
+ * @brief Return the set of ais_fields columns decoded for a message
+ *
+ * Columns outside the set are returned as NULL rather than as zero or an
+ * empty string, so "no data" is distinguishable from a real zero. Only
+ * part B of a type 24 decodes a call sign, which tells the parts apart.
+ *
+ * @param msg Decoded message
+ * @param type Message type from the payload (0–63)
+ * @return Bitmask of F_* columns
+ */
+uint64 ais_fields_present(const AISMessage *msg, int type) {
+    switch (type) {
+        case 1: case 2: case 3: return FIELDS_CLASS_A;
+        case 4: case 11: return FIELDS_BASE;
+        case 5: return FIELDS_STATIC;
+        case 9: return FIELDS_SAR;
+        case 18: return FIELDS_CLASS_B;
+        case 19: return FIELDS_CLASS_B_EXTENDED;
+        case 24: return msg->callsign ? FIELDS_STATIC_B_PART_B : FIELDS_STATIC_B_PART_A;
+        case 21: case 27: return FIELDS_COMMON | FIELDS_POSITION;
+        default: return FIELDS_COMMON;
+    }
+}
+
+
+/**
+ * @brief Build a text datum in a caller-provided buffer
+ *
+ * Uses a 1-byte varlena header when the string fits, so heap_form_tuple()
+ * copies it straight into the tuple and the row costs a single allocation.
+ *
+ * @param buf Scratch buffer of at least INLINE_TEXT_MAX bytes
+ * @param str String bytes (need not be NUL-terminated)
+ * @param len Number of bytes; truncated to fit the buffer
+ * @return Datum pointing into buf
+ */
+static Datum inline_bytes_datum(char *buf, const char *str, size_t len) {
+    if (len > INLINE_TEXT_MAX - VARHDRSZ) len = INLINE_TEXT_MAX - VARHDRSZ;
+
+    if (len + VARHDRSZ_SHORT <= VARATT_SHORT_MAX) {
+        SET_VARSIZE_SHORT(buf, len + VARHDRSZ_SHORT);
+        memcpy(buf + VARHDRSZ_SHORT, str, len);
+    } else {
+        SET_VARSIZE(buf, len + VARHDRSZ);
+        memcpy(buf + VARHDRSZ, str, len);
+    }
+    return PointerGetDatum(buf);
+}
+
+
+/**
+ * @brief Build a text datum from a decoded string in a caller-provided buffer
+ *
+ * @param buf Scratch buffer of at least INLINE_TEXT_MAX bytes
+ * @param str Decoded string
+ * @return Datum pointing into buf
+ */
+static Datum inline_text_datum(char *buf, const char *str) {
+    return inline_bytes_datum(buf, str, strnlen(str, INLINE_TEXT_MAX - VARHDRSZ));
+}
+
+
+/**
+ * @brief Fill ais_fields column values for a decoded message
+ *
+ * Text columns are built in textbuf, so the caller controls their lifetime.
+ * Strings are present only when decoded and non-empty.
+ *
+ * @param msg Decoded message
+ * @param type Message type from the payload
+ * @param values Output column values (F_NUM_FIELDS entries)
+ * @param nulls Output null flags (F_NUM_FIELDS entries)
+ * @param textbuf Scratch buffer of AIS_FIELDS_TEXT_BUFSIZE bytes
+ */
+void ais_fields_datums(const AISMessage *msg, int type, Datum *values, bool *nulls, char *textbuf) {
+    uint64 present = ais_fields_present(msg, type);
+
+    values[F_TYPE] = Int32GetDatum(type);
+    values[F_MMSI] = Int32GetDatum(msg->mmsi);
+    values[F_NAV_STATUS] = Int32GetDatum(msg->nav_status);
+    values[F_LAT] = Float8GetDatum(msg->lat);
+    values[F_LON] = Float8GetDatum(msg->lon);
+    values[F_SPEED] = Float8GetDatum(msg->speed);
+    values[F_HEADING] = Float8GetDatum(msg->heading);
+    values[F_COURSE] = Float8GetDatum(msg->course);
+    values[F_TIMESTAMP] = Int32GetDatum(msg->timestamp);
+    values[F_IMO] = Int32GetDatum(msg->imo);
+    values[F_CALLSIGN] = (Datum) 0;
+    values[F_VESSEL_NAME] = (Datum) 0;
+    values[F_SHIP_TYPE] = Int32GetDatum(msg->ship_type);
+    values[F_DESTINATION] = (Datum) 0;
+    values[F_DRAUGHT] = Float8GetDatum(msg->draught);
+    values[F_MANEUVER] = Int32GetDatum(msg->maneuver);
+    values[F_FIX_TYPE] = Int32GetDatum(msg->fix_type);
+    values[F_RADIO] = Int32GetDatum(msg->radio);
+    values[F_REPEAT] = Int32GetDatum(msg->repeat);
+    values[F_RAIM] = BoolGetDatum(msg->raim);
+
+    if (msg->callsign && msg->callsign[0]) {
+        values[F_CALLSIGN] = inline_text_datum(textbuf, msg->callsign);
+        present |= FIELD(F_CALLSIGN);
+    } else {
+        present &= ~FIELD(F_CALLSIGN);
+    }
+    if (msg->vessel_name && msg->vessel_name[0]) {
+        values[F_VESSEL_NAME] = inline_text_datum(textbuf + INLINE_TEXT_MAX, msg->vessel_name);
+        present |= FIELD(F_VESSEL_NAME);
+    } else {
+        present &= ~FIELD(F_VESSEL_NAME);
+    }
+    if (msg->destination && msg->destination[0]) {
+        values[F_DESTINATION] = inline_text_datum(textbuf + 2 * INLINE_TEXT_MAX, msg->destination);
+        present |= FIELD(F_DESTINATION);
+    } else {
+        present &= ~FIELD(F_DESTINATION);
+    }
+
+    for (int i = 0; i < F_NUM_FIELDS; i++)
+        nulls[i] = (present & FIELD(i)) == 0;
+}
+
+
+/**
+ * @brief Fill the tag block columns (station, receive_time, line_count)
+ *
+ * Tags the receiver did not send stay NULL. The station is built in the
+ * fourth INLINE_TEXT_MAX slot of textbuf.
+ *
+ * @param tags Tag block of the message, or NULL if it had none
+ * @param values Output column values (F_NUM_FIELDS entries)
+ * @param nulls Output null flags (F_NUM_FIELDS entries)
+ * @param textbuf Scratch buffer of AIS_FIELDS_TEXT_BUFSIZE bytes
+ */
+void ais_tag_datums(const AISTagBlock *tags, Datum *values, bool *nulls, char *textbuf) {
+    nulls[F_STATION] = !tags || tags->station_len == 0;
+    nulls[F_RECEIVE_TIME] = !tags || tags->receive_time == 0;
+    nulls[F_LINE_COUNT] = !tags || tags->line_count == 0;
+
+    if (!nulls[F_STATION])
+        values[F_STATION] = inline_bytes_datum(textbuf + 3 * INLINE_TEXT_MAX, tags->station, tags->station_len);
+    if (!nulls[F_RECEIVE_TIME])
+        values[F_RECEIVE_TIME] = TimestampTzGetDatum(time_t_to_timestamptz((pg_time_t) tags->receive_time));
+    if (!nulls[F_LINE_COUNT])
+        values[F_LINE_COUNT] = Int32GetDatum(tags->line_count);
+}
+
+
+/**
+ * @brief Return the decoded fields of an AIS message as one ais_fields row
+ *
+ * The blessed result TupleDesc is cached in fn_extra, text columns are built
+ * in place from the decoded strings, and columns the message type does not
+ * carry are NULL. Returns NULL for sentences that cannot be decoded on their
+ * own (malformed input or a fragment of a multipart message).
  *
- * This is a set-returning function (SRF) that returns key/value pairs.
+ * Usage: SELECT (pg_ais_fields(sentence)).*;
  */
 PG_FUNCTION_INFO_V1(pg_ais_fields);
 Datum
 pg_ais_fields(PG_FUNCTION_ARGS) {
-    text *txt = PG_GETARG_TEXT_PP(0);
-    char *input = text_to_cstring(txt);
+    ais *input = PG_GETARG_AIS_PP(0);
+    TupleDesc tupdesc = (TupleDesc) fcinfo->flinfo->fn_extra;
+
+    if (tupdesc == NULL) {
+        TupleDesc resdesc;
+        if (get_call_result_type(fcinfo, NULL, &resdesc) != TYPEFUNC_COMPOSITE)
+            ereport(ERROR, (errmsg("return type must be a row type")));
+
+        MemoryContext oldcxt = MemoryContextSwitchTo(fcinfo->flinfo->fn_mcxt);
+        tupdesc = BlessTupleDesc(CreateTupleDescCopy(resdesc));
+        MemoryContextSwitchTo(oldcxt);
+        fcinfo->flinfo->fn_extra = tupdesc;
+    }
+    if (tupdesc->natts != F_NUM_FIELDS)
+        ereport(ERROR, (errmsg("ais_fields must have %d columns", F_NUM_FIELDS)));
 
-    AISMessage msg;
-    if (!parse_ais_from_text(input, &msg)) {
-        ereport(ERROR, (errmsg("invalid AIS message")));
+    AISPayloadView view;
+    if (!ais_payload_view(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), &view)) PG_RETURN_NULL();
+
+    AISMessage msg = {0};
+    if (!parse_ais_view(&msg, &view).ok) {
+        free_ais_message(&msg);
+        PG_RETURN_NULL();
     }
 
-    TupleDesc tupdesc;
-    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
-        ereport(ERROR, (errmsg("return type must be a row type")));
-
-    Datum values[20];
-    bool nulls[20] = {false};
-
-    values[0] = Int32GetDatum(msg.type);
-    values[1] = Int32GetDatum(msg.mmsi);
-    values[2] = Int32GetDatum(msg.nav_status);
-    values[3] = Float8GetDatum(msg.lat);
-    values[4] = Float8GetDatum(msg.lon);
-    values[5] = Float8GetDatum(msg.speed);
-    values[6] = Float8GetDatum(msg.heading);
-    values[7] = Float8GetDatum(msg.course);
-    values[8] = Int32GetDatum(msg.timestamp);
-    values[9] = Int32GetDatum(msg.imo);
-    values[10] = CStringGetTextDatum(msg.callsign ? msg.callsign : "");
-    values[11] = CStringGetTextDatum(msg.vessel_name ? msg.vessel_name : "");
-    values[12] = Int32GetDatum(msg.ship_type);
-    values[13] = CStringGetTextDatum(msg.destination ? msg.destination : "");
-    values[14] = Float8GetDatum(msg.draught);
-    values[15] = Int32GetDatum(msg.maneuver);
-    values[16] = Int32GetDatum(msg.fix_type);
-    values[17] = Int32GetDatum(msg.radio);
-    values[18] = Int32GetDatum(msg.repeat);
-    values[19] = BoolGetDatum(msg.raim);
+    Datum values[F_NUM_FIELDS];
+    bool nulls[F_NUM_FIELDS];
+    char textbuf[AIS_FIELDS_TEXT_BUFSIZE];
+
+    ais_fields_datums(&msg, ais_view_type(&view), values, nulls, textbuf);
+    ais_tag_datums(&view.tags, values, nulls, textbuf);
 
     HeapTuple tuple = heap_form_tuple(tupdesc, values, nulls);
     free_ais_message(&msg);
@@ -283,47 +665,236 @@ pg_ais_fields(PG_FUNCTION_ARGS) {
 }
 
 
+/* Column names of the ais_fields composite type, in column order */
+const char *const ais_field_names[F_NUM_FIELDS] = {
+    "type", "mmsi", "nav_status", "lat", "lon", "speed", "heading", "course",
+    "timestamp", "imo", "callsign", "vessel_name", "ship_type", "destination",
+    "draught", "maneuver", "fix_type", "radio", "repeat", "raim",
+    "station", "receive_time", "line_count"
+};
+
+
 /**
- * @brief Alias for pg_ais_point() for PostGIS geometry
+ * @brief Parse the tag block of an ais datum in place
+ *
+ * @param input Detoasted ais varlena
+ * @param tags Output tags pointing into input
+ * @return false if the tag block is malformed
  */
-PG_FUNCTION_INFO_V1(pg_ais_point);
+static bool ais_tags(const ais *input, AISTagBlock *tags) {
+    size_t consumed;
+    return ais_tag_block_view(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), tags, &consumed);
+}
+
+
+/**
+ * @brief Return the source station ("s:") of the sentence's tag block
+ *
+ * Usage: SELECT pg_ais_station(sentence);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_station);
 Datum
-pg_ais_point(PG_FUNCTION_ARGS) {
-    bytea *raw = PG_GETARG_BYTEA_P(0);
-    AISMessage msg;
+pg_ais_station(PG_FUNCTION_ARGS) {
+    ais *input = PG_GETARG_AIS_PP(0);
+    AISTagBlock tags;
 
-    if (!parse_ais_message(raw, &msg)) {
-        PG_RETURN_NULL();
+    if (!ais_tags(input, &tags) || tags.station_len == 0) PG_RETURN_NULL();
+    PG_RETURN_TEXT_P(cstring_to_text_with_len(tags.station, tags.station_len));
+}
+
+
+/**
+ * @brief Return the receive time ("c:") of the sentence's tag block
+ *
+ * Usage: SELECT pg_ais_receive_time(sentence);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_receive_time);
+Datum
+pg_ais_receive_time(PG_FUNCTION_ARGS) {
+    ais *input = PG_GETARG_AIS_PP(0);
+    AISTagBlock tags;
+
+    if (!ais_tags(input, &tags) || tags.receive_time == 0) PG_RETURN_NULL();
+    PG_RETURN_TIMESTAMPTZ(time_t_to_timestamptz((pg_time_t) tags.receive_time));
+}
+
+
+/**
+ * @brief Return the receiver line count ("n:") of the sentence's tag block
+ *
+ * Usage: SELECT pg_ais_line_count(sentence);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_line_count);
+Datum
+pg_ais_line_count(PG_FUNCTION_ARGS) {
+    ais *input = PG_GETARG_AIS_PP(0);
+    AISTagBlock tags;
+
+    if (!ais_tags(input, &tags) || tags.line_count == 0) PG_RETURN_NULL();
+    PG_RETURN_INT32(tags.line_count);
+}
+
+
+/**
+ * @brief Build a JSONB object with every field decoded for the message type
+ *
+ * Uses the same per-type field set as pg_ais_fields(), plus the accuracy
+ * flag, rate of turn, binary length and the text of safety messages where
+ * the decoder provides them. "Not available" sentinels become JSON null.
+ *
+ * @param msg   Decoded message
+ * @param type  Message type from the payload
+ * @param first First fragment view (ordered by sequence number)
+ * @return JSONB object
+ */
+static Jsonb *message_to_jsonb_full(const AISMessage *msg, int type, const AISPayloadView *first) {
+    JsonbParseState *state = NULL;
+    uint64 present = ais_fields_present(msg, type);
+    int64 lon, lat;
+    bool has_position = message_position(first, msg, &lon, &lat);
+
+    pushJsonbValue(&state, WJB_BEGIN_OBJECT, NULL);
+    for (int f = 0; f < F_NUM_FIELDS; f++) {
+        const char *key = ais_field_names[f];
+        if ((present & FIELD(f)) == 0) continue;
+
+        switch (f) {
+            case F_TYPE: ADD_NUMERIC_FIELD(key, type); break;
+            case F_MMSI: ADD_NUMERIC_FIELD(key, msg->mmsi); break;
+            case F_NAV_STATUS: ADD_NUMERIC_FIELD(key, msg->nav_status); break;
+            case F_LAT:
+            case F_LON:
+                if (has_position) {
+                    JsonbValue v = {.type = jbvNumeric};
+                    v.val.numeric = decimal_numeric(f == F_LAT ? lat : lon, 6);
+                    push_jsonb_key(&state, key);
+                    pushJsonbValue(&state, WJB_VALUE, &v);
+                } else {
+                    ADD_NULL_FIELD(key);
+                }
+                break;
+            case F_SPEED:
+                if (msg->speed >= 0) ADD_FLOAT_FIELD(key, msg->speed, 1);
+                else ADD_NULL_FIELD(key);
+                break;
+            case F_HEADING:
+                if (msg->heading >= 0) ADD_FLOAT_FIELD(key, msg->heading, 0);
+                else ADD_NULL_FIELD(key);
+                break;
+            case F_COURSE:
+                if (msg->course >= 0) ADD_FLOAT_FIELD(key, msg->course, 1);
+                else ADD_NULL_FIELD(key);
+                break;
+            case F_TIMESTAMP:
+                if (msg->timestamp < 60) ADD_NUMERIC_FIELD(key, msg->timestamp);
+                else ADD_NULL_FIELD(key);
+                break;
+            case F_IMO: ADD_NUMERIC_FIELD(key, msg->imo); break;
+            case F_CALLSIGN: ADD_STRING_FIELD(key, msg->callsign); break;
+            case F_VESSEL_NAME: ADD_STRING_FIELD(key, msg->vessel_name); break;
+            case F_SHIP_TYPE: ADD_NUMERIC_FIELD(key, msg->ship_type); break;
+            case F_DESTINATION: ADD_STRING_FIELD(key, msg->destination); break;
+            case F_DRAUGHT: ADD_FLOAT_FIELD(key, msg->draught, 1); break;
+            case F_MANEUVER: ADD_NUMERIC_FIELD(key, msg->maneuver); break;
+            case F_FIX_TYPE: ADD_NUMERIC_FIELD(key, msg->fix_type); break;
+            case F_RADIO: ADD_NUMERIC_FIELD(key, msg->radio); break;
+            case F_REPEAT: ADD_NUMERIC_FIELD(key, msg->repeat); break;
+            case F_RAIM: ADD_BOOL_FIELD(key, msg->raim); break;
+        }
     }
 
-    if (msg.lat < -90 || msg.lat > 90 || msg.lon < -180 || msg.lon > 180) {
+    switch (type) {
+        case 1: case 2: case 3:
+            ADD_NUMERIC_FIELD("rot", msg->rot);
+            ADD_BOOL_FIELD("accuracy", msg->accuracy);
+            break;
+        case 4: case 11: case 18: case 19:
+            ADD_BOOL_FIELD("accuracy", msg->accuracy);
+            break;
+        case 6: case 8: case 17: case 25: case 26:
+            ADD_NUMERIC_FIELD("bin_len", msg->bin_len);
+            break;
+        case 12: case 14:
+            /* The safety text is decoded into the vessel_name slot */
+            ADD_STRING_FIELD("text", msg->vessel_name);
+            break;
+    }
+
+    return JsonbValueToJsonb(pushJsonbValue(&state, WJB_END_OBJECT, NULL));
+}
+
+
+/**
+ * @brief Return every decoded field of a single-part message as JSONB
+ *
+ * Returns NULL for malformed input or a fragment of a multipart message;
+ * use the ais[] form for those.
+ *
+ * Usage: SELECT pg_ais_parse_full(sentence);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_parse_full);
+Datum
+pg_ais_parse_full(PG_FUNCTION_ARGS) {
+    ais *input = PG_GETARG_AIS_PP(0);
+    AISPayloadView view;
+
+    if (!payload_view_timed(input, &view)) PG_RETURN_NULL();
+
+    AISMessage msg = {0};
+    if (!parse_ais_view(&msg, &view).ok) {
         free_ais_message(&msg);
         PG_RETURN_NULL();
     }
 
-    POINT *point = palloc(sizeof(POINT));
-    point->x = msg.lon;
-    point->y = msg.lat;
-
+    uint64 started = PG_AIS_TIMING_START();
+    Jsonb *result = message_to_jsonb_full(&msg, ais_view_type(&view), &view);
+    PG_AIS_TIMING_END(AIS_STAGE_OUTPUT, msg.type, started);
     free_ais_message(&msg);
-    PG_RETURN_POINT_P(point);
+    PG_RETURN_JSONB_P(result);
 }
 
 
-// WKB currently big-endian; future support for LE should be considered
-// TODO: Add byte-order handling (endianness detection) if needed
 /**
- * @brief Alias for pg_ais_point() for PostGIS geometry
+ * @brief Return every decoded field of a reassembled multipart message as JSONB
+ *
+ * Usage: SELECT pg_ais_parse_full(ARRAY[part1, part2]);
  */
-PG_FUNCTION_INFO_V1(pg_ais_point_geom);
+PG_FUNCTION_INFO_V1(pg_ais_parse_full_parts);
 Datum
-pg_ais_point_geom(PG_FUNCTION_ARGS) {
-    text *txt = PG_GETARG_TEXT_PP(0);
-    char *input = text_to_cstring(txt);
+pg_ais_parse_full_parts(PG_FUNCTION_ARGS) {
+    ArrayType *arr = PG_GETARG_ARRAYTYPE_P(0);
+    AISPayloadView parts[MAX_PARTS];
+
+    int nparts = pg_ais_collect_fragments(arr, parts);
+    if (nparts < 0) PG_RETURN_NULL();
+
+    AISMessage msg = {0};
+    if (!parse_ais_views(&msg, parts, nparts).ok) {
+        free_ais_message(&msg);
+        PG_RETURN_NULL();
+    }
+
+    uint64 started = PG_AIS_TIMING_START();
+    Jsonb *result = message_to_jsonb_full(&msg, ais_view_type(&parts[0]), &parts[0]);
+    PG_AIS_TIMING_END(AIS_STAGE_OUTPUT, msg.type, started);
+    free_ais_message(&msg);
+    PG_RETURN_JSONB_P(result);
+}
 
+
+/**
+ * @brief Return the position as a native point (lon, lat)
+ *
+ * For PostGIS use pg_ais_geometry() or pg_ais_ewkb() instead.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_point);
+Datum
+pg_ais_point(PG_FUNCTION_ARGS) {
+    bytea *raw = PG_GETARG_BYTEA_P(0);
     AISMessage msg;
-    if (!parse_ais_from_text(input, &msg)) {
-        ereport(ERROR, (errmsg("invalid AIS message")));
+
+    if (!parse_ais_message(raw, &msg)) {
+        PG_RETURN_NULL();
     }
 
     if (msg.lat < -90 || msg.lat > 90 || msg.lon < -180 || msg.lon > 180) {
@@ -331,18 +902,12 @@ pg_ais_point_geom(PG_FUNCTION_ARGS) {
         PG_RETURN_NULL();
     }
 
-    // WKB format: https://en.wikipedia.org/wiki/Well-known_text_representation_of_geometry#Well-known_binary
-    // SRID: 4326, GeometryType: 1 (Point)
-    uint8_t wkb[21] = {0x00}; // Big endian
-    wkb[0] = 0;               // big endian
-    wkb[1] = 0; wkb[2] = 0; wkb[3] = 0; wkb[4] = 0; // type placeholder
-    wkb[1] = 0x00; wkb[2] = 0x00; wkb[3] = 0x00; wkb[4] = 0x01; // WKBPoint
-
-    memcpy(&wkb[5], &msg.lon, 8);
-    memcpy(&wkb[13], &msg.lat, 8);
+    POINT *point = palloc(sizeof(POINT));
+    point->x = msg.lon;
+    point->y = msg.lat;
 
     free_ais_message(&msg);
-    PG_RETURN_BYTEA_P(cstring_to_text_with_len((const char *)wkb, sizeof(wkb)));
+    PG_RETURN_POINT_P(point);
 }
 
 
@@ -464,33 +1029,6 @@ pg_ais_get_bool_field(PG_FUNCTION_ARGS) {
 /* Internal utility functions. */
 
 
-/**
- * @brief Free heap-allocated components of an AISMessage struct
- *
- * Releases memory from dynamic fields (callsign, vessel_name, destination, bin_data).
- *
- * @param msg Pointer to AISMessage with heap fields to release
- */
-void free_ais_message(AISMessage *msg) {
-    if (msg->callsign) {
-        free(msg->callsign);
-        msg->callsign = NULL;
-    }
-    if (msg->vessel_name) {
-        free(msg->vessel_name);
-        msg->vessel_name = NULL;
-    }
-    if (msg->destination) {
-        free(msg->destination);
-        msg->destination = NULL;
-    }
-    if (msg->bin_data) {
-        free(msg->bin_data);
-        msg->bin_data = NULL;
-    }
-}
-
-
 /**
  * @brief Convert navigation status code to descriptive string
  *
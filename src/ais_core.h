@@ -1,6 +1,9 @@
 #ifndef AIS_CORE_H
 #define AIS_CORE_H
 
+#include "postgres.h"
+#include "utils/jsonb.h"
+
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -72,6 +75,7 @@ typedef struct {
     uint8_t eta_minute;
     float draught;
     char *destination;
+    uint8_t static_fields;  // AIS_STATIC_* bits a type 5, 19 or 24 carries
 } AISMessage;
 
 
@@ -0,0 +1,21 @@
+#ifndef AIS_HASH_H
+#define AIS_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @brief Fast non-cryptographic 64-bit hash (XXH64 algorithm)
+ *
+ * Used for payload deduplication and the ais hash opclass. Self-contained so
+ * that the benchmark and unit tests can use it without linking PostgreSQL.
+ *
+ * @param data Bytes to hash
+ * @param len Number of bytes
+ * @param seed Hash seed (0 for the canonical value)
+ * @return 64-bit hash value
+ */
+uint64_t ais_hash64(const void *data, size_t len, uint64_t seed);
+
+#endif
@@ -0,0 +1,75 @@
+#include "ais_histogram.h"
+
+#include <math.h>
+
+
+/**
+ * @brief Index of the highest set bit of a non-zero value
+ */
+static inline int highest_bit(uint64_t v) {
+    return 63 - __builtin_clzll(v);
+}
+
+
+/**
+ * @brief Log-linear bucket of a value
+ *
+ * @param value Value to count, e.g. nanoseconds
+ * @return Bucket index below AIS_HISTOGRAM_BUCKETS
+ */
+int ais_histogram_bucket(uint64_t value) {
+    if (value < AIS_HISTOGRAM_SUB) return (int)value;
+
+    int exp = highest_bit(value);
+    if (exp >= AIS_HISTOGRAM_MAX_BITS) return AIS_HISTOGRAM_BUCKETS - 1;
+
+    int sub = (int)(value >> (exp - AIS_HISTOGRAM_SUB_BITS)) - AIS_HISTOGRAM_SUB;
+    return (exp - AIS_HISTOGRAM_SUB_BITS + 1) * AIS_HISTOGRAM_SUB + sub;
+}
+
+
+/**
+ * @brief Smallest value counted in a bucket
+ */
+uint64_t ais_histogram_lower(int bucket) {
+    if (bucket < AIS_HISTOGRAM_SUB) return (uint64_t)bucket;
+
+    int octave = bucket / AIS_HISTOGRAM_SUB;
+    uint64_t sub = (uint64_t)(bucket % AIS_HISTOGRAM_SUB);
+    return (AIS_HISTOGRAM_SUB + sub) << (octave - 1);
+}
+
+
+/**
+ * @brief Smallest value counted in the next bucket
+ */
+uint64_t ais_histogram_upper(int bucket) {
+    if (bucket < AIS_HISTOGRAM_SUB) return (uint64_t)bucket + 1;
+    return ais_histogram_lower(bucket) + ((uint64_t)1 << (bucket / AIS_HISTOGRAM_SUB - 1));
+}
+
+
+/**
+ * @brief Estimate a quantile from bucket counts
+ *
+ * @param counts AIS_HISTOGRAM_BUCKETS counts
+ * @param q Quantile in [0, 1], e.g. 0.99
+ * @return Midpoint of the bucket holding the quantile, or 0 if all counts are zero
+ */
+double ais_histogram_quantile(const uint64_t *counts, double q) {
+    uint64_t total = 0;
+
+    for (int i = 0; i < AIS_HISTOGRAM_BUCKETS; i++) total += counts[i];
+    if (total == 0) return 0;
+
+    /* 1-based rank of the smallest value with q of the counts at or below it */
+    double want = ceil(q * (double)total);
+    uint64_t rank = want < 1 ? 1 : want > (double)total ? total : (uint64_t)want;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < AIS_HISTOGRAM_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) return ((double)ais_histogram_lower(i) + (double)ais_histogram_upper(i)) / 2.0;
+    }
+    return 0;
+}
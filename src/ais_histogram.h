@@ -0,0 +1,52 @@
+#ifndef AIS_HISTOGRAM_H
+#define AIS_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* Linear sub-buckets per power of two: relative error at most 1/8 */
+#define AIS_HISTOGRAM_SUB_BITS 3
+#define AIS_HISTOGRAM_SUB (1 << AIS_HISTOGRAM_SUB_BITS)
+
+/* Values of 2^32 and more (about 4.3 s in nanoseconds) share the last bucket */
+#define AIS_HISTOGRAM_MAX_BITS 32
+
+#define AIS_HISTOGRAM_BUCKETS ((AIS_HISTOGRAM_MAX_BITS - AIS_HISTOGRAM_SUB_BITS + 1) * AIS_HISTOGRAM_SUB)
+
+
+/**
+ * @brief Log-linear bucket of a value
+ *
+ * Values below AIS_HISTOGRAM_SUB get a bucket each; above, every power of
+ * two is split into AIS_HISTOGRAM_SUB equal buckets. Self-contained so the
+ * unit tests and benchmarks can use it without linking PostgreSQL.
+ *
+ * @param value Value to count, e.g. nanoseconds
+ * @return Bucket index below AIS_HISTOGRAM_BUCKETS
+ */
+int ais_histogram_bucket(uint64_t value);
+
+
+/**
+ * @brief Smallest value counted in a bucket
+ */
+uint64_t ais_histogram_lower(int bucket);
+
+
+/**
+ * @brief Smallest value counted in the next bucket
+ */
+uint64_t ais_histogram_upper(int bucket);
+
+
+/**
+ * @brief Estimate a quantile from bucket counts
+ *
+ * @param counts AIS_HISTOGRAM_BUCKETS counts
+ * @param q Quantile in [0, 1], e.g. 0.99
+ * @return Midpoint of the bucket holding the quantile, or 0 if all counts are zero
+ */
+double ais_histogram_quantile(const uint64_t *counts, double q);
+
+#endif
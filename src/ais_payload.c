@@ -0,0 +1,551 @@
+#include "ais_payload.h"
+#include <string.h>
+
+
+/**
+ * @brief Convert a 6-bit armoring character to its numeric value
+ *
+ * Valid characters are '0'–'W' (48–87) and '`'–'w' (96–119).
+ *
+ * @param c Input character from AIS payload
+ * @return Value from 0–63, or -1 if the character is not valid armoring
+ */
+static inline int sixbit_value(char c) {
+    if (c < 48 || c > 119 || (c > 87 && c < 96)) return -1;
+    c -= 48;
+    if (c > 40) c -= 8;
+    return c;
+}
+
+
+/**
+ * @brief Parse a small non-negative decimal field
+ *
+ * @param s Field start
+ * @param len Field length
+ * @param fallback Value returned for an empty field
+ * @return Parsed value, or -1 if the field contains non-digits
+ */
+static int parse_small_int(const char *s, int len, int fallback) {
+    if (len == 0) return fallback;
+    int v = 0;
+    for (int i = 0; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9') return -1;
+        v = v * 10 + (s[i] - '0');
+    }
+    return v;
+}
+
+
+/**
+ * @brief Parse a decimal tag value
+ *
+ * @param s Value start
+ * @param len Value length
+ * @param out Output value
+ * @return false if the value is empty, too long or contains non-digits
+ */
+static bool parse_tag_int(const char *s, int len, int64_t *out) {
+    if (len == 0 || len > 18) return false;
+    int64_t v = 0;
+    for (int i = 0; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9') return false;
+        v = v * 10 + (s[i] - '0');
+    }
+    *out = v;
+    return true;
+}
+
+
+/**
+ * @brief Convert a hexadecimal digit to its value
+ *
+ * @param c Input character
+ * @return Value from 0–15, or -1 if c is not a hex digit
+ */
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+
+/**
+ * @brief Parse the tag blocks in front of a sentence without copying
+ *
+ * Recognizes the source station ("s:"), receive time ("c:", seconds or
+ * milliseconds) and line count ("n:"); other tags are skipped. A line that
+ * does not start with '\\' has no tag block and consumes nothing.
+ *
+ * @param line Raw line bytes
+ * @param len Number of bytes in line
+ * @param tags Output tag values pointing into line
+ * @param consumed Output number of tag block bytes before the sentence
+ * @return false if a tag block is unterminated or fails its "*hh" checksum
+ */
+bool ais_tag_block_view(const char *line, size_t len, AISTagBlock *tags, size_t *consumed) {
+    const char *p = line;
+    const char *end = line + len;
+
+    memset(tags, 0, sizeof(*tags));
+    while (p < end && *p == '\\') {
+        const char *start = ++p;
+        const char *close = memchr(start, '\\', (size_t)(end - start));
+        if (!close) return false;
+
+        /* Checksum covers the bytes between '\\' and '*' */
+        const char *star = memchr(start, '*', (size_t)(close - start));
+        const char *fields_end = star ? star : close;
+        if (star) {
+            unsigned char sum = 0;
+            for (const char *c = start; c < star; c++) sum ^= (unsigned char)*c;
+            if (close - star != 3) return false;
+            int hi = hex_value(star[1]);
+            int lo = hex_value(star[2]);
+            if (hi < 0 || lo < 0 || sum != (unsigned char)((hi << 4) | lo)) return false;
+        }
+
+        while (start < fields_end) {
+            const char *comma = memchr(start, ',', (size_t)(fields_end - start));
+            const char *field_end = comma ? comma : fields_end;
+            int value_len = (int)(field_end - start) - 2;
+            int64_t v;
+
+            if (value_len >= 0 && start[1] == ':') {
+                const char *value = start + 2;
+                switch (start[0]) {
+                    case 's':
+                        tags->station = value;
+                        tags->station_len = value_len;
+                        break;
+                    case 'c':
+                        /* Some receivers stamp milliseconds */
+                        if (parse_tag_int(value, value_len, &v))
+                            tags->receive_time = v >= INT64_C(100000000000) ? v / 1000 : v;
+                        break;
+                    case 'n':
+                        if (parse_tag_int(value, value_len, &v) && v <= INT32_MAX)
+                            tags->line_count = (int)v;
+                        break;
+                }
+            }
+            start = field_end + 1;
+        }
+        p = close + 1;
+    }
+
+    *consumed = (size_t)(p - line);
+    return true;
+}
+
+
+/**
+ * @brief Locate the fields of an !AIVDM/!AIVDO sentence without copying
+ *
+ * Accepts any two-character talker id and leading NMEA 4.0 tag blocks. The
+ * sentence does not need to be NUL-terminated, which lets callers pass
+ * varlena data directly.
+ *
+ * @param sentence Raw sentence bytes
+ * @param len Number of bytes in sentence
+ * @param view Output view pointing into sentence
+ * @return true if the sentence has the expected field layout
+ */
+bool ais_payload_view(const char *sentence, size_t len, AISPayloadView *view) {
+    AISTagBlock tags;
+    size_t consumed = 0;
+
+    if (!sentence || !view) return false;
+    if (len > 0 && sentence[0] == '\\') {
+        if (!ais_tag_block_view(sentence, len, &tags, &consumed)) return false;
+        sentence += consumed;
+        len -= consumed;
+    }
+    if (len < 7 || sentence[0] != '!') return false;
+    if (memcmp(sentence + 3, "VDM", 3) != 0 && memcmp(sentence + 3, "VDO", 3) != 0) return false;
+
+    const char *field[7];
+    int field_len[7];
+    const char *end = sentence + len;
+    const char *p = sentence;
+    int n = 0;
+    bool starred = false;
+
+    field[0] = p;
+    while (p < end && n < 7) {
+        if (*p == ',' || *p == '*') {
+            field_len[n] = (int)(p - field[n]);
+            if (++n < 7) field[n] = p + 1;
+            if (*p == '*') {
+                starred = true;
+                break;
+            }
+        }
+        p++;
+    }
+    if (n < 7) {
+        if (n != 6 || starred) return false;
+        /* Tolerate a missing "*hh" suffix after the fill-bits field */
+        field_len[6] = (int)(end - field[6]);
+        n = 7;
+    }
+
+    view->total = parse_small_int(field[1], field_len[1], -1);
+    view->seq = parse_small_int(field[2], field_len[2], -1);
+    view->fill_bits = parse_small_int(field[6], field_len[6], 0);
+    if (view->total < 1 || view->seq < 1 || view->seq > view->total) return false;
+    if (view->fill_bits < 0 || view->fill_bits > 5) return false;
+
+    view->message_id = field[3];
+    view->message_id_len = field_len[3];
+    view->channel = field_len[4] > 0 ? field[4][0] : '\0';
+    view->payload = field[5];
+    view->len = field_len[5];
+    if (consumed > 0) view->tags = tags;
+    else memset(&view->tags, 0, sizeof(view->tags));
+    return true;
+}
+
+
+/**
+ * @brief Extract an unsigned bitfield from a payload view
+ *
+ * Reads whole 6-bit characters into a 64-bit accumulator and shifts once,
+ * instead of looping per bit.
+ *
+ * @param view Payload view
+ * @param start Bit offset (0-based)
+ * @param len Number of bits (1–32)
+ * @param out Output value
+ * @return false on bounds error or invalid armoring character
+ */
+bool ais_view_uint(const AISPayloadView *view, int start, int len, uint32_t *out) {
+    if (start < 0 || len <= 0 || len > 32 || start + len > view->len * 6) return false;
+
+    int first = start / 6;
+    int last = (start + len - 1) / 6;
+    uint64_t acc = 0;
+    for (int i = first; i <= last; i++) {
+        int v = sixbit_value(view->payload[i]);
+        if (v < 0) return false;
+        acc = (acc << 6) | (uint64_t)v;
+    }
+
+    int shift = (last - first + 1) * 6 - (start % 6) - len;
+    *out = (uint32_t)((acc >> shift) & ((UINT64_C(1) << len) - 1));
+    return true;
+}
+
+
+/**
+ * @brief Extract a two's complement signed bitfield from a payload view
+ *
+ * @param view Payload view
+ * @param start Bit offset (0-based)
+ * @param len Number of bits (1–32)
+ * @param out Output value
+ * @return false on bounds error or invalid armoring character
+ */
+bool ais_view_int(const AISPayloadView *view, int start, int len, int32_t *out) {
+    uint32_t raw;
+    if (!ais_view_uint(view, start, len, &raw)) return false;
+    if (len < 32 && ((raw >> (len - 1)) & 1))
+        raw |= ~0U << len;
+    *out = (int32_t)raw;
+    return true;
+}
+
+
+/**
+ * @brief Return the message type from the first payload character
+ *
+ * @param view Payload view
+ * @return Message type (0–63), or -1 if the payload is empty or malformed
+ */
+int ais_view_type(const AISPayloadView *view) {
+    if (!view || view->len < 1) return -1;
+    return sixbit_value(view->payload[0]);
+}
+
+
+/**
+ * @brief Extract the fixed-point position of a position-bearing message
+ *
+ * Supports types 1–3, 4, 9, 11, 18, 19, 21 and 27. Coordinates are returned in
+ * 1/10000 minute; type 27 is rescaled from its coarser 1/10 minute encoding.
+ *
+ * @param view Payload view (must be the first fragment)
+ * @param lon Output longitude
+ * @param lat Output latitude
+ * @return false if the type carries no position or the position is unavailable
+ */
+bool ais_view_position(const AISPayloadView *view, int32_t *lon, int32_t *lat) {
+    int lon_bit, lat_bit;
+
+    if (view->seq != 1) return false;
+
+    switch (ais_view_type(view)) {
+        case 1:
+        case 2:
+        case 3:
+        case 9: lon_bit = 61; lat_bit = 89; break;
+        case 4:
+        case 11: lon_bit = 79; lat_bit = 107; break;
+        case 18:
+        case 19: lon_bit = 57; lat_bit = 85; break;
+        case 21: lon_bit = 164; lat_bit = 192; break;
+        case 27: {
+            int32_t x, y;
+            if (!ais_view_int(view, 44, 18, &x) || !ais_view_int(view, 62, 17, &y)) return false;
+            if (x < -1800 * 60 || x > 1800 * 60 || y < -900 * 60 || y > 900 * 60) return false;
+            *lon = x * 1000;
+            *lat = y * 1000;
+            return true;
+        }
+        default: return false;
+    }
+
+    if (!ais_view_int(view, lon_bit, 28, lon) || !ais_view_int(view, lat_bit, 27, lat)) return false;
+    /* 181 and 91 degrees are the "not available" sentinels */
+    return *lon >= -AIS_LON_LIMIT && *lon <= AIS_LON_LIMIT &&
+           *lat >= -AIS_LAT_LIMIT && *lat <= AIS_LAT_LIMIT;
+}
+
+
+/**
+ * @brief Extract speed and course over ground in tenths
+ *
+ * @param view Payload view (must be the first fragment)
+ * @param speed Output speed in 0.1 knot, -1 if unavailable
+ * @param course Output course in 0.1 degree, -1 if unavailable
+ */
+void ais_view_motion(const AISPayloadView *view, int32_t *speed, int32_t *course) {
+    uint32_t sog, cog;
+
+    *speed = -1;
+    *course = -1;
+    if (view->seq != 1) return;
+
+    switch (ais_view_type(view)) {
+        case 1:
+        case 2:
+        case 3:
+            if (ais_view_uint(view, 50, 10, &sog) && sog != 1023) *speed = (int32_t)sog;
+            if (ais_view_uint(view, 116, 12, &cog) && cog < 3600) *course = (int32_t)cog;
+            break;
+        case 9:
+            /* Aircraft speed is in whole knots */
+            if (ais_view_uint(view, 50, 10, &sog) && sog != 1023) *speed = (int32_t)sog * 10;
+            if (ais_view_uint(view, 116, 12, &cog) && cog < 3600) *course = (int32_t)cog;
+            break;
+        case 18:
+        case 19:
+            if (ais_view_uint(view, 46, 10, &sog) && sog != 1023) *speed = (int32_t)sog;
+            if (ais_view_uint(view, 112, 12, &cog) && cog < 3600) *course = (int32_t)cog;
+            break;
+        case 27:
+            if (ais_view_uint(view, 79, 6, &sog) && sog != 63) *speed = (int32_t)sog * 10;
+            if (ais_view_uint(view, 85, 9, &cog) && cog < 360) *course = (int32_t)cog * 10;
+            break;
+        default:
+            break;
+    }
+}
+
+
+/**
+ * @brief Pack reassembled fragment payloads into a canonical bit string
+ *
+ * Concatenates the 6-bit values of every fragment, drops the fill bits of the
+ * final fragment and packs the result MSB-first with a zeroed tail. The output
+ * does not depend on talker, channel, sequence id or where the sender split
+ * the fragments, so it identifies one transmission across receivers.
+ *
+ * @param parts Fragment views ordered by sequence number
+ * @param nparts Number of fragments
+ * @param out Output buffer
+ * @param out_size Size of out in bytes
+ * @return Number of payload bits written, or -1 on malformed input or overflow
+ */
+int ais_view_pack_bits(const AISPayloadView *parts, int nparts, uint8_t *out, size_t out_size) {
+    uint32_t acc = 0;
+    int acc_bits = 0;
+    size_t pos = 0;
+    int total_bits = 0;
+
+    if (nparts < 1) return -1;
+    for (int i = 0; i < nparts; i++) total_bits += parts[i].len * 6;
+    total_bits -= parts[nparts - 1].fill_bits;
+    if (total_bits <= 0 || (size_t)(total_bits + 7) / 8 > out_size) return -1;
+
+    int remaining = total_bits;
+    for (int i = 0; i < nparts && remaining > 0; i++) {
+        for (int j = 0; j < parts[i].len && remaining > 0; j++) {
+            int v = sixbit_value(parts[i].payload[j]);
+            if (v < 0) return -1;
+            int take = remaining < 6 ? remaining : 6;
+            acc = (acc << take) | ((uint32_t)v >> (6 - take));
+            acc_bits += take;
+            remaining -= take;
+            while (acc_bits >= 8) {
+                acc_bits -= 8;
+                out[pos++] = (uint8_t)(acc >> acc_bits);
+            }
+        }
+    }
+    if (acc_bits > 0)
+        out[pos++] = (uint8_t)(acc << (8 - acc_bits));
+    return total_bits;
+}
+
+
+/**
+ * @brief Map a fixed-point longitude onto [0, 2^AIS_CURVE_BITS)
+ */
+uint32_t ais_quantize_lon(int32_t lon) {
+    if (lon < -AIS_LON_LIMIT) lon = -AIS_LON_LIMIT;
+    if (lon > AIS_LON_LIMIT) lon = AIS_LON_LIMIT;
+    return (uint32_t)(((uint64_t)(lon + AIS_LON_LIMIT) << AIS_CURVE_BITS) / (2 * (uint64_t)AIS_LON_LIMIT + 1));
+}
+
+
+/**
+ * @brief Map a fixed-point latitude onto [0, 2^AIS_CURVE_BITS)
+ */
+uint32_t ais_quantize_lat(int32_t lat) {
+    if (lat < -AIS_LAT_LIMIT) lat = -AIS_LAT_LIMIT;
+    if (lat > AIS_LAT_LIMIT) lat = AIS_LAT_LIMIT;
+    return (uint32_t)(((uint64_t)(lat + AIS_LAT_LIMIT) << AIS_CURVE_BITS) / (2 * (uint64_t)AIS_LAT_LIMIT + 1));
+}
+
+
+/**
+ * @brief Spread the low 32 bits of v so that bit i moves to bit 2i
+ */
+static inline uint64_t spread_bits(uint32_t v) {
+    uint64_t x = v;
+    x = (x | (x << 16)) & UINT64_C(0x0000FFFF0000FFFF);
+    x = (x | (x << 8)) & UINT64_C(0x00FF00FF00FF00FF);
+    x = (x | (x << 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+    x = (x | (x << 2)) & UINT64_C(0x3333333333333333);
+    x = (x | (x << 1)) & UINT64_C(0x5555555555555555);
+    return x;
+}
+
+
+/**
+ * @brief Interleave two quantized coordinates into a Morton (Z-order) key
+ *
+ * Longitude occupies the even bits and latitude the odd bits. The key is
+ * monotone in each axis, so a bounding box maps to a closed key interval.
+ *
+ * @param qx Quantized longitude
+ * @param qy Quantized latitude
+ * @return 62-bit Morton key
+ */
+uint64_t ais_morton_key(uint32_t qx, uint32_t qy) {
+    return spread_bits(qx) | (spread_bits(qy) << 1);
+}
+
+
+/**
+ * @brief Compute the Hilbert curve index of two quantized coordinates
+ *
+ * @param qx Quantized longitude
+ * @param qy Quantized latitude
+ * @param bits Curve order per axis (1–AIS_CURVE_BITS)
+ * @return Hilbert index with 2*bits significant bits
+ */
+uint64_t ais_hilbert_key(uint32_t qx, uint32_t qy, int bits) {
+    uint32_t x = qx >> (AIS_CURVE_BITS - bits);
+    uint32_t y = qy >> (AIS_CURVE_BITS - bits);
+    uint32_t n = 1U << bits;
+    uint64_t d = 0;
+
+    for (uint32_t s = n >> 1; s > 0; s >>= 1) {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += (uint64_t)s * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            uint32_t t = x;
+            x = y;
+            y = t;
+        }
+    }
+    return d;
+}
+
+
+/**
+ * @brief Bisect a fixed-point coordinate range into 2^bits cells
+ *
+ * @param v Coordinate, clamped to [-limit, limit]
+ * @param limit Half the range
+ * @param bits Number of bisections
+ * @return Cell index; the upper bound belongs to the last cell
+ */
+static uint32_t bisect_cell(int32_t v, int32_t limit, int bits) {
+    if (v < -limit) v = -limit;
+    if (v > limit) v = limit;
+    uint64_t q = ((uint64_t)(v + limit) << bits) / (2 * (uint64_t)limit);
+    uint64_t max = (UINT64_C(1) << bits) - 1;
+    return (uint32_t)(q > max ? max : q);
+}
+
+
+/**
+ * @brief Encode a fixed-point position as a geohash
+ *
+ * @param lon Fixed-point longitude
+ * @param lat Fixed-point latitude
+ * @param precision Number of characters (1–AIS_GEOHASH_MAX)
+ * @param out Output buffer of at least precision + 1 bytes, NUL-terminated
+ */
+void ais_geohash(int32_t lon, int32_t lat, int precision, char *out) {
+    static const char base32[] = "0123456789bcdefghjkmnpqrstuvwxyz";
+    int bits = 5 * precision;
+    int lat_bits = bits / 2;
+    int lon_bits = bits - lat_bits;
+    uint64_t x = spread_bits(bisect_cell(lon, AIS_LON_LIMIT, lon_bits));
+    uint64_t y = spread_bits(bisect_cell(lat, AIS_LAT_LIMIT, lat_bits));
+
+    /* Geohash starts with a longitude bit; with an odd bit count it also ends with one */
+    uint64_t hash = (lon_bits == lat_bits) ? (x << 1) | y : x | (y << 1);
+
+    for (int i = 0; i < precision; i++)
+        out[i] = base32[(hash >> (5 * (precision - 1 - i))) & 31];
+    out[precision] = '\0';
+}
+
+
+/**
+ * @brief Hierarchical grid cell of two quantized coordinates
+ *
+ * @param qx Quantized longitude
+ * @param qy Quantized latitude
+ * @param level Grid level (0–AIS_GRID_MAX_LEVEL)
+ * @return Cell id
+ */
+uint64_t ais_grid_cell(uint32_t qx, uint32_t qy, int level) {
+    int shift = AIS_CURVE_BITS - level;
+    return ((uint64_t)level << AIS_GRID_LEVEL_SHIFT) | ais_morton_key(qx >> shift, qy >> shift);
+}
+
+
+/**
+ * @brief Ancestor of a grid cell at a coarser level
+ *
+ * @param cell Cell id from ais_grid_cell()
+ * @param level Target level, at most the level of cell
+ * @return Cell id of the enclosing cell
+ */
+uint64_t ais_grid_parent(uint64_t cell, int level) {
+    int from = (int)(cell >> AIS_GRID_LEVEL_SHIFT);
+    uint64_t key = cell & ((UINT64_C(1) << AIS_GRID_LEVEL_SHIFT) - 1);
+    return ((uint64_t)level << AIS_GRID_LEVEL_SHIFT) | (key >> (2 * (from - level)));
+}
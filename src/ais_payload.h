@@ -0,0 +1,243 @@
+#ifndef AIS_PAYLOAD_H
+#define AIS_PAYLOAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* Positions are kept in the on-air fixed-point unit of 1/10000 minute */
+#define AIS_COORD_SCALE 600000
+#define AIS_LON_LIMIT (180 * AIS_COORD_SCALE)
+#define AIS_LAT_LIMIT (90 * AIS_COORD_SCALE)
+
+/* Bits per axis used by the space-filling curve keys (62-bit keys fit in int8) */
+#define AIS_CURVE_BITS 31
+
+/* Longest geohash, 60 bits: about 19 mm of latitude */
+#define AIS_GEOHASH_MAX 12
+
+/* Finest grid level; the level is kept above the 2*level Morton bits */
+#define AIS_GRID_MAX_LEVEL 29
+#define AIS_GRID_LEVEL_SHIFT 58
+
+
+/**
+ * @brief Borrowed view of an NMEA 4.0 tag block ("\\s:station,c:time*hh\\")
+ *
+ * Zero members mean the tag was absent. station points into the caller's
+ * buffer and is not NUL-terminated.
+ */
+typedef struct {
+    const char *station;
+    int station_len;
+    int64_t receive_time;   /* "c:" Unix time in seconds */
+    int line_count;         /* "n:" receiver line counter */
+} AISTagBlock;
+
+
+/**
+ * @brief Borrowed view of the payload inside a raw AIS sentence
+ *
+ * Points into the caller's sentence buffer; nothing is copied or allocated.
+ * The payload is not NUL-terminated, so every reader is length-aware.
+ */
+typedef struct {
+    const char *payload;
+    int len;
+    int fill_bits;
+    int total;
+    int seq;
+    char channel;
+    const char *message_id;
+    int message_id_len;
+    AISTagBlock tags;
+} AISPayloadView;
+
+
+/**
+ * @brief Parse the tag blocks in front of a sentence without copying
+ *
+ * Recognizes the source station ("s:"), receive time ("c:", seconds or
+ * milliseconds) and line count ("n:"); other tags are skipped. A line that
+ * does not start with '\\' has no tag block and consumes nothing.
+ *
+ * @param line Raw line bytes
+ * @param len Number of bytes in line
+ * @param tags Output tag values pointing into line
+ * @param consumed Output number of tag block bytes before the sentence
+ * @return false if a tag block is unterminated or fails its "*hh" checksum
+ */
+bool ais_tag_block_view(const char *line, size_t len, AISTagBlock *tags, size_t *consumed);
+
+
+/**
+ * @brief Locate the fields of an !AIVDM/!AIVDO sentence without copying
+ *
+ * Accepts any two-character talker id and leading NMEA 4.0 tag blocks. The
+ * sentence does not need to be NUL-terminated, which lets callers pass
+ * varlena data directly.
+ *
+ * @param sentence Raw sentence bytes
+ * @param len Number of bytes in sentence
+ * @param view Output view pointing into sentence
+ * @return true if the sentence has the expected field layout
+ */
+bool ais_payload_view(const char *sentence, size_t len, AISPayloadView *view);
+
+
+/**
+ * @brief Extract an unsigned bitfield from a payload view
+ *
+ * Reads whole 6-bit characters into a 64-bit accumulator and shifts once,
+ * instead of looping per bit.
+ *
+ * @param view Payload view
+ * @param start Bit offset (0-based)
+ * @param len Number of bits (1–32)
+ * @param out Output value
+ * @return false on bounds error or invalid armoring character
+ */
+bool ais_view_uint(const AISPayloadView *view, int start, int len, uint32_t *out);
+
+
+/**
+ * @brief Extract a two's complement signed bitfield from a payload view
+ *
+ * @param view Payload view
+ * @param start Bit offset (0-based)
+ * @param len Number of bits (1–32)
+ * @param out Output value
+ * @return false on bounds error or invalid armoring character
+ */
+bool ais_view_int(const AISPayloadView *view, int start, int len, int32_t *out);
+
+
+/**
+ * @brief Return the message type from the first payload character
+ *
+ * @param view Payload view
+ * @return Message type (0–63), or -1 if the payload is empty or malformed
+ */
+int ais_view_type(const AISPayloadView *view);
+
+
+/**
+ * @brief Extract the fixed-point position of a position-bearing message
+ *
+ * Supports types 1–3, 4, 9, 11, 18, 19, 21 and 27. Coordinates are returned in
+ * 1/10000 minute; type 27 is rescaled from its coarser 1/10 minute encoding.
+ *
+ * @param view Payload view (must be the first fragment)
+ * @param lon Output longitude
+ * @param lat Output latitude
+ * @return false if the type carries no position or the position is unavailable
+ */
+bool ais_view_position(const AISPayloadView *view, int32_t *lon, int32_t *lat);
+
+
+/**
+ * @brief Extract speed and course over ground in tenths
+ *
+ * Supports types 1–3, 9, 18, 19 and 27; coarser encodings (type 9 speed,
+ * type 27) are rescaled. Unavailable values and other types yield -1.
+ *
+ * @param view Payload view (must be the first fragment)
+ * @param speed Output speed in 0.1 knot
+ * @param course Output course in 0.1 degree
+ */
+void ais_view_motion(const AISPayloadView *view, int32_t *speed, int32_t *course);
+
+
+/**
+ * @brief Pack reassembled fragment payloads into a canonical bit string
+ *
+ * Concatenates the 6-bit values of every fragment, drops the fill bits of the
+ * final fragment and packs the result MSB-first with a zeroed tail. The output
+ * does not depend on talker, channel, sequence id or where the sender split
+ * the fragments, so it identifies one transmission across receivers.
+ *
+ * @param parts Fragment views ordered by sequence number
+ * @param nparts Number of fragments
+ * @param out Output buffer
+ * @param out_size Size of out in bytes
+ * @return Number of payload bits written, or -1 on malformed input or overflow
+ */
+int ais_view_pack_bits(const AISPayloadView *parts, int nparts, uint8_t *out, size_t out_size);
+
+
+/**
+ * @brief Map a fixed-point longitude onto [0, 2^AIS_CURVE_BITS)
+ */
+uint32_t ais_quantize_lon(int32_t lon);
+
+
+/**
+ * @brief Map a fixed-point latitude onto [0, 2^AIS_CURVE_BITS)
+ */
+uint32_t ais_quantize_lat(int32_t lat);
+
+
+/**
+ * @brief Interleave two quantized coordinates into a Morton (Z-order) key
+ *
+ * Longitude occupies the even bits and latitude the odd bits. The key is
+ * monotone in each axis, so a bounding box maps to a closed key interval.
+ *
+ * @param qx Quantized longitude
+ * @param qy Quantized latitude
+ * @return 62-bit Morton key
+ */
+uint64_t ais_morton_key(uint32_t qx, uint32_t qy);
+
+
+/**
+ * @brief Compute the Hilbert curve index of two quantized coordinates
+ *
+ * @param qx Quantized longitude
+ * @param qy Quantized latitude
+ * @param bits Curve order per axis (1–AIS_CURVE_BITS)
+ * @return Hilbert index with 2*bits significant bits
+ */
+uint64_t ais_hilbert_key(uint32_t qx, uint32_t qy, int bits);
+
+
+/**
+ * @brief Encode a fixed-point position as a geohash
+ *
+ * Bisects the fixed-point ranges directly, so the cells match the usual
+ * degree-based geohash exactly. Nothing is allocated.
+ *
+ * @param lon Fixed-point longitude
+ * @param lat Fixed-point latitude
+ * @param precision Number of characters (1–AIS_GEOHASH_MAX)
+ * @param out Output buffer of at least precision + 1 bytes, NUL-terminated
+ */
+void ais_geohash(int32_t lon, int32_t lat, int precision, char *out);
+
+
+/**
+ * @brief Hierarchical grid cell of two quantized coordinates
+ *
+ * Level l splits the world into 2^l x 2^l cells numbered along the Morton
+ * curve; the level sits in the bits above AIS_GRID_LEVEL_SHIFT so ids of
+ * different levels never collide.
+ *
+ * @param qx Quantized longitude
+ * @param qy Quantized latitude
+ * @param level Grid level (0–AIS_GRID_MAX_LEVEL)
+ * @return Cell id
+ */
+uint64_t ais_grid_cell(uint32_t qx, uint32_t qy, int level);
+
+
+/**
+ * @brief Ancestor of a grid cell at a coarser level
+ *
+ * @param cell Cell id from ais_grid_cell()
+ * @param level Target level, at most the level of cell
+ * @return Cell id of the enclosing cell
+ */
+uint64_t ais_grid_parent(uint64_t cell, int level);
+
+#endif
@@ -0,0 +1,473 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ais_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef AIS_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef AIS_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+
+/* Compressed bytes read from disk per read() call */
+#define AIS_READER_INPUT_SIZE (256 * 1024)
+
+
+struct AISReader {
+    int fd;
+    AISReaderFormat format;
+    uint64_t remaining;     /* plain files: bytes left in the range */
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    /* Ring of decompressed blocks; filled by the thread, drained by read */
+    char *blocks[AIS_READER_BLOCKS];
+    size_t block_len[AIS_READER_BLOCKS];
+    int head;
+    int filled;
+    size_t head_off;
+    bool done;
+    bool stop;
+    char error[256];
+
+    /* Compressed input, owned by the thread */
+    char *in;
+    size_t in_len;
+    size_t in_pos;
+    bool in_eof;
+#ifdef AIS_WITH_ZLIB
+    z_stream z;
+    bool z_ready;
+#endif
+#ifdef AIS_WITH_ZSTD
+    ZSTD_DCtx *zstd;
+    bool zstd_pending;      /* inside a frame */
+#endif
+};
+
+
+/**
+ * @brief Classify the first bytes of a file
+ *
+ * @param magic First bytes of the file
+ * @param n Number of bytes available
+ * @return Detected format
+ */
+static AISReaderFormat detect_magic(const unsigned char *magic, size_t n) {
+    if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) return AIS_FORMAT_GZIP;
+    if (n >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+        return AIS_FORMAT_ZSTD;
+    return AIS_FORMAT_PLAIN;
+}
+
+
+/**
+ * @brief read() that retries on EINTR
+ *
+ * @return Bytes read, 0 at end of file, or -1 on error
+ */
+static ssize_t read_retry(int fd, void *buf, size_t n) {
+    ssize_t r;
+    do {
+        r = read(fd, buf, n);
+    } while (r < 0 && errno == EINTR);
+    return r;
+}
+
+
+/**
+ * @brief Detect the encoding of a file from its first bytes
+ *
+ * @param path File to inspect
+ * @param format Output format
+ * @return false if the file cannot be opened or read
+ */
+bool ais_reader_detect(const char *path, AISReaderFormat *format) {
+    unsigned char magic[4];
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    ssize_t n = read_retry(fd, magic, sizeof(magic));
+    close(fd);
+    if (n < 0) return false;
+    *format = detect_magic(magic, (size_t)n);
+    return true;
+}
+
+
+/**
+ * @brief Record an error for the consumer (thread side)
+ */
+static void set_error(AISReader *reader, const char *what, int err) {
+    pthread_mutex_lock(&reader->lock);
+    if (err) snprintf(reader->error, sizeof(reader->error), "%s: %s", what, strerror(err));
+    else snprintf(reader->error, sizeof(reader->error), "%s", what);
+    pthread_mutex_unlock(&reader->lock);
+}
+
+
+/**
+ * @brief Refill the compressed input buffer once it is drained
+ *
+ * @return false on read error
+ */
+static bool fill_input(AISReader *reader) {
+    if (reader->in_pos < reader->in_len || reader->in_eof) return true;
+
+    ssize_t n = read_retry(reader->fd, reader->in, AIS_READER_INPUT_SIZE);
+    if (n < 0) {
+        set_error(reader, "could not read file", errno);
+        return false;
+    }
+    reader->in_len = (size_t)n;
+    reader->in_pos = 0;
+    reader->in_eof = n == 0;
+    return true;
+}
+
+
+/**
+ * @brief Produce one block of plain bytes
+ *
+ * @param reader Reader
+ * @param dst Block buffer of AIS_READER_BLOCK_SIZE bytes
+ * @param len Output bytes produced (0 at end of input)
+ * @return false on error
+ */
+static bool produce_plain(AISReader *reader, char *dst, size_t *len) {
+    size_t want = AIS_READER_BLOCK_SIZE;
+    *len = 0;
+    if (reader->remaining < want) want = (size_t)reader->remaining;
+
+    while (*len < want) {
+        ssize_t n = read_retry(reader->fd, dst + *len, want - *len);
+        if (n < 0) {
+            set_error(reader, "could not read file", errno);
+            return false;
+        }
+        if (n == 0) break;
+        *len += (size_t)n;
+    }
+    reader->remaining -= *len;
+    return true;
+}
+
+
+#ifdef AIS_WITH_ZLIB
+/**
+ * @brief Produce one block of gzip-decompressed bytes
+ *
+ * Concatenated gzip members (as left by log rotation) are read in sequence.
+ */
+static bool produce_gzip(AISReader *reader, char *dst, size_t *len) {
+    z_stream *z = &reader->z;
+    z->next_out = (Bytef *)dst;
+    z->avail_out = AIS_READER_BLOCK_SIZE;
+
+    while (z->avail_out > 0) {
+        if (!fill_input(reader)) return false;
+        if (reader->in_pos == reader->in_len) {
+            if (z->total_in > 0) {
+                set_error(reader, "unexpected end of gzip data", 0);
+                return false;
+            }
+            break;
+        }
+
+        z->next_in = (Bytef *)reader->in + reader->in_pos;
+        z->avail_in = (uInt)(reader->in_len - reader->in_pos);
+        int rc = inflate(z, Z_NO_FLUSH);
+        reader->in_pos = reader->in_len - z->avail_in;
+
+        if (rc == Z_STREAM_END) {
+            inflateReset(z);
+        } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            set_error(reader, z->msg ? z->msg : "corrupt gzip data", 0);
+            return false;
+        }
+    }
+    *len = AIS_READER_BLOCK_SIZE - z->avail_out;
+    return true;
+}
+#endif
+
+
+#ifdef AIS_WITH_ZSTD
+/**
+ * @brief Produce one block of zstd-decompressed bytes
+ */
+static bool produce_zstd(AISReader *reader, char *dst, size_t *len) {
+    ZSTD_outBuffer out = {dst, AIS_READER_BLOCK_SIZE, 0};
+
+    while (out.pos < out.size) {
+        if (!fill_input(reader)) return false;
+        if (reader->in_pos == reader->in_len) {
+            if (reader->zstd_pending) {
+                set_error(reader, "unexpected end of zstd data", 0);
+                return false;
+            }
+            break;
+        }
+
+        ZSTD_inBuffer in = {reader->in, reader->in_len, reader->in_pos};
+        size_t rc = ZSTD_decompressStream(reader->zstd, &out, &in);
+        reader->in_pos = in.pos;
+        if (ZSTD_isError(rc)) {
+            set_error(reader, ZSTD_getErrorName(rc), 0);
+            return false;
+        }
+        reader->zstd_pending = rc != 0;
+    }
+    *len = out.pos;
+    return true;
+}
+#endif
+
+
+/**
+ * @brief Reader thread: fill free ring blocks until the input ends
+ */
+static void *reader_main(void *arg) {
+    AISReader *reader = (AISReader *)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&reader->lock);
+        while (reader->filled == AIS_READER_BLOCKS && !reader->stop)
+            pthread_cond_wait(&reader->cond, &reader->lock);
+        if (reader->stop) {
+            pthread_mutex_unlock(&reader->lock);
+            return NULL;
+        }
+        int slot = (reader->head + reader->filled) % AIS_READER_BLOCKS;
+        pthread_mutex_unlock(&reader->lock);
+
+        size_t len = 0;
+        bool ok = false;
+        switch (reader->format) {
+            case AIS_FORMAT_PLAIN: ok = produce_plain(reader, reader->blocks[slot], &len); break;
+#ifdef AIS_WITH_ZLIB
+            case AIS_FORMAT_GZIP: ok = produce_gzip(reader, reader->blocks[slot], &len); break;
+#endif
+#ifdef AIS_WITH_ZSTD
+            case AIS_FORMAT_ZSTD: ok = produce_zstd(reader, reader->blocks[slot], &len); break;
+#endif
+            default: break;
+        }
+
+        pthread_mutex_lock(&reader->lock);
+        if (ok && len > 0) {
+            reader->block_len[slot] = len;
+            reader->filled++;
+        } else {
+            reader->done = true;
+        }
+        pthread_cond_broadcast(&reader->cond);
+        pthread_mutex_unlock(&reader->lock);
+        if (!ok || len == 0) return NULL;
+    }
+}
+
+
+/**
+ * @brief Release everything but the thread
+ */
+static void reader_free(AISReader *reader) {
+    if (reader->fd >= 0) close(reader->fd);
+    for (int i = 0; i < AIS_READER_BLOCKS; i++) free(reader->blocks[i]);
+    free(reader->in);
+#ifdef AIS_WITH_ZLIB
+    if (reader->z_ready) inflateEnd(&reader->z);
+#endif
+#ifdef AIS_WITH_ZSTD
+    if (reader->zstd) ZSTD_freeDCtx(reader->zstd);
+#endif
+    pthread_mutex_destroy(&reader->lock);
+    pthread_cond_destroy(&reader->cond);
+    free(reader);
+}
+
+
+/**
+ * @brief Open a log file and start its reader thread
+ *
+ * offset and limit select a byte range of a plain file and must be zero for
+ * compressed files, which are always read whole.
+ *
+ * @param path File to read
+ * @param offset Byte offset to start at (plain files only)
+ * @param limit Maximum bytes to read, or 0 for the rest of the file
+ * @param err Output error message on failure
+ * @param errlen Size of err
+ * @return Reader (malloc'd), or NULL on failure
+ */
+AISReader *ais_reader_open(const char *path, uint64_t offset, uint64_t limit, char *err, size_t errlen) {
+    AISReader *reader = calloc(1, sizeof(AISReader));
+    unsigned char magic[4];
+    sigset_t all, old;
+
+    if (!reader) {
+        snprintf(err, errlen, "out of memory");
+        return NULL;
+    }
+    pthread_mutex_init(&reader->lock, NULL);
+    pthread_cond_init(&reader->cond, NULL);
+
+    reader->fd = open(path, O_RDONLY);
+    if (reader->fd < 0) {
+        snprintf(err, errlen, "could not open file \"%s\" for reading: %s", path, strerror(errno));
+        reader_free(reader);
+        return NULL;
+    }
+
+    ssize_t n = read_retry(reader->fd, magic, sizeof(magic));
+    reader->format = detect_magic(magic, n > 0 ? (size_t)n : 0);
+    if (n < 0 || lseek(reader->fd, (off_t)(reader->format == AIS_FORMAT_PLAIN ? offset : 0), SEEK_SET) < 0) {
+        snprintf(err, errlen, "could not read file \"%s\": %s", path, strerror(errno));
+        reader_free(reader);
+        return NULL;
+    }
+    reader->remaining = limit > 0 ? limit : UINT64_MAX;
+
+    if (reader->format != AIS_FORMAT_PLAIN && (offset > 0 || limit > 0)) {
+        snprintf(err, errlen, "cannot read a byte range of compressed file \"%s\"", path);
+        reader_free(reader);
+        return NULL;
+    }
+
+    bool supported = reader->format == AIS_FORMAT_PLAIN;
+#ifdef AIS_WITH_ZLIB
+    if (reader->format == AIS_FORMAT_GZIP) {
+        /* 15 + 32: largest window, gzip or zlib header auto-detected */
+        reader->z_ready = inflateInit2(&reader->z, 15 + 32) == Z_OK;
+        supported = reader->z_ready;
+    }
+#endif
+#ifdef AIS_WITH_ZSTD
+    if (reader->format == AIS_FORMAT_ZSTD) {
+        reader->zstd = ZSTD_createDCtx();
+        supported = reader->zstd != NULL;
+    }
+#endif
+    if (!supported) {
+        snprintf(err, errlen, "file \"%s\" is %s-compressed, which this build cannot read", path,
+                 reader->format == AIS_FORMAT_GZIP ? "gzip" : "zstd");
+        reader_free(reader);
+        return NULL;
+    }
+
+    for (int i = 0; i < AIS_READER_BLOCKS; i++) {
+        reader->blocks[i] = malloc(AIS_READER_BLOCK_SIZE);
+        if (!reader->blocks[i]) {
+            snprintf(err, errlen, "out of memory");
+            reader_free(reader);
+            return NULL;
+        }
+    }
+    if (reader->format != AIS_FORMAT_PLAIN && !(reader->in = malloc(AIS_READER_INPUT_SIZE))) {
+        snprintf(err, errlen, "out of memory");
+        reader_free(reader);
+        return NULL;
+    }
+
+    /* Signals must keep going to the calling thread */
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int rc = pthread_create(&reader->thread, NULL, reader_main, reader);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (rc != 0) {
+        snprintf(err, errlen, "could not start reader thread: %s", strerror(rc));
+        reader_free(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+
+/**
+ * @brief Return the encoding detected when the reader was opened
+ */
+AISReaderFormat ais_reader_format(const AISReader *reader) {
+    return reader->format;
+}
+
+
+/**
+ * @brief Copy up to n decompressed bytes into dst, waiting for the thread
+ *
+ * The head block is read outside the lock; the thread only writes blocks
+ * that are not filled.
+ *
+ * @param reader Reader
+ * @param dst Destination buffer
+ * @param n Capacity of dst
+ * @return Bytes copied; 0 at end of input or after an error
+ */
+size_t ais_reader_read(AISReader *reader, char *dst, size_t n) {
+    size_t copied = 0;
+
+    while (copied < n) {
+        pthread_mutex_lock(&reader->lock);
+        while (reader->filled == 0 && !reader->done)
+            pthread_cond_wait(&reader->cond, &reader->lock);
+        bool empty = reader->filled == 0;
+        pthread_mutex_unlock(&reader->lock);
+        if (empty) break;
+
+        int slot = reader->head;
+        size_t avail = reader->block_len[slot] - reader->head_off;
+        size_t take = avail < n - copied ? avail : n - copied;
+        memcpy(dst + copied, reader->blocks[slot] + reader->head_off, take);
+        copied += take;
+        reader->head_off += take;
+
+        if (reader->head_off == reader->block_len[slot]) {
+            pthread_mutex_lock(&reader->lock);
+            reader->head = (reader->head + 1) % AIS_READER_BLOCKS;
+            reader->filled--;
+            reader->head_off = 0;
+            pthread_cond_broadcast(&reader->cond);
+            pthread_mutex_unlock(&reader->lock);
+        }
+    }
+    return copied;
+}
+
+
+/**
+ * @brief Return the error that stopped the reader thread, if any
+ *
+ * @param reader Reader
+ * @return Error message, or NULL if the input ended normally
+ */
+const char *ais_reader_error(const AISReader *reader) {
+    return reader->error[0] ? reader->error : NULL;
+}
+
+
+/**
+ * @brief Stop the reader thread and release the reader
+ *
+ * @param reader Reader, or NULL
+ */
+void ais_reader_close(AISReader *reader) {
+    if (!reader) return;
+
+    pthread_mutex_lock(&reader->lock);
+    reader->stop = true;
+    pthread_cond_broadcast(&reader->cond);
+    pthread_mutex_unlock(&reader->lock);
+    pthread_join(reader->thread, NULL);
+    reader_free(reader);
+}
@@ -0,0 +1,96 @@
+#ifndef AIS_READER_H
+#define AIS_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* Bytes produced per block by the reader thread */
+#define AIS_READER_BLOCK_SIZE (1024 * 1024)
+
+/* Blocks the reader thread may run ahead of the consumer */
+#define AIS_READER_BLOCKS 4
+
+
+/**
+ * @brief On-disk encoding of a receiver log, detected from its magic bytes
+ */
+typedef enum {
+    AIS_FORMAT_PLAIN,
+    AIS_FORMAT_GZIP,   /* 1f 8b */
+    AIS_FORMAT_ZSTD    /* 28 b5 2f fd */
+} AISReaderFormat;
+
+
+/**
+ * @brief Pipelined reader for plain, gzip and zstd receiver logs
+ *
+ * A background thread reads and decompresses the file into a small ring of
+ * large blocks while the caller decodes the previous ones. The thread never
+ * calls back into the caller and blocks all signals, so it is safe inside a
+ * PostgreSQL backend as long as the consumer closes it on every exit path.
+ */
+typedef struct AISReader AISReader;
+
+
+/**
+ * @brief Detect the encoding of a file from its first bytes
+ *
+ * @param path File to inspect
+ * @param format Output format
+ * @return false if the file cannot be opened or read
+ */
+bool ais_reader_detect(const char *path, AISReaderFormat *format);
+
+
+/**
+ * @brief Open a log file and start its reader thread
+ *
+ * offset and limit select a byte range of a plain file and must be zero for
+ * compressed files, which are always read whole.
+ *
+ * @param path File to read
+ * @param offset Byte offset to start at (plain files only)
+ * @param limit Maximum bytes to read, or 0 for the rest of the file
+ * @param err Output error message on failure
+ * @param errlen Size of err
+ * @return Reader (malloc'd), or NULL on failure
+ */
+AISReader *ais_reader_open(const char *path, uint64_t offset, uint64_t limit, char *err, size_t errlen);
+
+
+/**
+ * @brief Return the encoding detected when the reader was opened
+ */
+AISReaderFormat ais_reader_format(const AISReader *reader);
+
+
+/**
+ * @brief Copy up to n decompressed bytes into dst, waiting for the thread
+ *
+ * @param reader Reader
+ * @param dst Destination buffer
+ * @param n Capacity of dst
+ * @return Bytes copied; 0 at end of input or after an error
+ */
+size_t ais_reader_read(AISReader *reader, char *dst, size_t n);
+
+
+/**
+ * @brief Return the error that stopped the reader thread, if any
+ *
+ * @param reader Reader
+ * @return Error message, or NULL if the input ended normally
+ */
+const char *ais_reader_error(const AISReader *reader);
+
+
+/**
+ * @brief Stop the reader thread and release the reader
+ *
+ * @param reader Reader, or NULL
+ */
+void ais_reader_close(AISReader *reader);
+
+#endif
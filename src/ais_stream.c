@@ -0,0 +1,297 @@
+#include "ais_stream.h"
+#include <string.h>
+
+
+/**
+ * @brief Convert a hexadecimal digit to its value
+ *
+ * @param c Input character
+ * @return Value from 0–15, or -1 if c is not a hex digit
+ */
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+
+/**
+ * @brief Reset a stream to its initial state
+ *
+ * @param stream Stream to reset
+ */
+void ais_stream_init(AISStream *stream) {
+    memset(stream, 0, sizeof(*stream));
+}
+
+
+/**
+ * @brief Verify the NMEA "*hh" checksum of a sentence
+ *
+ * The checksum is the XOR of all bytes between the leading '!' and the '*'.
+ *
+ * @param sentence Sentence starting at '!'
+ * @param len Number of bytes in sentence (trailing CR/LF allowed)
+ * @return true if the checksum is present and matches
+ */
+bool ais_sentence_checksum_ok(const char *sentence, size_t len) {
+    if (!sentence || len < 4 || sentence[0] != '!') return false;
+
+    unsigned char sum = 0;
+    size_t i = 1;
+    while (i < len && sentence[i] != '*') sum ^= (unsigned char)sentence[i++];
+    if (i + 2 >= len) return false;
+
+    int hi = hex_value(sentence[i + 1]);
+    int lo = hex_value(sentence[i + 2]);
+    return hi >= 0 && lo >= 0 && sum == (unsigned char)((hi << 4) | lo);
+}
+
+
+/**
+ * @brief Locate the sentence fields of a raw receiver log line
+ *
+ * Skips text before the sentence and its tag blocks the way
+ * ais_stream_push() does, so a fragment is seen the same with or without a
+ * receiver prefix. Checksums are not verified.
+ *
+ * @param line Line bytes, without the newline
+ * @param len Number of bytes in line
+ * @param view Output view pointing into line
+ * @return false if the line holds no well-formed sentence
+ */
+bool ais_stream_sentence_view(const char *line, size_t len, AISPayloadView *view) {
+    const char *start = line;
+    const char *end = line + len;
+    while (start < end && *start != '!' && *start != '\\') start++;
+    if (start == end) return false;
+
+    AISTagBlock tags;
+    size_t consumed;
+    if (!ais_tag_block_view(start, (size_t)(end - start), &tags, &consumed)) return false;
+    if (!ais_payload_view(start + consumed, (size_t)(end - start) - consumed, view)) return false;
+    view->tags = tags;
+    return true;
+}
+
+
+/**
+ * @brief Check whether a fragment's station tag is compatible with a slot
+ *
+ * Station names longer than the slot buffer compare on their prefix.
+ *
+ * @param slot Pending message
+ * @param tags Fragment tags
+ * @return true if either side has no station or the stations are equal
+ */
+static bool same_station(const AISPendingMessage *slot, const AISTagBlock *tags) {
+    if (slot->tags.station_len == 0 || tags->station_len == 0) return true;
+
+    size_t n = (size_t)tags->station_len < sizeof(slot->station) ? (size_t)tags->station_len : sizeof(slot->station);
+    return (size_t)slot->tags.station_len == n && memcmp(slot->station, tags->station, n) == 0;
+}
+
+
+/**
+ * @brief Merge a fragment's tags into its pending message
+ *
+ * The first fragment carrying a tag wins; the station is copied because the
+ * fragment's line does not outlive the call.
+ *
+ * @param slot Pending message
+ * @param tags Fragment tags
+ */
+static void merge_tags(AISPendingMessage *slot, const AISTagBlock *tags) {
+    if (slot->tags.station_len == 0 && tags->station_len > 0) {
+        size_t n = (size_t)tags->station_len < sizeof(slot->station) ? (size_t)tags->station_len : sizeof(slot->station);
+        memcpy(slot->station, tags->station, n);
+        slot->tags.station = slot->station;
+        slot->tags.station_len = (int)n;
+    }
+    if (slot->tags.receive_time == 0) slot->tags.receive_time = tags->receive_time;
+    if (slot->tags.line_count == 0) slot->tags.line_count = tags->line_count;
+}
+
+
+/**
+ * @brief Find the pending slot for a fragment, claiming one if needed
+ *
+ * Expires messages older than AIS_STREAM_MAX_AGE while scanning. When every
+ * slot is busy the oldest message is dropped. A fragment without a station
+ * tag matches on channel and sequence id alone, since some receivers tag
+ * only the first fragment of a group.
+ *
+ * @param stream Stream state
+ * @param view Fragment view
+ * @return Slot for the fragment's message
+ */
+static AISPendingMessage *pending_slot(AISStream *stream, const AISPayloadView *view) {
+    AISPendingMessage *free_slot = NULL;
+    AISPendingMessage *oldest = NULL;
+
+    for (int i = 0; i < AIS_STREAM_SLOTS; i++) {
+        AISPendingMessage *slot = &stream->pending[i];
+        if (slot->in_use && stream->sentences - slot->serial > AIS_STREAM_MAX_AGE) {
+            slot->in_use = false;
+            stream->incomplete++;
+        }
+        if (!slot->in_use) {
+            if (!free_slot) free_slot = slot;
+            continue;
+        }
+        if (slot->channel == view->channel &&
+            (int)strlen(slot->message_id) == view->message_id_len &&
+            memcmp(slot->message_id, view->message_id, view->message_id_len) == 0 &&
+            same_station(slot, &view->tags))
+            return slot;
+        if (!oldest || slot->serial < oldest->serial) oldest = slot;
+    }
+
+    if (!free_slot) {
+        free_slot = oldest;
+        stream->incomplete++;
+    }
+    memset(free_slot, 0, offsetof(AISPendingMessage, len));
+    free_slot->in_use = true;
+    free_slot->channel = view->channel;
+    memcpy(free_slot->message_id, view->message_id, view->message_id_len);
+    free_slot->message_id[view->message_id_len] = '\0';
+    free_slot->total = view->total;
+    free_slot->serial = stream->sentences;
+    return free_slot;
+}
+
+
+/**
+ * @brief Feed one line of a receiver log to the stream
+ *
+ * NMEA 4.0 tag blocks in front of the sentence are parsed; other text before
+ * the first '!' (receiver timestamps and the like) is ignored. Fragments are
+ * matched by source station, channel and sequence id and may arrive in any
+ * order; incomplete messages are dropped when their slot is reused or after
+ * AIS_STREAM_MAX_AGE sentences.
+ *
+ * @param stream Stream state
+ * @param line Line bytes, without the newline
+ * @param len Number of bytes in line
+ * @param out Output message when AIS_STREAM_MESSAGE is returned
+ * @return Outcome for this line
+ */
+AISStreamResult ais_stream_push(AISStream *stream, const char *line, size_t len, AISStreamMessage *out) {
+    const char *start = line;
+    const char *end = line + len;
+    while (start < end && *start != '!' && *start != '\\') start++;
+    if (start == end) return AIS_STREAM_SKIPPED;
+
+    size_t slen = (size_t)(end - start);
+    while (slen > 0 && (start[slen - 1] == '\r' || start[slen - 1] == '\n' || start[slen - 1] == ' '))
+        slen--;
+
+    AISTagBlock tags;
+    size_t consumed;
+    stream->sentences++;
+    if (!ais_tag_block_view(start, slen, &tags, &consumed)) {
+        stream->bad_checksum++;
+        return AIS_STREAM_BAD_CHECKSUM;
+    }
+
+    const char *bang = start + consumed;
+    size_t blen = slen - consumed;
+    if (!ais_sentence_checksum_ok(bang, blen)) {
+        stream->bad_checksum++;
+        return AIS_STREAM_BAD_CHECKSUM;
+    }
+
+    AISPayloadView view;
+    if (!ais_payload_view(bang, blen, &view) || view.len < 1 ||
+        view.total > AIS_STREAM_MAX_PARTS || view.len >= AIS_STREAM_PART_MAX ||
+        view.message_id_len >= (int)sizeof(((AISPendingMessage *)0)->message_id)) {
+        stream->malformed++;
+        return AIS_STREAM_MALFORMED;
+    }
+    view.tags = tags;
+
+    if (view.total == 1) {
+        memcpy(stream->assembled, view.payload, view.len);
+        stream->assembled[view.len] = '\0';
+        out->payload = stream->assembled;
+        out->len = view.len;
+        out->fill_bits = view.fill_bits;
+        out->nparts = 1;
+        out->channel = view.channel;
+        out->sentence = start;
+        out->sentence_len = slen;
+        out->tags = tags;
+        stream->messages++;
+        return AIS_STREAM_MESSAGE;
+    }
+
+    AISPendingMessage *slot = pending_slot(stream, &view);
+    unsigned bit = 1u << (view.seq - 1);
+    if (slot->total != view.total || (slot->received & bit) ||
+        (view.seq == 1 && stream->sentences - slot->serial > AIS_STREAM_REORDER_WINDOW)) {
+        /* Sequence id reused before the previous message completed */
+        stream->incomplete++;
+        memset(slot, 0, offsetof(AISPendingMessage, len));
+        slot = pending_slot(stream, &view);
+    }
+
+    merge_tags(slot, &tags);
+    memcpy(slot->part[view.seq - 1], view.payload, view.len);
+    slot->len[view.seq - 1] = view.len;
+    slot->received |= bit;
+    if (view.seq == view.total) slot->fill_bits = view.fill_bits;
+    if (slot->received != (1u << slot->total) - 1) return AIS_STREAM_PENDING;
+
+    int total_len = 0;
+    for (int i = 0; i < slot->total; i++) {
+        memcpy(stream->assembled + total_len, slot->part[i], slot->len[i]);
+        total_len += slot->len[i];
+    }
+    stream->assembled[total_len] = '\0';
+
+    out->payload = stream->assembled;
+    out->len = total_len;
+    out->fill_bits = slot->fill_bits;
+    out->nparts = slot->total;
+    out->channel = slot->channel;
+    out->sentence = NULL;
+    out->sentence_len = 0;
+    out->tags = slot->tags;
+    slot->in_use = false;
+    stream->messages++;
+    stream->reassembled++;
+    return AIS_STREAM_MESSAGE;
+}
+
+
+/**
+ * @brief Drop messages still waiting for fragments at end of input
+ *
+ * Each dropped message is counted in stream->incomplete.
+ *
+ * @param stream Stream state
+ */
+void ais_stream_finish(AISStream *stream) {
+    for (int i = 0; i < AIS_STREAM_SLOTS; i++) {
+        if (stream->pending[i].in_use) {
+            stream->pending[i].in_use = false;
+            stream->incomplete++;
+        }
+    }
+}
+
+
+/**
+ * @brief Return the number of multipart messages waiting for fragments
+ *
+ * @param stream Stream state
+ * @return Pending message count
+ */
+int ais_stream_pending(const AISStream *stream) {
+    int n = 0;
+    for (int i = 0; i < AIS_STREAM_SLOTS; i++)
+        if (stream->pending[i].in_use) n++;
+    return n;
+}
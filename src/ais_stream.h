@@ -0,0 +1,172 @@
+#ifndef AIS_STREAM_H
+#define AIS_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ais_payload.h"
+
+
+/* Fragments per message; matches MAX_PARTS of the SQL-facing code */
+#define AIS_STREAM_MAX_PARTS 5
+
+/* Longest fragment payload kept while waiting for the rest of a message */
+#define AIS_STREAM_PART_MAX 128
+
+/* Multipart messages reassembled concurrently (one per channel/sequence id) */
+#define AIS_STREAM_SLOTS 32
+
+/* Longest source station name kept for a pending multipart message */
+#define AIS_STREAM_STATION_MAX 32
+
+/* Sentences after which an incomplete message is dropped */
+#define AIS_STREAM_MAX_AGE 256
+
+/*
+ * A first fragment joins earlier out-of-order fragments only if they arrived
+ * within this many sentences; otherwise the sequence id has been reused.
+ */
+#define AIS_STREAM_REORDER_WINDOW 8
+
+
+/**
+ * @brief Outcome of feeding one line to an AISStream
+ */
+typedef enum {
+    AIS_STREAM_MESSAGE,       /* a complete message is available in the output */
+    AIS_STREAM_PENDING,       /* fragment stored, message not complete yet */
+    AIS_STREAM_SKIPPED,       /* blank line or not an AIS sentence */
+    AIS_STREAM_BAD_CHECKSUM,  /* "*hh" missing or wrong */
+    AIS_STREAM_MALFORMED      /* sentence fields or fragment numbering invalid */
+} AISStreamResult;
+
+
+/**
+ * @brief A complete message produced by ais_stream_push()
+ *
+ * payload is NUL-terminated and owned by the stream; it stays valid until the
+ * next call. sentence points into the caller's line for single-part messages
+ * (including any tag block) and is NULL for reassembled ones. tags come from
+ * the first fragment that carried them.
+ */
+typedef struct {
+    const char *payload;
+    int len;
+    int fill_bits;
+    int nparts;
+    char channel;
+    const char *sentence;
+    size_t sentence_len;
+    AISTagBlock tags;
+} AISStreamMessage;
+
+
+/**
+ * @brief A multipart message waiting for its remaining fragments
+ */
+typedef struct {
+    bool in_use;
+    char channel;
+    char message_id[10];
+    char station[AIS_STREAM_STATION_MAX];
+    AISTagBlock tags;
+    int total;
+    unsigned received;
+    int fill_bits;
+    uint64_t serial;
+    int len[AIS_STREAM_MAX_PARTS];
+    char part[AIS_STREAM_MAX_PARTS][AIS_STREAM_PART_MAX];
+} AISPendingMessage;
+
+
+/**
+ * @brief Reassembly state and counters for a stream of raw sentences
+ *
+ * Fixed size and allocation free; embed it in a caller struct or allocate it
+ * once per load.
+ */
+typedef struct {
+    uint64_t sentences;
+    uint64_t messages;
+    uint64_t reassembled;      /* messages joined from several fragments */
+    uint64_t bad_checksum;
+    uint64_t malformed;
+    uint64_t incomplete;
+    AISPendingMessage pending[AIS_STREAM_SLOTS];
+    char assembled[AIS_STREAM_MAX_PARTS * AIS_STREAM_PART_MAX + 1];
+} AISStream;
+
+
+/**
+ * @brief Reset a stream to its initial state
+ *
+ * @param stream Stream to reset
+ */
+void ais_stream_init(AISStream *stream);
+
+
+/**
+ * @brief Verify the NMEA "*hh" checksum of a sentence
+ *
+ * The checksum is the XOR of all bytes between the leading '!' and the '*'.
+ *
+ * @param sentence Sentence starting at '!'
+ * @param len Number of bytes in sentence (trailing CR/LF allowed)
+ * @return true if the checksum is present and matches
+ */
+bool ais_sentence_checksum_ok(const char *sentence, size_t len);
+
+
+/**
+ * @brief Locate the sentence fields of a raw receiver log line
+ *
+ * Skips text before the sentence and its tag blocks the way
+ * ais_stream_push() does, so a fragment is seen the same with or without a
+ * receiver prefix. Checksums are not verified.
+ *
+ * @param line Line bytes, without the newline
+ * @param len Number of bytes in line
+ * @param view Output view pointing into line
+ * @return false if the line holds no well-formed sentence
+ */
+bool ais_stream_sentence_view(const char *line, size_t len, AISPayloadView *view);
+
+
+/**
+ * @brief Feed one line of a receiver log to the stream
+ *
+ * NMEA 4.0 tag blocks in front of the sentence are parsed; other text before
+ * the first '!' (receiver timestamps and the like) is ignored. Fragments are
+ * matched by source station, channel and sequence id and may arrive in any
+ * order; incomplete messages are dropped when their slot is reused or after
+ * AIS_STREAM_MAX_AGE sentences.
+ *
+ * @param stream Stream state
+ * @param line Line bytes, without the newline
+ * @param len Number of bytes in line
+ * @param out Output message when AIS_STREAM_MESSAGE is returned
+ * @return Outcome for this line
+ */
+AISStreamResult ais_stream_push(AISStream *stream, const char *line, size_t len, AISStreamMessage *out);
+
+
+/**
+ * @brief Drop messages still waiting for fragments at end of input
+ *
+ * Each dropped message is counted in stream->incomplete.
+ *
+ * @param stream Stream state
+ */
+void ais_stream_finish(AISStream *stream);
+
+
+/**
+ * @brief Return the number of multipart messages waiting for fragments
+ *
+ * @param stream Stream state
+ * @return Pending message count
+ */
+int ais_stream_pending(const AISStream *stream);
+
+#endif
@@ -0,0 +1,181 @@
+#include "ais_track.h"
+#include "ais_payload.h"
+
+#include <math.h>
+
+
+/* One fixed-point unit (1/10000 minute) of latitude is 1/10000 nautical mile */
+#define METRES_PER_UNIT (1852.0 / 10000.0)
+
+/* 0.1 knot in metres per millisecond */
+#define SPEED_UNIT_M_PER_MS (1852.0 / 10.0 / 3600.0 / 1000.0)
+
+#define DEG_TO_RAD (3.14159265358979323846 / 180.0)
+
+/* Mean Earth radius (IUGG), metres */
+#define EARTH_RADIUS 6371008.8
+
+
+/**
+ * @brief Map a signed value to unsigned so small magnitudes stay small
+ */
+static inline uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+
+/**
+ * @brief Inverse of zigzag()
+ */
+static inline int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+
+/**
+ * @brief Write an unsigned LEB128 varint
+ *
+ * @return Number of bytes written (1–10)
+ */
+static inline size_t put_varint(uint64_t v, uint8_t *out) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+
+/**
+ * @brief Read an unsigned LEB128 varint
+ *
+ * @return false if the data ends mid-varint or exceeds 64 bits
+ */
+static inline bool get_varint(const uint8_t **pos, const uint8_t *end, uint64_t *v) {
+    const uint8_t *p = *pos;
+    uint64_t result = 0;
+
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        result |= (uint64_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            *pos = p;
+            *v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**
+ * @brief Apply a decoded delta to a 32-bit field, rejecting overflow
+ */
+static inline bool add_delta32(int32_t *field, uint64_t encoded) {
+    int64_t v = (int64_t)*field + unzigzag(encoded);
+    if (v < INT32_MIN || v > INT32_MAX) return false;
+    *field = (int32_t)v;
+    return true;
+}
+
+
+/**
+ * @brief Append one point as zigzag varint deltas from the previous one
+ *
+ * @param prev Previous point (all zero before the first point)
+ * @param point Point to encode
+ * @param out Output buffer of at least AIS_TRACK_POINT_MAX bytes
+ * @return Number of bytes written
+ */
+size_t ais_track_encode_point(const AISTrackPoint *prev, const AISTrackPoint *point, uint8_t *out) {
+    size_t n = 0;
+    n += put_varint(zigzag((int64_t)((uint64_t)point->t - (uint64_t)prev->t)), out + n);
+    n += put_varint(zigzag((int64_t)point->lon - prev->lon), out + n);
+    n += put_varint(zigzag((int64_t)point->lat - prev->lat), out + n);
+    n += put_varint(zigzag((int64_t)point->speed - prev->speed), out + n);
+    n += put_varint(zigzag((int64_t)point->course - prev->course), out + n);
+    return n;
+}
+
+
+/**
+ * @brief Decode the next point, applying its deltas to the previous one
+ *
+ * @param pos Read position, advanced past the point
+ * @param end End of the encoded data
+ * @param point Previous point on input, decoded point on output
+ * @return false if the data is truncated or a value overflows
+ */
+bool ais_track_decode_point(const uint8_t **pos, const uint8_t *end, AISTrackPoint *point) {
+    uint64_t dt, dlon, dlat, dspeed, dcourse;
+
+    if (!get_varint(pos, end, &dt) || !get_varint(pos, end, &dlon) || !get_varint(pos, end, &dlat) ||
+        !get_varint(pos, end, &dspeed) || !get_varint(pos, end, &dcourse))
+        return false;
+
+    point->t = (int64_t)((uint64_t)point->t + (uint64_t)unzigzag(dt));
+    return add_delta32(&point->lon, dlon) && add_delta32(&point->lat, dlat) &&
+           add_delta32(&point->speed, dspeed) && add_delta32(&point->course, dcourse);
+}
+
+
+/**
+ * @brief Dead-reckoning test: does a point stray from the anchor's course?
+ *
+ * @param anchor Last kept point
+ * @param point Candidate point
+ * @param tolerance Allowed deviation in metres
+ * @return true if the point is further than tolerance from the prediction
+ */
+bool ais_track_deviates(const AISTrackPoint *anchor, const AISTrackPoint *point, double tolerance) {
+    double dlon = (double)point->lon - anchor->lon;
+    double mid_lat = ((double)anchor->lat + point->lat) / 2.0 / AIS_COORD_SCALE;
+
+    /* Take the short way across the antimeridian */
+    if (dlon > AIS_LON_LIMIT) dlon -= 2.0 * AIS_LON_LIMIT;
+    if (dlon < -AIS_LON_LIMIT) dlon += 2.0 * AIS_LON_LIMIT;
+
+    double east = dlon * METRES_PER_UNIT * cos(mid_lat * DEG_TO_RAD);
+    double north = ((double)point->lat - anchor->lat) * METRES_PER_UNIT;
+
+    if (anchor->speed > 0 && anchor->course >= 0) {
+        double travelled = anchor->speed * SPEED_UNIT_M_PER_MS * (double)(point->t - anchor->t);
+        double heading = anchor->course / 10.0 * DEG_TO_RAD;
+        east -= travelled * sin(heading);
+        north -= travelled * cos(heading);
+    }
+    return east * east + north * north > tolerance * tolerance;
+}
+
+
+/**
+ * @brief Great-circle (haversine) distance between two points
+ *
+ * The longitude term is periodic, so no antimeridian handling is needed.
+ *
+ * @return Distance in metres on a sphere of the mean Earth radius
+ */
+double ais_track_distance(const AISTrackPoint *a, const AISTrackPoint *b) {
+    double lat1 = (double)a->lat / AIS_COORD_SCALE * DEG_TO_RAD;
+    double lat2 = (double)b->lat / AIS_COORD_SCALE * DEG_TO_RAD;
+    double half_dlat = (lat2 - lat1) / 2.0;
+    double half_dlon = ((double)b->lon - a->lon) / AIS_COORD_SCALE * DEG_TO_RAD / 2.0;
+    double h = sin(half_dlat) * sin(half_dlat) + cos(lat1) * cos(lat2) * sin(half_dlon) * sin(half_dlon);
+
+    return 2.0 * EARTH_RADIUS * asin(sqrt(h < 1.0 ? h : 1.0));
+}
+
+
+/**
+ * @brief Smallest course change between two points
+ *
+ * @return Change in 0.1 degree (0–1800), or -1 if either course is unavailable
+ */
+int32_t ais_track_turn(const AISTrackPoint *a, const AISTrackPoint *b) {
+    if (a->course < 0 || b->course < 0) return -1;
+
+    int32_t turn = b->course > a->course ? b->course - a->course : a->course - b->course;
+    return turn > 1800 ? 3600 - turn : turn;
+}
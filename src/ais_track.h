@@ -0,0 +1,83 @@
+#ifndef AIS_TRACK_H
+#define AIS_TRACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* Longest encoding of one point: a 64-bit time delta and four 32-bit deltas */
+#define AIS_TRACK_POINT_MAX (10 + 4 * 5)
+
+
+/**
+ * @brief One point of a delta-encoded track
+ *
+ * Coordinates are fixed-point (1/10000 minute). Speed is in 0.1 knot and
+ * course in 0.1 degree; both are -1 when not available.
+ */
+typedef struct {
+    int64_t t;                 /* milliseconds */
+    int32_t lon;
+    int32_t lat;
+    int32_t speed;
+    int32_t course;
+} AISTrackPoint;
+
+
+/**
+ * @brief Append one point as zigzag varint deltas from the previous one
+ *
+ * Self-contained so the unit tests and benchmarks can use it without
+ * linking PostgreSQL.
+ *
+ * @param prev Previous point (all zero before the first point)
+ * @param point Point to encode
+ * @param out Output buffer of at least AIS_TRACK_POINT_MAX bytes
+ * @return Number of bytes written
+ */
+size_t ais_track_encode_point(const AISTrackPoint *prev, const AISTrackPoint *point, uint8_t *out);
+
+
+/**
+ * @brief Decode the next point, applying its deltas to the previous one
+ *
+ * @param pos Read position, advanced past the point
+ * @param end End of the encoded data
+ * @param point Previous point on input, decoded point on output
+ * @return false if the data is truncated or a value overflows
+ */
+bool ais_track_decode_point(const uint8_t **pos, const uint8_t *end, AISTrackPoint *point);
+
+
+/**
+ * @brief Dead-reckoning test: does a point stray from the anchor's course?
+ *
+ * Projects the anchor along its speed and course (or holds it in place if
+ * either is unavailable) to the point's time and compares the prediction
+ * with the point on a local equirectangular plane.
+ *
+ * @param anchor Last kept point
+ * @param point Candidate point
+ * @param tolerance Allowed deviation in metres
+ * @return true if the point is further than tolerance from the prediction
+ */
+bool ais_track_deviates(const AISTrackPoint *anchor, const AISTrackPoint *point, double tolerance);
+
+
+/**
+ * @brief Great-circle (haversine) distance between two points
+ *
+ * @return Distance in metres on a sphere of the mean Earth radius
+ */
+double ais_track_distance(const AISTrackPoint *a, const AISTrackPoint *b);
+
+
+/**
+ * @brief Smallest course change between two points
+ *
+ * @return Change in 0.1 degree (0–1800), or -1 if either course is unavailable
+ */
+int32_t ais_track_turn(const AISTrackPoint *a, const AISTrackPoint *b);
+
+#endif
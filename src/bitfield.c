@@ -3,22 +3,22 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
-#include "ais_ascii.h" // must define sixbit_ascii[64]
+#include "ais_ascii.h"
 
 
 /**
  * @brief Convert a 6-bit AIS character to its numeric value
  *
- * This helper decodes an ASCII character from the AIS payload (chars 48–119)
- * into a 6-bit unsigned integer according to the ITU-R M.1371 spec.
+ * This helper decodes an ASCII character from the AIS payload ('0'–'W' and
+ * '`'–'w') into a 6-bit unsigned integer according to the ITU-R M.1371 spec.
  *
  * @param c Input character from AIS payload
- * @return Value from 0–63, or 0 if input is invalid
+ * @return Value from 0–63, or -1 if input is not a payload character
  */
-static inline uint8_t sixbit_to_uint(char c) {
-    if (c < 48 || c > 119) return 0;
+static inline int sixbit_to_uint(char c) {
+    if (c < 48 || c > 119 || (c > 87 && c < 96)) return -1;
     c -= 48;
-    if (c > 40) c -= 8;
+    if (c >= 40) c -= 8;
     return c;
 }
 
@@ -54,11 +54,11 @@ ParseResult parse_uint_safe(const char *payload, int start, int len, uint32_t *r
         int bit_idx = start + i;
         int byte_idx = bit_idx / 6;
         int bit_offset = 5 - (bit_idx % 6);
-        char c = payload[byte_idx];
-        if (c < 48 || c > 119) {
+        int sixbit = sixbit_to_uint(payload[byte_idx]);
+        if (sixbit < 0) {
             return (ParseResult){ .ok = false, .code = PARSE_ERR_INVALID_BITFIELD, .msg = "Invalid 6-bit character" };
         }
-        int bit = ((c - 48) >> bit_offset) & 1;
+        int bit = (sixbit >> bit_offset) & 1;
         value = (value << 1) | bit;
     }
 
@@ -92,11 +92,11 @@ ParseResult parse_int_safe(const char *payload, int start, int len, int32_t *res
         int bit_idx = start + i;
         int byte_idx = bit_idx / 6;
         int bit_offset = 5 - (bit_idx % 6);
-        char c = payload[byte_idx];
-        if (c < 48 || c > 119) {
+        int sixbit = sixbit_to_uint(payload[byte_idx]);
+        if (sixbit < 0) {
             return (ParseResult){ .ok = false, .code = PARSE_ERR_INVALID_BITFIELD, .msg = "Invalid 6-bit character" };
         }
-        int bit = ((c - 48) >> bit_offset) & 1;
+        int bit = (sixbit >> bit_offset) & 1;
         val = (val << 1) | bit;
     }
     if ((val >> (len - 1)) & 1) {
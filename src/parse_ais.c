@@ -1,22 +1,13 @@
 #include "pg_ais.h"
 #include "parse_ais.h"
+#include "parse_ais_msg.h"
+#include "bitfield.h"
+#include "pg_ais_metrics.h"
+#include "ais_ascii.h"
 #include <string.h>
 #include <stdio.h>
 
 
-/* 6-bit ASCII to ITU-R M.1371-1 ASCII mapping */
-static const char sixbit_ascii[64] = {
-    '@', 'A', 'B', 'C', 'D', 'E', 'F', 'G',
-    'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O',
-    'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W',
-    'X', 'Y', 'Z', '[', '\\', ']', '^', '_',
-    ' ', '!', '"', '#', '$', '%', '&', '\'',
-    '(', ')', '*', '+', ',', '-', '.', '/',
-    '0', '1', '2', '3', '4', '5', '6', '7',
-    '8', '9', ':', ';', '<', '=', '>', '?'
-};
-
-
 /**
  * @brief Parse a single !AIVDM fragment into its components
  *
@@ -25,11 +16,18 @@ static const char sixbit_ascii[64] = {
  *
  * @param sentence Full NMEA sentence (e.g., "!AIVDM,1,1,,A,...*hh")
  * @param frag Output structure (caller must call free_buffer() or manage payload/raw)
- * @return true on success, false if malformed
+ * @return ParseResult indicating success or reason for failure
  */
 ParseResult parse_ais_fragment(const char *sentence, AISFragment *frag) {
+    uint64 started = PG_AIS_TIMING_START();
+
+    /* Skip NMEA 4.0 tag blocks; the sentence starts after the last '\\' */
+    if (sentence && sentence[0] == '\\') {
+        const char *bang = strstr(sentence, "\\!");
+        sentence = bang ? bang + 1 : NULL;
+    }
     if (!sentence || strncmp(sentence, "!AIVDM", 6) != 0)
-        return PARSE_ERROR;
+        return PARSE_FAILURE(PARSE_ERR_PAYLOAD_NULL, "Not an !AIVDM sentence");
 
     char copy[512];
     strncpy(copy, sentence, sizeof(copy));
@@ -43,7 +41,7 @@ ParseResult parse_ais_fragment(const char *sentence, AISFragment *frag) {
         tok = strtok(NULL, ",*");
     }
 
-    if (i < 7) return PARSE_ERROR;
+    if (i < 7) return PARSE_FAILURE(PARSE_ERR_TOO_SHORT, "Sentence has too few fields");
 
     frag->total = atoi(tokens[1]);
     frag->seq = atoi(tokens[2]);
@@ -55,7 +53,8 @@ ParseResult parse_ais_fragment(const char *sentence, AISFragment *frag) {
     frag->fill_bits = atoi(tokens[6]);
     frag->raw = AIS_STRDUP(sentence);
 
-    return PARSE_OK;
+    PG_AIS_TIMING_END(AIS_STAGE_TOKENIZE, 0, started);
+    return PARSE_SUCCESS;
 }
 
 
@@ -63,20 +62,24 @@ ParseResult parse_ais_fragment(const char *sentence, AISFragment *frag) {
  * @brief Reassemble multipart AIS message fragments into one message
  *
  * Joins payloads from a buffer of AISFragment parts and emits a synthesized AISMessage.
- * Tracks parse success using pg_ais_record_parse_result.
+ * Counts the joined message with pg_ais_record_reassembly; the decode itself
+ * is counted and timed by parse_ais_payload.
  *
  * @param buffer Fragment buffer with parts
  * @param msg_out Output parsed AISMessage
  * @return ParseResult indicating success or reason for failure
  */
 ParseResult try_reassemble(AISFragmentBuffer *buffer, AISMessage *msg_out) {
-    if (!buffer || !buffer->parts[0]) return PARSE_ERROR;
+    uint64 started = PG_AIS_TIMING_START();
+
+    if (!buffer || !buffer->parts[0]) return PARSE_FAILURE(PARSE_ERR_PAYLOAD_NULL, "No fragments buffered");
 
     int total = buffer->parts[0]->total;
-    if (buffer->received < total) return PARSE_INCOMPLETE;
+    if (total < 1 || total > MAX_PARTS || buffer->received < total)
+        return PARSE_FAILURE(PARSE_ERR_TOO_SHORT, "Fragments missing");
 
     for (int i = 0; i < total; i++) {
-        if (!buffer->parts[i]) return PARSE_INCOMPLETE;
+        if (!buffer->parts[i]) return PARSE_FAILURE(PARSE_ERR_TOO_SHORT, "Fragments missing");
     }
 
     char full_payload[1024] = {0};
@@ -85,10 +88,10 @@ ParseResult try_reassemble(AISFragmentBuffer *buffer, AISMessage *msg_out) {
     for (int i = 0; i < total; i++) {
         strncat(full_payload, buffer->parts[i]->payload, sizeof(full_payload) - strlen(full_payload) - 1);
     }
+    PG_AIS_TIMING_END(AIS_STAGE_REASSEMBLE, 0, started);
 
     ParseResult result = parse_ais_payload(msg_out, full_payload, fill_bits);
-    pg_ais_record_parse_result(result == PARSE_OK);
-    pg_ais_record_reassembly_attempt(result == PARSE_OK);
+    pg_ais_record_reassembly(AIS_REASSEMBLY_COMPLETE, 1);
     return result;
 }
 
@@ -126,23 +129,22 @@ void reset_buffer(AISFragmentBuffer *buffer) {
  * @return ParseResult indicating success or failure
  */
 ParseResult parse_string_utf8(const char *payload, int start, int bitlen, char **out) {
-    if (!payload || start < 0 || bitlen <= 0 || (bitlen % 6 != 0)) return PARSE_ERROR;
+    if (!payload || !out) return PARSE_FAILURE(PARSE_ERR_PAYLOAD_NULL, "Payload or output pointer was NULL");
+    if (start < 0 || bitlen <= 0 || (bitlen % 6 != 0))
+        return PARSE_FAILURE(PARSE_ERR_INVALID_BITFIELD, "String length is not a multiple of 6 bits");
     int charlen = bitlen / 6;
     int bitlen_total = (int)strlen(payload) * 6;
-    if ((start + bitlen) > bitlen_total) return PARSE_ERROR;
+    if ((start + bitlen) > bitlen_total) return PARSE_FAILURE(PARSE_ERR_TOO_SHORT, "String exceeds payload bounds");
 
     char *str = calloc(charlen + 1, 1);
-    if (!str) return PARSE_ERROR;
+    if (!str) return PARSE_FAILURE(PARSE_ERR_STRING_DECODE, "Memory allocation failed");
 
     for (int i = 0; i < charlen; i++) {
         uint32_t sixbit = 0;
-        if (!parse_uint_safe(payload, start + i * 6, 6, &sixbit)) {
-            free(str);
-            return PARSE_ERROR;
-        }
-        if (sixbit > 63) {
+        ParseResult result = parse_uint_safe(payload, start + i * 6, 6, &sixbit);
+        if (result.code != PARSE_OK) {
             free(str);
-            return PARSE_ERROR;
+            return result;
         }
         str[i] = (sixbit == 0) ? ' ' : sixbit_ascii[sixbit];
     }
@@ -156,5 +158,5 @@ ParseResult parse_string_utf8(const char *payload, int start, int bitlen, char *
     }
 
     *out = str;
-    return PARSE_OK;
+    return PARSE_SUCCESS;
 }
@@ -3,12 +3,150 @@
 #include <stdio.h>
 #include <math.h>
 
+#include "parse_ais.h"
 #include "parse_ais_msg.h"
 #include "bitfield.h"
 #include "shared_ais_utils.h"
 #include "pg_ais_metrics.h"
 
 
+/**
+ * @brief Check that a payload is at least the given number of bits long
+ *
+ * @param payload 6-bit encoded payload
+ * @param bits Required length in bits
+ * @return true if the payload is long enough
+ */
+static bool payload_has_bits(const char *payload, int bits) {
+    return (int)strlen(payload) * 6 >= bits;
+}
+
+
+/* Return a failed field read from the enclosing decoder */
+#define TRY_PARSE(expr) \
+    do { \
+        ParseResult try_result_ = (expr); \
+        if (try_result_.code != PARSE_OK) return try_result_; \
+    } while (0)
+
+
+/**
+ * @brief Read an unsigned field of up to 8 bits into a byte
+ *
+ * @param payload 6-bit encoded payload
+ * @param start Bit offset of the field
+ * @param len Field width in bits
+ * @param out Output value, untouched on error
+ * @return ParseResult of the underlying read
+ */
+static ParseResult parse_u8(const char *payload, int start, int len, uint8_t *out) {
+    uint32_t value;
+    ParseResult result = parse_uint_safe(payload, start, len, &value);
+    if (result.code == PARSE_OK) *out = (uint8_t)value;
+    return result;
+}
+
+
+/**
+ * @brief Read the 30-bit MMSI every message carries at bit 8
+ *
+ * @param msg Message to fill
+ * @param payload 6-bit encoded payload
+ * @return ParseResult of the underlying read
+ */
+static ParseResult parse_mmsi(AISMessage *msg, const char *payload) {
+    uint32_t mmsi;
+    ParseResult result = parse_uint_safe(payload, 8, 30, &mmsi);
+    if (result.code == PARSE_OK) msg->mmsi = (int)mmsi;
+    return result;
+}
+
+
+/**
+ * @brief Read a 28-bit longitude and 27-bit latitude in 1/10000 minute
+ *
+ * @param msg Message to fill
+ * @param payload 6-bit encoded payload
+ * @param lon_start Bit offset of the longitude
+ * @param lat_start Bit offset of the latitude
+ * @return ParseResult of the first failed read, or success
+ */
+static ParseResult parse_position(AISMessage *msg, const char *payload, int lon_start, int lat_start) {
+    double lon, lat;
+    TRY_PARSE(parse_lon_safe(payload, lon_start, &lon));
+    TRY_PARSE(parse_lat_safe(payload, lat_start, &lat));
+    msg->lon = (float)lon;
+    msg->lat = (float)lat;
+    return PARSE_SUCCESS;
+}
+
+
+/**
+ * @brief Read speed over ground, course over ground and true heading
+ *
+ * @param msg Message to fill
+ * @param payload 6-bit encoded payload
+ * @param speed_start Bit offset of the 10-bit speed
+ * @param course_start Bit offset of the 12-bit course
+ * @param heading_start Bit offset of the 9-bit heading
+ * @return ParseResult of the first failed read, or success
+ */
+static ParseResult parse_motion(AISMessage *msg, const char *payload, int speed_start, int course_start,
+                                int heading_start) {
+    double speed, heading;
+    uint32_t course_raw;
+    TRY_PARSE(parse_speed_safe(payload, speed_start, &speed));
+    TRY_PARSE(parse_uint_safe(payload, course_start, 12, &course_raw));
+    TRY_PARSE(parse_heading_safe(payload, heading_start, &heading));
+    msg->speed = (float)speed;
+    msg->course = course_raw / 10.0;
+    msg->heading = (float)heading;
+    return PARSE_SUCCESS;
+}
+
+
+/**
+ * @brief Copy the binary data of a message, timed as the dearmor stage
+ *
+ * @param msg Message to fill; msg->type must be set
+ * @param payload 6-bit encoded payload
+ * @param start Bit offset of the binary data
+ * @param len Length of the binary data in bits
+ * @return ParseResult, PARSE_ERR_TOO_SHORT on bounds error
+ */
+static ParseResult dearmor_bin_payload(AISMessage *msg, const char *payload, int start, int len) {
+    uint64 started = PG_AIS_TIMING_START();
+    int bin_len = 0;
+    bool ok = parse_bin_payload(payload, start, len, &msg->bin_data, &bin_len);
+    PG_AIS_TIMING_END(AIS_STAGE_DEARMOR, msg->type, started);
+    if (!ok) return PARSE_FAILURE(PARSE_ERR_TOO_SHORT, "Binary data exceeds payload bounds");
+    msg->bin_len = (uint32_t)bin_len;
+    return PARSE_SUCCESS;
+}
+
+
+/**
+ * @brief Decode the four reference-point distances of a static report
+ *
+ * @param msg Message to fill
+ * @param payload 6-bit encoded payload
+ * @param start Bit offset of dimension to bow
+ * @return ParseResult of the first failed read, or success
+ */
+static ParseResult parse_dimensions(AISMessage *msg, const char *payload, int start) {
+    uint32_t bow, stern, port, starboard;
+    TRY_PARSE(parse_uint_safe(payload, start, 9, &bow));
+    TRY_PARSE(parse_uint_safe(payload, start + 9, 9, &stern));
+    TRY_PARSE(parse_uint_safe(payload, start + 18, 6, &port));
+    TRY_PARSE(parse_uint_safe(payload, start + 24, 6, &starboard));
+    msg->dimension_to_bow = bow;
+    msg->dimension_to_stern = stern;
+    msg->dimension_to_port = port;
+    msg->dimension_to_starboard = starboard;
+    return PARSE_SUCCESS;
+}
+
+
 /**
  * @brief Parses AIS message types 1, 2, and 3 (Class A position reports)
  *
@@ -21,24 +159,21 @@
  */
 ParseResult parse_msg_1_2_3(AISMessage *msg, const char *payload) {
     msg->type = 1;
-    if (!parse_uint_safe(payload, 6, 2, &msg->repeat)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 38, 4, &msg->nav_status)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 42, 8, &msg->rot)) return PARSE_ERROR;
-    msg->speed = parse_speed(payload, 50);
-    if (!parse_uint_safe(payload, 60, 1, &msg->accuracy)) return PARSE_ERROR;
-    msg->lon = parse_lon(payload, 61);
-    msg->lat = parse_lat(payload, 89);
-    uint32_t course_raw;
-    if (!parse_uint_safe(payload, 116, 12, &course_raw)) return PARSE_ERROR;
-    msg->course = course_raw / 10.0;
-    msg->heading = parse_heading(payload, 128);
-    if (!parse_uint_safe(payload, 137, 6, &msg->timestamp)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 143, 2, &msg->maneuver)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 148, 1, &msg->raim)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 149, 19, &msg->radio)) return PARSE_ERROR;
+    TRY_PARSE(parse_u8(payload, 6, 2, &msg->repeat));
+    TRY_PARSE(parse_mmsi(msg, payload));
+    TRY_PARSE(parse_u8(payload, 38, 4, &msg->nav_status));
+    int32_t rot;
+    TRY_PARSE(parse_int_safe(payload, 42, 8, &rot));
+    msg->rot = (int8_t)rot;
+    TRY_PARSE(parse_u8(payload, 60, 1, &msg->accuracy));
+    TRY_PARSE(parse_position(msg, payload, 61, 89));
+    TRY_PARSE(parse_motion(msg, payload, 50, 116, 128));
+    TRY_PARSE(parse_u8(payload, 137, 6, &msg->timestamp));
+    TRY_PARSE(parse_u8(payload, 143, 2, &msg->maneuver));
+    TRY_PARSE(parse_u8(payload, 148, 1, &msg->raim));
+    TRY_PARSE(parse_uint_safe(payload, 149, 19, &msg->radio));
     normalize_position_fields(msg);
-    return PARSE_OK;
+    return PARSE_SUCCESS;
 }
 
 
@@ -53,16 +188,15 @@ ParseResult parse_msg_1_2_3(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_4_11(AISMessage *msg, const char *payload) {
     msg->type = 4;
-    if (!parse_uint_safe(payload, 6, 2, &msg->repeat)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 78, 1, &msg->accuracy)) return PARSE_ERROR;
-    msg->lon = parse_lon(payload, 79);
-    msg->lat = parse_lat(payload, 107);
-    if (!parse_uint_safe(payload, 137, 6, &msg->timestamp)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 148, 1, &msg->raim)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 149, 19, &msg->radio)) return PARSE_ERROR;
+    TRY_PARSE(parse_u8(payload, 6, 2, &msg->repeat));
+    TRY_PARSE(parse_mmsi(msg, payload));
+    TRY_PARSE(parse_u8(payload, 78, 1, &msg->accuracy));
+    TRY_PARSE(parse_position(msg, payload, 79, 107));
+    TRY_PARSE(parse_u8(payload, 137, 6, &msg->timestamp));
+    TRY_PARSE(parse_u8(payload, 148, 1, &msg->raim));
+    TRY_PARSE(parse_uint_safe(payload, 149, 19, &msg->radio));
     normalize_position_fields(msg);
-    return PARSE_OK;
+    return PARSE_SUCCESS;
 }
 
 
@@ -77,11 +211,39 @@ ParseResult parse_msg_4_11(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_5(AISMessage *msg, const char *payload) {
     msg->type = 5;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 40, 30, &msg->imo)) return PARSE_ERROR;
-    if (parse_string_utf8(payload, 70, 42, &msg->callsign) != PARSE_OK) return PARSE_ERROR;
-    if (parse_string_utf8(payload, 112, 120, &msg->vessel_name) != PARSE_OK) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(parse_mmsi(msg, payload));
+    TRY_PARSE(parse_uint_safe(payload, 40, 30, &msg->imo));
+    TRY_PARSE(parse_string_utf8(payload, 70, 42, &msg->callsign));
+    TRY_PARSE(parse_string_utf8(payload, 112, 120, &msg->vessel_name));
+
+    unsigned fields = AIS_STATIC_NAME | AIS_STATIC_CALLSIGN | AIS_STATIC_IMO;
+
+    /* Voyage data; some transmitters truncate the tail of the message */
+    if (payload_has_bits(payload, 302)) {
+        uint32_t ship_type, fix_type, month, day, hour, minute, draught;
+        TRY_PARSE(parse_uint_safe(payload, 232, 8, &ship_type));
+        TRY_PARSE(parse_dimensions(msg, payload, 240));
+        TRY_PARSE(parse_uint_safe(payload, 270, 4, &fix_type));
+        TRY_PARSE(parse_uint_safe(payload, 274, 4, &month));
+        TRY_PARSE(parse_uint_safe(payload, 278, 5, &day));
+        TRY_PARSE(parse_uint_safe(payload, 283, 5, &hour));
+        TRY_PARSE(parse_uint_safe(payload, 288, 6, &minute));
+        TRY_PARSE(parse_uint_safe(payload, 294, 8, &draught));
+        msg->ship_type = ship_type;
+        msg->fix_type = fix_type;
+        msg->eta_month = month;
+        msg->eta_day = day;
+        msg->eta_hour = hour;
+        msg->eta_minute = minute;
+        msg->draught = draught / 10.0f;
+        fields |= AIS_STATIC_SHIP_TYPE | AIS_STATIC_DIMENSIONS;
+    }
+    if (payload_has_bits(payload, 422) &&
+        parse_string_utf8(payload, 302, 120, &msg->destination).code == PARSE_OK)
+        fields |= AIS_STATIC_DESTINATION;
+
+    msg->static_fields = fields;
+    return PARSE_SUCCESS;
 }
 
 
@@ -96,11 +258,11 @@ ParseResult parse_msg_5(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_6(AISMessage *msg, const char *payload) {
     msg->type = 6;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
+    TRY_PARSE(parse_mmsi(msg, payload));
     int bin_start = 88;
     int bin_len = ((int)strlen(payload) * 6) - bin_start;
-    if (!parse_bin_payload(payload, bin_start, bin_len, &msg->bin_data, &msg->bin_len)) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(dearmor_bin_payload(msg, payload, bin_start, bin_len));
+    return PARSE_SUCCESS;
 }
 
 
@@ -115,8 +277,8 @@ ParseResult parse_msg_6(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_7(AISMessage *msg, const char *payload) {
     msg->type = 7;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(parse_mmsi(msg, payload));
+    return PARSE_SUCCESS;
 }
 
 
@@ -131,11 +293,11 @@ ParseResult parse_msg_7(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_8(AISMessage *msg, const char *payload) {
     msg->type = 8;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
+    TRY_PARSE(parse_mmsi(msg, payload));
     int bin_start = 56;
     int bin_len = ((int)strlen(payload) * 6) - bin_start;
-    if (!parse_bin_payload(payload, bin_start, bin_len, &msg->bin_data, &msg->bin_len)) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(dearmor_bin_payload(msg, payload, bin_start, bin_len));
+    return PARSE_SUCCESS;
 }
 
 
@@ -150,16 +312,11 @@ ParseResult parse_msg_8(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_9(AISMessage *msg, const char *payload) {
     msg->type = 9;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    msg->lat = parse_lat(payload, 107);
-    msg->lon = parse_lon(payload, 79);
-    msg->speed = parse_speed(payload, 50);
-    msg->heading = parse_heading(payload, 128);
-    uint32_t course_raw;
-    if (!parse_uint_safe(payload, 116, 12, &course_raw)) return PARSE_ERROR;
-    msg->course = course_raw / 10.0;
+    TRY_PARSE(parse_mmsi(msg, payload));
+    TRY_PARSE(parse_position(msg, payload, 79, 107));
+    TRY_PARSE(parse_motion(msg, payload, 50, 116, 128));
     normalize_position_fields(msg);
-    return PARSE_OK;
+    return PARSE_SUCCESS;
 }
 
 
@@ -174,8 +331,8 @@ ParseResult parse_msg_9(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_10(AISMessage *msg, const char *payload) {
     msg->type = 10;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(parse_mmsi(msg, payload));
+    return PARSE_SUCCESS;
 }
 
 
@@ -190,10 +347,10 @@ ParseResult parse_msg_10(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_12(AISMessage *msg, const char *payload) {
     msg->type = 12;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
+    TRY_PARSE(parse_mmsi(msg, payload));
     int bitlen = ((int)strlen(payload) * 6) - 72;
-    if (parse_string_utf8(payload, 72, bitlen, &msg->vessel_name) != PARSE_OK) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(parse_string_utf8(payload, 72, bitlen, &msg->vessel_name));
+    return PARSE_SUCCESS;
 }
 
 
@@ -208,8 +365,8 @@ ParseResult parse_msg_12(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_13(AISMessage *msg, const char *payload) {
     msg->type = 13;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(parse_mmsi(msg, payload));
+    return PARSE_SUCCESS;
 }
 
 
@@ -224,16 +381,14 @@ ParseResult parse_msg_13(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_14(AISMessage *msg, const char *payload) {
     msg->type = 14;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
+    TRY_PARSE(parse_mmsi(msg, payload));
     int bitlen = ((int)strlen(payload) * 6) - 40;
-    if (parse_string_utf8(payload, 40, bitlen, &msg->vessel_name) != PARSE_OK) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(parse_string_utf8(payload, 40, bitlen, &msg->vessel_name));
+    return PARSE_SUCCESS;
 }
 
 
 /**
- * @brief Parses AIS message type 15 (Interrogation)
- *//**
  * @brief Parses AIS message type 15 (Interrogation)
  *
  * Requests data from another vessel.
@@ -244,8 +399,8 @@ ParseResult parse_msg_14(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_15(AISMessage *msg, const char *payload) {
     msg->type = 15;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(parse_mmsi(msg, payload));
+    return PARSE_SUCCESS;
 }
 
 
@@ -260,8 +415,8 @@ ParseResult parse_msg_15(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_16(AISMessage *msg, const char *payload) {
     msg->type = 16;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(parse_mmsi(msg, payload));
+    return PARSE_SUCCESS;
 }
 
 
@@ -276,11 +431,45 @@ ParseResult parse_msg_16(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_17(AISMessage *msg, const char *payload) {
     msg->type = 17;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
+    TRY_PARSE(parse_mmsi(msg, payload));
     int bin_start = 80;
     int bin_len = ((int)strlen(payload) * 6) - bin_start;
-    if (!parse_bin_payload(payload, bin_start, bin_len, &msg->bin_data, &msg->bin_len)) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(dearmor_bin_payload(msg, payload, bin_start, bin_len));
+    return PARSE_SUCCESS;
+}
+
+
+/**
+ * @brief Parses AIS message type 24 (Class B static data report)
+ *
+ * Part A carries the vessel name; part B the ship type, callsign and
+ * dimensions. Other part numbers are invalid.
+ *
+ * @param msg Pointer to AISMessage struct to populate
+ * @param payload Encoded payload string
+ * @return ParseResult with outcome of decoding
+ */
+static ParseResult parse_msg_24(AISMessage *msg, const char *payload) {
+    uint32_t part, ship_type;
+
+    msg->type = 24;
+    TRY_PARSE(parse_u8(payload, 6, 2, &msg->repeat));
+    TRY_PARSE(parse_mmsi(msg, payload));
+    TRY_PARSE(parse_uint_safe(payload, 38, 2, &part));
+
+    if (part == 0) {
+        TRY_PARSE(parse_string_utf8(payload, 40, 120, &msg->vessel_name));
+        msg->static_fields = AIS_STATIC_NAME;
+        return PARSE_SUCCESS;
+    }
+    if (part != 1) return PARSE_FAILURE(PARSE_ERR_INVALID_BITFIELD, "Invalid type 24 part number");
+
+    TRY_PARSE(parse_uint_safe(payload, 40, 8, &ship_type));
+    TRY_PARSE(parse_string_utf8(payload, 90, 42, &msg->callsign));
+    TRY_PARSE(parse_dimensions(msg, payload, 132));
+    msg->ship_type = ship_type;
+    msg->static_fields = AIS_STATIC_CALLSIGN | AIS_STATIC_SHIP_TYPE | AIS_STATIC_DIMENSIONS;
+    return PARSE_SUCCESS;
 }
 
 
@@ -294,22 +483,31 @@ ParseResult parse_msg_17(AISMessage *msg, const char *payload) {
  * @return ParseResult with outcome of decoding
  */
 ParseResult parse_msg_18_19_24(AISMessage *msg, const char *payload) {
+    uint32_t type;
+    TRY_PARSE(parse_uint_safe(payload, 0, 6, &type));
+    if (type == 24) return parse_msg_24(msg, payload);
+
     msg->type = 18;
-    if (!parse_uint_safe(payload, 6, 2, &msg->repeat)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    msg->speed = parse_speed(payload, 46);
-    if (!parse_uint_safe(payload, 56, 1, &msg->accuracy)) return PARSE_ERROR;
-    msg->lon = parse_lon(payload, 57);
-    msg->lat = parse_lat(payload, 85);
-    uint32_t course_raw;
-    if (!parse_uint_safe(payload, 112, 12, &course_raw)) return PARSE_ERROR;
-    msg->course = course_raw / 10.0;
-    msg->heading = parse_heading(payload, 128);
-    if (!parse_uint_safe(payload, 134, 6, &msg->timestamp)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 148, 1, &msg->raim)) return PARSE_ERROR;
-    if (!parse_uint_safe(payload, 149, 19, &msg->radio)) return PARSE_ERROR;
+    TRY_PARSE(parse_u8(payload, 6, 2, &msg->repeat));
+    TRY_PARSE(parse_mmsi(msg, payload));
+    TRY_PARSE(parse_u8(payload, 56, 1, &msg->accuracy));
+    TRY_PARSE(parse_position(msg, payload, 57, 85));
+    TRY_PARSE(parse_motion(msg, payload, 46, 112, 128));
+    TRY_PARSE(parse_u8(payload, 134, 6, &msg->timestamp));
+    TRY_PARSE(parse_u8(payload, 148, 1, &msg->raim));
+    TRY_PARSE(parse_uint_safe(payload, 149, 19, &msg->radio));
     normalize_position_fields(msg);
-    return PARSE_OK;
+
+    /* Type 19 appends the name, ship type and dimensions */
+    if (type == 19 && payload_has_bits(payload, 301)) {
+        uint32_t ship_type;
+        TRY_PARSE(parse_string_utf8(payload, 143, 120, &msg->vessel_name));
+        TRY_PARSE(parse_uint_safe(payload, 263, 8, &ship_type));
+        TRY_PARSE(parse_dimensions(msg, payload, 271));
+        msg->ship_type = ship_type;
+        msg->static_fields = AIS_STATIC_NAME | AIS_STATIC_SHIP_TYPE | AIS_STATIC_DIMENSIONS;
+    }
+    return PARSE_SUCCESS;
 }
 
 
@@ -324,8 +522,8 @@ ParseResult parse_msg_18_19_24(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_20(AISMessage *msg, const char *payload) {
     msg->type = 20;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(parse_mmsi(msg, payload));
+    return PARSE_SUCCESS;
 }
 
 
@@ -340,11 +538,10 @@ ParseResult parse_msg_20(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_21(AISMessage *msg, const char *payload) {
     msg->type = 21;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    msg->lon = parse_lon(payload, 57);
-    msg->lat = parse_lat(payload, 85);
+    TRY_PARSE(parse_mmsi(msg, payload));
+    TRY_PARSE(parse_position(msg, payload, 57, 85));
     normalize_position_fields(msg);
-    return PARSE_OK;
+    return PARSE_SUCCESS;
 }
 
 
@@ -359,8 +556,8 @@ ParseResult parse_msg_21(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_22(AISMessage *msg, const char *payload) {
     msg->type = 22;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(parse_mmsi(msg, payload));
+    return PARSE_SUCCESS;
 }
 
 
@@ -375,8 +572,8 @@ ParseResult parse_msg_22(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_23(AISMessage *msg, const char *payload) {
     msg->type = 23;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(parse_mmsi(msg, payload));
+    return PARSE_SUCCESS;
 }
 
 
@@ -391,11 +588,11 @@ ParseResult parse_msg_23(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_25(AISMessage *msg, const char *payload) {
     msg->type = 25;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
+    TRY_PARSE(parse_mmsi(msg, payload));
     int bin_start = 40;
     int bin_len = ((int)strlen(payload) * 6) - bin_start;
-    if (!parse_bin_payload(payload, bin_start, bin_len, &msg->bin_data, &msg->bin_len)) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(dearmor_bin_payload(msg, payload, bin_start, bin_len));
+    return PARSE_SUCCESS;
 }
 
 
@@ -410,11 +607,11 @@ ParseResult parse_msg_25(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_26(AISMessage *msg, const char *payload) {
     msg->type = 26;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
+    TRY_PARSE(parse_mmsi(msg, payload));
     int bin_start = 90;
     int bin_len = ((int)strlen(payload) * 6) - bin_start;
-    if (!parse_bin_payload(payload, bin_start, bin_len, &msg->bin_data, &msg->bin_len)) return PARSE_ERROR;
-    return PARSE_OK;
+    TRY_PARSE(dearmor_bin_payload(msg, payload, bin_start, bin_len));
+    return PARSE_SUCCESS;
 }
 
 
@@ -429,11 +626,10 @@ ParseResult parse_msg_26(AISMessage *msg, const char *payload) {
  */
 ParseResult parse_msg_27(AISMessage *msg, const char *payload) {
     msg->type = 27;
-    if (!parse_uint_safe(payload, 8, 30, &msg->mmsi)) return PARSE_ERROR;
-    msg->lon = parse_lon(payload, 44);
-    msg->lat = parse_lat(payload, 61);
+    TRY_PARSE(parse_mmsi(msg, payload));
+    TRY_PARSE(parse_position(msg, payload, 44, 61));
     normalize_position_fields(msg);
-    return PARSE_OK;
+    return PARSE_SUCCESS;
 }
 
 
@@ -450,9 +646,10 @@ ParseResult parse_msg_27(AISMessage *msg, const char *payload) {
 ParseResult parse_ais_payload(AISMessage *msg, const char *payload, int fill_bits) {
     ParseResult result;
     (void)fill_bits;
-    if (!payload || strlen(payload) < 1) return PARSE_ERROR;
+    if (!payload || strlen(payload) < 1) return PARSE_FAILURE(PARSE_ERR_PAYLOAD_NULL, "Empty payload");
     uint32_t msg_type;
-    if (!parse_uint_safe(payload, 0, 6, &msg_type)) return PARSE_ERROR;
+    TRY_PARSE(parse_uint_safe(payload, 0, 6, &msg_type));
+    uint64 started = PG_AIS_TIMING_START();
     switch (msg_type) {
         case 1:
         case 2:
@@ -481,9 +678,64 @@ ParseResult parse_ais_payload(AISMessage *msg, const char *payload, int fill_bit
         case 25: result = parse_msg_25(msg, payload); break;
         case 26: result = parse_msg_26(msg, payload); break;
         case 27: result = parse_msg_27(msg, payload); break;
-        default: result = PARSE_UNSUPPORTED; break;
-        default: return PARSE_UNSUPPORTED;
+        default: result = PARSE_FAILURE(PARSE_ERR_UNSUPPORTED_TYPE, "Unsupported message type"); break;
     }
-    pg_ais_record_parse_result(result == PARSE_OK);
+    PG_AIS_TIMING_END(AIS_STAGE_DECODE, (int)msg_type, started);
+    pg_ais_record_parse_result((int)msg_type, result);
     return result;
 }
+
+
+/**
+ * @brief Decode a single-part message straight from a payload view
+ *
+ * Copies the payload into a bounded stack buffer (the view is not
+ * NUL-terminated) and dispatches to parse_ais_payload(). Used by the SQL
+ * accessors so they never build an intermediate C string of the sentence.
+ *
+ * @param msg AISMessage struct to fill (caller must zero it)
+ * @param view Payload view of a single-part sentence
+ * @return ParseResult containing structured status of parse attempt
+ */
+ParseResult parse_ais_view(AISMessage *msg, const AISPayloadView *view) {
+    if (!view || view->total != 1) {
+        return (ParseResult){ .ok = false, .code = PARSE_ERR_TOO_SHORT, .msg = "Not a complete single-part payload" };
+    }
+    return parse_ais_views(msg, view, 1);
+}
+
+
+/**
+ * @brief Decode a reassembled message from its fragment views
+ *
+ * Concatenates the fragment payloads into a bounded stack buffer and
+ * dispatches to parse_ais_payload() with the fill bits of the last part.
+ *
+ * @param msg AISMessage struct to fill (caller must zero it)
+ * @param parts Fragment views ordered by sequence number
+ * @param nparts Number of fragments
+ * @return ParseResult containing structured status of parse attempt
+ */
+ParseResult parse_ais_views(AISMessage *msg, const AISPayloadView *parts, int nparts) {
+    char payload[AIS_MAX_SENTENCE_LEN];
+    int len = 0;
+
+    if (!parts || nparts < 1) {
+        return (ParseResult){ .ok = false, .code = PARSE_ERR_TOO_SHORT, .msg = "No payload fragments" };
+    }
+    uint64 started = PG_AIS_TIMING_START();
+    for (int i = 0; i < nparts; i++) {
+        if (parts[i].len < 0 || len + parts[i].len >= (int)sizeof(payload)) {
+            return (ParseResult){ .ok = false, .code = PARSE_ERR_TOO_SHORT, .msg = "Payload exceeds maximum sentence length" };
+        }
+        memcpy(payload + len, parts[i].payload, parts[i].len);
+        len += parts[i].len;
+    }
+    if (len < 1) {
+        return (ParseResult){ .ok = false, .code = PARSE_ERR_TOO_SHORT, .msg = "Empty payload" };
+    }
+
+    payload[len] = '\0';
+    if (nparts > 1) PG_AIS_TIMING_END(AIS_STAGE_REASSEMBLE, 0, started);
+    return parse_ais_payload(msg, payload, parts[nparts - 1].fill_bits);
+}
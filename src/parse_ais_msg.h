@@ -5,6 +5,16 @@
 #include "pg_ais.h"
 #include "ais_core.h"
 #include "shared_ais_utils.h"
+#include "ais_payload.h"
+
+/* Static data a decoded message carries, recorded in AISMessage.static_fields */
+#define AIS_STATIC_NAME        0x01
+#define AIS_STATIC_CALLSIGN    0x02
+#define AIS_STATIC_IMO         0x04
+#define AIS_STATIC_SHIP_TYPE   0x08
+#define AIS_STATIC_DIMENSIONS  0x10
+#define AIS_STATIC_DESTINATION 0x20
+
 
 /**
  * @brief Parses AIS message types 1, 2, and 3 (Class A position reports)
@@ -178,7 +188,9 @@ ParseResult parse_msg_17(AISMessage *msg, const char *payload);
 /**
  * @brief Parses AIS message types 18, 19, and 24 (Class B reports)
  *
- * Class B equipment position, static, and vessel type details.
+ * Class B equipment position, static, and vessel type details. Type 24 is
+ * decoded by part: A carries the name, B the callsign, ship type and
+ * dimensions.
  *
  * @param msg Pointer to AISMessage struct to populate
  * @param payload Encoded payload string
@@ -283,4 +295,30 @@ ParseResult parse_msg_27(AISMessage *msg, const char *payload);
  */
 ParseResult parse_ais_payload(AISMessage *msg, const char *payload, int fill_bits);
 
-#endif
\ No newline at end of file
+
+
+/**
+ * @brief Decode a single-part message straight from a payload view
+ *
+ * Copies the payload into a bounded stack buffer (the view is not
+ * NUL-terminated) and dispatches to parse_ais_payload(). Used by the SQL
+ * accessors so they never build an intermediate C string of the sentence.
+ *
+ * @param msg AISMessage struct to fill (caller must zero it)
+ * @param view Payload view of a single-part sentence
+ * @return ParseResult containing structured status of parse attempt
+ */
+ParseResult parse_ais_view(AISMessage *msg, const AISPayloadView *view);
+
+
+/**
+ * @brief Decode a reassembled message from its fragment views
+ *
+ * @param msg AISMessage struct to fill (caller must zero it)
+ * @param parts Fragment views ordered by sequence number
+ * @param nparts Number of fragments
+ * @return ParseResult containing structured status of parse attempt
+ */
+ParseResult parse_ais_views(AISMessage *msg, const AISPayloadView *parts, int nparts);
+
+#endif
@@ -4,6 +4,8 @@
 /* parse_ais_result.h - structured error model for AIS parsing */
 #pragma once
 
+#include <stdbool.h>
+
 /**
  * @brief Error codes returned by parsing functions.
  */
@@ -25,4 +27,10 @@ typedef struct {
     const char *msg;              ///< Optional human-readable error message
 } ParseResult;
 
+/** Result of a successful parse */
+#define PARSE_SUCCESS ((ParseResult){ .ok = true, .code = PARSE_OK, .msg = NULL })
+
+/** Result of a failed parse with the given code and message */
+#define PARSE_FAILURE(c, m) ((ParseResult){ .ok = false, .code = (c), .msg = (m) })
+
 #endif
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include "fmgr.h"
 #include "utils/varlena.h"
 
+#include "ais_core.h"
+
 #define MAX_PARTS 5
 
 #ifndef AIS_ALLOC
@@ -35,6 +37,16 @@ typedef struct ais {
 } ais;
 
 
+/**
+ * @brief Fetch an ais datum, detoasting but keeping a short varlena header
+ *
+ * Use VARDATA_ANY / VARSIZE_ANY_EXHDR on the result. Avoids the copy that
+ * PG_GETARG_POINTER callers need before touching the payload.
+ */
+#define DatumGetAisPP(d) ((ais *) PG_DETOAST_DATUM_PACKED(d))
+#define PG_GETARG_AIS_PP(n) DatumGetAisPP(PG_GETARG_DATUM(n))
+
+
 // AIS Message structures
 /**
  * @brief Structure representing a single AIS NMEA fragment
@@ -65,25 +77,6 @@ typedef struct {
 } AISFragmentBuffer;
 
 
-/**
- * @brief Decoded representation of a full AIS message
- *
- * Parsed result after reassembling and decoding one or more AIS fragments.
- * Contains fields commonly used in vessel tracking and analytics.
- */
-typedef struct {
-    int type;
-    int mmsi;
-    float lat;
-    float lon;
-    float speed;
-    float heading;
-    uint32_t imo;
-    char *callsign;
-    char *vessel_name;
-} AISMessage;
-
-
 /**
  * @brief Convert a PostgreSQL ais varlena value to a C-string
  *
@@ -114,6 +107,30 @@ ais *ais_from_cstring_external(const char *str);
 Datum pg_ais_get_text_field(PG_FUNCTION_ARGS);
 
 
+/**
+ * @brief Return the core decoded fields of an AIS message as JSONB
+ *
+ * Usage: SELECT pg_ais_parse(sentence);
+ */
+PGDLLEXPORT Datum pg_ais_parse(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Return every decoded field of a single-part message as JSONB
+ *
+ * Usage: SELECT pg_ais_parse_full(sentence);
+ */
+PGDLLEXPORT Datum pg_ais_parse_full(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Return every decoded field of a reassembled multipart message as JSONB
+ *
+ * Usage: SELECT pg_ais_parse_full(ARRAY[part1, part2]);
+ */
+PGDLLEXPORT Datum pg_ais_parse_full_parts(PG_FUNCTION_ARGS);
+
+
 /**
  * @brief Return a debug JSONB object containing all parsed fields
  *
@@ -123,25 +140,43 @@ PGDLLEXPORT Datum pg_ais_debug(PG_FUNCTION_ARGS);
 
 
 /**
- * @brief Return a set of named fields for a given AIS message
+ * @brief Return the decoded fields of an AIS message as one ais_fields row
  *
- * This is a set-returning function (SRF) that returns key/value pairs.
+ * Usage: SELECT (pg_ais_fields(sentence)).*;
  */
 PGDLLEXPORT Datum pg_ais_fields(PG_FUNCTION_ARGS);
 
 
 /**
- * @brief Return a PostGIS-compatible geometry Point (lon, lat)
+ * @brief Return the source station ("s:") of the sentence's tag block
  *
- * Usage: SELECT pg_ais_point(sentence);
+ * Usage: SELECT pg_ais_station(sentence);
  */
-PGDLLEXPORT Datum pg_ais_point(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_ais_station(PG_FUNCTION_ARGS);
 
 
 /**
- * @brief Alias for pg_ais_point() for PostGIS geometry
+ * @brief Return the receive time ("c:") of the sentence's tag block
+ *
+ * Usage: SELECT pg_ais_receive_time(sentence);
  */
-PGDLLEXPORT Datum pg_ais_point_geom(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_ais_receive_time(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Return the receiver line count ("n:") of the sentence's tag block
+ *
+ * Usage: SELECT pg_ais_line_count(sentence);
+ */
+PGDLLEXPORT Datum pg_ais_line_count(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Return the position as a native point (lon, lat)
+ *
+ * Usage: SELECT pg_ais_point(sentence);
+ */
+PGDLLEXPORT Datum pg_ais_point(PG_FUNCTION_ARGS);
 
 
 /**
@@ -4,13 +4,14 @@
 /**
  * @brief Wrap a raw AIS NMEA sentence as a PostgreSQL varlena value
  *
- * Validates that the input string starts with '!' and wraps it as an ais datum.
+ * Validates that the input string starts with '!' or an NMEA 4.0 tag block
+ * ('\\') and wraps it as an ais datum.
  *
  * @param str Null-terminated NMEA 0183 AIS sentence string
  * @return New ais varlena wrapper (palloc'd or malloc'd), or NULL on error
  */
 ais *ais_from_cstring_external(const char *str) {
-    if (!str || str[0] != '!') return NULL;
+    if (!str || (str[0] != '!' && str[0] != '\\')) return NULL;
     size_t len = strlen(str);
     ais *result = (ais *) AIS_ALLOC(VARHDRSZ + len);
     if (!result) return NULL;
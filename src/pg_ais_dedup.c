@@ -0,0 +1,283 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "datatype/timestamp.h"
+#include "utils/array.h"
+#include "utils/lsyscache.h"
+#include "utils/timestamp.h"
+
+#include <string.h>
+
+#include "pg_ais.h"
+#include "ais_payload.h"
+#include "ais_hash.h"
+#include "pg_ais_dedup.h"
+
+
+/**
+ * @brief Return the bytes that identify a message for hashing and equality
+ *
+ * For well-formed sentences this is the armored payload plus its fill bits,
+ * so the same message heard on another channel or with another sequence id
+ * compares equal. Malformed input falls back to the whole sentence.
+ *
+ * @param value Detoasted ais varlena
+ * @param data Output pointer to identifying bytes (borrowed)
+ * @param len Output length of identifying bytes
+ * @return Fill bits of the payload, or -1 for the whole-sentence fallback
+ */
+static int ais_identity(const ais *value, const char **data, size_t *len) {
+    AISPayloadView view;
+    if (ais_payload_view(VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value), &view)) {
+        *data = view.payload;
+        *len = (size_t)view.len;
+        return view.fill_bits;
+    }
+    *data = VARDATA_ANY(value);
+    *len = VARSIZE_ANY_EXHDR(value);
+    return -1;
+}
+
+
+/**
+ * @brief Hash the identifying bytes of an ais datum
+ *
+ * @param value Detoasted ais varlena
+ * @param seed Hash seed
+ * @return 64-bit hash
+ */
+static uint64_t ais_identity_hash(const ais *value, uint64_t seed) {
+    const char *data;
+    size_t len;
+    ais_identity(value, &data, &len);
+    return ais_hash64(data, len, seed);
+}
+
+
+/**
+ * @brief Return a 64-bit hash of the message payload
+ *
+ * Hashes the payload in place; the sentence is never converted to a C string.
+ * An index on this expression is 8 bytes per row.
+ *
+ * Usage: SELECT pg_ais_hash64(sentence);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_hash64);
+Datum
+pg_ais_hash64(PG_FUNCTION_ARGS) {
+    ais *value = PG_GETARG_AIS_PP(0);
+    PG_RETURN_INT64((int64) ais_identity_hash(value, 0));
+}
+
+
+/**
+ * @brief Hash opclass support: 32-bit payload hash
+ *
+ * Equal to the low 32 bits of the seed-0 extended hash, as the hash AM requires.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_hash);
+Datum
+pg_ais_hash(PG_FUNCTION_ARGS) {
+    ais *value = PG_GETARG_AIS_PP(0);
+    PG_RETURN_INT32((int32) (uint32) ais_identity_hash(value, 0));
+}
+
+
+/**
+ * @brief Hash opclass support: seeded 64-bit payload hash
+ *
+ * Enables hash partitioning on ais columns.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_hash_extended);
+Datum
+pg_ais_hash_extended(PG_FUNCTION_ARGS) {
+    ais *value = PG_GETARG_AIS_PP(0);
+    uint64 seed = (uint64) PG_GETARG_INT64(1);
+    PG_RETURN_INT64((int64) ais_identity_hash(value, seed));
+}
+
+
+/**
+ * @brief Compare the identifying bytes of two ais datums
+ */
+static bool ais_identity_equal(const ais *a, const ais *b) {
+    const char *da, *db;
+    size_t la, lb;
+    int fa = ais_identity(a, &da, &la);
+    int fb = ais_identity(b, &db, &lb);
+    return fa == fb && la == lb && memcmp(da, db, la) == 0;
+}
+
+
+/**
+ * @brief Payload equality for the ais "=" operator
+ *
+ * Two sentences are equal when they carry the same payload and fill bits,
+ * regardless of talker, channel or sequence id.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_eq);
+Datum
+pg_ais_eq(PG_FUNCTION_ARGS) {
+    PG_RETURN_BOOL(ais_identity_equal(PG_GETARG_AIS_PP(0), PG_GETARG_AIS_PP(1)));
+}
+
+
+/**
+ * @brief Payload inequality for the ais "<>" operator
+ */
+PG_FUNCTION_INFO_V1(pg_ais_ne);
+Datum
+pg_ais_ne(PG_FUNCTION_ARGS) {
+    PG_RETURN_BOOL(!ais_identity_equal(PG_GETARG_AIS_PP(0), PG_GETARG_AIS_PP(1)));
+}
+
+
+/* Largest reassembled payload we fingerprint: MAX_PARTS fragments of 82 chars */
+#define FINGERPRINT_MAX_BYTES ((MAX_PARTS * 82 * 6 + 7) / 8)
+
+
+/**
+ * @brief Fingerprint an ordered set of fragment views
+ *
+ * The bit length seeds the hash so that payloads differing only in trailing
+ * zero bits stay distinct. A non-zero time bucket is mixed into the seed.
+ *
+ * @param parts Fragment views ordered by sequence number
+ * @param nparts Number of fragments
+ * @param bucket Time bucket number (0 when not bucketing)
+ * @param out Output fingerprint
+ * @return false if the fragments do not form a complete message
+ */
+static bool fingerprint_views(const AISPayloadView *parts, int nparts, int64 bucket, int64 *out) {
+    uint8_t bits[FINGERPRINT_MAX_BYTES];
+    int nbits = ais_view_pack_bits(parts, nparts, bits, sizeof(bits));
+    if (nbits < 0) return false;
+
+    uint64_t seed = (uint64_t)nbits ^ ((uint64_t)bucket * UINT64_C(0x9E3779B97F4A7C15));
+    *out = (int64) ais_hash64(bits, (size_t)(nbits + 7) / 8, seed);
+    return true;
+}
+
+
+/**
+ * @brief Whether two fragment views carry the same sequence id and channel
+ */
+static bool same_message(const AISPayloadView *a, const AISPayloadView *b) {
+    return a->channel == b->channel &&
+           a->message_id_len == b->message_id_len &&
+           memcmp(a->message_id, b->message_id, a->message_id_len) == 0;
+}
+
+
+/**
+ * @brief Collect fragment views from an ais[] and order them by sequence number
+ *
+ * Fragments may be given in any order but must all belong to one message of
+ * at most MAX_PARTS parts, each sequence number present exactly once and all
+ * sharing the same sequence id and channel.
+ *
+ * @param arr Array of ais fragments
+ * @param parts Output views (MAX_PARTS entries)
+ * @return Number of fragments, or -1 if the set is not a complete message
+ */
+int pg_ais_collect_fragments(ArrayType *arr, AISPayloadView *parts) {
+    int16 typlen;
+    bool typbyval;
+    char typalign;
+    Datum *elems;
+    bool *nulls;
+    int nelems;
+
+    get_typlenbyvalalign(ARR_ELEMTYPE(arr), &typlen, &typbyval, &typalign);
+    deconstruct_array(arr, ARR_ELEMTYPE(arr), typlen, typbyval, typalign, &elems, &nulls, &nelems);
+    if (nelems < 1 || nelems > MAX_PARTS) return -1;
+
+    bool seen[MAX_PARTS] = {false};
+    AISPayloadView first;
+    for (int i = 0; i < nelems; i++) {
+        AISPayloadView view;
+        if (nulls[i]) return -1;
+        ais *frag = DatumGetAisPP(elems[i]);
+        if (!ais_payload_view(VARDATA_ANY(frag), VARSIZE_ANY_EXHDR(frag), &view)) return -1;
+        if (view.total != nelems || seen[view.seq - 1]) return -1;
+        if (i == 0) first = view;
+        else if (!same_message(&view, &first)) return -1;
+        seen[view.seq - 1] = true;
+        parts[view.seq - 1] = view;
+    }
+    return nelems;
+}
+
+
+/**
+ * @brief Convert a timestamp into a bucket number for a given window
+ *
+ * @param ts Receive timestamp
+ * @param window Bucket width (must be positive)
+ * @return floor(ts / window)
+ */
+static int64 time_bucket_number(TimestampTz ts, const Interval *window) {
+    int64 width = window->time +
+                  (int64) window->day * USECS_PER_DAY +
+                  (int64) window->month * DAYS_PER_MONTH * USECS_PER_DAY;
+
+    if (width <= 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("fingerprint window must be positive")));
+    if (TIMESTAMP_NOT_FINITE(ts))
+        ereport(ERROR,
+                (errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+                 errmsg("timestamp out of range")));
+
+    int64 bucket = ts / width;
+    if (ts % width < 0) bucket--;
+    return bucket;
+}
+
+
+/**
+ * @brief Receiver-independent fingerprint of a single-part message
+ *
+ * Returns NULL for a fragment of a multipart message; use the ais[] form.
+ *
+ * Usage: SELECT pg_ais_fingerprint(sentence);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_fingerprint);
+Datum
+pg_ais_fingerprint(PG_FUNCTION_ARGS) {
+    ais *value = PG_GETARG_AIS_PP(0);
+    AISPayloadView view;
+    int64 bucket = 0;
+    int64 fp;
+
+    if (!ais_payload_view(VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value), &view) || view.total != 1)
+        PG_RETURN_NULL();
+    if (PG_NARGS() == 3)
+        bucket = time_bucket_number(PG_GETARG_TIMESTAMPTZ(1), PG_GETARG_INTERVAL_P(2));
+
+    if (!fingerprint_views(&view, 1, bucket, &fp)) PG_RETURN_NULL();
+    PG_RETURN_INT64(fp);
+}
+
+
+/**
+ * @brief Receiver-independent fingerprint of a reassembled multipart message
+ *
+ * Usage: SELECT pg_ais_fingerprint(ARRAY[part1, part2]);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_fingerprint_parts);
+Datum
+pg_ais_fingerprint_parts(PG_FUNCTION_ARGS) {
+    ArrayType *arr = PG_GETARG_ARRAYTYPE_P(0);
+    AISPayloadView parts[MAX_PARTS];
+    int64 bucket = 0;
+    int64 fp;
+
+    int nparts = pg_ais_collect_fragments(arr, parts);
+    if (nparts < 0) PG_RETURN_NULL();
+    if (PG_NARGS() == 3)
+        bucket = time_bucket_number(PG_GETARG_TIMESTAMPTZ(1), PG_GETARG_INTERVAL_P(2));
+
+    if (!fingerprint_views(parts, nparts, bucket, &fp)) PG_RETURN_NULL();
+    PG_RETURN_INT64(fp);
+}
@@ -0,0 +1,68 @@
+#ifndef PG_AIS_DEDUP_H
+#define PG_AIS_DEDUP_H
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/array.h"
+
+#include "ais_payload.h"
+
+
+/**
+ * @brief Return a 64-bit hash of the message payload
+ *
+ * Usage: SELECT pg_ais_hash64(sentence);
+ */
+PGDLLEXPORT Datum pg_ais_hash64(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Hash opclass support: 32-bit payload hash
+ */
+PGDLLEXPORT Datum pg_ais_hash(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Hash opclass support: seeded 64-bit payload hash
+ */
+PGDLLEXPORT Datum pg_ais_hash_extended(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Payload equality for the ais "=" operator
+ */
+PGDLLEXPORT Datum pg_ais_eq(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Payload inequality for the ais "<>" operator
+ */
+PGDLLEXPORT Datum pg_ais_ne(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Receiver-independent fingerprint of a single-part message
+ *
+ * Usage: SELECT pg_ais_fingerprint(sentence [, received_at, '10 seconds']);
+ */
+PGDLLEXPORT Datum pg_ais_fingerprint(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Receiver-independent fingerprint of a reassembled multipart message
+ *
+ * Usage: SELECT pg_ais_fingerprint(ARRAY[part1, part2] [, received_at, '10 seconds']);
+ */
+PGDLLEXPORT Datum pg_ais_fingerprint_parts(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Collect fragment views from an ais[] and order them by sequence number
+ *
+ * @param arr Array of ais fragments (any order, one sequence id and channel)
+ * @param parts Output views (MAX_PARTS entries)
+ * @return Number of fragments, or -1 if the set is not a complete message
+ */
+int pg_ais_collect_fragments(ArrayType *arr, AISPayloadView *parts);
+
+#endif
@@ -0,0 +1,144 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "lib/stringinfo.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/interrupt.h"
+#include "storage/fd.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "pg_ais_exporter.h"
+#include "pg_ais_metrics.h"
+
+
+char *ais_metrics_file = NULL;
+int ais_metrics_interval = 15;
+
+
+/**
+ * @brief Define the exporter GUCs and register its worker
+ */
+void pg_ais_exporter_init(void) {
+    BackgroundWorker worker;
+
+    DefineCustomStringVariable("pg_ais.metrics_file",
+                               "File the metrics exporter writes in the Prometheus text format (empty disables it).",
+                               "Relative paths are relative to the data directory. Requires pg_ais in "
+                               "shared_preload_libraries.",
+                               &ais_metrics_file, "",
+                               PGC_POSTMASTER, 0, NULL, NULL, NULL);
+    DefineCustomIntVariable("pg_ais.metrics_interval",
+                            "Seconds between writes of the metrics file.",
+                            NULL, &ais_metrics_interval, 15, 1, INT_MAX / 1000,
+                            PGC_SIGHUP, GUC_UNIT_S, NULL, NULL, NULL);
+
+    if (!process_shared_preload_libraries_in_progress || ais_metrics_file == NULL || ais_metrics_file[0] == '\0')
+        return;
+
+    memset(&worker, 0, sizeof(worker));
+    worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+    worker.bgw_start_time = BgWorkerStart_PostmasterStart;
+    worker.bgw_restart_time = 60;
+    snprintf(worker.bgw_library_name, BGW_MAXLEN, "pg_ais");
+    snprintf(worker.bgw_function_name, BGW_MAXLEN, "pg_ais_exporter_main");
+    snprintf(worker.bgw_name, BGW_MAXLEN, "pg_ais metrics exporter");
+    snprintf(worker.bgw_type, BGW_MAXLEN, "pg_ais metrics exporter");
+    RegisterBackgroundWorker(&worker);
+}
+
+
+/**
+ * @brief Write the Prometheus text of all metrics to a file atomically
+ *
+ * The file is scraped rather than recovered after a crash, so the rename
+ * is not fsynced.
+ *
+ * @param path Target file, relative to the data directory unless absolute
+ * @return false if the write failed (logged)
+ */
+bool ais_metrics_export(const char *path) {
+    StringInfoData buf;
+    char *tmpfile = psprintf("%s.tmp", path);
+
+    initStringInfo(&buf);
+    pg_ais_metrics_prometheus_text(&buf);
+
+    FILE *file = AllocateFile(tmpfile, PG_BINARY_W);
+    if (file == NULL) goto error;
+    if (fwrite(buf.data, 1, buf.len, file) != (size_t) buf.len) {
+        FreeFile(file);
+        goto error;
+    }
+    if (FreeFile(file) != 0) goto error;
+
+    if (rename(tmpfile, path) != 0) {
+        ereport(LOG,
+                (errcode_for_file_access(),
+                 errmsg("could not rename file \"%s\" to \"%s\": %m", tmpfile, path)));
+        unlink(tmpfile);
+        pfree(tmpfile);
+        pfree(buf.data);
+        return false;
+    }
+    pfree(tmpfile);
+    pfree(buf.data);
+    return true;
+
+error:
+    ereport(LOG,
+            (errcode_for_file_access(),
+             errmsg("could not write file \"%s\": %m", tmpfile)));
+    unlink(tmpfile);
+    pfree(tmpfile);
+    pfree(buf.data);
+    return false;
+}
+
+
+/**
+ * @brief Background worker writing the metrics file every export interval
+ *
+ * Writes once at start so the file exists before the first scrape.
+ */
+void pg_ais_exporter_main(Datum arg) {
+    pqsignal(SIGHUP, SignalHandlerForConfigReload);
+    pqsignal(SIGTERM, SignalHandlerForShutdownRequest);
+    BackgroundWorkerUnblockSignals();
+
+    while (!ShutdownRequestPending) {
+        if (ConfigReloadPending) {
+            ConfigReloadPending = false;
+            ProcessConfigFile(PGC_SIGHUP);
+        }
+        (void) ais_metrics_export(ais_metrics_file);
+
+        (void) WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+                         ais_metrics_interval * 1000L, PG_WAIT_EXTENSION);
+        ResetLatch(MyLatch);
+        CHECK_FOR_INTERRUPTS();
+    }
+    proc_exit(0);
+}
+
+
+/**
+ * @brief All counters and latency histograms in the Prometheus text format
+ *
+ * Serve it from any HTTP endpoint, or let the exporter worker write it to
+ * a file for the node_exporter textfile collector.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_metrics_prometheus);
+Datum
+pg_ais_metrics_prometheus(PG_FUNCTION_ARGS) {
+    StringInfoData buf;
+
+    initStringInfo(&buf);
+    pg_ais_metrics_prometheus_text(&buf);
+    PG_RETURN_TEXT_P(cstring_to_text_with_len(buf.data, buf.len));
+}
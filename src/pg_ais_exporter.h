@@ -0,0 +1,47 @@
+#ifndef PG_AIS_EXPORTER_H
+#define PG_AIS_EXPORTER_H
+
+#include "postgres.h"
+#include "fmgr.h"
+
+
+/* GUCs */
+extern char *ais_metrics_file;
+extern int ais_metrics_interval;
+
+
+/**
+ * @brief Define the exporter GUCs and register its worker
+ *
+ * The worker only runs when pg_ais is preloaded and pg_ais.metrics_file
+ * is set.
+ */
+void pg_ais_exporter_init(void);
+
+
+/**
+ * @brief Write the Prometheus text of all metrics to a file atomically
+ *
+ * The text goes to a temporary file that is renamed over path, so a
+ * scraper never reads a partial file.
+ *
+ * @param path Target file, relative to the data directory unless absolute
+ * @return false if the write failed (logged)
+ */
+bool ais_metrics_export(const char *path);
+
+
+/**
+ * @brief Background worker writing the metrics file every export interval
+ */
+PGDLLEXPORT void pg_ais_exporter_main(Datum arg);
+
+
+/**
+ * @brief All counters and latency histograms in the Prometheus text format
+ *
+ * Usage: SELECT pg_ais_metrics_prometheus();
+ */
+PGDLLEXPORT Datum pg_ais_metrics_prometheus(PG_FUNCTION_ARGS);
+
+#endif
@@ -0,0 +1,992 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "access/parallel.h"
+#include "access/reloptions.h"
+#include "catalog/pg_authid.h"
+#include "catalog/pg_foreign_table.h"
+#include "catalog/pg_type.h"
+#include "commands/defrem.h"
+#include "commands/explain.h"
+#include "foreign/fdwapi.h"
+#include "foreign/foreign.h"
+#include "optimizer/cost.h"
+#include "optimizer/optimizer.h"
+#include "optimizer/pathnode.h"
+#include "optimizer/paths.h"
+#include "optimizer/planmain.h"
+#include "optimizer/restrictinfo.h"
+#include "port/atomics.h"
+#include "storage/fd.h"
+#include "utils/acl.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+
+#include <math.h>
+#include <sys/stat.h>
+
+#include "ais_core.h"
+#include "ais_payload.h"
+#include "ais_reader.h"
+#include "ais_stream.h"
+#include "parse_ais_msg.h"
+#include "pg_ais_fields.h"
+#include "pg_ais_fdw.h"
+#include "pg_ais_load.h"
+
+
+/* Columns that can be filled from the payload header without decoding */
+#define FIELDS_HEADER_ONLY (FIELD(F_TYPE) | FIELD(F_MMSI) | FIELDS_POSITION | FIELDS_TAG)
+
+/* fdw_private layout of the ForeignScan plan node */
+enum {
+    PRIV_ATTRS,     /* IntList of referenced attribute numbers (0: whole row) */
+    PRIV_FILTERS,   /* List of IntLists: (field, allowed values...) */
+    PRIV_BBOX       /* IntList lon_min, lon_max, lat_min, lat_max, or NIL */
+};
+
+
+/**
+ * @brief Where a foreign table column takes its value from
+ */
+typedef enum {
+    COL_NONE,       /* unknown name: always NULL */
+    COL_FIELD,      /* an ais_fields column */
+    COL_SENTENCE,   /* raw single-part sentence */
+    COL_PAYLOAD,    /* reassembled armored payload */
+    COL_FILENAME    /* log file the message came from */
+} AISFdwColumnKind;
+
+
+typedef struct {
+    AISFdwColumnKind kind;
+    int field;
+    FmgrInfo input_fn;
+    Oid input_ioparam;
+    int32 typmod;
+} AISFdwColumn;
+
+
+/**
+ * @brief One log file and the first chunk number it covers
+ *
+ * Compressed files cannot be entered mid-stream, so each is a single chunk.
+ */
+typedef struct {
+    char path[MAXPGPATH];
+    uint64 size;
+    bool compressed;
+    uint64 first_chunk;
+} AISFdwFile;
+
+
+/**
+ * @brief Work distribution shared by the leader and parallel workers
+ *
+ * Lives in DSM for parallel scans and in backend memory otherwise. Chunks
+ * are handed out with an atomic counter.
+ */
+typedef struct {
+    pg_atomic_uint64 next_chunk;
+    uint64 nchunks;
+    int nfiles;
+    AISFdwFile files[FLEXIBLE_ARRAY_MEMBER];
+} AISFdwShared;
+
+
+typedef struct {
+    char *directory;
+    char *suffix;
+    uint64 total_bytes;
+} AISFdwPlanState;
+
+
+typedef struct {
+    char *directory;
+    AISFdwShared *shared;
+    bool shared_local;
+    AISFdwColumn *columns;
+    int natts;
+    bool need_decode;
+    List *filters;
+    bool has_bbox;
+    int32 bbox[4];
+
+    /* current chunk */
+    bool in_chunk;
+    int file_idx;
+    AISLoadFile *file;
+    MemoryContext scancxt;
+    uint64 chunk_end;
+    int tail_lines;
+
+    /* line reader */
+    char *buf;
+    size_t buf_len;
+    size_t buf_off;
+    uint64 buf_pos;
+    bool eof;
+    bool skip_line;
+
+    AISStream *stream;
+    MemoryContext tuplecxt;
+} AISFdwScanState;
+
+
+/**
+ * @brief Read the directory and suffix options of a foreign table
+ */
+static void get_table_options(Oid relid, char **directory, char **suffix) {
+    ForeignTable *table = GetForeignTable(relid);
+    ListCell *lc;
+
+    *directory = NULL;
+    *suffix = NULL;
+    foreach(lc, table->options) {
+        DefElem *def = (DefElem *) lfirst(lc);
+        if (strcmp(def->defname, "directory") == 0) *directory = defGetString(def);
+        else if (strcmp(def->defname, "suffix") == 0) *suffix = defGetString(def);
+    }
+    if (*directory == NULL)
+        ereport(ERROR,
+                (errcode(ERRCODE_FDW_OPTION_NAME_NOT_FOUND),
+                 errmsg("pg_ais_fdw foreign table requires the \"directory\" option")));
+}
+
+
+/**
+ * @brief qsort comparator ordering log files by path
+ */
+static int file_cmp(const void *a, const void *b) {
+    return strcmp(((const AISFdwFile *) a)->path, ((const AISFdwFile *) b)->path);
+}
+
+
+/**
+ * @brief Number of parallel work units a log file is split into
+ */
+static uint64 file_chunks(const AISFdwFile *file) {
+    if (file->compressed) return 1;
+    return (file->size + AIS_FDW_CHUNK_SIZE - 1) / AIS_FDW_CHUNK_SIZE;
+}
+
+
+/**
+ * @brief List the regular files of a log directory in name order
+ *
+ * @param directory Directory to scan
+ * @param suffix Required file name suffix, or NULL for all files
+ * @param nfiles Output file count
+ * @param total_bytes Output sum of file sizes
+ * @return palloc'd array of files with chunk numbers assigned
+ */
+static AISFdwFile *list_log_files(const char *directory, const char *suffix, int *nfiles, uint64 *total_bytes) {
+    DIR *dir = AllocateDir(directory);
+    struct dirent *de;
+    int n = 0;
+    int cap = 16;
+    AISFdwFile *files = palloc(sizeof(AISFdwFile) * cap);
+    size_t suffix_len = suffix ? strlen(suffix) : 0;
+
+    while ((de = ReadDir(dir, directory)) != NULL) {
+        struct stat st;
+        size_t name_len = strlen(de->d_name);
+
+        if (de->d_name[0] == '.') continue;
+        if (suffix_len > 0 &&
+            (name_len < suffix_len || strcmp(de->d_name + name_len - suffix_len, suffix) != 0))
+            continue;
+
+        if (n == cap) {
+            cap *= 2;
+            files = repalloc(files, sizeof(AISFdwFile) * cap);
+        }
+        AISReaderFormat format;
+        snprintf(files[n].path, MAXPGPATH, "%s/%s", directory, de->d_name);
+        if (stat(files[n].path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        if (!ais_reader_detect(files[n].path, &format)) continue;
+        files[n].size = (uint64) st.st_size;
+        files[n].compressed = format != AIS_FORMAT_PLAIN;
+        n++;
+    }
+    FreeDir(dir);
+
+    qsort(files, n, sizeof(AISFdwFile), file_cmp);
+
+    uint64 chunk = 0;
+    *total_bytes = 0;
+    for (int i = 0; i < n; i++) {
+        files[i].first_chunk = chunk;
+        chunk += file_chunks(&files[i]);
+        *total_bytes += files[i].size;
+    }
+    *nfiles = n;
+    return files;
+}
+
+
+/**
+ * @brief Build the shared work distribution for a file list
+ *
+ * @param files Files from list_log_files()
+ * @param nfiles Number of files
+ * @param dest Destination (at least shared_size(nfiles) bytes)
+ */
+static void init_shared(const AISFdwFile *files, int nfiles, AISFdwShared *dest) {
+    dest->nfiles = nfiles;
+    dest->nchunks = 0;
+    if (nfiles > 0) {
+        memcpy(dest->files, files, sizeof(AISFdwFile) * nfiles);
+        const AISFdwFile *last = &files[nfiles - 1];
+        dest->nchunks = last->first_chunk + file_chunks(last);
+    }
+    pg_atomic_init_u64(&dest->next_chunk, 0);
+}
+
+
+/**
+ * @brief Size of an AISFdwShared holding nfiles files
+ */
+static Size shared_size(int nfiles) {
+    return add_size(offsetof(AISFdwShared, files), mul_size(sizeof(AISFdwFile), nfiles));
+}
+
+
+/**
+ * @brief Map a column name to an ais_fields column number
+ *
+ * @return F_* column, or -1 if the name is not an ais_fields column
+ */
+static int field_by_name(const char *name) {
+    for (int f = 0; f < F_NUM_FIELDS; f++)
+        if (strcmp(name, ais_field_names[f]) == 0) return f;
+    return -1;
+}
+
+
+/**
+ * @brief Return the SQL type the scan produces for an ais_fields column
+ */
+static Oid field_type(int field) {
+    switch (field) {
+        case F_LAT: case F_LON: case F_SPEED: case F_HEADING: case F_COURSE: case F_DRAUGHT:
+            return FLOAT8OID;
+        case F_CALLSIGN: case F_VESSEL_NAME: case F_DESTINATION: case F_STATION:
+            return TEXTOID;
+        case F_RECEIVE_TIME:
+            return TIMESTAMPTZOID;
+        case F_RAIM:
+            return BOOLOID;
+        default:
+            return INT4OID;
+    }
+}
+
+
+/**
+ * @brief Tighten the pushed-down bounding box with one comparison
+ *
+ * Bounds are widened by one fixed-point unit so the pre-filter never drops a
+ * row the exact (rechecked) qual would keep.
+ *
+ * @param bbox lon_min, lon_max, lat_min, lat_max
+ * @param field F_LAT or F_LON
+ * @param lower true for "column >= value" / "column > value"
+ * @param value Comparison constant in degrees
+ */
+static void tighten_bbox(int32 *bbox, int field, bool lower, double value) {
+    int32 limit = field == F_LON ? AIS_LON_LIMIT : AIS_LAT_LIMIT;
+    int32 *bound = &bbox[(field == F_LON ? 0 : 2) + (lower ? 0 : 1)];
+    double fixed = value * AIS_COORD_SCALE;
+
+    if (isnan(fixed)) return;
+    if (lower) {
+        fixed = floor(fixed) - 1;
+        if (fixed > limit + 1) fixed = limit + 1;
+        if (fixed > *bound) *bound = (int32) fixed;
+    } else {
+        fixed = ceil(fixed) + 1;
+        if (fixed < -limit - 1) fixed = -limit - 1;
+        if (fixed < *bound) *bound = (int32) fixed;
+    }
+}
+
+
+/**
+ * @brief Collect restriction clauses the scan can apply before decoding
+ *
+ * Recognizes "type|mmsi = const", "type|mmsi = ANY(const array)" and
+ * float8 range comparisons on lat/lon. All clauses are still evaluated by
+ * the executor; the pushed filters only skip messages early.
+ *
+ * @param relid Foreign table
+ * @param varno Range table index of the scanned relation
+ * @param clauses RestrictInfo list
+ * @param bbox_out Output bounding box IntList, or NIL
+ * @return List of (field, values...) IntLists
+ */
+static List *extract_filters(Oid relid, Index varno, List *clauses, List **bbox_out) {
+    List *filters = NIL;
+    int32 bbox[4] = {PG_INT32_MIN, PG_INT32_MAX, PG_INT32_MIN, PG_INT32_MAX};
+    bool has_bbox = false;
+    ListCell *lc;
+
+    foreach(lc, clauses) {
+        RestrictInfo *ri = lfirst_node(RestrictInfo, lc);
+        Node *clause = (Node *) ri->clause;
+
+        if (IsA(clause, OpExpr) && list_length(((OpExpr *) clause)->args) == 2) {
+            OpExpr *op = (OpExpr *) clause;
+            Node *left = linitial(op->args);
+            Node *right = lsecond(op->args);
+            bool var_left = IsA(left, Var) && IsA(right, Const);
+
+            if (!var_left && !(IsA(right, Var) && IsA(left, Const))) continue;
+
+            Var *var = (Var *) (var_left ? left : right);
+            Const *cst = (Const *) (var_left ? right : left);
+            if (var->varno != varno || var->varlevelsup != 0 || var->varattno <= 0 || cst->constisnull)
+                continue;
+
+            int field = field_by_name(get_attname(relid, var->varattno, false));
+            Oid fn = get_opcode(op->opno);
+
+            if ((field == F_TYPE || field == F_MMSI) && fn == F_INT4EQ) {
+                filters = lappend(filters, list_make2_int(field, DatumGetInt32(cst->constvalue)));
+            } else if ((field == F_LAT || field == F_LON) && cst->consttype == FLOAT8OID &&
+                       (fn == F_FLOAT8LT || fn == F_FLOAT8LE || fn == F_FLOAT8GT || fn == F_FLOAT8GE)) {
+                bool greater = fn == F_FLOAT8GT || fn == F_FLOAT8GE;
+                tighten_bbox(bbox, field, greater == var_left, DatumGetFloat8(cst->constvalue));
+                has_bbox = true;
+            }
+        } else if (IsA(clause, ScalarArrayOpExpr)) {
+            ScalarArrayOpExpr *sa = (ScalarArrayOpExpr *) clause;
+            Node *left = linitial(sa->args);
+            Node *right = lsecond(sa->args);
+
+            if (!sa->useOr || !IsA(left, Var) || !IsA(right, Const) || ((Const *) right)->constisnull)
+                continue;
+            if (get_opcode(sa->opno) != F_INT4EQ) continue;
+
+            Var *var = (Var *) left;
+            if (var->varno != varno || var->varlevelsup != 0 || var->varattno <= 0) continue;
+
+            int field = field_by_name(get_attname(relid, var->varattno, false));
+            if (field != F_TYPE && field != F_MMSI) continue;
+
+            ArrayType *arr = DatumGetArrayTypeP(((Const *) right)->constvalue);
+            Datum *elems;
+            bool *nulls;
+            int nelems;
+            List *filter = list_make1_int(field);
+
+            deconstruct_array(arr, INT4OID, sizeof(int32), true, TYPALIGN_INT, &elems, &nulls, &nelems);
+            for (int i = 0; i < nelems; i++)
+                if (!nulls[i]) filter = lappend_int(filter, DatumGetInt32(elems[i]));
+            filters = lappend(filters, filter);
+        }
+    }
+
+    *bbox_out = has_bbox ? list_make4_int(bbox[0], bbox[1], bbox[2], bbox[3]) : NIL;
+    return filters;
+}
+
+
+/**
+ * @brief Estimate relation size from the total size of the log files
+ */
+static void aisGetForeignRelSize(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid) {
+    AISFdwPlanState *plan = palloc0(sizeof(AISFdwPlanState));
+    int nfiles;
+
+    get_table_options(foreigntableid, &plan->directory, &plan->suffix);
+    pfree(list_log_files(plan->directory, plan->suffix, &nfiles, &plan->total_bytes));
+    baserel->fdw_private = plan;
+
+    double ntuples = (double) plan->total_bytes / AIS_FDW_BYTES_PER_LINE;
+    double selectivity = clauselist_selectivity(root, baserel->baserestrictinfo, 0, JOIN_INNER, NULL);
+    baserel->tuples = ntuples;
+    baserel->rows = clamp_row_est(ntuples * selectivity);
+}
+
+
+/**
+ * @brief Offer a serial scan and, when allowed, a parallel-aware partial scan
+ */
+static void aisGetForeignPaths(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid) {
+    AISFdwPlanState *plan = (AISFdwPlanState *) baserel->fdw_private;
+    double pages = ceil((double) plan->total_bytes / BLCKSZ);
+    double ntuples = baserel->tuples;
+    Cost startup_cost = baserel->baserestrictcost.startup;
+    Cost cpu_per_tuple = cpu_operator_cost * 20 + baserel->baserestrictcost.per_tuple;
+    Cost run_cost = seq_page_cost * pages + cpu_per_tuple * ntuples;
+
+    add_path(baserel, (Path *) create_foreignscan_path(root, baserel, NULL, baserel->rows,
+                                                       startup_cost, startup_cost + run_cost,
+                                                       NIL, NULL, NULL, NIL));
+
+    if (!baserel->consider_parallel) return;
+
+    int workers = compute_parallel_worker(baserel, pages, -1, max_parallel_workers_per_gather);
+    if (workers <= 0) return;
+
+    double divisor = workers + (parallel_leader_participation ? 1 : 0);
+    ForeignPath *partial = create_foreignscan_path(root, baserel, NULL, clamp_row_est(baserel->rows / divisor),
+                                                   startup_cost, startup_cost + run_cost / divisor,
+                                                   NIL, NULL, NULL, NIL);
+    partial->path.parallel_aware = true;
+    partial->path.parallel_safe = true;
+    partial->path.parallel_workers = workers;
+    add_partial_path(baserel, (Path *) partial);
+}
+
+
+/**
+ * @brief Record referenced columns and pushed-down filters in the plan
+ */
+static ForeignScan *aisGetForeignPlan(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid,
+                                      ForeignPath *best_path, List *tlist, List *scan_clauses,
+                                      Plan *outer_plan) {
+    Bitmapset *attrs = NULL;
+    List *attr_list = NIL;
+    List *bbox = NIL;
+    ListCell *lc;
+    int k = -1;
+
+    pull_varattnos((Node *) baserel->reltarget->exprs, baserel->relid, &attrs);
+    foreach(lc, baserel->baserestrictinfo)
+        pull_varattnos((Node *) lfirst_node(RestrictInfo, lc)->clause, baserel->relid, &attrs);
+
+    /* Attribute 0 stands for a whole-row reference: every column is needed */
+    while ((k = bms_next_member(attrs, k)) >= 0) {
+        AttrNumber attno = k + FirstLowInvalidHeapAttributeNumber;
+        if (attno >= 0) attr_list = lappend_int(attr_list, attno);
+    }
+
+    List *filters = extract_filters(foreigntableid, baserel->relid, baserel->baserestrictinfo, &bbox);
+    scan_clauses = extract_actual_clauses(scan_clauses, false);
+
+    return make_foreignscan(tlist, scan_clauses, baserel->relid, NIL,
+                            list_make3(attr_list, filters, bbox), NIL, NIL, outer_plan);
+}
+
+
+/**
+ * @brief Resolve how each foreign table column is produced
+ *
+ * ais_fields columns must use the type pg_ais_fields() returns; sentence,
+ * payload and filename go through the column type's input function.
+ */
+static AISFdwColumn *map_columns(Relation rel) {
+    TupleDesc tupdesc = RelationGetDescr(rel);
+    AISFdwColumn *columns = palloc0(sizeof(AISFdwColumn) * tupdesc->natts);
+
+    for (int i = 0; i < tupdesc->natts; i++) {
+        Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+        const char *name = NameStr(attr->attname);
+        AISFdwColumn *col = &columns[i];
+        int field;
+
+        if (attr->attisdropped) continue;
+
+        if (strcmp(name, "sentence") == 0) col->kind = COL_SENTENCE;
+        else if (strcmp(name, "payload") == 0) col->kind = COL_PAYLOAD;
+        else if (strcmp(name, "filename") == 0) col->kind = COL_FILENAME;
+        else if ((field = field_by_name(name)) >= 0) {
+            if (attr->atttypid != field_type(field))
+                ereport(ERROR,
+                        (errcode(ERRCODE_DATATYPE_MISMATCH),
+                         errmsg("column \"%s\" of foreign table \"%s\" must be of type %s",
+                                name, RelationGetRelationName(rel), format_type_be(field_type(field)))));
+            col->kind = COL_FIELD;
+            col->field = field;
+            continue;
+        } else {
+            continue;
+        }
+
+        Oid infunc;
+        getTypeInputInfo(attr->atttypid, &infunc, &col->input_ioparam);
+        fmgr_info(infunc, &col->input_fn);
+        col->typmod = attr->atttypmod;
+    }
+    return columns;
+}
+
+
+/**
+ * @brief Set up a scan: column mapping, pushed filters and the file list
+ *
+ * Workers of a parallel-aware scan take the file list from the leader's DSM
+ * instead of listing the directory again.
+ */
+static void aisBeginForeignScan(ForeignScanState *node, int eflags) {
+    ForeignScan *plan = (ForeignScan *) node->ss.ps.plan;
+    Relation rel = node->ss.ss_currentRelation;
+    AISFdwScanState *state = palloc0(sizeof(AISFdwScanState));
+    char *suffix;
+    ListCell *lc;
+
+    get_table_options(RelationGetRelid(rel), &state->directory, &suffix);
+    node->fdw_state = state;
+    if (eflags & EXEC_FLAG_EXPLAIN_ONLY) return;
+
+    state->natts = RelationGetNumberOfAttributes(rel);
+    state->columns = map_columns(rel);
+
+    /* Decode only when a referenced column needs more than the header */
+    foreach(lc, (List *) list_nth(plan->fdw_private, PRIV_ATTRS)) {
+        int attno = lfirst_int(lc);
+        if (attno == 0) {
+            state->need_decode = true;
+            break;
+        }
+        AISFdwColumn *col = &state->columns[attno - 1];
+        if (col->kind == COL_FIELD && (FIELD(col->field) & FIELDS_HEADER_ONLY) == 0)
+            state->need_decode = true;
+    }
+
+    state->filters = (List *) list_nth(plan->fdw_private, PRIV_FILTERS);
+    List *bbox = (List *) list_nth(plan->fdw_private, PRIV_BBOX);
+    if (bbox != NIL) {
+        state->has_bbox = true;
+        for (int i = 0; i < 4; i++) state->bbox[i] = list_nth_int(bbox, i);
+    }
+
+    if (!(plan->scan.plan.parallel_aware && IsParallelWorker())) {
+        int nfiles;
+        uint64 total_bytes;
+        AISFdwFile *files = list_log_files(state->directory, suffix, &nfiles, &total_bytes);
+        state->shared = palloc(shared_size(nfiles));
+        init_shared(files, nfiles, state->shared);
+        state->shared_local = true;
+        pfree(files);
+    }
+
+    state->buf = palloc(AIS_FDW_BUFFER_SIZE);
+    state->stream = palloc(sizeof(AISStream));
+    state->file_idx = -1;
+    state->scancxt = CurrentMemoryContext;
+    state->tuplecxt = AllocSetContextCreate(CurrentMemoryContext, "pg_ais_fdw tuple", ALLOCSET_SMALL_SIZES);
+}
+
+
+/**
+ * @brief Return the next line of the current chunk's file
+ *
+ * @param state Scan state
+ * @param line Output line start (not NUL-terminated)
+ * @param len Output line length without the newline
+ * @param start Output file offset of the line
+ * @return false at end of file
+ */
+static bool next_line(AISFdwScanState *state, char **line, size_t *len, uint64 *start) {
+    for (;;) {
+        char *p = state->buf + state->buf_off;
+        size_t avail = state->buf_len - state->buf_off;
+        char *nl = memchr(p, '\n', avail);
+
+        if (nl || (state->eof && avail > 0)) {
+            bool skip = state->skip_line;
+            *line = p;
+            *len = nl ? (size_t) (nl - p) : avail;
+            *start = state->buf_pos + state->buf_off;
+            state->buf_off += *len + (nl ? 1 : 0);
+            state->skip_line = false;
+            if (skip) continue;
+            return true;
+        }
+        if (state->eof) return false;
+
+        if (avail == AIS_FDW_BUFFER_SIZE) {
+            /* A line longer than the buffer cannot be a sentence; drop it */
+            state->skip_line = true;
+            state->buf_pos += state->buf_len;
+            state->buf_len = state->buf_off = 0;
+        } else {
+            memmove(state->buf, p, avail);
+            state->buf_pos += state->buf_off;
+            state->buf_len = avail;
+            state->buf_off = 0;
+        }
+
+        size_t n = ais_load_read(state->file, state->buf + state->buf_len, AIS_FDW_BUFFER_SIZE - state->buf_len);
+        if (n == 0) state->eof = true;
+        state->buf_len += n;
+    }
+}
+
+
+/**
+ * @brief Claim the next chunk and position the reader at its first line
+ *
+ * A chunk owns every line that starts inside it. Reading starts one byte
+ * early and discards the partial line, which belongs to the previous chunk.
+ * A compressed file is one chunk, decompressed by the reader thread.
+ *
+ * @return false when every chunk has been claimed
+ */
+static bool open_next_chunk(AISFdwScanState *state) {
+    AISFdwShared *shared = state->shared;
+    uint64 idx = pg_atomic_fetch_add_u64(&shared->next_chunk, 1);
+    int f = 0;
+
+    if (idx >= shared->nchunks) return false;
+    while (f + 1 < shared->nfiles && shared->files[f + 1].first_chunk <= idx) f++;
+
+    AISFdwFile *file = &shared->files[f];
+    uint64 begin = (idx - file->first_chunk) * (uint64) AIS_FDW_CHUNK_SIZE;
+    uint64 end = file->compressed ? PG_UINT64_MAX : Min(begin + AIS_FDW_CHUNK_SIZE, file->size);
+
+    state->buf_pos = begin > 0 ? begin - 1 : 0;
+    if (state->file) ais_load_close(state->file);
+
+    /* The reader must outlive the per-tuple context IterateForeignScan runs in */
+    MemoryContext oldcxt = MemoryContextSwitchTo(state->scancxt);
+    state->file = ais_load_open(file->path, state->buf_pos,
+                                file->compressed ? 0 : end - state->buf_pos + AIS_FDW_TAIL_BYTES);
+    MemoryContextSwitchTo(oldcxt);
+    state->file_idx = f;
+
+    state->buf_len = state->buf_off = 0;
+    state->eof = false;
+    state->skip_line = begin > 0;
+    state->chunk_end = end;
+    state->tail_lines = 0;
+    state->in_chunk = true;
+    ais_stream_init(state->stream);
+    return true;
+}
+
+
+/**
+ * @brief Check the pushed-down filters against the payload header
+ *
+ * @param state Scan state
+ * @param view Payload view of the complete message
+ * @return false if the message cannot satisfy the query
+ */
+static bool passes_filters(AISFdwScanState *state, const AISPayloadView *view) {
+    ListCell *lc;
+
+    foreach(lc, state->filters) {
+        List *filter = (List *) lfirst(lc);
+        int field = linitial_int(filter);
+        uint32_t value;
+        bool found = false;
+        ListCell *vc;
+
+        if (field == F_TYPE) value = (uint32_t) ais_view_type(view);
+        else if (!ais_view_uint(view, 8, 30, &value)) return false;
+
+        for_each_from(vc, filter, 1) {
+            if ((uint32_t) lfirst_int(vc) == value) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) return false;
+    }
+
+    if (state->has_bbox) {
+        int32_t lon, lat;
+        if (!ais_view_position(view, &lon, &lat)) return false;
+        if (lon < state->bbox[0] || lon > state->bbox[1] || lat < state->bbox[2] || lat > state->bbox[3])
+            return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Fill the scan slot from one complete message
+ *
+ * A message that does not decode keeps its header columns and returns NULL
+ * for the rest, so the rows returned do not depend on the columns selected.
+ */
+static void fill_slot(AISFdwScanState *state, TupleTableSlot *slot, const AISStreamMessage *m,
+                      const AISPayloadView *view) {
+    Datum fields[F_NUM_FIELDS];
+    bool field_nulls[F_NUM_FIELDS];
+    int type = ais_view_type(view);
+    char *textbuf = palloc(AIS_FIELDS_TEXT_BUFSIZE);
+    int32_t lon, lat;
+    bool decoded = false;
+
+    if (state->need_decode) {
+        AISMessage msg = {0};
+        decoded = parse_ais_payload(&msg, m->payload, m->fill_bits).ok;
+
+        if (decoded) ais_fields_datums(&msg, type, fields, field_nulls, textbuf);
+        free_ais_message(&msg);
+    }
+    if (!decoded) {
+        uint32_t mmsi;
+        for (int f = 0; f < F_NUM_FIELDS; f++) field_nulls[f] = true;
+        fields[F_TYPE] = Int32GetDatum(type);
+        field_nulls[F_TYPE] = false;
+        if (ais_view_uint(view, 8, 30, &mmsi)) {
+            fields[F_MMSI] = Int32GetDatum((int32) mmsi);
+            field_nulls[F_MMSI] = false;
+        }
+    }
+    ais_tag_datums(&m->tags, fields, field_nulls, textbuf);
+
+    /* Positions always come from the exact fixed-point value */
+    field_nulls[F_LON] = field_nulls[F_LAT] = !ais_view_position(view, &lon, &lat);
+    if (!field_nulls[F_LON]) {
+        fields[F_LON] = Float8GetDatum((double) lon / AIS_COORD_SCALE);
+        fields[F_LAT] = Float8GetDatum((double) lat / AIS_COORD_SCALE);
+    }
+
+    for (int i = 0; i < state->natts; i++) {
+        AISFdwColumn *col = &state->columns[i];
+        char sentence[AIS_MAX_SENTENCE_LEN];
+        const char *text = NULL;
+
+        slot->tts_isnull[i] = true;
+        switch (col->kind) {
+            case COL_FIELD:
+                slot->tts_isnull[i] = field_nulls[col->field];
+                slot->tts_values[i] = fields[col->field];
+                continue;
+            case COL_SENTENCE:
+                if (m->sentence && m->sentence_len < sizeof(sentence)) {
+                    memcpy(sentence, m->sentence, m->sentence_len);
+                    sentence[m->sentence_len] = '\0';
+                    text = sentence;
+                }
+                break;
+            case COL_PAYLOAD:
+                text = m->payload;
+                break;
+            case COL_FILENAME:
+                text = state->shared->files[state->file_idx].path;
+                break;
+            case COL_NONE:
+                continue;
+        }
+        if (text) {
+            slot->tts_values[i] = InputFunctionCall(&col->input_fn, (char *) text, col->input_ioparam, col->typmod);
+            slot->tts_isnull[i] = false;
+        }
+    }
+}
+
+
+/**
+ * @brief Return the next message that passes the pushed-down filters
+ *
+ * Lines starting inside the current chunk are decoded; past the chunk end
+ * only continuation fragments are read, and only while multipart messages
+ * begun in this chunk are still incomplete.
+ */
+static TupleTableSlot *aisIterateForeignScan(ForeignScanState *node) {
+    AISFdwScanState *state = (AISFdwScanState *) node->fdw_state;
+    TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+
+    ExecClearTuple(slot);
+    MemoryContextReset(state->tuplecxt);
+
+    for (;;) {
+        char *line;
+        size_t len;
+        uint64 start;
+        AISStreamMessage m;
+
+        if (!state->in_chunk && !open_next_chunk(state)) return slot;
+        if (!next_line(state, &line, &len, &start)) {
+            state->in_chunk = false;
+            continue;
+        }
+
+        if (start >= state->chunk_end) {
+            AISPayloadView frag;
+            char *bang = memchr(line, '!', len);
+
+            if (ais_stream_pending(state->stream) == 0 || ++state->tail_lines > AIS_FDW_TAIL_LINES) {
+                state->in_chunk = false;
+                continue;
+            }
+            if (!bang || !ais_payload_view(bang, len - (bang - line), &frag) || frag.seq == 1)
+                continue;
+        }
+
+        CHECK_FOR_INTERRUPTS();
+        if (ais_stream_push(state->stream, line, len, &m) != AIS_STREAM_MESSAGE) continue;
+
+        AISPayloadView view = {
+            .payload = m.payload, .len = m.len, .fill_bits = m.fill_bits,
+            .total = 1, .seq = 1, .channel = m.channel
+        };
+        if (!passes_filters(state, &view)) continue;
+
+        MemoryContext oldcxt = MemoryContextSwitchTo(state->tuplecxt);
+        fill_slot(state, slot, &m, &view);
+        MemoryContextSwitchTo(oldcxt);
+        return ExecStoreVirtualTuple(slot);
+    }
+}
+
+
+/**
+ * @brief Restart a scan from the first chunk
+ */
+static void aisReScanForeignScan(ForeignScanState *node) {
+    AISFdwScanState *state = (AISFdwScanState *) node->fdw_state;
+
+    /* Shared chunk counters are reset by aisReInitializeDSMForeignScan() */
+    if (state->shared_local)
+        pg_atomic_write_u64(&state->shared->next_chunk, 0);
+    state->in_chunk = false;
+}
+
+
+/**
+ * @brief Close the open log file
+ */
+static void aisEndForeignScan(ForeignScanState *node) {
+    AISFdwScanState *state = (AISFdwScanState *) node->fdw_state;
+
+    if (state && state->file) {
+        ais_load_close(state->file);
+        state->file = NULL;
+    }
+}
+
+
+/**
+ * @brief Show the log directory and what was pushed down
+ */
+static void aisExplainForeignScan(ForeignScanState *node, ExplainState *es) {
+    ForeignScan *plan = (ForeignScan *) node->ss.ps.plan;
+    AISFdwScanState *state = (AISFdwScanState *) node->fdw_state;
+    List *filters = (List *) list_nth(plan->fdw_private, PRIV_FILTERS);
+    List *bbox = (List *) list_nth(plan->fdw_private, PRIV_BBOX);
+
+    ExplainPropertyText("AIS Directory", state->directory, es);
+    ExplainPropertyInteger("AIS Pushed Filters", NULL, list_length(filters) + (bbox != NIL ? 1 : 0), es);
+}
+
+
+/**
+ * @brief Any scan of log files is safe to run in a parallel worker
+ */
+static bool aisIsForeignScanParallelSafe(PlannerInfo *root, RelOptInfo *rel, RangeTblEntry *rte) {
+    return true;
+}
+
+
+/**
+ * @brief DSM space for the chunk counter and the leader's file list
+ */
+static Size aisEstimateDSMForeignScan(ForeignScanState *node, ParallelContext *pcxt) {
+    AISFdwScanState *state = (AISFdwScanState *) node->fdw_state;
+    return shared_size(state->shared->nfiles);
+}
+
+
+/**
+ * @brief Publish the file list in DSM and switch the leader over to it
+ */
+static void aisInitializeDSMForeignScan(ForeignScanState *node, ParallelContext *pcxt, void *coordinate) {
+    AISFdwScanState *state = (AISFdwScanState *) node->fdw_state;
+    AISFdwShared *shared = (AISFdwShared *) coordinate;
+
+    init_shared(state->shared->files, state->shared->nfiles, shared);
+    pfree(state->shared);
+    state->shared = shared;
+    state->shared_local = false;
+}
+
+
+/**
+ * @brief Reset the chunk counter before a parallel rescan
+ */
+static void aisReInitializeDSMForeignScan(ForeignScanState *node, ParallelContext *pcxt, void *coordinate) {
+    pg_atomic_write_u64(&((AISFdwShared *) coordinate)->next_chunk, 0);
+}
+
+
+/**
+ * @brief Attach a parallel worker to the leader's chunk distribution
+ */
+static void aisInitializeWorkerForeignScan(ForeignScanState *node, shm_toc *toc, void *coordinate) {
+    AISFdwScanState *state = (AISFdwScanState *) node->fdw_state;
+    state->shared = (AISFdwShared *) coordinate;
+}
+
+
+/**
+ * @brief Foreign data wrapper handler for directories of raw AIS logs
+ *
+ * Usage: CREATE FOREIGN DATA WRAPPER pg_ais_fdw HANDLER pg_ais_fdw_handler ...;
+ */
+PG_FUNCTION_INFO_V1(pg_ais_fdw_handler);
+Datum
+pg_ais_fdw_handler(PG_FUNCTION_ARGS) {
+    FdwRoutine *routine = makeNode(FdwRoutine);
+
+    routine->GetForeignRelSize = aisGetForeignRelSize;
+    routine->GetForeignPaths = aisGetForeignPaths;
+    routine->GetForeignPlan = aisGetForeignPlan;
+    routine->BeginForeignScan = aisBeginForeignScan;
+    routine->IterateForeignScan = aisIterateForeignScan;
+    routine->ReScanForeignScan = aisReScanForeignScan;
+    routine->EndForeignScan = aisEndForeignScan;
+    routine->ExplainForeignScan = aisExplainForeignScan;
+
+    routine->IsForeignScanParallelSafe = aisIsForeignScanParallelSafe;
+    routine->EstimateDSMForeignScan = aisEstimateDSMForeignScan;
+    routine->InitializeDSMForeignScan = aisInitializeDSMForeignScan;
+    routine->ReInitializeDSMForeignScan = aisReInitializeDSMForeignScan;
+    routine->InitializeWorkerForeignScan = aisInitializeWorkerForeignScan;
+
+    PG_RETURN_POINTER(routine);
+}
+
+
+/**
+ * @brief Validate pg_ais_fdw options (directory, suffix)
+ *
+ * Only foreign tables take options. Setting a directory reads server files,
+ * so it needs the same privilege as COPY FROM a file.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_fdw_validator);
+Datum
+pg_ais_fdw_validator(PG_FUNCTION_ARGS) {
+    List *options = untransformRelOptions(PG_GETARG_DATUM(0));
+    Oid catalog = PG_GETARG_OID(1);
+    bool has_directory = false;
+    ListCell *lc;
+
+    foreach(lc, options) {
+        DefElem *def = (DefElem *) lfirst(lc);
+        bool known = strcmp(def->defname, "directory") == 0 || strcmp(def->defname, "suffix") == 0;
+
+        if (catalog != ForeignTableRelationId || !known)
+            ereport(ERROR,
+                    (errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
+                     errmsg("invalid option \"%s\"", def->defname),
+                     errhint("pg_ais_fdw foreign tables accept \"directory\" and \"suffix\".")));
+
+        if (strcmp(def->defname, "directory") == 0) {
+            if (!has_privs_of_role(GetUserId(), ROLE_PG_READ_SERVER_FILES))
+                ereport(ERROR,
+                        (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+                         errmsg("only superuser or a role with privileges of the pg_read_server_files role may specify the directory option")));
+            has_directory = true;
+        }
+    }
+
+    if (catalog == ForeignTableRelationId && !has_directory)
+        ereport(ERROR,
+                (errcode(ERRCODE_FDW_DYNAMIC_PARAMETER_VALUE_NEEDED),
+                 errmsg("directory is required for pg_ais_fdw foreign tables")));
+
+    PG_RETURN_VOID();
+}
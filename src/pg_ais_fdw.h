@@ -0,0 +1,37 @@
+#ifndef PG_AIS_FDW_H
+#define PG_AIS_FDW_H
+
+#include "postgres.h"
+#include "fmgr.h"
+
+
+/* Bytes of log per parallel work unit; lines are assigned by start offset */
+#define AIS_FDW_CHUNK_SIZE (16 * 1024 * 1024)
+
+/* Read buffer per scan */
+#define AIS_FDW_BUFFER_SIZE (256 * 1024)
+
+/* Lines read past a chunk end to complete multipart messages */
+#define AIS_FDW_TAIL_LINES 32
+
+/* Bytes a chunk's reader may run past the chunk end for those lines */
+#define AIS_FDW_TAIL_BYTES (64 * 1024)
+
+/* Planner estimate of bytes per logged sentence */
+#define AIS_FDW_BYTES_PER_LINE 64
+
+
+/**
+ * @brief Foreign data wrapper handler for directories of raw AIS logs
+ *
+ * Usage: CREATE FOREIGN DATA WRAPPER pg_ais_fdw HANDLER pg_ais_fdw_handler ...;
+ */
+PGDLLEXPORT Datum pg_ais_fdw_handler(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Validate pg_ais_fdw options (directory, suffix)
+ */
+PGDLLEXPORT Datum pg_ais_fdw_validator(PG_FUNCTION_ARGS);
+
+#endif
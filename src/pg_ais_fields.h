@@ -0,0 +1,92 @@
+#ifndef PG_AIS_FIELDS_H
+#define PG_AIS_FIELDS_H
+
+#include "postgres.h"
+#include "fmgr.h"
+
+#include "ais_core.h"
+#include "ais_payload.h"
+
+
+/* Column numbers of the ais_fields composite type */
+enum {
+    F_TYPE, F_MMSI, F_NAV_STATUS, F_LAT, F_LON, F_SPEED, F_HEADING, F_COURSE,
+    F_TIMESTAMP, F_IMO, F_CALLSIGN, F_VESSEL_NAME, F_SHIP_TYPE, F_DESTINATION,
+    F_DRAUGHT, F_MANEUVER, F_FIX_TYPE, F_RADIO, F_REPEAT, F_RAIM,
+    F_STATION, F_RECEIVE_TIME, F_LINE_COUNT,
+    F_NUM_FIELDS
+};
+
+#define FIELD(f) (UINT64CONST(1) << (f))
+
+/* Fields every decoder fills in */
+#define FIELDS_COMMON (FIELD(F_TYPE) | FIELD(F_MMSI))
+#define FIELDS_POSITION (FIELD(F_LAT) | FIELD(F_LON))
+#define FIELDS_CLASS_A (FIELDS_COMMON | FIELDS_POSITION | FIELD(F_NAV_STATUS) | FIELD(F_SPEED) | \
+                        FIELD(F_HEADING) | FIELD(F_COURSE) | FIELD(F_TIMESTAMP) | FIELD(F_MANEUVER) | \
+                        FIELD(F_RADIO) | FIELD(F_REPEAT) | FIELD(F_RAIM))
+#define FIELDS_BASE (FIELDS_COMMON | FIELDS_POSITION | FIELD(F_TIMESTAMP) | FIELD(F_RADIO) | \
+                     FIELD(F_REPEAT) | FIELD(F_RAIM))
+#define FIELDS_CLASS_B (FIELDS_COMMON | FIELDS_POSITION | FIELD(F_SPEED) | FIELD(F_HEADING) | \
+                        FIELD(F_COURSE) | FIELD(F_TIMESTAMP) | FIELD(F_RADIO) | FIELD(F_REPEAT) | FIELD(F_RAIM))
+#define FIELDS_STATIC (FIELDS_COMMON | FIELD(F_IMO) | FIELD(F_CALLSIGN) | FIELD(F_VESSEL_NAME) | \
+                       FIELD(F_SHIP_TYPE) | FIELD(F_DESTINATION) | FIELD(F_DRAUGHT) | FIELD(F_FIX_TYPE))
+/*
+ * Type 19 has no radio status. The bits the shared type 18 decoder reads as
+ * RAIM (148) and radio status (149-167) lie inside its vessel name (143-262),
+ * and its own RAIM flag at bit 305 is not decoded, so neither is reported.
+ */
+#define FIELDS_CLASS_B_EXTENDED (FIELDS_COMMON | FIELDS_POSITION | FIELD(F_SPEED) | FIELD(F_HEADING) | \
+                                 FIELD(F_COURSE) | FIELD(F_TIMESTAMP) | FIELD(F_REPEAT) | FIELD(F_VESSEL_NAME) | \
+                                 FIELD(F_SHIP_TYPE))
+#define FIELDS_STATIC_B_PART_A (FIELDS_COMMON | FIELD(F_REPEAT) | FIELD(F_VESSEL_NAME))
+#define FIELDS_STATIC_B_PART_B (FIELDS_COMMON | FIELD(F_REPEAT) | FIELD(F_CALLSIGN) | FIELD(F_SHIP_TYPE))
+#define FIELDS_SAR (FIELDS_COMMON | FIELDS_POSITION | FIELD(F_SPEED) | FIELD(F_HEADING) | FIELD(F_COURSE))
+
+/* Fields taken from the NMEA 4.0 tag block rather than the payload */
+#define FIELDS_TAG (FIELD(F_STATION) | FIELD(F_RECEIVE_TIME) | FIELD(F_LINE_COUNT))
+
+/* Large enough for the longest decoded string (type 14 text) plus a header */
+#define INLINE_TEXT_MAX 192
+
+/* Scratch space ais_fields_datums() and ais_tag_datums() need for the text columns */
+#define AIS_FIELDS_TEXT_BUFSIZE (4 * INLINE_TEXT_MAX)
+
+
+/* Column names of the ais_fields composite type, in column order */
+extern const char *const ais_field_names[F_NUM_FIELDS];
+
+
+/**
+ * @brief Return the set of ais_fields columns decoded for a message
+ *
+ * @param msg Decoded message, used to tell the two parts of a type 24 apart
+ * @param type Message type from the payload (0–63)
+ * @return Bitmask of F_* columns
+ */
+uint64 ais_fields_present(const AISMessage *msg, int type);
+
+
+/**
+ * @brief Fill ais_fields column values for a decoded message
+ *
+ * @param msg Decoded message
+ * @param type Message type from the payload
+ * @param values Output column values (F_NUM_FIELDS entries)
+ * @param nulls Output null flags (F_NUM_FIELDS entries)
+ * @param textbuf Scratch buffer of AIS_FIELDS_TEXT_BUFSIZE bytes
+ */
+void ais_fields_datums(const AISMessage *msg, int type, Datum *values, bool *nulls, char *textbuf);
+
+
+/**
+ * @brief Fill the tag block columns (station, receive_time, line_count)
+ *
+ * @param tags Tag block of the message, or NULL if it had none
+ * @param values Output column values (F_NUM_FIELDS entries)
+ * @param nulls Output null flags (F_NUM_FIELDS entries)
+ * @param textbuf Scratch buffer of AIS_FIELDS_TEXT_BUFSIZE bytes
+ */
+void ais_tag_datums(const AISTagBlock *tags, Datum *values, bool *nulls, char *textbuf);
+
+#endif
@@ -0,0 +1,407 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "access/xact.h"
+#include "catalog/namespace.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/interrupt.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "utils/guc.h"
+#include "utils/memutils.h"
+#include "utils/snapmgr.h"
+#include "utils/varlena.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pg_ais_ingest.h"
+#include "pg_ais_metrics.h"
+#include "pg_ais_pipeline.h"
+
+
+int ais_ingest_udp_port = 0;
+char *ais_ingest_udp_address = NULL;
+char *ais_ingest_fifo = NULL;
+char *ais_ingest_database = NULL;
+char *ais_ingest_role = NULL;
+char *ais_ingest_table = NULL;
+int ais_ingest_batch_rows = 10000;
+int ais_ingest_batch_ms = 1000;
+int ais_ingest_workers = 0;
+int ais_ingest_sort = AIS_INSERT_ORDER_NONE;
+
+
+static const struct config_enum_entry ingest_sort_options[] = {
+    {"none", AIS_INSERT_ORDER_NONE, false},
+    {"mmsi_time", AIS_INSERT_ORDER_MMSI_TIME, false},
+    {"spatial", AIS_INSERT_ORDER_SPATIAL, false},
+    {NULL, 0, false}
+};
+
+
+/**
+ * @brief Define the pg_ais.ingest_* GUCs and register the ingest worker
+ *
+ * The worker is registered only when pg_ais is in shared_preload_libraries
+ * and a UDP port or FIFO is configured. With pg_ais.ingest_workers > 0 a
+ * receiver is registered instead, which starts the decoders itself.
+ */
+void pg_ais_ingest_init(void) {
+    BackgroundWorker worker;
+
+    DefineCustomIntVariable("pg_ais.ingest_udp_port",
+                            "UDP port the ingest worker receives sentences on (0 disables UDP).",
+                            NULL, &ais_ingest_udp_port, 0, 0, 65535,
+                            PGC_POSTMASTER, 0, NULL, NULL, NULL);
+    DefineCustomStringVariable("pg_ais.ingest_udp_address",
+                               "Local address the ingest UDP socket binds to.",
+                               NULL, &ais_ingest_udp_address, "127.0.0.1",
+                               PGC_POSTMASTER, 0, NULL, NULL, NULL);
+    DefineCustomStringVariable("pg_ais.ingest_fifo",
+                               "Named pipe the ingest worker reads sentences from (created if missing).",
+                               NULL, &ais_ingest_fifo, "",
+                               PGC_POSTMASTER, 0, NULL, NULL, NULL);
+    DefineCustomStringVariable("pg_ais.ingest_database",
+                               "Database the ingest worker connects to.",
+                               NULL, &ais_ingest_database, "postgres",
+                               PGC_POSTMASTER, 0, NULL, NULL, NULL);
+    DefineCustomStringVariable("pg_ais.ingest_role",
+                               "Role the ingest worker inserts as (empty: bootstrap superuser).",
+                               NULL, &ais_ingest_role, "",
+                               PGC_POSTMASTER, 0, NULL, NULL, NULL);
+    DefineCustomStringVariable("pg_ais.ingest_table",
+                               "Table decoded messages are inserted into; columns are matched by name.",
+                               NULL, &ais_ingest_table, "ais_ingest",
+                               PGC_SIGHUP, 0, NULL, NULL, NULL);
+    DefineCustomIntVariable("pg_ais.ingest_batch_rows",
+                            "Rows after which the ingest worker commits a batch.",
+                            NULL, &ais_ingest_batch_rows, 10000, 1, INT_MAX,
+                            PGC_SIGHUP, 0, NULL, NULL, NULL);
+    DefineCustomIntVariable("pg_ais.ingest_batch_ms",
+                            "Milliseconds after which the ingest worker commits a non-empty batch.",
+                            NULL, &ais_ingest_batch_ms, 1000, 1, INT_MAX,
+                            PGC_SIGHUP, GUC_UNIT_MS, NULL, NULL, NULL);
+    DefineCustomEnumVariable("pg_ais.ingest_sort",
+                             "Order each ingest batch is sorted in before it is written.",
+                             "mmsi_time or spatial keeps index insertions on neighbouring leaf pages.",
+                             &ais_ingest_sort, AIS_INSERT_ORDER_NONE, ingest_sort_options,
+                             PGC_SIGHUP, 0, NULL, NULL, NULL);
+    DefineCustomIntVariable("pg_ais.ingest_workers",
+                            "Decoder workers fed by a separate receiver (0 receives and decodes in one worker).",
+                            NULL, &ais_ingest_workers, 0, 0, AIS_PIPELINE_MAX_WORKERS,
+                            PGC_POSTMASTER, 0, NULL, NULL, NULL);
+
+    if (!process_shared_preload_libraries_in_progress) return;
+    if (ais_ingest_udp_port == 0 && ais_ingest_fifo[0] == '\0') return;
+
+    memset(&worker, 0, sizeof(worker));
+    worker.bgw_flags = BGWORKER_SHMEM_ACCESS | BGWORKER_BACKEND_DATABASE_CONNECTION;
+    worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+    worker.bgw_restart_time = AIS_INGEST_RESTART_SECONDS;
+    snprintf(worker.bgw_library_name, BGW_MAXLEN, "pg_ais");
+    if (ais_ingest_workers > 0) {
+        /* The receiver needs no database; its decoders connect themselves */
+        worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+        snprintf(worker.bgw_function_name, BGW_MAXLEN, "pg_ais_receiver_main");
+        snprintf(worker.bgw_name, BGW_MAXLEN, "pg_ais receiver");
+        snprintf(worker.bgw_type, BGW_MAXLEN, "pg_ais receiver");
+    } else {
+        snprintf(worker.bgw_function_name, BGW_MAXLEN, "pg_ais_ingest_main");
+        snprintf(worker.bgw_name, BGW_MAXLEN, "pg_ais ingest");
+        snprintf(worker.bgw_type, BGW_MAXLEN, "pg_ais ingest");
+    }
+    RegisterBackgroundWorker(&worker);
+}
+
+
+/**
+ * @brief Bind a non-blocking UDP socket to the configured address and port
+ *
+ * @return Socket descriptor
+ */
+static int open_udp(void) {
+    struct addrinfo hints = {0};
+    struct addrinfo *addrs;
+    char port[16];
+    int size = AIS_INGEST_SOCKET_BUFFER;
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+    snprintf(port, sizeof(port), "%d", ais_ingest_udp_port);
+
+    int rc = getaddrinfo(ais_ingest_udp_address[0] ? ais_ingest_udp_address : NULL, port, &hints, &addrs);
+    if (rc != 0)
+        ereport(ERROR,
+                (errmsg("could not resolve pg_ais.ingest_udp_address \"%s\": %s",
+                        ais_ingest_udp_address, gai_strerror(rc))));
+
+    int fd = socket(addrs->ai_family, SOCK_DGRAM, 0);
+    if (fd < 0 || bind(fd, addrs->ai_addr, addrs->ai_addrlen) != 0) {
+        int save_errno = errno;
+        freeaddrinfo(addrs);
+        errno = save_errno;
+        ereport(ERROR,
+                (errcode_for_socket_access(),
+                 errmsg("could not bind UDP port %d on \"%s\": %m",
+                        ais_ingest_udp_port, ais_ingest_udp_address)));
+    }
+    freeaddrinfo(addrs);
+
+    /* Best effort: a larger buffer only reduces drops during commits */
+    (void) setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    if (!pg_set_noblock(fd))
+        ereport(ERROR,
+                (errcode_for_socket_access(),
+                 errmsg("could not set UDP socket to non-blocking mode: %m")));
+    return fd;
+}
+
+
+/**
+ * @brief Open the configured FIFO for non-blocking reads, creating it if needed
+ *
+ * Opened read-write so the worker never sees end-of-file when the last
+ * writer disconnects.
+ *
+ * @return File descriptor
+ */
+static int open_fifo(void) {
+    struct stat st;
+
+    if (stat(ais_ingest_fifo, &st) != 0) {
+        if (errno != ENOENT || mkfifo(ais_ingest_fifo, S_IRUSR | S_IWUSR | S_IWGRP) != 0)
+            ereport(ERROR,
+                    (errcode_for_file_access(),
+                     errmsg("could not create FIFO \"%s\": %m", ais_ingest_fifo)));
+    } else if (!S_ISFIFO(st.st_mode)) {
+        ereport(ERROR,
+                (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                 errmsg("\"%s\" is not a FIFO", ais_ingest_fifo)));
+    }
+
+    int fd = open(ais_ingest_fifo, O_RDWR | O_NONBLOCK);
+    if (fd < 0)
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("could not open FIFO \"%s\": %m", ais_ingest_fifo)));
+    return fd;
+}
+
+
+/**
+ * @brief Bind the configured UDP port or open (creating if needed) the FIFO
+ *
+ * UDP wins when both are configured.
+ *
+ * @param src Output source, buffer allocated in the current memory context
+ */
+void ais_ingest_source_open(AISIngestSource *src) {
+    memset(src, 0, sizeof(*src));
+    src->udp = ais_ingest_udp_port > 0;
+    src->fd = src->udp ? open_udp() : open_fifo();
+    /* One extra byte lets a datagram's last line be terminated in place */
+    src->buf = palloc(AIS_INGEST_RECV_SIZE * 2 + 1);
+}
+
+
+/**
+ * @brief Read whatever is available without blocking
+ *
+ * @param src Source
+ * @return false if nothing was available
+ */
+bool ais_ingest_source_fill(AISIngestSource *src) {
+    /* Compact: keep only the partial line at the end */
+    if (src->off > 0) {
+        memmove(src->buf, src->buf + src->off, src->len - src->off);
+        src->len -= src->off;
+        src->off = 0;
+    }
+    if (src->len > AIS_INGEST_RECV_SIZE) {
+        /* A line longer than a whole datagram cannot be a sentence */
+        src->len = 0;
+    }
+
+    ssize_t n = src->udp ? recv(src->fd, src->buf + src->len, AIS_INGEST_RECV_SIZE, 0)
+                         : read(src->fd, src->buf + src->len, AIS_INGEST_RECV_SIZE);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return false;
+        ereport(ERROR,
+                (errcode_for_socket_access(),
+                 errmsg("could not receive AIS sentences: %m")));
+    }
+    if (n == 0) return false;
+
+    src->len += (size_t) n;
+    if (src->udp && src->buf[src->len - 1] != '\n') src->buf[src->len++] = '\n';
+    return true;
+}
+
+
+/**
+ * @brief Return the next complete line in the buffer
+ *
+ * @param src Source
+ * @param line Output line start (not NUL-terminated)
+ * @param len Output line length without the newline
+ * @return false when only a partial line (or nothing) is left
+ */
+bool ais_ingest_source_line(AISIngestSource *src, char **line, size_t *len) {
+    char *start = src->buf + src->off;
+    char *nl = memchr(start, '\n', src->len - src->off);
+
+    if (!nl) return false;
+    *line = start;
+    *len = (size_t) (nl - start);
+    src->off += *len + 1;
+    return true;
+}
+
+
+/**
+ * @brief Insert one message, starting a transaction for a new batch
+ *
+ * The target table name is resolved at the start of every batch, so a
+ * reload of pg_ais.ingest_table takes effect at the next batch.
+ *
+ * @param batch Current batch
+ * @param m Complete message from the stream
+ */
+void ais_ingest_batch_add(AISIngestBatch *batch, const AISStreamMessage *m) {
+    if (batch->ins == NULL) {
+        SetCurrentStatementStartTimestamp();
+        StartTransactionCommand();
+        PushActiveSnapshot(GetTransactionSnapshot());
+        pgstat_report_activity(STATE_RUNNING, "pg_ais ingest batch");
+
+        List *names = stringToQualifiedNameList(ais_ingest_table);
+        Oid relid = RangeVarGetRelid(makeRangeVarFromNameList(names), NoLock, false);
+
+        batch->ins = ais_insert_begin(relid, Min(ais_ingest_batch_rows, AIS_INSERT_DEFAULT_BATCH));
+        ais_insert_set_order(batch->ins, (AISInsertOrder) ais_ingest_sort);
+        batch->ins->states = &batch->states;
+        batch->ins->statics = &batch->statics;
+        batch->started = GetCurrentTimestamp();
+        batch->rows = 0;
+    }
+
+    if (ais_insert_message(batch->ins, m)) batch->rows++;
+    else batch->decode_errors++;
+}
+
+
+/**
+ * @brief Milliseconds until the open batch must be committed
+ *
+ * @param batch Current batch
+ * @return Remaining time, 0 if due now, or -1 if no batch is open
+ */
+long ais_ingest_batch_timeout(const AISIngestBatch *batch) {
+    if (batch->ins == NULL) return -1;
+    if (batch->rows >= (uint64) ais_ingest_batch_rows) return 0;
+
+    long elapsed = TimestampDifferenceMilliseconds(batch->started, GetCurrentTimestamp());
+    return elapsed >= ais_ingest_batch_ms ? 0 : ais_ingest_batch_ms - elapsed;
+}
+
+
+/**
+ * @brief Flush and commit the open batch, if any
+ *
+ * Vessel states and static reports queued by the batch reach the shared
+ * caches only after the commit, so rows that were rolled back never show
+ * up there.
+ *
+ * @param batch Current batch
+ * @return Rows committed
+ */
+uint64 ais_ingest_batch_commit(AISIngestBatch *batch) {
+    if (batch->ins == NULL) return 0;
+
+    uint64 rows = ais_insert_end(batch->ins);
+    batch->ins = NULL;
+    PopActiveSnapshot();
+    CommitTransactionCommand();
+    ais_state_apply(&batch->states);
+    ais_static_apply(&batch->statics);
+    pgstat_report_stat(false);
+    pgstat_report_activity(STATE_IDLE, NULL);
+    elog(DEBUG1, "pg_ais ingest committed " UINT64_FORMAT " rows", rows);
+    return rows;
+}
+
+
+/**
+ * @brief Background worker entry point: receive, decode and insert
+ *
+ * Waits on the socket or FIFO and the process latch, drains everything
+ * available, and commits when pg_ais.ingest_batch_rows rows are pending or
+ * the oldest pending row is pg_ais.ingest_batch_ms old. SIGTERM commits the
+ * open batch before exiting.
+ */
+void pg_ais_ingest_main(Datum arg) {
+    AISIngestSource src;
+    AISIngestBatch batch = {0};
+    AISStream *stream;
+    AISMetricsStreamMark mark = {0};
+
+    pqsignal(SIGHUP, SignalHandlerForConfigReload);
+    pqsignal(SIGTERM, SignalHandlerForShutdownRequest);
+    BackgroundWorkerUnblockSignals();
+
+    BackgroundWorkerInitializeConnection(ais_ingest_database,
+                                         ais_ingest_role[0] ? ais_ingest_role : NULL, 0);
+
+    MemoryContextSwitchTo(TopMemoryContext);
+    ais_ingest_source_open(&src);
+    stream = palloc(sizeof(AISStream));
+    ais_stream_init(stream);
+
+    ereport(LOG,
+            (errmsg("pg_ais ingest worker reading from %s",
+                    src.udp ? psprintf("UDP %s:%d", ais_ingest_udp_address, ais_ingest_udp_port)
+                            : psprintf("FIFO \"%s\"", ais_ingest_fifo))));
+
+    while (!ShutdownRequestPending) {
+        long timeout = ais_ingest_batch_timeout(&batch);
+        int events = WL_LATCH_SET | WL_SOCKET_READABLE | WL_EXIT_ON_PM_DEATH;
+
+        if (timeout > 0) events |= WL_TIMEOUT;
+        if (timeout != 0) {
+            int rc = WaitLatchOrSocket(MyLatch, events, src.fd, timeout, PG_WAIT_EXTENSION);
+            if (rc & WL_LATCH_SET) ResetLatch(MyLatch);
+        }
+        CHECK_FOR_INTERRUPTS();
+
+        if (ConfigReloadPending) {
+            ConfigReloadPending = false;
+            ProcessConfigFile(PGC_SIGHUP);
+        }
+
+        while (!ShutdownRequestPending && ais_ingest_source_fill(&src)) {
+            char *line;
+            size_t len;
+            AISStreamMessage m;
+
+            while (ais_ingest_source_line(&src, &line, &len)) {
+                if (pg_ais_stream_push(stream, line, len, &m) == AIS_STREAM_MESSAGE)
+                    ais_ingest_batch_add(&batch, &m);
+                if (ais_ingest_batch_timeout(&batch) == 0) ais_ingest_batch_commit(&batch);
+            }
+            CHECK_FOR_INTERRUPTS();
+        }
+        pg_ais_record_stream(stream, &mark);
+
+        if (ais_ingest_batch_timeout(&batch) == 0) ais_ingest_batch_commit(&batch);
+    }
+
+    ais_ingest_batch_commit(&batch);
+    proc_exit(0);
+}
@@ -0,0 +1,138 @@
+#ifndef PG_AIS_INGEST_H
+#define PG_AIS_INGEST_H
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/timestamp.h"
+
+#include "ais_stream.h"
+#include "pg_ais_insert.h"
+
+
+/* Receive buffer: one maximal UDP datagram, or a read from the FIFO */
+#define AIS_INGEST_RECV_SIZE 65536
+
+/* Kernel receive buffer requested for the UDP socket to absorb bursts */
+#define AIS_INGEST_SOCKET_BUFFER (4 * 1024 * 1024)
+
+/* Seconds before the postmaster restarts a failed ingest worker */
+#define AIS_INGEST_RESTART_SECONDS 10
+
+
+/* GUCs (pg_ais.ingest_*) */
+extern int ais_ingest_udp_port;
+extern char *ais_ingest_udp_address;
+extern char *ais_ingest_fifo;
+extern char *ais_ingest_database;
+extern char *ais_ingest_role;
+extern char *ais_ingest_table;
+extern int ais_ingest_batch_rows;
+extern int ais_ingest_batch_ms;
+extern int ais_ingest_workers;
+extern int ais_ingest_sort;
+
+
+/**
+ * @brief Where the ingest worker reads raw sentences from
+ *
+ * UDP datagrams and FIFO reads are appended to buf; complete lines are then
+ * handed out in place and a partial trailing line is carried over. A
+ * datagram always ends its last line.
+ */
+typedef struct {
+    int fd;
+    bool udp;
+    char *buf;
+    size_t len;
+    size_t off;
+} AISIngestSource;
+
+
+/**
+ * @brief Rows inserted in the current ingest transaction
+ */
+typedef struct {
+    AISInsertState *ins;
+    TimestampTz started;
+    uint64 rows;
+    uint64 decode_errors;
+    AISStatePending states;   /* vessel states to store once committed */
+    AISStaticPending statics; /* static reports to merge once committed */
+} AISIngestBatch;
+
+
+/**
+ * @brief Define the pg_ais.ingest_* GUCs and register the ingest worker
+ *
+ * The worker is registered only when pg_ais is in shared_preload_libraries
+ * and a UDP port or FIFO is configured. With pg_ais.ingest_workers > 0 a
+ * receiver is registered instead, which starts the decoders itself.
+ */
+void pg_ais_ingest_init(void);
+
+
+/**
+ * @brief Bind the configured UDP port or open (creating if needed) the FIFO
+ *
+ * @param src Output source, buffer allocated in the current memory context
+ */
+void ais_ingest_source_open(AISIngestSource *src);
+
+
+/**
+ * @brief Read whatever is available without blocking
+ *
+ * @param src Source
+ * @return false if nothing was available
+ */
+bool ais_ingest_source_fill(AISIngestSource *src);
+
+
+/**
+ * @brief Return the next complete line in the buffer
+ *
+ * @param src Source
+ * @param line Output line start (not NUL-terminated)
+ * @param len Output line length without the newline
+ * @return false when only a partial line (or nothing) is left
+ */
+bool ais_ingest_source_line(AISIngestSource *src, char **line, size_t *len);
+
+
+/**
+ * @brief Insert one message, starting a transaction for a new batch
+ *
+ * @param batch Current batch
+ * @param m Complete message from the stream
+ */
+void ais_ingest_batch_add(AISIngestBatch *batch, const AISStreamMessage *m);
+
+
+/**
+ * @brief Milliseconds until the open batch must be committed
+ *
+ * @param batch Current batch
+ * @return Remaining time, 0 if due now, or -1 if no batch is open
+ */
+long ais_ingest_batch_timeout(const AISIngestBatch *batch);
+
+
+/**
+ * @brief Flush and commit the open batch, if any
+ *
+ * Vessel states and static reports queued by the batch reach the shared
+ * caches only after the commit, so rows that were rolled back never show
+ * up there.
+ *
+ * @param batch Current batch
+ * @return Rows committed
+ */
+uint64 ais_ingest_batch_commit(AISIngestBatch *batch);
+
+
+/**
+ * @brief Background worker entry point: receive, decode and insert
+ */
+PGDLLEXPORT void pg_ais_ingest_main(Datum arg);
+
+#endif
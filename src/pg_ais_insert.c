@@ -0,0 +1,466 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "access/table.h"
+#include "access/tableam.h"
+#include "access/xact.h"
+#include "catalog/objectaddress.h"
+#include "catalog/pg_type.h"
+#include "executor/executor.h"
+#include "nodes/makefuncs.h"
+#include "optimizer/optimizer.h"
+#include "parser/parse_coerce.h"
+#include "rewrite/rewriteHandler.h"
+#include "utils/acl.h"
+#include "utils/builtins.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+
+#include "ais_payload.h"
+#include "parse_ais_msg.h"
+#include "pg_ais_insert.h"
+#include "pg_ais_metrics.h"
+#include "pg_ais_state.h"
+
+
+/**
+ * @brief Return the SQL type ais_fields_datums() produces for a column
+ *
+ * @param field F_* column number
+ * @return Type OID of the datum
+ */
+static Oid field_type(int field) {
+    switch (field) {
+        case F_LAT: case F_LON: case F_SPEED: case F_HEADING: case F_COURSE: case F_DRAUGHT:
+            return FLOAT8OID;
+        case F_CALLSIGN: case F_VESSEL_NAME: case F_DESTINATION: case F_STATION:
+            return TEXTOID;
+        case F_RECEIVE_TIME:
+            return TIMESTAMPTZOID;
+        case F_RAIM:
+            return BOOLOID;
+        default:
+            return INT4OID;
+    }
+}
+
+
+/**
+ * @brief Decide where one target column takes its value from
+ *
+ * Matches the column name against the ais_fields columns, "sentence" and
+ * "payload", and prepares the cast or input function the column type needs.
+ * Unmatched columns are filled from their default expression.
+ *
+ * @param rel Target relation
+ * @param attr Column to map
+ * @param map Output mapping
+ */
+static void map_column(Relation rel, Form_pg_attribute attr, AISColumnMap *map) {
+    const char *name = NameStr(attr->attname);
+
+    memset(map, 0, sizeof(*map));
+    map->typmod = attr->atttypmod;
+
+    if (strcmp(name, "sentence") == 0 || strcmp(name, "payload") == 0) {
+        Oid infunc;
+        map->source = name[0] == 's' ? AIS_COL_SENTENCE : AIS_COL_PAYLOAD;
+        getTypeInputInfo(attr->atttypid, &infunc, &map->input_ioparam);
+        fmgr_info(infunc, &map->input_fn);
+        return;
+    }
+
+    for (int f = 0; f < F_NUM_FIELDS; f++) {
+        Oid funcid;
+        Oid srctype = field_type(f);
+
+        if (strcmp(name, ais_field_names[f]) != 0) continue;
+
+        map->source = AIS_COL_FIELD;
+        map->field = f;
+        if (attr->atttypid == srctype) return;
+
+        switch (find_coercion_pathway(attr->atttypid, srctype, COERCION_ASSIGNMENT, &funcid)) {
+            case COERCION_PATH_RELABELTYPE:
+                return;
+            case COERCION_PATH_FUNC:
+                map->cast = true;
+                map->cast_nargs = get_func_nargs(funcid);
+                fmgr_info(funcid, &map->cast_fn);
+                return;
+            default:
+                ereport(ERROR,
+                        (errcode(ERRCODE_DATATYPE_MISMATCH),
+                         errmsg("column \"%s\" is of type %s but AIS field \"%s\" is of type %s",
+                                name, format_type_be(attr->atttypid), name, format_type_be(srctype))));
+        }
+    }
+
+    map->source = AIS_COL_DEFAULT;
+    if (!attr->attgenerated) {
+        Expr *defexpr = (Expr *) build_column_default(rel, attr->attnum);
+        if (defexpr)
+            map->default_expr = ExecInitExpr(expression_planner(defexpr), NULL);
+    }
+}
+
+
+/**
+ * @brief Open a target table for batched inserts
+ *
+ * Checks INSERT privilege and rejects relations the multi-insert path cannot
+ * handle (views, partitioned and foreign tables, row triggers).
+ *
+ * @param relid Target table
+ * @param batch_size Rows per table_multi_insert() call
+ * @return Insert state, allocated in the current memory context
+ */
+AISInsertState *ais_insert_begin(Oid relid, int batch_size) {
+    AISInsertState *state = palloc0(sizeof(AISInsertState));
+    Relation rel = table_open(relid, RowExclusiveLock);
+
+    if (rel->rd_rel->relkind != RELKIND_RELATION)
+        ereport(ERROR,
+                (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                 errmsg("\"%s\" is not a table", RelationGetRelationName(rel)),
+                 errhint("Load into a plain table or a single partition.")));
+
+    AclResult aclresult = pg_class_aclcheck(relid, GetUserId(), ACL_INSERT);
+    if (aclresult != ACLCHECK_OK)
+        aclcheck_error(aclresult, get_relkind_objtype(rel->rd_rel->relkind), RelationGetRelationName(rel));
+
+    if (rel->trigdesc &&
+        (rel->trigdesc->trig_insert_before_row || rel->trigdesc->trig_insert_after_row ||
+         rel->trigdesc->trig_insert_instead_row))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("cannot bulk load into \"%s\" because it has row-level INSERT triggers",
+                        RelationGetRelationName(rel))));
+
+    if (batch_size < 1)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("batch size must be positive")));
+
+    /* Executor state so constraints, defaults and index insertion work as in COPY */
+    RangeTblEntry *rte = makeNode(RangeTblEntry);
+    rte->rtekind = RTE_RELATION;
+    rte->relid = relid;
+    rte->relkind = rel->rd_rel->relkind;
+    rte->rellockmode = RowExclusiveLock;
+    rte->requiredPerms = ACL_INSERT;
+
+    state->estate = CreateExecutorState();
+    ExecInitRangeTable(state->estate, list_make1(rte));
+    state->rri = makeNode(ResultRelInfo);
+    ExecInitResultRelation(state->estate, state->rri, 1);
+    ExecOpenIndices(state->rri, false);
+
+    TupleDesc tupdesc = RelationGetDescr(rel);
+    state->columns = palloc0(sizeof(AISColumnMap) * tupdesc->natts);
+    for (int i = 0; i < tupdesc->natts; i++) {
+        Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+        if (!attr->attisdropped) map_column(rel, attr, &state->columns[i]);
+    }
+
+    state->rel = rel;
+    state->cid = GetCurrentCommandId(true);
+    state->bistate = GetBulkInsertState();
+    state->batch_size = batch_size;
+    state->slots = palloc0(sizeof(TupleTableSlot *) * batch_size);
+    state->batchcxt = AllocSetContextCreate(CurrentMemoryContext, "pg_ais insert batch", ALLOCSET_DEFAULT_SIZES);
+    return state;
+}
+
+
+/**
+ * @brief Sort each batch by the given key before it is written
+ *
+ * @param state Insert state
+ * @param order Batch order
+ */
+void ais_insert_set_order(AISInsertState *state, AISInsertOrder order) {
+    Assert(state->nslots == 0);
+
+    state->order = order;
+    if (order != AIS_INSERT_ORDER_NONE && state->keys == NULL) {
+        MemoryContext cxt = GetMemoryChunkContext(state);
+        state->keys = MemoryContextAlloc(cxt, sizeof(AISInsertKey) * state->batch_size);
+        state->sorted = MemoryContextAlloc(cxt, sizeof(TupleTableSlot *) * state->batch_size);
+    }
+}
+
+
+/**
+ * @brief Parse a batch order name: "none", "mmsi_time" or "spatial"
+ *
+ * @param name Order name
+ * @return Batch order; raises an ERROR for unknown names
+ */
+AISInsertOrder ais_insert_order_from_name(const char *name) {
+    if (pg_strcasecmp(name, "none") == 0) return AIS_INSERT_ORDER_NONE;
+    if (pg_strcasecmp(name, "mmsi_time") == 0) return AIS_INSERT_ORDER_MMSI_TIME;
+    if (pg_strcasecmp(name, "spatial") == 0) return AIS_INSERT_ORDER_SPATIAL;
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+             errmsg("invalid sort order \"%s\"", name),
+             errhint("Valid orders are \"none\", \"mmsi_time\" and \"spatial\".")));
+    return AIS_INSERT_ORDER_NONE;   /* keep compiler quiet */
+}
+
+
+/**
+ * @brief Compute the sort key of a row about to be buffered
+ *
+ * The spatial key is read straight from the payload bits, like the
+ * pg_ais_zorder opclass, so it is exact and independent of the float
+ * coordinates in the decoded message.
+ *
+ * @param state Insert state
+ * @param row Decoded message
+ * @param key Output key
+ */
+static void row_sort_key(const AISInsertState *state, const AISInsertRow *row, AISInsertKey *key) {
+    key->slot = state->nslots;
+    key->major = PG_UINT64_MAX;
+    key->minor = 0;
+
+    if (state->order == AIS_INSERT_ORDER_MMSI_TIME) {
+        key->major = (uint32) row->msg->mmsi;
+        if (row->tags) key->minor = row->tags->receive_time;
+    } else {
+        AISPayloadView view = {.payload = row->payload, .len = strlen(row->payload), .total = 1, .seq = 1};
+        int32_t lon, lat;
+        if (ais_view_position(&view, &lon, &lat))
+            key->major = ais_morton_key(ais_quantize_lon(lon), ais_quantize_lat(lat));
+    }
+}
+
+
+/**
+ * @brief qsort comparator for AISInsertKey
+ */
+static int insert_key_cmp(const void *a, const void *b) {
+    const AISInsertKey *x = a;
+    const AISInsertKey *y = b;
+
+    if (x->major != y->major) return x->major < y->major ? -1 : 1;
+    if (x->minor != y->minor) return x->minor < y->minor ? -1 : 1;
+    return x->slot - y->slot;
+}
+
+
+/**
+ * @brief Reorder the buffered slots by their sort keys
+ *
+ * Only the slot pointers move; every slot stays owned by the state.
+ *
+ * @param state Insert state
+ */
+static void sort_batch(AISInsertState *state) {
+    qsort(state->keys, state->nslots, sizeof(AISInsertKey), insert_key_cmp);
+    for (int i = 0; i < state->nslots; i++)
+        state->sorted[i] = state->slots[state->keys[i].slot];
+    memcpy(state->slots, state->sorted, sizeof(TupleTableSlot *) * state->nslots);
+}
+
+
+/**
+ * @brief Convert one decoded value to the target column type
+ *
+ * @param map Column mapping
+ * @param value Source datum
+ * @return Datum of the column type
+ */
+static Datum cast_value(AISColumnMap *map, Datum value) {
+    if (!map->cast) return value;
+    if (map->cast_nargs == 1) return FunctionCall1(&map->cast_fn, value);
+    return FunctionCall3(&map->cast_fn, value, Int32GetDatum(map->typmod), BoolGetDatum(false));
+}
+
+
+/**
+ * @brief Buffer one decoded message, flushing when the batch is full
+ *
+ * @param state Insert state
+ * @param row Decoded message
+ */
+void ais_insert_row(AISInsertState *state, const AISInsertRow *row) {
+    if (state->nslots == state->batch_size) ais_insert_flush(state);
+
+    uint64 started = PG_AIS_TIMING_START();
+    TupleTableSlot *slot = state->slots[state->nslots];
+    if (slot == NULL) {
+        slot = table_slot_create(state->rel, NULL);
+        state->slots[state->nslots] = slot;
+    }
+    ExecClearTuple(slot);
+
+    MemoryContext oldcxt = MemoryContextSwitchTo(state->batchcxt);
+    ExprContext *econtext = GetPerTupleExprContext(state->estate);
+    TupleDesc tupdesc = slot->tts_tupleDescriptor;
+    Datum fields[F_NUM_FIELDS];
+    bool field_nulls[F_NUM_FIELDS];
+    char *textbuf = palloc(AIS_FIELDS_TEXT_BUFSIZE);
+
+    ais_fields_datums(row->msg, row->type, fields, field_nulls, textbuf);
+    ais_tag_datums(row->tags, fields, field_nulls, textbuf);
+
+    for (int i = 0; i < tupdesc->natts; i++) {
+        AISColumnMap *map = &state->columns[i];
+        Datum *value = &slot->tts_values[i];
+        bool *isnull = &slot->tts_isnull[i];
+
+        *value = (Datum) 0;
+        *isnull = true;
+        if (TupleDescAttr(tupdesc, i)->attisdropped) continue;
+
+        switch (map->source) {
+            case AIS_COL_FIELD:
+                *isnull = field_nulls[map->field];
+                if (!*isnull) *value = cast_value(map, fields[map->field]);
+                break;
+            case AIS_COL_SENTENCE:
+                if (row->sentence) {
+                    *value = InputFunctionCall(&map->input_fn, (char *) row->sentence, map->input_ioparam, map->typmod);
+                    *isnull = false;
+                }
+                break;
+            case AIS_COL_PAYLOAD:
+                *value = InputFunctionCall(&map->input_fn, (char *) row->payload, map->input_ioparam, map->typmod);
+                *isnull = false;
+                break;
+            case AIS_COL_DEFAULT:
+                if (map->default_expr)
+                    *value = ExecEvalExpr(map->default_expr, econtext, isnull);
+                break;
+        }
+    }
+    ExecStoreVirtualTuple(slot);
+
+    if (tupdesc->constr) {
+        if (tupdesc->constr->has_generated_stored)
+            ExecComputeStoredGenerated(state->rri, state->estate, slot, CMD_INSERT);
+        ExecConstraints(state->rri, slot, state->estate);
+    }
+
+    MemoryContextSwitchTo(oldcxt);
+    if (state->order != AIS_INSERT_ORDER_NONE) row_sort_key(state, row, &state->keys[state->nslots]);
+    state->nslots++;
+    PG_AIS_TIMING_END(AIS_STAGE_OUTPUT, row->type, started);
+}
+
+
+/**
+ * @brief Decode one complete message and queue it for insertion
+ *
+ * The single-part sentence (with its tag block) is kept for a "sentence"
+ * column; reassembled messages have none. With the states and statics
+ * queues set, positions and static data are queued for the vessel state
+ * cache and the static data dictionary, timestamped by the tag block
+ * receive time or else the current time; the caller applies the queues
+ * once the batch has committed.
+ *
+ * @param ins Insert state
+ * @param m Complete message from the stream
+ * @return false if the payload does not decode
+ */
+bool ais_insert_message(AISInsertState *ins, const AISStreamMessage *m) {
+    AISPayloadView view = {
+        .payload = m->payload, .len = m->len, .fill_bits = m->fill_bits,
+        .total = 1, .seq = 1, .channel = m->channel
+    };
+    char sentence[AIS_MAX_SENTENCE_LEN];
+    AISMessage msg = {0};
+
+    if (!parse_ais_payload(&msg, m->payload, m->fill_bits).ok) {
+        free_ais_message(&msg);
+        return false;
+    }
+
+    if (ins->states || ins->statics) {
+        TimestampTz ts = m->tags.receive_time ? time_t_to_timestamptz((pg_time_t) m->tags.receive_time)
+                                              : GetCurrentTimestamp();
+        if (ins->states) ais_state_defer(ins->states, &msg, &view, ts);
+        if (ins->statics) ais_static_defer(ins->statics, &msg, ts);
+    }
+
+    AISInsertRow row = {
+        .msg = &msg,
+        .type = ais_view_type(&view),
+        .sentence = NULL,
+        .payload = m->payload,
+        .tags = &m->tags
+    };
+    if (m->sentence && m->sentence_len < sizeof(sentence)) {
+        memcpy(sentence, m->sentence, m->sentence_len);
+        sentence[m->sentence_len] = '\0';
+        row.sentence = sentence;
+    }
+
+    PG_TRY();
+    {
+        ais_insert_row(ins, &row);
+    }
+    PG_FINALLY();
+    {
+        free_ais_message(&msg);
+    }
+    PG_END_TRY();
+    return true;
+}
+
+
+/**
+ * @brief Write all buffered rows to the table and its indexes
+ *
+ * Rows are sorted first when a batch order is set.
+ *
+ * @param state Insert state
+ */
+void ais_insert_flush(AISInsertState *state) {
+    if (state->nslots == 0) return;
+    if (state->order != AIS_INSERT_ORDER_NONE && state->nslots > 1) sort_batch(state);
+
+    uint64 started = PG_AIS_TIMING_START();
+    table_multi_insert(state->rel, state->slots, state->nslots, state->cid, 0, state->bistate);
+
+    for (int i = 0; i < state->nslots; i++) {
+        if (state->rri->ri_NumIndices > 0) {
+            List *recheck = ExecInsertIndexTuples(state->rri, state->slots[i], state->estate,
+                                                  false, false, NULL, NIL);
+            list_free(recheck);
+        }
+        ExecClearTuple(state->slots[i]);
+    }
+    PG_AIS_TIMING_END(AIS_STAGE_INSERT, 0, started);
+
+    state->rows += state->nslots;
+    state->nslots = 0;
+    MemoryContextReset(state->batchcxt);
+    ResetPerTupleExprContext(state->estate);
+}
+
+
+/**
+ * @brief Flush remaining rows and release the target table
+ *
+ * @param state Insert state
+ * @return Total rows inserted
+ */
+uint64 ais_insert_end(AISInsertState *state) {
+    ais_insert_flush(state);
+
+    for (int i = 0; i < state->batch_size && state->slots[i]; i++)
+        ExecDropSingleTupleTableSlot(state->slots[i]);
+
+    FreeBulkInsertState(state->bistate);
+    table_finish_bulk_insert(state->rel, 0);
+    ExecCloseResultRelations(state->estate);
+    ExecCloseRangeTableRelations(state->estate);
+    FreeExecutorState(state->estate);
+    table_close(state->rel, NoLock);
+    MemoryContextDelete(state->batchcxt);
+    return state->rows;
+}
@@ -0,0 +1,181 @@
+#ifndef PG_AIS_INSERT_H
+#define PG_AIS_INSERT_H
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "access/heapam.h"
+#include "executor/executor.h"
+#include "nodes/execnodes.h"
+#include "utils/relcache.h"
+
+#include "ais_core.h"
+#include "ais_stream.h"
+#include "pg_ais_fields.h"
+#include "pg_ais_state.h"
+#include "pg_ais_static.h"
+
+
+/* Default number of rows buffered before table_multi_insert() */
+#define AIS_INSERT_DEFAULT_BATCH 1000
+
+
+/**
+ * @brief Where a target column takes its value from
+ */
+typedef enum {
+    AIS_COL_DEFAULT,   /* column default (or NULL when there is none) */
+    AIS_COL_FIELD,     /* an ais_fields column of the decoded message */
+    AIS_COL_SENTENCE,  /* the raw sentence of a single-part message */
+    AIS_COL_PAYLOAD    /* the reassembled armored payload */
+} AISColumnSource;
+
+
+/**
+ * @brief Per-column conversion from a decoded message into the target type
+ */
+typedef struct {
+    AISColumnSource source;
+    int field;                /* F_* column when source is AIS_COL_FIELD */
+    bool cast;                /* value needs cast_fn (types differ) */
+    int cast_nargs;
+    FmgrInfo cast_fn;
+    FmgrInfo input_fn;        /* type input function for text sources */
+    Oid input_ioparam;
+    int32 typmod;
+    ExprState *default_expr;  /* for AIS_COL_DEFAULT */
+} AISColumnMap;
+
+
+/**
+ * @brief Order rows are written in within each batch
+ *
+ * Sorting a batch before table_multi_insert() turns random btree leaf
+ * accesses into mostly sequential ones for an index on the same key.
+ */
+typedef enum {
+    AIS_INSERT_ORDER_NONE,        /* arrival order */
+    AIS_INSERT_ORDER_MMSI_TIME,   /* MMSI, then tag block time, then arrival */
+    AIS_INSERT_ORDER_SPATIAL      /* Morton key of the position; none last */
+} AISInsertOrder;
+
+
+/**
+ * @brief Sort key of one buffered row
+ */
+typedef struct {
+    uint64 major;
+    int64 minor;
+    int slot;          /* index into the unsorted slots, also the tiebreak */
+} AISInsertKey;
+
+
+/**
+ * @brief A decoded message ready to be written as one row
+ */
+typedef struct {
+    const AISMessage *msg;
+    int type;
+    const char *sentence;      /* NUL-terminated, NULL for reassembled messages */
+    const char *payload;       /* NUL-terminated armored payload */
+    const AISTagBlock *tags;   /* NMEA 4.0 tag block, or NULL */
+} AISInsertRow;
+
+
+/**
+ * @brief Batched multi-insert of decoded messages into a heap table
+ *
+ * Target columns are matched by name against the ais_fields columns plus
+ * "sentence" and "payload"; every other column gets its default. Rows are
+ * buffered in slots and written with table_multi_insert() under one bulk
+ * insert state, then indexed, as COPY FROM does. Each batch may be sorted
+ * first for index locality (see ais_insert_set_order()).
+ */
+typedef struct {
+    Relation rel;
+    EState *estate;
+    ResultRelInfo *rri;
+    BulkInsertState bistate;
+    CommandId cid;
+    AISColumnMap *columns;
+    TupleTableSlot **slots;
+    int nslots;
+    int batch_size;
+    AISInsertOrder order;
+    AISInsertKey *keys;        /* per buffered row, when order is set */
+    TupleTableSlot **sorted;   /* scratch for reordering slots */
+    AISStatePending *states;   /* queue for the vessel state cache, or NULL */
+    AISStaticPending *statics; /* queue for the static data dictionary, or NULL */
+    MemoryContext batchcxt;
+    uint64 rows;
+} AISInsertState;
+
+
+/**
+ * @brief Open a target table for batched inserts
+ *
+ * Checks INSERT privilege and rejects relations the multi-insert path cannot
+ * handle (views, partitioned and foreign tables, row triggers).
+ *
+ * @param relid Target table
+ * @param batch_size Rows per table_multi_insert() call
+ * @return Insert state, allocated in the current memory context
+ */
+AISInsertState *ais_insert_begin(Oid relid, int batch_size);
+
+
+/**
+ * @brief Sort each batch by the given key before it is written
+ *
+ * @param state Insert state
+ * @param order Batch order
+ */
+void ais_insert_set_order(AISInsertState *state, AISInsertOrder order);
+
+
+/**
+ * @brief Parse a batch order name: "none", "mmsi_time" or "spatial"
+ *
+ * @param name Order name
+ * @return Batch order; raises an ERROR for unknown names
+ */
+AISInsertOrder ais_insert_order_from_name(const char *name);
+
+
+/**
+ * @brief Buffer one decoded message, flushing when the batch is full
+ *
+ * @param state Insert state
+ * @param row Decoded message
+ */
+void ais_insert_row(AISInsertState *state, const AISInsertRow *row);
+
+
+/**
+ * @brief Decode one complete message and queue it for insertion
+ *
+ * @param ins Insert state
+ * @param m Complete message from the stream
+ * @return false if the payload does not decode
+ */
+bool ais_insert_message(AISInsertState *ins, const AISStreamMessage *m);
+
+
+/**
+ * @brief Write all buffered rows to the table and its indexes
+ *
+ * Rows are sorted first when a batch order is set.
+ *
+ * @param state Insert state
+ */
+void ais_insert_flush(AISInsertState *state);
+
+
+/**
+ * @brief Flush remaining rows and release the target table
+ *
+ * @param state Insert state
+ * @return Total rows inserted
+ */
+uint64 ais_insert_end(AISInsertState *state);
+
+#endif
@@ -0,0 +1,198 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "access/htup_details.h"
+#include "catalog/pg_authid.h"
+#include "utils/acl.h"
+#include "utils/builtins.h"
+
+#include <string.h>
+
+#include "ais_stream.h"
+#include "pg_ais_insert.h"
+#include "pg_ais_load.h"
+#include "pg_ais_metrics.h"
+
+
+/* Columns of the pg_ais_load_file() result row */
+enum {
+    L_ROWS, L_SENTENCES, L_BAD_CHECKSUM, L_MALFORMED, L_INCOMPLETE, L_DECODE_ERRORS,
+    L_NUM_COLUMNS
+};
+
+
+/**
+ * @brief Memory context reset callback stopping an abandoned reader
+ */
+static void load_file_cleanup(void *arg) {
+    AISLoadFile *file = (AISLoadFile *) arg;
+    ais_reader_close(file->reader);
+    file->reader = NULL;
+}
+
+
+/**
+ * @brief Open a plain, gzip or zstd log file for reading
+ *
+ * @param path File to read
+ * @param offset Byte offset to start at (plain files only)
+ * @param limit Maximum bytes to read, or 0 for the rest of the file
+ * @return Open file, allocated in the current memory context
+ */
+AISLoadFile *ais_load_open(const char *path, uint64 offset, uint64 limit) {
+    char err[512];
+    AISReader *reader = ais_reader_open(path, offset, limit, err, sizeof(err));
+
+    if (reader == NULL)
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("%s", err)));
+
+    AISLoadFile *file = palloc0(sizeof(AISLoadFile));
+    file->reader = reader;
+    file->path = pstrdup(path);
+    file->cleanup.func = load_file_cleanup;
+    file->cleanup.arg = file;
+    MemoryContextRegisterResetCallback(CurrentMemoryContext, &file->cleanup);
+    return file;
+}
+
+
+/**
+ * @brief Read up to n decompressed bytes, raising an ERROR on failure
+ *
+ * @param file Open file
+ * @param buf Destination buffer
+ * @param n Capacity of buf
+ * @return Bytes read; 0 at end of file
+ */
+size_t ais_load_read(AISLoadFile *file, char *buf, size_t n) {
+    size_t got = ais_reader_read(file->reader, buf, n);
+
+    if (got == 0 && ais_reader_error(file->reader))
+        ereport(ERROR,
+                (errcode(ERRCODE_DATA_CORRUPTED),
+                 errmsg("could not read file \"%s\": %s", file->path, ais_reader_error(file->reader))));
+    return got;
+}
+
+
+/**
+ * @brief Stop the reader thread and close the file
+ *
+ * @param file Open file
+ */
+void ais_load_close(AISLoadFile *file) {
+    ais_reader_close(file->reader);
+    file->reader = NULL;
+}
+
+
+/**
+ * @brief Stream a raw AIS receiver log from the server into a table
+ *
+ * Plain, gzip and zstd files are accepted (detected from their magic bytes)
+ * and decompressed by a reader thread in large blocks, overlapping with
+ * decoding. Lines are split in place in the block buffer; each line is
+ * checksum-validated, reassembled and decoded in a single pass, and rows go
+ * to the target with table_multi_insert() in batches of batch_size. Lines
+ * that fail validation or decoding are counted and skipped.
+ *
+ * Target columns are matched by name: any ais_fields column, "sentence"
+ * (raw single-part sentence, NULL for reassembled messages) and "payload"
+ * (reassembled armored payload). Other columns take their defaults.
+ *
+ * Each batch can be sorted before it is written ("mmsi_time" or "spatial")
+ * so index insertions hit neighbouring leaf pages.
+ *
+ * Usage: SELECT * FROM pg_ais_load_file('/data/ais/2024-06-10.nmea', 'ais_positions');
+ */
+PG_FUNCTION_INFO_V1(pg_ais_load_file);
+Datum
+pg_ais_load_file(PG_FUNCTION_ARGS) {
+    char *path = text_to_cstring(PG_GETARG_TEXT_PP(0));
+    Oid relid = PG_GETARG_OID(1);
+    int batch_size = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : AIS_INSERT_DEFAULT_BATCH;
+    AISInsertOrder order = PG_NARGS() > 3 ? ais_insert_order_from_name(text_to_cstring(PG_GETARG_TEXT_PP(3)))
+                                          : AIS_INSERT_ORDER_NONE;
+    TupleDesc tupdesc;
+
+    if (!has_privs_of_role(GetUserId(), ROLE_PG_READ_SERVER_FILES))
+        ereport(ERROR,
+                (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+                 errmsg("must be superuser or have privileges of the pg_read_server_files role to load from a file")));
+
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        ereport(ERROR, (errmsg("return type must be a row type")));
+
+    AISLoadFile *file = ais_load_open(path, 0, 0);
+    AISInsertState *ins = ais_insert_begin(relid, batch_size);
+    ais_insert_set_order(ins, order);
+    AISStream *stream = palloc(sizeof(AISStream));
+    char *buf = palloc(AIS_LOAD_BLOCK_SIZE);
+    size_t carry = 0;
+    bool skip_line = false;
+    uint64 decode_errors = 0;
+    AISMetricsStreamMark mark = {0};
+
+    ais_stream_init(stream);
+
+    for (;;) {
+        size_t n = ais_load_read(file, buf + carry, AIS_LOAD_BLOCK_SIZE - carry);
+
+        size_t avail = carry + n;
+        char *line = buf;
+        char *end = buf + avail;
+        char *nl;
+
+        CHECK_FOR_INTERRUPTS();
+
+        while ((nl = memchr(line, '\n', end - line)) != NULL) {
+            AISStreamMessage m;
+            if (!skip_line &&
+                pg_ais_stream_push(stream, line, nl - line, &m) == AIS_STREAM_MESSAGE &&
+                !ais_insert_message(ins, &m))
+                decode_errors++;
+            skip_line = false;
+            line = nl + 1;
+        }
+
+        carry = end - line;
+        if (n == 0) {
+            /* Last line without a trailing newline */
+            AISStreamMessage m;
+            if (carry > 0 && !skip_line &&
+                pg_ais_stream_push(stream, line, carry, &m) == AIS_STREAM_MESSAGE &&
+                !ais_insert_message(ins, &m))
+                decode_errors++;
+            break;
+        }
+        if (carry == AIS_LOAD_BLOCK_SIZE) {
+            /* A line longer than a block cannot be a sentence; drop it */
+            stream->malformed++;
+            skip_line = true;
+            carry = 0;
+        } else if (carry > 0) {
+            memmove(buf, line, carry);
+        }
+    }
+
+    ais_load_close(file);
+    ais_stream_finish(stream);
+    pg_ais_record_stream(stream, &mark);
+    uint64 rows = ais_insert_end(ins);
+
+    Datum values[L_NUM_COLUMNS];
+    bool nulls[L_NUM_COLUMNS] = {false};
+
+    values[L_ROWS] = Int64GetDatum(rows);
+    values[L_SENTENCES] = Int64GetDatum(stream->sentences);
+    values[L_BAD_CHECKSUM] = Int64GetDatum(stream->bad_checksum);
+    values[L_MALFORMED] = Int64GetDatum(stream->malformed);
+    values[L_INCOMPLETE] = Int64GetDatum(stream->incomplete);
+    values[L_DECODE_ERRORS] = Int64GetDatum(decode_errors);
+
+    tupdesc = BlessTupleDesc(tupdesc);
+    PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
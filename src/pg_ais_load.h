@@ -0,0 +1,74 @@
+#ifndef PG_AIS_LOAD_H
+#define PG_AIS_LOAD_H
+
+#include "postgres.h"
+#include "fmgr.h"
+
+#include "ais_reader.h"
+
+
+/* Bytes taken from the log reader per call */
+#define AIS_LOAD_BLOCK_SIZE (1024 * 1024)
+
+
+/**
+ * @brief A server log file read through an AISReader
+ *
+ * The reader thread is stopped when the memory context the file was opened
+ * in is reset, so an ERROR never leaks it.
+ */
+typedef struct {
+    AISReader *reader;
+    char *path;
+    MemoryContextCallback cleanup;
+} AISLoadFile;
+
+
+/**
+ * @brief Open a plain, gzip or zstd log file for reading
+ *
+ * @param path File to read
+ * @param offset Byte offset to start at (plain files only)
+ * @param limit Maximum bytes to read, or 0 for the rest of the file
+ * @return Open file, allocated in the current memory context
+ */
+AISLoadFile *ais_load_open(const char *path, uint64 offset, uint64 limit);
+
+
+/**
+ * @brief Read up to n decompressed bytes, raising an ERROR on failure
+ *
+ * @param file Open file
+ * @param buf Destination buffer
+ * @param n Capacity of buf
+ * @return Bytes read; 0 at end of file
+ */
+size_t ais_load_read(AISLoadFile *file, char *buf, size_t n);
+
+
+/**
+ * @brief Stop the reader thread and close the file
+ *
+ * @param file Open file
+ */
+void ais_load_close(AISLoadFile *file);
+
+
+/**
+ * @brief Stream a raw AIS receiver log from the server into a table
+ *
+ * The file is opened with ais_load_open(), so plain, gzip and zstd logs
+ * are decompressed by the reader thread while the backend decodes. Lines
+ * are split in place in AIS_LOAD_BLOCK_SIZE blocks and fed through an
+ * AISStream, and decoded messages go to the target in batches. The result
+ * row counts inserted rows, sentences seen, and lines rejected for a bad
+ * checksum, malformed fields, missing fragments or a failed decode.
+ *
+ * Each batch can be sorted before it is written ("mmsi_time" or "spatial")
+ * so index insertions hit neighbouring leaf pages.
+ *
+ * Usage: SELECT * FROM pg_ais_load_file('/data/ais/2024-06-10.nmea', 'ais_positions');
+ */
+PGDLLEXPORT Datum pg_ais_load_file(PG_FUNCTION_ARGS);
+
+#endif
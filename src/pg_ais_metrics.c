@@ -1,74 +1,640 @@
 #include "pg_ais_metrics.h"
 #include "funcapi.h"
+#include "miscadmin.h"
+#include "access/htup_details.h"
+#include "port/atomics.h"
+#include "storage/ipc.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
 #include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/memutils.h"
+#include "utils/tuplestore.h"
 
 
-static uint64_t total_messages_parsed = 0;
-static uint64_t total_parse_failures = 0;
-static uint64_t total_reassembly_attempts = 0;
-static uint64_t total_reassembly_success = 0;
+/* Columns of the pg_ais_stat() rows */
+enum {
+    ST_METRIC, ST_LABEL, ST_VALUE,
+    ST_NUM_COLUMNS
+};
+
+/* Columns of the pg_ais_timing() rows */
+enum {
+    TM_STAGE, TM_TYPE, TM_COUNT, TM_MEAN, TM_P50, TM_P99, TM_P999,
+    TM_NUM_COLUMNS
+};
+
+
+/* GUCs */
+bool ais_track_timing = false;
+
+
+/**
+ * @brief Counters of one process
+ *
+ * Only the owning process writes its slot, so increments are a plain read
+ * and write of an atomic rather than a locked add; readers sum all slots.
+ */
+typedef struct {
+    pg_atomic_uint64 counter[AIS_METRIC_COUNTERS];
+} AISMetricsSlot;
+
+/* Slots padded to a cache line so neighbouring backends do not share one */
+typedef union {
+    AISMetricsSlot slot;
+    char pad[TYPEALIGN(PG_CACHE_LINE_SIZE, sizeof(AISMetricsSlot))];
+} AISMetricsSlotPadded;
+
+
+/**
+ * @brief Shared header: slot count and the totals at the last reset
+ */
+typedef struct {
+    int nslots;
+    pg_atomic_uint64 reset[AIS_METRIC_COUNTERS];
+} AISMetricsShared;
+
+
+/**
+ * @brief Latency histograms of all processes, in nanoseconds
+ *
+ * Shared by every backend, so updates are atomic adds; timing is opt-in
+ * and already pays for two clock reads per stage.
+ */
+typedef struct {
+    pg_atomic_uint64 bucket[AIS_STAGES][AIS_METRIC_TYPES][AIS_HISTOGRAM_BUCKETS];
+    pg_atomic_uint64 sum[AIS_STAGES][AIS_METRIC_TYPES];
+} AISTimingHistograms;
+
+
+static AISMetricsShared *metrics_shared = NULL;
+static AISMetricsSlotPadded *metrics_slots = NULL;
+
+/* Used when not preloaded, and by processes without a PGPROC */
+static AISMetricsSlot local_slot;
+static bool local_slot_ready = false;
+
+/* Shared histograms, or a session-local copy when not preloaded */
+static AISTimingHistograms *timing_histograms = NULL;
+
+static const char *const reassembly_labels[AIS_REASSEMBLY_OUTCOMES] = {"complete", "incomplete"};
+
+static const char *const error_labels[AIS_METRIC_ERRORS] = {
+    "ok", "too_short", "invalid_bitfield", "unsupported_type", "string_decode", "payload_null"
+};
+
+static const char *const stage_labels[AIS_STAGES] = {
+    "tokenize", "dearmor", "decode", "reassemble", "output", "insert"
+};
+
+
+/**
+ * @brief Prometheus name suffix, label name and help text of each metric
+ */
+static const struct {
+    const char *metric;
+    const char *label;
+    const char *help;
+} prometheus_info[] = {
+    {"sentences", NULL, "Lines read by the loaders and ingest workers."},
+    {"bad_checksum", NULL, "Lines with a missing or wrong checksum."},
+    {"malformed", NULL, "Lines that are not valid sentences."},
+    {"reassembly", "outcome", "Multipart messages joined or dropped."},
+    {"error", "code", "Failed decodes by ParseErrorCode."},
+    {"decoded", "type", "Messages decoded, by message type."},
+    {"failed", "type", "Messages that failed to decode, by message type."},
+};
+
+/* Smallest histogram bound exported to Prometheus, in nanoseconds */
+#define PROMETHEUS_MIN_BOUND 256
+
+/**
+ * @brief Define the metrics GUCs
+ */
+void pg_ais_metrics_init(void) {
+    DefineCustomBoolVariable("pg_ais.track_timing",
+                             "Collects per-stage parse latency histograms.",
+                             "Adds two clock reads per stage; see pg_ais_timing().",
+                             &ais_track_timing,
+                             false,
+                             PGC_SUSET,
+                             0,
+                             NULL, NULL, NULL);
+}
+
+
+/**
+ * @brief Number of slots: one per PGPROC that can run pg_ais code
+ */
+static int metrics_nslots(void) {
+    return MaxBackends + NUM_AUXILIARY_PROCS;
+}
+
+
+/**
+ * @brief Reserve one counter slot per backend and auxiliary process
+ */
+void pg_ais_metrics_shmem_request(void) {
+    RequestAddinShmemSpace(sizeof(AISMetricsShared));
+    RequestAddinShmemSpace(mul_size(metrics_nslots(), sizeof(AISMetricsSlotPadded)));
+    RequestAddinShmemSpace(sizeof(AISTimingHistograms));
+}
+
+
+/**
+ * @brief Zero every bucket and sum of a histogram set
+ */
+static void timing_init(AISTimingHistograms *h) {
+    for (int s = 0; s < AIS_STAGES; s++)
+        for (int t = 0; t < AIS_METRIC_TYPES; t++) {
+            pg_atomic_init_u64(&h->sum[s][t], 0);
+            for (int b = 0; b < AIS_HISTOGRAM_BUCKETS; b++) pg_atomic_init_u64(&h->bucket[s][t][b], 0);
+        }
+}
+
+
+/**
+ * @brief Create or attach the shared counter slots
+ *
+ * Called with AddinShmemInitLock held.
+ */
+void pg_ais_metrics_shmem_startup(void) {
+    bool found_shared, found_slots, found_timing;
+    int nslots = metrics_nslots();
+
+    metrics_shared = ShmemInitStruct("pg_ais metrics", sizeof(AISMetricsShared), &found_shared);
+    metrics_slots = ShmemInitStruct("pg_ais metrics slots",
+                                    mul_size(nslots, sizeof(AISMetricsSlotPadded)), &found_slots);
+    timing_histograms = ShmemInitStruct("pg_ais timing", sizeof(AISTimingHistograms), &found_timing);
+    if (!found_timing) timing_init(timing_histograms);
+    if (found_shared && found_slots) return;
+
+    metrics_shared->nslots = nslots;
+    for (int c = 0; c < AIS_METRIC_COUNTERS; c++) {
+        pg_atomic_init_u64(&metrics_shared->reset[c], 0);
+        for (int i = 0; i < nslots; i++) pg_atomic_init_u64(&metrics_slots[i].slot.counter[c], 0);
+    }
+}
+
+
+/**
+ * @brief Slot of the calling process
+ */
+static AISMetricsSlot *metrics_slot(void) {
+    if (metrics_shared != NULL && MyProc != NULL && MyProc->pgprocno < metrics_shared->nslots)
+        return &metrics_slots[MyProc->pgprocno].slot;
+
+    if (!local_slot_ready) {
+        for (int c = 0; c < AIS_METRIC_COUNTERS; c++) pg_atomic_init_u64(&local_slot.counter[c], 0);
+        local_slot_ready = true;
+    }
+    return &local_slot;
+}
+
+
+/**
+ * @brief Add to a counter of the caller's own slot
+ */
+static inline void metrics_add(AISMetricsSlot *slot, int counter, uint64 n) {
+    pg_atomic_write_u64(&slot->counter[counter], pg_atomic_read_u64(&slot->counter[counter]) + n);
+}
+
+
+/**
+ * @brief Count one decode attempt
+ *
+ * @param type Message type from the payload (invalid types are counted as 0)
+ * @param result Outcome of the decode
+ */
+void pg_ais_record_parse_result(int type, ParseResult result) {
+    AISMetricsSlot *slot = metrics_slot();
+
+    if (type < 0 || type >= AIS_METRIC_TYPES) type = 0;
+    if (result.ok) {
+        metrics_add(slot, AIS_METRIC_DECODED + type, 1);
+        return;
+    }
+    metrics_add(slot, AIS_METRIC_FAILED + type, 1);
+    if (result.code > PARSE_OK && result.code < AIS_METRIC_ERRORS)
+        metrics_add(slot, AIS_METRIC_ERROR + result.code, 1);
+}
+
+
+/**
+ * @brief Count a multipart message leaving reassembly
+ *
+ * @param outcome Whether it was joined or dropped
+ * @param n Number of messages
+ */
+void pg_ais_record_reassembly(AISReassemblyOutcome outcome, uint64 n) {
+    if (n > 0) metrics_add(metrics_slot(), AIS_METRIC_REASSEMBLY + outcome, n);
+}
+
+
+/**
+ * @brief Add a stream's counters since the mark and advance the mark
+ *
+ * @param stream Stream whose counters to add
+ * @param mark Counters added by earlier calls for this stream
+ */
+void pg_ais_record_stream(const AISStream *stream, AISMetricsStreamMark *mark) {
+    AISMetricsSlot *slot = metrics_slot();
+
+    metrics_add(slot, AIS_METRIC_SENTENCES, stream->sentences - mark->sentences);
+    metrics_add(slot, AIS_METRIC_BAD_CHECKSUM, stream->bad_checksum - mark->bad_checksum);
+    metrics_add(slot, AIS_METRIC_MALFORMED, stream->malformed - mark->malformed);
+    metrics_add(slot, AIS_METRIC_REASSEMBLY + AIS_REASSEMBLY_COMPLETE, stream->reassembled - mark->reassembled);
+    metrics_add(slot, AIS_METRIC_REASSEMBLY + AIS_REASSEMBLY_INCOMPLETE, stream->incomplete - mark->incomplete);
+
+    mark->sentences = stream->sentences;
+    mark->bad_checksum = stream->bad_checksum;
+    mark->malformed = stream->malformed;
+    mark->reassembled = stream->reassembled;
+    mark->incomplete = stream->incomplete;
+}
 
 
 /**
- * @brief Increment metrics counters after each parse
+ * @brief Histograms of this cluster, or of this session when not preloaded
+ */
+static AISTimingHistograms *timing_get(void) {
+    if (timing_histograms == NULL) {
+        timing_histograms = MemoryContextAlloc(TopMemoryContext, sizeof(AISTimingHistograms));
+        timing_init(timing_histograms);
+    }
+    return timing_histograms;
+}
+
+
+/**
+ * @brief Count one timed stage in the latency histograms
  *
- * Should be called from inside pg_ais_parse to track success/failure.
+ * @param stage Stage that ran
+ * @param type Message type, or 0 if unknown or not a single type
+ * @param elapsed_ns Duration in nanoseconds
+ */
+void pg_ais_record_timing(AISStage stage, int type, uint64 elapsed_ns) {
+    AISTimingHistograms *h = timing_get();
+
+    if (type < 0 || type >= AIS_METRIC_TYPES) type = 0;
+    pg_atomic_fetch_add_u64(&h->bucket[stage][type][ais_histogram_bucket(elapsed_ns)], 1);
+    pg_atomic_fetch_add_u64(&h->sum[stage][type], elapsed_ns);
+}
+
+
+/**
+ * @brief Feed one line to a stream, timed as tokenize or reassemble
  *
- * @param success True if parsing succeeded (PARSE_OK), false otherwise
+ * Lines that complete or extend a multipart message count as reassembly;
+ * the message type is only known once a message is complete.
  */
-void pg_ais_record_parse_result(bool success) {
-    total_messages_parsed++;
-    if (!success) total_parse_failures++;
+AISStreamResult pg_ais_stream_push(AISStream *stream, const char *line, size_t len, AISStreamMessage *out) {
+    uint64 started = PG_AIS_TIMING_START();
+    AISStreamResult result = ais_stream_push(stream, line, len, out);
+
+    if (likely(started == 0)) return result;
+
+    int type = 0;
+    AISStage stage = result == AIS_STREAM_PENDING ? AIS_STAGE_REASSEMBLE : AIS_STAGE_TOKENIZE;
+    if (result == AIS_STREAM_MESSAGE) {
+        AISPayloadView view = {.payload = out->payload, .len = out->len, .total = 1, .seq = 1};
+        type = ais_view_type(&view);
+        if (out->nparts > 1) stage = AIS_STAGE_REASSEMBLE;
+    }
+    PG_AIS_TIMING_END(stage, type, started);
+    return result;
 }
 
 
 /**
- * @brief Record an attempt to reassemble a multipart AIS message
+ * @brief Sum every counter over all slots, without the reset baseline
  *
- * Tracks how many reassembly attempts occurred and how many succeeded.
- * Should be called after parse_ais_payload from try_reassemble.
+ * @param totals Output, AIS_METRIC_COUNTERS entries
+ */
+static void metrics_raw_totals(uint64 *totals) {
+    memset(totals, 0, sizeof(uint64) * AIS_METRIC_COUNTERS);
+    if (metrics_shared == NULL) {
+        AISMetricsSlot *slot = metrics_slot();
+        for (int c = 0; c < AIS_METRIC_COUNTERS; c++) totals[c] = pg_atomic_read_u64(&slot->counter[c]);
+        return;
+    }
+
+    for (int i = 0; i < metrics_shared->nslots; i++)
+        for (int c = 0; c < AIS_METRIC_COUNTERS; c++)
+            totals[c] += pg_atomic_read_u64(&metrics_slots[i].slot.counter[c]);
+}
+
+
+/**
+ * @brief Counters since the last reset, summed over all processes
+ *
+ * Slots are read without a lock, so a total may miss increments made
+ * while it is being summed.
  *
- * @param success True if reassembly led to a successful parse
+ * @param totals Output, AIS_METRIC_COUNTERS entries
  */
-void pg_ais_record_reassembly_attempt(bool success) {
-    total_reassembly_attempts++;
-    if (success) total_reassembly_success++;
+void pg_ais_metrics_totals(uint64 *totals) {
+    metrics_raw_totals(totals);
+    if (metrics_shared == NULL) return;
+
+    for (int c = 0; c < AIS_METRIC_COUNTERS; c++) {
+        uint64 base = pg_atomic_read_u64(&metrics_shared->reset[c]);
+        totals[c] = totals[c] > base ? totals[c] - base : 0;
+    }
 }
 
 
 /**
- * @brief SQL-accessible function to expose internal parse metrics
+ * @brief Sum a range of counters
+ */
+static uint64 metrics_sum(const uint64 *totals, int first, int n) {
+    uint64 sum = 0;
+    for (int c = first; c < first + n; c++) sum += totals[c];
+    return sum;
+}
+
+
+/**
+ * @brief Metric name and label of a counter
  *
- * Returns a single row with total parses and failures.
+ * @param counter Counter index
+ * @param label Output label, or NULL for counters without one
+ * @param buf Buffer for a numeric label
+ * @return Metric name
+ */
+static const char *metric_name(int counter, const char **label, char *buf) {
+    *label = NULL;
+    if (counter >= AIS_METRIC_DECODED) {
+        int type = (counter - AIS_METRIC_DECODED) % AIS_METRIC_TYPES;
+        if (type == 0) {
+            *label = "other";
+        } else {
+            pg_ltoa(type, buf);
+            *label = buf;
+        }
+        return counter >= AIS_METRIC_FAILED ? "failed" : "decoded";
+    }
+    if (counter >= AIS_METRIC_ERROR) {
+        *label = error_labels[counter - AIS_METRIC_ERROR];
+        return "error";
+    }
+    if (counter >= AIS_METRIC_REASSEMBLY) {
+        *label = reassembly_labels[counter - AIS_METRIC_REASSEMBLY];
+        return "reassembly";
+    }
+    switch (counter) {
+        case AIS_METRIC_SENTENCES: return "sentences";
+        case AIS_METRIC_BAD_CHECKSUM: return "bad_checksum";
+        default: return "malformed";
+    }
+}
+
+
+/**
+ * @brief Append a histogram series label set
+ */
+static void prometheus_series(StringInfo buf, const char *suffix, int stage, int type) {
+    appendStringInfo(buf, "pg_ais_stage_duration_seconds_%s{stage=\"%s\",type=\"", suffix, stage_labels[stage]);
+    if (type == 0)
+        appendStringInfoString(buf, "other");
+    else
+        appendStringInfo(buf, "%d", type);
+    appendStringInfoChar(buf, '"');
+}
+
+
+/**
+ * @brief Append every counter and latency histogram in the Prometheus
+ * text exposition format
+ *
+ * Counters are exported as pg_ais_<metric>_total, labelled like
+ * pg_stat_ais. Each timed stage and type becomes one
+ * pg_ais_stage_duration_seconds histogram whose buckets are the powers of
+ * two from 256 ns, which are exact bucket boundaries of the internal
+ * log-linear histogram; a reset looks like a counter restart.
+ *
+ * @param buf Output buffer
+ */
+void pg_ais_metrics_prometheus_text(StringInfo buf) {
+    uint64 totals[AIS_METRIC_COUNTERS];
+    const char *previous = NULL;
+    AISTimingHistograms *h = timing_get();
+
+    pg_ais_metrics_totals(totals);
+    for (int c = 0; c < AIS_METRIC_COUNTERS; c++) {
+        char numbuf[12];
+        const char *label;
+        const char *name = metric_name(c, &label, numbuf);
+        int i = 0;
+
+        if (c == AIS_METRIC_ERROR + PARSE_OK) continue;
+        while (strcmp(prometheus_info[i].metric, name) != 0) i++;
+        if (previous == NULL || strcmp(name, previous) != 0) {
+            appendStringInfo(buf, "# HELP pg_ais_%s_total %s\n", name, prometheus_info[i].help);
+            appendStringInfo(buf, "# TYPE pg_ais_%s_total counter\n", name);
+            previous = name;
+        }
+        if (label)
+            appendStringInfo(buf, "pg_ais_%s_total{%s=\"%s\"} " UINT64_FORMAT "\n",
+                             name, prometheus_info[i].label, label, totals[c]);
+        else
+            appendStringInfo(buf, "pg_ais_%s_total " UINT64_FORMAT "\n", name, totals[c]);
+    }
+
+    appendStringInfoString(buf, "# HELP pg_ais_stage_duration_seconds Parsing stage latency, "
+                                "collected when pg_ais.track_timing is on.\n");
+    appendStringInfoString(buf, "# TYPE pg_ais_stage_duration_seconds histogram\n");
+    for (int s = 0; s < AIS_STAGES; s++) {
+        for (int t = 0; t < AIS_METRIC_TYPES; t++) {
+            uint64 counts[AIS_HISTOGRAM_BUCKETS];
+            uint64 count = 0;
+
+            for (int b = 0; b < AIS_HISTOGRAM_BUCKETS; b++) {
+                counts[b] = pg_atomic_read_u64(&h->bucket[s][t][b]);
+                count += counts[b];
+            }
+            if (count == 0) continue;
+
+            /* The last bucket is open-ended and only counts towards +Inf */
+            uint64 cumulative = 0;
+            for (int b = 0; b < AIS_HISTOGRAM_BUCKETS - 1; b++) {
+                cumulative += counts[b];
+                if ((b + 1) % AIS_HISTOGRAM_SUB != 0 || ais_histogram_upper(b) < PROMETHEUS_MIN_BOUND) continue;
+                prometheus_series(buf, "bucket", s, t);
+                appendStringInfo(buf, ",le=\"%.9g\"} " UINT64_FORMAT "\n",
+                                 ais_histogram_upper(b) / 1e9, cumulative);
+            }
+            prometheus_series(buf, "bucket", s, t);
+            appendStringInfo(buf, ",le=\"+Inf\"} " UINT64_FORMAT "\n", count);
+            prometheus_series(buf, "sum", s, t);
+            appendStringInfo(buf, "} %.9g\n", pg_atomic_read_u64(&h->sum[s][t]) / 1e9);
+            prometheus_series(buf, "count", s, t);
+            appendStringInfo(buf, "} " UINT64_FORMAT "\n", count);
+        }
+    }
+}
+
+
+/**
+ * @brief Totals since the last reset, summed over all processes
+ *
+ * Returns a single row with total parses, failures and multipart
+ * reassemblies. Without shared_preload_libraries it covers this session.
  */
 PG_FUNCTION_INFO_V1(pg_ais_metrics);
 Datum pg_ais_metrics(PG_FUNCTION_ARGS) {
     TupleDesc tupdesc;
+    uint64 totals[AIS_METRIC_COUNTERS];
+
     if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
         ereport(ERROR, (errmsg("invalid return type for pg_ais_metrics")));
 
     Datum values[4];
     bool nulls[4] = {false, false, false, false};
 
-    values[0] = Int64GetDatum(total_messages_parsed);
-    values[1] = Int64GetDatum(total_parse_failures);
-    values[2] = Int64GetDatum(total_reassembly_attempts);
-    values[3] = Int64GetDatum(total_reassembly_success);
+    pg_ais_metrics_totals(totals);
+    uint64 failed = metrics_sum(totals, AIS_METRIC_FAILED, AIS_METRIC_TYPES);
+    uint64 complete = totals[AIS_METRIC_REASSEMBLY + AIS_REASSEMBLY_COMPLETE];
 
-    HeapTuple tuple = heap_form_tuple(tupdesc, values, nulls);
+    values[0] = Int64GetDatum(metrics_sum(totals, AIS_METRIC_DECODED, AIS_METRIC_TYPES) + failed);
+    values[1] = Int64GetDatum(failed);
+    values[2] = Int64GetDatum(complete + totals[AIS_METRIC_REASSEMBLY + AIS_REASSEMBLY_INCOMPLETE]);
+    values[3] = Int64GetDatum(complete);
+
+    HeapTuple tuple = heap_form_tuple(BlessTupleDesc(tupdesc), values, nulls);
     PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
 }
 
 
 /**
- * @brief Reset internal counters to zero (optional utility)
+ * @brief Every counter as (metric, label, value) rows; backs pg_stat_ais
+ *
+ * decoded and failed are labelled by message type, error by ParseErrorCode
+ * and reassembly by outcome. The "ok" error row is omitted.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_stat);
+Datum
+pg_ais_stat(PG_FUNCTION_ARGS) {
+    ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    TupleDesc tupdesc;
+    uint64 totals[AIS_METRIC_COUNTERS];
+
+    if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo) || (rsinfo->allowedModes & SFRM_Materialize) == 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("set-valued function called in context that cannot accept a set")));
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        ereport(ERROR, (errmsg("return type must be a row type")));
+
+    MemoryContext oldcxt = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+    Tuplestorestate *tupstore = tuplestore_begin_heap(true, false, work_mem);
+    rsinfo->returnMode = SFRM_Materialize;
+    rsinfo->setResult = tupstore;
+    rsinfo->setDesc = CreateTupleDescCopy(tupdesc);
+    MemoryContextSwitchTo(oldcxt);
+
+    pg_ais_metrics_totals(totals);
+    for (int c = 0; c < AIS_METRIC_COUNTERS; c++) {
+        Datum values[ST_NUM_COLUMNS];
+        bool nulls[ST_NUM_COLUMNS] = {false};
+        char buf[12];
+        const char *label;
+
+        if (c == AIS_METRIC_ERROR + PARSE_OK) continue;
+        values[ST_METRIC] = CStringGetTextDatum(metric_name(c, &label, buf));
+        values[ST_LABEL] = label ? CStringGetTextDatum(label) : (Datum) 0;
+        nulls[ST_LABEL] = label == NULL;
+        values[ST_VALUE] = Int64GetDatum((int64) totals[c]);
+        tuplestore_putvalues(tupstore, rsinfo->setDesc, values, nulls);
+    }
+    return (Datum) 0;
+}
+
+
+/**
+ * @brief Latency percentiles per stage and message type
+ *
+ * One row per stage and type that has been timed since the last reset;
+ * type is NULL for work not attributable to one valid type. Percentiles
+ * are bucket midpoints, within 1/16 of the true value.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_timing);
+Datum
+pg_ais_timing(PG_FUNCTION_ARGS) {
+    ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    TupleDesc tupdesc;
+    AISTimingHistograms *h = timing_get();
+
+    if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo) || (rsinfo->allowedModes & SFRM_Materialize) == 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("set-valued function called in context that cannot accept a set")));
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        ereport(ERROR, (errmsg("return type must be a row type")));
+
+    MemoryContext oldcxt = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+    Tuplestorestate *tupstore = tuplestore_begin_heap(true, false, work_mem);
+    rsinfo->returnMode = SFRM_Materialize;
+    rsinfo->setResult = tupstore;
+    rsinfo->setDesc = CreateTupleDescCopy(tupdesc);
+    MemoryContextSwitchTo(oldcxt);
+
+    for (int s = 0; s < AIS_STAGES; s++) {
+        for (int t = 0; t < AIS_METRIC_TYPES; t++) {
+            uint64_t counts[AIS_HISTOGRAM_BUCKETS];
+            uint64 count = 0;
+            Datum values[TM_NUM_COLUMNS];
+            bool nulls[TM_NUM_COLUMNS] = {false};
+
+            for (int b = 0; b < AIS_HISTOGRAM_BUCKETS; b++) {
+                counts[b] = pg_atomic_read_u64(&h->bucket[s][t][b]);
+                count += counts[b];
+            }
+            if (count == 0) continue;
+
+            values[TM_STAGE] = CStringGetTextDatum(stage_labels[s]);
+            values[TM_TYPE] = Int32GetDatum(t);
+            nulls[TM_TYPE] = t == 0;
+            values[TM_COUNT] = Int64GetDatum((int64) count);
+            values[TM_MEAN] = Float8GetDatum((double) pg_atomic_read_u64(&h->sum[s][t]) / count / 1000.0);
+            values[TM_P50] = Float8GetDatum(ais_histogram_quantile(counts, 0.5) / 1000.0);
+            values[TM_P99] = Float8GetDatum(ais_histogram_quantile(counts, 0.99) / 1000.0);
+            values[TM_P999] = Float8GetDatum(ais_histogram_quantile(counts, 0.999) / 1000.0);
+            tuplestore_putvalues(tupstore, rsinfo->setDesc, values, nulls);
+        }
+    }
+    return (Datum) 0;
+}
+
+
+/**
+ * @brief Reset the counters and histograms of all processes to zero
+ *
+ * Shared slots are never written by other processes, so the reset records
+ * the current totals as the new baseline instead of clearing them. The
+ * histograms are shared and cleared in place; a concurrent add may
+ * survive the reset.
  */
 PG_FUNCTION_INFO_V1(pg_ais_reset_metrics);
 Datum pg_ais_reset_metrics(PG_FUNCTION_ARGS) {
-    total_messages_parsed = 0;
-    total_parse_failures = 0;
-    total_reassembly_attempts = 0;
-    total_reassembly_success = 0;
+    uint64 totals[AIS_METRIC_COUNTERS];
+
+    if (timing_histograms != NULL) {
+        for (int s = 0; s < AIS_STAGES; s++)
+            for (int t = 0; t < AIS_METRIC_TYPES; t++) {
+                pg_atomic_write_u64(&timing_histograms->sum[s][t], 0);
+                for (int b = 0; b < AIS_HISTOGRAM_BUCKETS; b++)
+                    pg_atomic_write_u64(&timing_histograms->bucket[s][t][b], 0);
+            }
+    }
+
+    if (metrics_shared == NULL) {
+        AISMetricsSlot *slot = metrics_slot();
+        for (int c = 0; c < AIS_METRIC_COUNTERS; c++) pg_atomic_write_u64(&slot->counter[c], 0);
+        PG_RETURN_VOID();
+    }
+
+    metrics_raw_totals(totals);
+    for (int c = 0; c < AIS_METRIC_COUNTERS; c++) pg_atomic_write_u64(&metrics_shared->reset[c], totals[c]);
     PG_RETURN_VOID();
 }
-
@@ -3,42 +3,221 @@
 
 #include "postgres.h"
 #include "fmgr.h"
+#include "lib/stringinfo.h"
 
-#ifdef PG_MODULE_MAGIC
-PG_MODULE_MAGIC;
+#include <time.h>
+
+#include "ais_histogram.h"
+#include "ais_stream.h"
+#include "parse_ais_result.h"
+
+
+/* Message types counted separately; slot 0 collects invalid types */
+#define AIS_METRIC_TYPES 28
+
+/* One counter per ParseErrorCode */
+#define AIS_METRIC_ERRORS (PARSE_ERR_PAYLOAD_NULL + 1)
+
+
+/**
+ * @brief How a multipart message left reassembly
+ */
+typedef enum {
+    AIS_REASSEMBLY_COMPLETE,   /* every fragment arrived and was joined */
+    AIS_REASSEMBLY_INCOMPLETE, /* dropped while waiting for fragments */
+    AIS_REASSEMBLY_OUTCOMES
+} AISReassemblyOutcome;
+
+
+/**
+ * @brief Index of each counter in a metrics slot
+ */
+typedef enum {
+    AIS_METRIC_SENTENCES,
+    AIS_METRIC_BAD_CHECKSUM,
+    AIS_METRIC_MALFORMED,
+    AIS_METRIC_REASSEMBLY,                                              /* + outcome */
+    AIS_METRIC_ERROR = AIS_METRIC_REASSEMBLY + AIS_REASSEMBLY_OUTCOMES, /* + ParseErrorCode */
+    AIS_METRIC_DECODED = AIS_METRIC_ERROR + AIS_METRIC_ERRORS,          /* + message type */
+    AIS_METRIC_FAILED = AIS_METRIC_DECODED + AIS_METRIC_TYPES,          /* + message type */
+    AIS_METRIC_COUNTERS = AIS_METRIC_FAILED + AIS_METRIC_TYPES
+} AISMetricCounter;
+
+
+/**
+ * @brief Parsing stages timed when pg_ais.track_timing is on
+ *
+ * Stages may nest: decode includes the dearmoring of binary payloads.
+ */
+typedef enum {
+    AIS_STAGE_TOKENIZE,   /* sentence split, checksum and tag block */
+    AIS_STAGE_DEARMOR,    /* 6-bit binary payload to bytes */
+    AIS_STAGE_DECODE,     /* per-type field decode */
+    AIS_STAGE_REASSEMBLE, /* fragment buffering and joining */
+    AIS_STAGE_OUTPUT,     /* JSONB or row building */
+    AIS_STAGE_INSERT,     /* batched heap and index insert */
+    AIS_STAGES
+} AISStage;
+
+
+/* GUCs */
+extern bool ais_track_timing;
+
+
+/* Start a stage timer; 0 when timing is off */
+#define PG_AIS_TIMING_START() (unlikely(ais_track_timing) ? pg_ais_clock_ns() : 0)
+
+/* Record a stage started by PG_AIS_TIMING_START(); type is only evaluated when timed */
+#define PG_AIS_TIMING_END(stage, type, started) \
+    do { \
+        if (unlikely((started) != 0)) pg_ais_record_timing((stage), (type), pg_ais_clock_ns() - (started)); \
+    } while (0)
+
+
+/**
+ * @brief Stream counters already added to the metrics
+ */
+typedef struct {
+    uint64 sentences;
+    uint64 bad_checksum;
+    uint64 malformed;
+    uint64 incomplete;
+    uint64 reassembled;
+} AISMetricsStreamMark;
+
+
+/**
+ * @brief Define the metrics GUCs
+ */
+void pg_ais_metrics_init(void);
+
+
+/**
+ * @brief Reserve one counter slot per backend and auxiliary process
+ */
+void pg_ais_metrics_shmem_request(void);
+
+
+/**
+ * @brief Create or attach the shared counter slots
+ *
+ * Called with AddinShmemInitLock held. Without it, every backend counts
+ * in a private slot and the metrics cover the current session only.
+ */
+void pg_ais_metrics_shmem_startup(void);
+
+
+/**
+ * @brief Count one decode attempt
+ *
+ * Called by parse_ais_payload() for every message it dispatches.
+ *
+ * @param type Message type from the payload (invalid types are counted as 0)
+ * @param result Outcome of the decode
+ */
+void pg_ais_record_parse_result(int type, ParseResult result);
+
+
+/**
+ * @brief Count a multipart message leaving reassembly
+ *
+ * @param outcome Whether it was joined or dropped
+ * @param n Number of messages
+ */
+void pg_ais_record_reassembly(AISReassemblyOutcome outcome, uint64 n);
+
+
+/**
+ * @brief Add a stream's counters since the mark and advance the mark
+ *
+ * Long-running readers call this once per batch; a zeroed mark starts
+ * from a freshly initialised stream.
+ *
+ * @param stream Stream whose counters to add
+ * @param mark Counters added by earlier calls for this stream
+ */
+void pg_ais_record_stream(const AISStream *stream, AISMetricsStreamMark *mark);
+
+
+/**
+ * @brief Monotonic clock in nanoseconds, unaffected by NTP slewing
+ */
+static inline uint64 pg_ais_clock_ns(void) {
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC_RAW
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
 #endif
+    return (uint64) ts.tv_sec * 1000000000 + (uint64) ts.tv_nsec;
+}
+
 
 /**
- * @brief Increment metrics counters after each parse
+ * @brief Count one timed stage in the latency histograms
  *
- * Should be called from inside pg_ais_parse to track success/failure.
+ * @param stage Stage that ran
+ * @param type Message type, or 0 if unknown or not a single type
+ * @param elapsed_ns Duration in nanoseconds
+ */
+void pg_ais_record_timing(AISStage stage, int type, uint64 elapsed_ns);
+
+
+/**
+ * @brief Feed one line to a stream, timed as tokenize or reassemble
  *
- * @param success True if parsing succeeded (PARSE_OK), false otherwise
+ * Same as ais_stream_push(); lines that complete or extend a multipart
+ * message count as reassembly.
  */
-void pg_ais_record_parse_result(bool success);
+AISStreamResult pg_ais_stream_push(AISStream *stream, const char *line, size_t len, AISStreamMessage *out);
 
 
 /**
- * @brief Record an attempt to reassemble a multipart AIS message
+ * @brief Counters since the last reset, summed over all processes
  *
- * Tracks how many reassembly attempts occurred and how many succeeded.
- * Should be called after parse_ais_payload from try_reassemble.
+ * @param totals Output, indexed by AISMetricCounter
+ */
+void pg_ais_metrics_totals(uint64 *totals);
+
+
+/**
+ * @brief Append every counter and latency histogram in the Prometheus
+ * text exposition format
  *
- * @param success True if reassembly led to a successful parse
+ * @param buf Output buffer
  */
-void pg_ais_record_reassembly_attempt(bool success);
+void pg_ais_metrics_prometheus_text(StringInfo buf);
 
 
 /**
- * @brief SQL-accessible function to expose internal parse metrics
+ * @brief Totals since the last reset, summed over all processes
  *
- * Returns a single row with total parses and failures.
+ * Usage: SELECT * FROM pg_ais_metrics();
  */
 PGDLLEXPORT Datum pg_ais_metrics(PG_FUNCTION_ARGS);
 
+
+/**
+ * @brief Every counter as (metric, label, value) rows; backs pg_stat_ais
+ *
+ * Usage: SELECT * FROM pg_stat_ais WHERE metric = 'decoded';
+ */
+PGDLLEXPORT Datum pg_ais_stat(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Latency percentiles per stage and message type
+ *
+ * Usage: SELECT * FROM pg_ais_timing() ORDER BY p99_us DESC;
+ */
+PGDLLEXPORT Datum pg_ais_timing(PG_FUNCTION_ARGS);
+
+
 /**
- * @brief Reset internal counters to zero (optional utility)
+ * @brief Reset the counters and histograms of all processes to zero
+ *
+ * Usage: SELECT pg_ais_reset_metrics();
  */
 PGDLLEXPORT Datum pg_ais_reset_metrics(PG_FUNCTION_ARGS);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,608 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "access/htup_details.h"
+#include "access/xact.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/interrupt.h"
+#include "storage/dsm.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
+#include "utils/guc.h"
+#include "utils/memutils.h"
+#include "utils/timestamp.h"
+
+#include "ais_hash.h"
+#include "ais_payload.h"
+#include "ais_stream.h"
+#include "pg_ais_ingest.h"
+#include "pg_ais_metrics.h"
+#include "pg_ais_pipeline.h"
+
+
+/**
+ * @brief Fixed shared memory: where backends find the running pipeline
+ */
+typedef struct {
+    pg_atomic_uint32 handle;        /* dsm_handle, or DSM_HANDLE_INVALID */
+} AISPipelineShared;
+
+
+/**
+ * @brief Counters copied out of one ring for pg_ais_ingest_stats()
+ */
+typedef struct {
+    int pid;
+    uint64 depth;
+    uint64 enqueued;
+    uint64 stalls;
+    uint64 dropped;
+    uint64 rows;
+    uint64 decode_errors;
+} AISPipelineStats;
+
+
+/**
+ * @brief Receiver-side state of a running pipeline
+ */
+typedef struct {
+    dsm_segment *seg;
+    AISPipelineHeader *header;
+    BackgroundWorkerHandle *handles[AIS_PIPELINE_MAX_WORKERS];
+    TimestampTz checked;            /* last time the decoders were checked */
+} AISReceiver;
+
+
+static AISPipelineShared *pipeline_shared = NULL;
+
+
+/**
+ * @brief Reserve the fixed shared memory that publishes the pipeline segment
+ */
+void pg_ais_pipeline_shmem_request(void) {
+    RequestAddinShmemSpace(MAXALIGN(sizeof(AISPipelineShared)));
+}
+
+
+/**
+ * @brief Attach to (or initialize) the fixed pipeline shared memory
+ *
+ * Called with AddinShmemInitLock held.
+ */
+void pg_ais_pipeline_shmem_startup(void) {
+    bool found;
+
+    pipeline_shared = ShmemInitStruct("pg_ais pipeline", sizeof(AISPipelineShared), &found);
+    if (!found) pg_atomic_init_u32(&pipeline_shared->handle, DSM_HANDLE_INVALID);
+}
+
+
+/**
+ * @brief Size of a pipeline segment with nworkers rings
+ */
+static Size pipeline_size(int nworkers) {
+    return add_size(offsetof(AISPipelineHeader, rings),
+                    mul_size(sizeof(AISPipelineRing), nworkers));
+}
+
+
+/**
+ * @brief Set the latch of the decoder attached to a ring, if any
+ *
+ * @param ring Decoder's ring
+ */
+static void set_decoder_latch(AISPipelineRing *ring) {
+    if (pg_atomic_read_u32(&ring->pid) == 0) return;
+    pg_read_barrier();
+    SetLatch(&ProcGlobal->allProcs[pg_atomic_read_u32(&ring->procno)].procLatch);
+}
+
+
+/**
+ * @brief Wake a decoder if it is waiting on its latch
+ *
+ * @param ring Decoder's ring
+ */
+static void wake_decoder(AISPipelineRing *ring) {
+    pg_memory_barrier();
+    if (pg_atomic_read_u32(&ring->sleeping)) set_decoder_latch(ring);
+}
+
+
+/**
+ * @brief Start (or restart) the decoder for one ring
+ *
+ * @param seg Pipeline segment
+ * @param index Ring index
+ * @return Worker handle, or NULL if no background worker slot was free
+ */
+static BackgroundWorkerHandle *launch_decoder(dsm_segment *seg, int index) {
+    BackgroundWorker worker;
+    BackgroundWorkerHandle *handle;
+
+    memset(&worker, 0, sizeof(worker));
+    worker.bgw_flags = BGWORKER_SHMEM_ACCESS | BGWORKER_BACKEND_DATABASE_CONNECTION;
+    worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+    worker.bgw_restart_time = BGW_NEVER_RESTART;
+    snprintf(worker.bgw_library_name, BGW_MAXLEN, "pg_ais");
+    snprintf(worker.bgw_function_name, BGW_MAXLEN, "pg_ais_decoder_main");
+    snprintf(worker.bgw_name, BGW_MAXLEN, "pg_ais decoder %d", index);
+    snprintf(worker.bgw_type, BGW_MAXLEN, "pg_ais decoder");
+    worker.bgw_main_arg = UInt32GetDatum(dsm_segment_handle(seg));
+    memcpy(worker.bgw_extra, &index, sizeof(index));
+    worker.bgw_notify_pid = MyProcPid;
+
+    if (!RegisterDynamicBackgroundWorker(&worker, &handle)) return NULL;
+    return handle;
+}
+
+
+/**
+ * @brief Restart decoders that have exited or were never started
+ *
+ * A decoder that fails (for example because the target table is missing)
+ * exits and is started again here, so its ring keeps draining once the
+ * problem is fixed. Runs at most every AIS_PIPELINE_CHECK_MS.
+ *
+ * @param r Receiver state
+ */
+static void ensure_decoders(AISReceiver *r) {
+    TimestampTz now = GetCurrentTimestamp();
+
+    if (!TimestampDifferenceExceeds(r->checked, now, AIS_PIPELINE_CHECK_MS)) return;
+    r->checked = now;
+
+    for (int i = 0; i < r->header->nworkers; i++) {
+        pid_t pid;
+
+        if (r->handles[i] && GetBackgroundWorkerPid(r->handles[i], &pid) != BGWH_STOPPED) continue;
+        if (r->handles[i]) {
+            pfree(r->handles[i]);
+            ereport(LOG, (errmsg("pg_ais decoder %d exited, restarting", i)));
+        }
+        r->handles[i] = launch_decoder(r->seg, i);
+        if (!r->handles[i])
+            ereport(WARNING,
+                    (errmsg("could not start pg_ais decoder %d", i),
+                     errhint("Raise max_worker_processes to at least pg_ais.ingest_workers + 1.")));
+    }
+}
+
+
+/**
+ * @brief Whether the decoder of a ring has been started and not yet exited
+ */
+static bool decoder_running(AISReceiver *r, int index) {
+    pid_t pid;
+
+    return r->handles[index] && GetBackgroundWorkerPid(r->handles[index], &pid) != BGWH_STOPPED;
+}
+
+
+/**
+ * @brief Exit callback: tell decoders to drain and stop, unpublish the segment
+ */
+static void receiver_shutdown(int code, Datum arg) {
+    AISPipelineHeader *header = (AISPipelineHeader *) DatumGetPointer(arg);
+
+    pg_atomic_write_u32(&pipeline_shared->handle, DSM_HANDLE_INVALID);
+    pg_atomic_write_u32(&header->shutdown, 1);
+    pg_memory_barrier();
+    for (int i = 0; i < header->nworkers; i++) set_decoder_latch(&header->rings[i]);
+}
+
+
+/**
+ * @brief Pick the ring for one line
+ *
+ * Fragments are routed by sequence id and channel only: some receivers tag
+ * just the first fragment with its station, and every fragment of a message
+ * must reach the same decoder. Receiver prefixes and tag blocks are skipped
+ * first, as the decoder's AISStream does.
+ *
+ * @param line Raw line
+ * @param len Line length
+ * @param nworkers Number of rings
+ * @param next Round-robin cursor for single-part sentences
+ * @return Ring index
+ */
+static int route_line(const char *line, size_t len, int nworkers, uint32 *next) {
+    AISPayloadView view;
+
+    if (!ais_stream_sentence_view(line, len, &view) || view.total <= 1)
+        return (int) ((*next)++ % (uint32) nworkers);
+
+    uint64 h = ais_hash64(view.message_id, view.message_id_len, (uint64) (unsigned char) view.channel);
+    return (int) (h % (uint64) nworkers);
+}
+
+
+/**
+ * @brief Append one line to a ring, waiting while it is full
+ *
+ * While waiting, decoders that exited are restarted. A line for a full ring
+ * whose decoder has exited and could not be restarted yet is dropped, so one
+ * failing decoder cannot stall the receiver and with it every other decoder.
+ *
+ * @param r Receiver state
+ * @param index Destination ring
+ * @param line Raw line
+ * @param len Line length
+ * @return false if shutdown was requested while waiting
+ */
+static bool ring_push(AISReceiver *r, int index, const char *line, size_t len) {
+    AISPipelineRing *ring = &r->header->rings[index];
+    uint64 head = pg_atomic_read_u64(&ring->head);
+
+    if (len > AIS_PIPELINE_LINE_MAX) {
+        pg_atomic_fetch_add_u64(&ring->dropped, 1);
+        return true;
+    }
+
+    while (head - pg_atomic_read_u64(&ring->tail) >= AIS_PIPELINE_RING_SLOTS) {
+        if (!decoder_running(r, index)) {
+            ensure_decoders(r);
+            if (!decoder_running(r, index)) {
+                pg_atomic_fetch_add_u64(&ring->dropped, 1);
+                return true;
+            }
+        }
+        pg_atomic_fetch_add_u64(&ring->stalls, 1);
+        wake_decoder(ring);
+        (void) WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+                         AIS_PIPELINE_STALL_MS, PG_WAIT_EXTENSION);
+        ResetLatch(MyLatch);
+        CHECK_FOR_INTERRUPTS();
+        if (ShutdownRequestPending) return false;
+    }
+
+    AISPipelineSlot *slot = &ring->slots[head & (AIS_PIPELINE_RING_SLOTS - 1)];
+    memcpy(slot->line, line, len);
+    slot->len = (uint16) len;
+    pg_write_barrier();
+    pg_atomic_write_u64(&ring->head, head + 1);
+    return true;
+}
+
+
+/**
+ * @brief Receiver worker: read the source and fan lines out to decoders
+ *
+ * Creates one ring per decoder in a dynamic shared memory segment, starts
+ * pg_ais.ingest_workers decoders and restarts any that exit. Fragments of a
+ * multipart message are routed by a hash of message id and channel so one
+ * decoder sees the whole set; single-part sentences go round-robin.
+ */
+void pg_ais_receiver_main(Datum arg) {
+    AISIngestSource src;
+    AISReceiver r = {0};
+    int nworkers = ais_ingest_workers;
+    uint32 next = 0;
+
+    pqsignal(SIGHUP, SignalHandlerForConfigReload);
+    pqsignal(SIGTERM, SignalHandlerForShutdownRequest);
+    BackgroundWorkerUnblockSignals();
+
+    MemoryContextSwitchTo(TopMemoryContext);
+    ais_ingest_source_open(&src);
+
+    dsm_segment *seg = dsm_create(pipeline_size(nworkers), 0);
+    AISPipelineHeader *header = dsm_segment_address(seg);
+
+    r.seg = seg;
+    r.header = header;
+
+    header->nworkers = nworkers;
+    pg_atomic_init_u32(&header->shutdown, 0);
+    for (int i = 0; i < nworkers; i++) {
+        AISPipelineRing *ring = &header->rings[i];
+        pg_atomic_init_u64(&ring->head, 0);
+        pg_atomic_init_u64(&ring->stalls, 0);
+        pg_atomic_init_u64(&ring->dropped, 0);
+        pg_atomic_init_u64(&ring->tail, 0);
+        pg_atomic_init_u32(&ring->sleeping, 0);
+        pg_atomic_init_u32(&ring->procno, 0);
+        pg_atomic_init_u32(&ring->pid, 0);
+        pg_atomic_init_u64(&ring->rows, 0);
+        pg_atomic_init_u64(&ring->decode_errors, 0);
+    }
+    before_shmem_exit(receiver_shutdown, PointerGetDatum(header));
+    pg_atomic_write_u32(&pipeline_shared->handle, dsm_segment_handle(seg));
+
+    ereport(LOG,
+            (errmsg("pg_ais receiver reading from %s with %d decoders",
+                    src.udp ? psprintf("UDP %s:%d", ais_ingest_udp_address, ais_ingest_udp_port)
+                            : psprintf("FIFO \"%s\"", ais_ingest_fifo),
+                    nworkers)));
+
+    while (!ShutdownRequestPending) {
+        int rc = WaitLatchOrSocket(MyLatch,
+                                   WL_LATCH_SET | WL_SOCKET_READABLE | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+                                   src.fd, AIS_PIPELINE_CHECK_MS, PG_WAIT_EXTENSION);
+        if (rc & WL_LATCH_SET) ResetLatch(MyLatch);
+        CHECK_FOR_INTERRUPTS();
+
+        if (ConfigReloadPending) {
+            ConfigReloadPending = false;
+            ProcessConfigFile(PGC_SIGHUP);
+        }
+
+        ensure_decoders(&r);
+
+        while (!ShutdownRequestPending && ais_ingest_source_fill(&src)) {
+            uint32 touched = 0;
+            char *line;
+            size_t len;
+
+            while (ais_ingest_source_line(&src, &line, &len)) {
+                if (len == 0) continue;
+                int i = route_line(line, len, nworkers, &next);
+                if (!ring_push(&r, i, line, len)) break;
+                touched |= 1u << i;
+            }
+
+            for (int i = 0; i < nworkers; i++)
+                if (touched & (1u << i)) wake_decoder(&header->rings[i]);
+            CHECK_FOR_INTERRUPTS();
+        }
+    }
+
+    /* Let decoders commit what is queued before the segment goes away */
+    receiver_shutdown(0, PointerGetDatum(header));
+    for (int i = 0; i < nworkers; i++)
+        if (r.handles[i]) (void) WaitForBackgroundWorkerShutdown(r.handles[i]);
+    proc_exit(0);
+}
+
+
+/**
+ * @brief Commit the decoder's open batch and publish its counters
+ */
+static void decoder_commit(AISPipelineRing *ring, AISIngestBatch *batch) {
+    uint64 errors = batch->decode_errors;
+
+    pg_atomic_fetch_add_u64(&ring->rows, ais_ingest_batch_commit(batch));
+    pg_atomic_fetch_add_u64(&ring->decode_errors, errors);
+    batch->decode_errors = 0;
+}
+
+
+/**
+ * @brief Decode ring slots from *tail up to end into the open batch
+ *
+ * A row that raises an ERROR (a failed cast or constraint, say) aborts the
+ * open batch rather than the decoder; otherwise the restarted decoder would
+ * replay the same slot and fail again. The aborted rows, the failing one
+ * included, are counted in decode_errors and *tail moves past that slot.
+ * An ERROR while opening a batch (the target table is missing, say) is
+ * not tied to a row and still ends the decoder, which is restarted.
+ *
+ * @param ring Decoder's ring
+ * @param stream Reassembly state
+ * @param batch Current batch
+ * @param tail First slot to consume; set to the first slot not consumed
+ * @param end Slot to stop at
+ */
+static void decoder_consume(AISPipelineRing *ring, AISStream *stream, AISIngestBatch *batch,
+                            uint64 *tail, uint64 end) {
+    MemoryContext cxt = CurrentMemoryContext;
+    volatile uint64 next = *tail;
+    volatile bool adding = false;
+    volatile bool opening = false;
+
+    PG_TRY();
+    {
+        for (; next < end; next++) {
+            AISPipelineSlot *slot = &ring->slots[next & (AIS_PIPELINE_RING_SLOTS - 1)];
+            AISStreamMessage m;
+
+            if (pg_ais_stream_push(stream, slot->line, slot->len, &m) == AIS_STREAM_MESSAGE) {
+                adding = true;
+                opening = batch->ins == NULL;
+                ais_ingest_batch_add(batch, &m);
+                adding = false;
+            }
+            if (ais_ingest_batch_timeout(batch) == 0) decoder_commit(ring, batch);
+        }
+    }
+    PG_CATCH();
+    {
+        if (opening && batch->ins == NULL) PG_RE_THROW();
+
+        MemoryContextSwitchTo(cxt);
+        EmitErrorReport();
+        FlushErrorState();
+        AbortCurrentTransaction();
+        pgstat_report_activity(STATE_IDLE, NULL);
+
+        pg_atomic_fetch_add_u64(&ring->decode_errors,
+                                batch->decode_errors + batch->rows + (adding ? 1 : 0));
+        batch->ins = NULL;
+        batch->rows = 0;
+        batch->decode_errors = 0;
+        batch->states.count = 0;
+        batch->statics.count = 0;
+        next++;
+    }
+    PG_END_TRY();
+    *tail = next;
+}
+
+
+/**
+ * @brief Exit callback: mark the ring as having no decoder
+ *
+ * Runs on ERROR exits too, so the receiver and pg_ais_ingest_stats() never
+ * use the procno of a decoder that is gone.
+ */
+static void decoder_detach(int code, Datum arg) {
+    AISPipelineRing *ring = (AISPipelineRing *) DatumGetPointer(arg);
+
+    pg_atomic_write_u32(&ring->sleeping, 0);
+    pg_atomic_write_u32(&ring->pid, 0);
+}
+
+
+/**
+ * @brief Decoder worker: reassemble, decode and batch-insert one ring
+ *
+ * Consumes slots in runs of AIS_PIPELINE_CONSUME_BATCH before publishing its
+ * tail, and sleeps on its latch when the ring is empty. A run cut short by a
+ * failing row is published up to and including that row's slot. Exits once
+ * the ring is empty after the receiver or postmaster asked it to stop.
+ *
+ * @param arg dsm_handle of the pipeline segment; ring index in bgw_extra
+ */
+void pg_ais_decoder_main(Datum arg) {
+    AISIngestBatch batch = {0};
+    int index;
+
+    memcpy(&index, MyBgworkerEntry->bgw_extra, sizeof(index));
+
+    pqsignal(SIGHUP, SignalHandlerForConfigReload);
+    pqsignal(SIGTERM, SignalHandlerForShutdownRequest);
+    BackgroundWorkerUnblockSignals();
+
+    dsm_segment *seg = dsm_attach(DatumGetUInt32(arg));
+    if (seg == NULL) proc_exit(0);   /* receiver already gone */
+    dsm_pin_mapping(seg);
+
+    AISPipelineHeader *header = dsm_segment_address(seg);
+    AISPipelineRing *ring = &header->rings[index];
+
+    BackgroundWorkerInitializeConnection(ais_ingest_database,
+                                         ais_ingest_role[0] ? ais_ingest_role : NULL, 0);
+
+    MemoryContextSwitchTo(TopMemoryContext);
+    AISStream *stream = palloc(sizeof(AISStream));
+    AISMetricsStreamMark mark = {0};
+    ais_stream_init(stream);
+
+    pg_atomic_write_u32(&ring->procno, MyProc->pgprocno);
+    pg_write_barrier();
+    pg_atomic_write_u32(&ring->pid, (uint32) MyProcPid);
+    before_shmem_exit(decoder_detach, PointerGetDatum(ring));
+
+    for (;;) {
+        uint64 tail = pg_atomic_read_u64(&ring->tail);
+        uint64 head = pg_atomic_read_u64(&ring->head);
+
+        if (ConfigReloadPending) {
+            ConfigReloadPending = false;
+            ProcessConfigFile(PGC_SIGHUP);
+        }
+
+        if (head != tail) {
+            uint64 end = Min(head, tail + AIS_PIPELINE_CONSUME_BATCH);
+
+            pg_read_barrier();
+            decoder_consume(ring, stream, &batch, &tail, end);
+            /* Slot reads must complete before the receiver may reuse them */
+            pg_memory_barrier();
+            pg_atomic_write_u64(&ring->tail, tail);
+            pg_ais_record_stream(stream, &mark);
+            CHECK_FOR_INTERRUPTS();
+            continue;
+        }
+
+        if (ShutdownRequestPending || pg_atomic_read_u32(&header->shutdown)) break;
+
+        long timeout = ais_ingest_batch_timeout(&batch);
+        if (timeout == 0) {
+            decoder_commit(ring, &batch);
+            continue;
+        }
+
+        pg_atomic_write_u32(&ring->sleeping, 1);
+        pg_memory_barrier();
+        if (pg_atomic_read_u64(&ring->head) == tail) {
+            (void) WaitLatch(MyLatch,
+                             WL_LATCH_SET | WL_EXIT_ON_PM_DEATH | (timeout > 0 ? WL_TIMEOUT : 0),
+                             timeout, PG_WAIT_EXTENSION);
+            ResetLatch(MyLatch);
+        }
+        pg_atomic_write_u32(&ring->sleeping, 0);
+        CHECK_FOR_INTERRUPTS();
+    }
+
+    decoder_commit(ring, &batch);
+    proc_exit(0);
+}
+
+
+/**
+ * @brief Per-decoder ring depth, stall and row counters
+ *
+ * Returns no rows unless the pipeline is running. The counters are copied
+ * out on the first call so the segment is attached only briefly.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_ingest_stats);
+Datum
+pg_ais_ingest_stats(PG_FUNCTION_ARGS) {
+    FuncCallContext *funcctx;
+    AISPipelineStats *stats;
+
+    if (SRF_IS_FIRSTCALL()) {
+        funcctx = SRF_FIRSTCALL_INIT();
+        MemoryContext oldcxt = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+        TupleDesc tupdesc;
+
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+            ereport(ERROR, (errmsg("invalid return type for pg_ais_ingest_stats")));
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+        funcctx->max_calls = 0;
+
+        dsm_handle h = pipeline_shared ? pg_atomic_read_u32(&pipeline_shared->handle)
+                                       : DSM_HANDLE_INVALID;
+        dsm_segment *seg = h != DSM_HANDLE_INVALID ? dsm_attach(h) : NULL;
+        if (seg) {
+            AISPipelineHeader *header = dsm_segment_address(seg);
+
+            stats = palloc(sizeof(AISPipelineStats) * header->nworkers);
+            for (int i = 0; i < header->nworkers; i++) {
+                AISPipelineRing *ring = &header->rings[i];
+                uint64 tail = pg_atomic_read_u64(&ring->tail);
+
+                stats[i].enqueued = pg_atomic_read_u64(&ring->head);
+                stats[i].depth = stats[i].enqueued - tail;
+                stats[i].pid = (int) pg_atomic_read_u32(&ring->pid);
+                stats[i].stalls = pg_atomic_read_u64(&ring->stalls);
+                stats[i].dropped = pg_atomic_read_u64(&ring->dropped);
+                stats[i].rows = pg_atomic_read_u64(&ring->rows);
+                stats[i].decode_errors = pg_atomic_read_u64(&ring->decode_errors);
+            }
+            funcctx->max_calls = header->nworkers;
+            funcctx->user_fctx = stats;
+            dsm_detach(seg);
+        }
+        MemoryContextSwitchTo(oldcxt);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+    stats = funcctx->user_fctx;
+
+    if (funcctx->call_cntr < funcctx->max_calls) {
+        AISPipelineStats *s = &stats[funcctx->call_cntr];
+        Datum values[9];
+        bool nulls[9] = {false};
+
+        values[0] = Int32GetDatum((int32) funcctx->call_cntr);
+        values[1] = Int32GetDatum(s->pid);
+        nulls[1] = s->pid == 0;
+        values[2] = Int64GetDatum((int64) s->depth);
+        values[3] = Int64GetDatum(AIS_PIPELINE_RING_SLOTS);
+        values[4] = Int64GetDatum((int64) s->enqueued);
+        values[5] = Int64GetDatum((int64) s->stalls);
+        values[6] = Int64GetDatum((int64) s->dropped);
+        values[7] = Int64GetDatum((int64) s->rows);
+        values[8] = Int64GetDatum((int64) s->decode_errors);
+
+        HeapTuple tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+    }
+    SRF_RETURN_DONE(funcctx);
+}
@@ -0,0 +1,113 @@
+#ifndef PG_AIS_PIPELINE_H
+#define PG_AIS_PIPELINE_H
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "port/atomics.h"
+
+
+/* Upper bound for pg_ais.ingest_workers; one bit per ring in the receiver */
+#define AIS_PIPELINE_MAX_WORKERS 32
+
+/* Slots per decoder ring (power of two) */
+#define AIS_PIPELINE_RING_SLOTS 8192
+
+/* Longest line a slot holds: a sentence plus generous tag blocks */
+#define AIS_PIPELINE_LINE_MAX 254
+
+/* Slots a decoder consumes before publishing its tail */
+#define AIS_PIPELINE_CONSUME_BATCH 256
+
+/* Milliseconds the receiver sleeps when a ring is full */
+#define AIS_PIPELINE_STALL_MS 1
+
+/* Milliseconds between checks that every decoder is still running */
+#define AIS_PIPELINE_CHECK_MS 1000
+
+
+/**
+ * @brief One raw line in a ring
+ */
+typedef struct {
+    uint16 len;
+    char line[AIS_PIPELINE_LINE_MAX];
+} AISPipelineSlot;
+
+
+/**
+ * @brief Ring feeding one decoder
+ *
+ * Lock-free single-producer/single-consumer queue: only the receiver
+ * advances head and only the decoder advances tail, both as free-running
+ * counters. The receiver's and decoder's fields sit on separate cache lines.
+ */
+typedef struct {
+    /* Receiver side */
+    pg_atomic_uint64 head;
+    pg_atomic_uint64 stalls;        /* waits because the ring was full */
+    pg_atomic_uint64 dropped;       /* lines too long, or for a full ring without a decoder */
+    char pad[PG_CACHE_LINE_SIZE];
+
+    /* Decoder side */
+    pg_atomic_uint64 tail;
+    pg_atomic_uint32 sleeping;      /* decoder is waiting on its latch */
+    pg_atomic_uint32 procno;        /* decoder's PGPROC, valid once pid is set */
+    pg_atomic_uint32 pid;           /* 0 while no decoder is attached */
+    pg_atomic_uint64 rows;
+    pg_atomic_uint64 decode_errors;
+
+    AISPipelineSlot slots[AIS_PIPELINE_RING_SLOTS];
+} AISPipelineRing;
+
+
+/**
+ * @brief Dynamic shared memory segment created by the receiver
+ */
+typedef struct {
+    int nworkers;
+    pg_atomic_uint32 shutdown;      /* receiver exited; drain and stop */
+    AISPipelineRing rings[FLEXIBLE_ARRAY_MEMBER];
+} AISPipelineHeader;
+
+
+/**
+ * @brief Reserve the fixed shared memory that publishes the pipeline segment
+ */
+void pg_ais_pipeline_shmem_request(void);
+
+
+/**
+ * @brief Attach to (or initialize) the fixed pipeline shared memory
+ *
+ * Called with AddinShmemInitLock held.
+ */
+void pg_ais_pipeline_shmem_startup(void);
+
+
+/**
+ * @brief Receiver worker: read the source and fan lines out to decoders
+ *
+ * Creates one ring per decoder in a dynamic shared memory segment, starts
+ * pg_ais.ingest_workers decoders and restarts any that exit. Fragments of a
+ * multipart message are routed by a hash of message id and channel so one
+ * decoder sees the whole set; single-part sentences go round-robin.
+ */
+PGDLLEXPORT void pg_ais_receiver_main(Datum arg);
+
+
+/**
+ * @brief Decoder worker: reassemble, decode and batch-insert one ring
+ *
+ * @param arg dsm_handle of the pipeline segment; ring index in bgw_extra
+ */
+PGDLLEXPORT void pg_ais_decoder_main(Datum arg);
+
+
+/**
+ * @brief Per-decoder ring depth, stall and row counters
+ *
+ * Returns no rows unless the pipeline is running.
+ */
+PGDLLEXPORT Datum pg_ais_ingest_stats(PG_FUNCTION_ARGS);
+
+#endif
@@ -0,0 +1,669 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "access/brin_internal.h"
+#include "access/brin_tuple.h"
+#include "access/skey.h"
+#include "access/stratnum.h"
+#include "catalog/pg_type.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/geo_decls.h"
+#include "utils/lsyscache.h"
+#include "utils/sortsupport.h"
+#include "utils/typcache.h"
+
+#include <math.h>
+
+#include "pg_ais.h"
+#include "ais_payload.h"
+#include "pg_ais_spatial.h"
+
+
+/* Sort key for messages without a usable position: after every real key */
+#define AIS_ZORDER_NONE PG_INT64_MAX
+
+/* BRIN summary of a range whose messages carry no position at all */
+#define AIS_ZORDER_EMPTY_MIN PG_INT64_MAX
+#define AIS_ZORDER_EMPTY_MAX PG_INT64_MIN
+
+/* Spatial reference of every AIS position (WGS 84) */
+#define AIS_SRID 4326
+
+/* EWKB: little-endian marker, Point type word with the SRID flag */
+#define EWKB_NDR 0x01
+#define EWKB_POINT_WITH_SRID 0x20000001
+#define EWKB_POINT_SIZE 25
+
+/* PostGIS geometry type number of a point */
+#define POSTGIS_POINTTYPE 1
+
+
+/**
+ * @brief PostGIS serialized 2D point (GSERIALIZED version 1, no bbox)
+ *
+ * Every PostGIS release since 2.0 reads this layout; points never carry a
+ * cached bounding box, and coordinates are in native byte order.
+ */
+typedef struct {
+    int32 vl_len_;             /* varlena header */
+    uint8 srid[3];             /* 21-bit SRID, big-endian */
+    uint8 gflags;              /* 0: 2D, no bbox, planar, version 1 */
+    uint32 type;               /* POINTTYPE */
+    uint32 npoints;
+    double x;
+    double y;
+} AISGeometryPoint;
+
+
+/**
+ * @brief Query box in fixed-point units, inclusive on every side
+ */
+typedef struct {
+    int32 xmin;
+    int32 ymin;
+    int32 xmax;
+    int32 ymax;
+    bool wraps;                /* crosses the antimeridian (xmin > xmax) */
+} AISFixedBox;
+
+
+/**
+ * @brief Extract the fixed-point position of an ais datum without copying
+ *
+ * @param value Detoasted (possibly short-header) ais varlena
+ * @param lon Output longitude (1/10000 minute)
+ * @param lat Output latitude (1/10000 minute)
+ * @return true if the message carries an available position
+ */
+static bool ais_datum_position(const ais *value, int32_t *lon, int32_t *lat) {
+    AISPayloadView view;
+    if (!ais_payload_view(VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value), &view)) return false;
+    return ais_view_position(&view, lon, lat);
+}
+
+
+/**
+ * @brief Compute the Morton key of an ais datum
+ *
+ * @param value ais varlena
+ * @param key Output Morton key
+ * @return true if the message carries an available position
+ */
+static bool ais_datum_zorder(const ais *value, int64 *key) {
+    int32_t lon, lat;
+    if (!ais_datum_position(value, &lon, &lat)) return false;
+    *key = (int64) ais_morton_key(ais_quantize_lon(lon), ais_quantize_lat(lat));
+    return true;
+}
+
+
+/**
+ * @brief Sort key used by the btree opclass: Morton key, or last if none
+ */
+static int64 ais_datum_sort_key(Datum d) {
+    ais *value = DatumGetAisPP(d);
+    int64 key;
+    if (!ais_datum_zorder(value, &key)) key = AIS_ZORDER_NONE;
+    if ((Pointer) value != DatumGetPointer(d)) pfree(value);
+    return key;
+}
+
+
+/**
+ * @brief Convert a degree coordinate to clamped fixed-point
+ *
+ * @param deg Coordinate in degrees
+ * @param limit Fixed-point magnitude limit for the axis
+ * @param round_up Round towards +inf (upper bounds) instead of -inf
+ * @return Fixed-point coordinate in 1/10000 minute
+ */
+static int32 degrees_to_fixed(double deg, int32 limit, bool round_up) {
+    double v = deg * AIS_COORD_SCALE;
+    v = round_up ? ceil(v) : floor(v);
+    if (v < -limit) return -limit;
+    if (v > limit) return limit;
+    return (int32) v;
+}
+
+
+/**
+ * @brief Convert a degree box to fixed point, rounding bounds inwards
+ *
+ * A position matches the fixed-point box exactly when its degree value
+ * lies inside the degree box. xmin > xmax selects a box crossing the
+ * antimeridian.
+ *
+ * @param xmin West longitude
+ * @param ymin South latitude
+ * @param xmax East longitude
+ * @param ymax North latitude
+ * @param box Output fixed-point box
+ */
+static void fixed_box_init(double xmin, double ymin, double xmax, double ymax, AISFixedBox *box) {
+    if (isnan(xmin) || isnan(ymin) || isnan(xmax) || isnan(ymax))
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("bounding box coordinates must not be NaN")));
+    if (ymin > ymax)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("bounding box ymin %g is greater than ymax %g", ymin, ymax)));
+
+    box->xmin = degrees_to_fixed(xmin, AIS_LON_LIMIT, true);
+    box->ymin = degrees_to_fixed(ymin, AIS_LAT_LIMIT, true);
+    box->xmax = degrees_to_fixed(xmax, AIS_LON_LIMIT, false);
+    box->ymax = degrees_to_fixed(ymax, AIS_LAT_LIMIT, false);
+    box->wraps = xmin > xmax;
+}
+
+
+/**
+ * @brief Test a fixed-point position against a fixed-point box
+ */
+static inline bool fixed_box_contains(const AISFixedBox *box, int32 lon, int32 lat) {
+    if (lat < box->ymin || lat > box->ymax) return false;
+    if (box->wraps) return lon >= box->xmin || lon <= box->xmax;
+    return lon >= box->xmin && lon <= box->xmax;
+}
+
+
+/**
+ * @brief Morton key interval covering every position inside a box
+ *
+ * The Morton key is monotone in each axis, so the lower-left and upper-right
+ * corners bound the keys of all points in between.
+ *
+ * @param box Query box, x = longitude and y = latitude in degrees
+ * @param lo Output lowest possible key
+ * @param hi Output highest possible key
+ */
+static void box_zorder_bounds(const BOX *box, int64 *lo, int64 *hi) {
+    int32 xmin = degrees_to_fixed(box->low.x, AIS_LON_LIMIT, false);
+    int32 ymin = degrees_to_fixed(box->low.y, AIS_LAT_LIMIT, false);
+    int32 xmax = degrees_to_fixed(box->high.x, AIS_LON_LIMIT, true);
+    int32 ymax = degrees_to_fixed(box->high.y, AIS_LAT_LIMIT, true);
+
+    *lo = (int64) ais_morton_key(ais_quantize_lon(xmin), ais_quantize_lat(ymin));
+    *hi = (int64) ais_morton_key(ais_quantize_lon(xmax), ais_quantize_lat(ymax));
+}
+
+
+/**
+ * @brief Return the 62-bit Morton (Z-order) key of a message position
+ *
+ * Reads the coordinates straight from the armored payload; nothing is
+ * allocated. Returns NULL for messages without an available position.
+ *
+ * Usage: SELECT pg_ais_zorder(sentence);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_zorder);
+Datum
+pg_ais_zorder(PG_FUNCTION_ARGS) {
+    ais *value = PG_GETARG_AIS_PP(0);
+    int64 key;
+
+    if (!ais_datum_zorder(value, &key)) PG_RETURN_NULL();
+    PG_RETURN_INT64(key);
+}
+
+
+/**
+ * @brief Return the Hilbert curve index of a message position
+ *
+ * Hilbert keys have better locality than Morton keys for sorting, but are not
+ * monotone per axis, so the BRIN opclass uses Morton keys instead.
+ *
+ * Usage: SELECT pg_ais_hilbert(sentence, 16);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_hilbert);
+Datum
+pg_ais_hilbert(PG_FUNCTION_ARGS) {
+    ais *value = PG_GETARG_AIS_PP(0);
+    int32 bits = PG_GETARG_INT32(1);
+    int32_t lon, lat;
+
+    if (bits < 1 || bits > AIS_CURVE_BITS)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("hilbert curve order must be between 1 and %d", AIS_CURVE_BITS)));
+
+    if (!ais_datum_position(value, &lon, &lat)) PG_RETURN_NULL();
+    PG_RETURN_INT64((int64) ais_hilbert_key(ais_quantize_lon(lon), ais_quantize_lat(lat), bits));
+}
+
+
+/**
+ * @brief Test whether a message position lies inside a box (lon/lat)
+ *
+ * Messages without a position never match. Backs the "ais <@ box" operator.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_within_box);
+Datum
+pg_ais_within_box(PG_FUNCTION_ARGS) {
+    ais *value = PG_GETARG_AIS_PP(0);
+    BOX *box = PG_GETARG_BOX_P(1);
+    AISFixedBox fbox;
+    int32_t lon, lat;
+
+    if (!ais_datum_position(value, &lon, &lat)) PG_RETURN_BOOL(false);
+
+    fixed_box_init(box->low.x, box->low.y, box->high.x, box->high.y, &fbox);
+    PG_RETURN_BOOL(fixed_box_contains(&fbox, lon, lat));
+}
+
+
+/**
+ * @brief Test whether a message position lies inside lon/lat bounds
+ *
+ * Reads only the type and the coordinate bits of the payload and compares
+ * in fixed point; no message is decoded. xmin > xmax selects a box crossing
+ * the antimeridian. Messages without a position never match.
+ *
+ * Usage: SELECT * FROM ais_raw WHERE pg_ais_in_bbox(sentence, 4.0, 51.5, 4.6, 52.1);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_in_bbox);
+Datum
+pg_ais_in_bbox(PG_FUNCTION_ARGS) {
+    ais *value = PG_GETARG_AIS_PP(0);
+    AISFixedBox box;
+    int32_t lon, lat;
+
+    fixed_box_init(PG_GETARG_FLOAT8(1), PG_GETARG_FLOAT8(2), PG_GETARG_FLOAT8(3), PG_GETARG_FLOAT8(4), &box);
+    if (!ais_datum_position(value, &lon, &lat)) PG_RETURN_BOOL(false);
+    PG_RETURN_BOOL(fixed_box_contains(&box, lon, lat));
+}
+
+
+/**
+ * @brief Batch form of pg_ais_in_bbox() over an array of messages
+ *
+ * Converts the bounds once and returns one flag per element, NULL for
+ * NULL elements.
+ *
+ * Usage: SELECT pg_ais_in_bbox(array_agg(sentence), 4.0, 51.5, 4.6, 52.1) FROM ais_raw;
+ */
+PG_FUNCTION_INFO_V1(pg_ais_in_bbox_array);
+Datum
+pg_ais_in_bbox_array(PG_FUNCTION_ARGS) {
+    ArrayType *arr = PG_GETARG_ARRAYTYPE_P(0);
+    AISFixedBox box;
+    int16 typlen;
+    bool typbyval;
+    char typalign;
+    Datum *elems;
+    bool *nulls;
+    int nelems;
+
+    if (ARR_NDIM(arr) > 1)
+        ereport(ERROR,
+                (errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+                 errmsg("pg_ais_in_bbox expects a one-dimensional array")));
+    fixed_box_init(PG_GETARG_FLOAT8(1), PG_GETARG_FLOAT8(2), PG_GETARG_FLOAT8(3), PG_GETARG_FLOAT8(4), &box);
+
+    get_typlenbyvalalign(ARR_ELEMTYPE(arr), &typlen, &typbyval, &typalign);
+    deconstruct_array(arr, ARR_ELEMTYPE(arr), typlen, typbyval, typalign, &elems, &nulls, &nelems);
+    if (nelems == 0) PG_RETURN_ARRAYTYPE_P(construct_empty_array(BOOLOID));
+
+    /* Results overwrite the element datums in place */
+    for (int i = 0; i < nelems; i++) {
+        int32_t lon, lat;
+        if (nulls[i]) continue;
+        bool inside = ais_datum_position((ais *) DatumGetPointer(elems[i]), &lon, &lat) &&
+                      fixed_box_contains(&box, lon, lat);
+        elems[i] = BoolGetDatum(inside);
+    }
+
+    int dims[1] = {nelems};
+    int lbs[1] = {ARR_LBOUND(arr)[0]};
+    PG_RETURN_ARRAYTYPE_P(construct_md_array(elems, nulls, 1, dims, lbs, BOOLOID, 1, true, TYPALIGN_CHAR));
+}
+
+
+/**
+ * @brief Return the geohash of a message position
+ *
+ * Computed from the payload's fixed-point coordinates into a stack buffer;
+ * only the result text is allocated. Returns NULL for messages without an
+ * available position.
+ *
+ * Usage: SELECT pg_ais_geohash(sentence, 7);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_geohash);
+Datum
+pg_ais_geohash(PG_FUNCTION_ARGS) {
+    ais *value = PG_GETARG_AIS_PP(0);
+    int32 precision = PG_GETARG_INT32(1);
+    char hash[AIS_GEOHASH_MAX + 1];
+    int32_t lon, lat;
+
+    if (precision < 1 || precision > AIS_GEOHASH_MAX)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("geohash precision must be between 1 and %d", AIS_GEOHASH_MAX)));
+
+    if (!ais_datum_position(value, &lon, &lat)) PG_RETURN_NULL();
+    ais_geohash(lon, lat, precision, hash);
+    PG_RETURN_TEXT_P(cstring_to_text_with_len(hash, precision));
+}
+
+
+/**
+ * @brief Check a grid level argument
+ */
+static void check_grid_level(int32 level) {
+    if (level < 0 || level > AIS_GRID_MAX_LEVEL)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("grid level must be between 0 and %d", AIS_GRID_MAX_LEVEL)));
+}
+
+
+/**
+ * @brief Return the hierarchical grid cell id of a message position
+ *
+ * Level l has 2^l x 2^l cells numbered along the Morton curve, so within a
+ * level nearby cells get nearby ids. Returns NULL for messages without an
+ * available position.
+ *
+ * Usage: SELECT pg_ais_grid_cell(sentence, 12), count(*) FROM ais_raw GROUP BY 1;
+ */
+PG_FUNCTION_INFO_V1(pg_ais_grid_cell);
+Datum
+pg_ais_grid_cell(PG_FUNCTION_ARGS) {
+    ais *value = PG_GETARG_AIS_PP(0);
+    int32 level = PG_GETARG_INT32(1);
+    int32_t lon, lat;
+
+    check_grid_level(level);
+    if (!ais_datum_position(value, &lon, &lat)) PG_RETURN_NULL();
+    PG_RETURN_INT64((int64) ais_grid_cell(ais_quantize_lon(lon), ais_quantize_lat(lat), level));
+}
+
+
+/**
+ * @brief Return the enclosing cell of a grid cell at a coarser level
+ *
+ * Lets density computed at a fine level roll up without revisiting rows.
+ *
+ * Usage: SELECT pg_ais_grid_parent(cell, 8), sum(n) FROM density GROUP BY 1;
+ */
+PG_FUNCTION_INFO_V1(pg_ais_grid_parent);
+Datum
+pg_ais_grid_parent(PG_FUNCTION_ARGS) {
+    int64 cell = PG_GETARG_INT64(0);
+    int32 level = PG_GETARG_INT32(1);
+
+    check_grid_level(level);
+    if (cell < 0 || (cell >> AIS_GRID_LEVEL_SHIFT) > AIS_GRID_MAX_LEVEL)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("invalid grid cell id " INT64_FORMAT, cell)));
+    if (level > (cell >> AIS_GRID_LEVEL_SHIFT))
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("grid level %d is finer than the cell's level %d",
+                        level, (int) (cell >> AIS_GRID_LEVEL_SHIFT))));
+    PG_RETURN_INT64((int64) ais_grid_parent((uint64) cell, level));
+}
+
+
+/**
+ * @brief Store a 32-bit value little-endian
+ */
+static void put_le32(uint8 *p, uint32 v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8) (v >> (8 * i));
+}
+
+
+/**
+ * @brief Store a double little-endian
+ */
+static void put_le_double(uint8 *p, double d) {
+    uint64 v;
+    memcpy(&v, &d, sizeof(v));
+    for (int i = 0; i < 8; i++) p[i] = (uint8) (v >> (8 * i));
+}
+
+
+/**
+ * @brief Return the position as a little-endian EWKB point with SRID 4326
+ *
+ * Built straight from the payload's fixed-point coordinates into the result
+ * varlena; ST_GeomFromEWKB() and PostGIS binary COPY take it as is. Returns
+ * NULL for messages without an available position.
+ *
+ * Usage: SELECT pg_ais_ewkb(sentence);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_ewkb);
+Datum
+pg_ais_ewkb(PG_FUNCTION_ARGS) {
+    ais *value = PG_GETARG_AIS_PP(0);
+    int32_t lon, lat;
+
+    if (!ais_datum_position(value, &lon, &lat)) PG_RETURN_NULL();
+
+    bytea *result = palloc(VARHDRSZ + EWKB_POINT_SIZE);
+    SET_VARSIZE(result, VARHDRSZ + EWKB_POINT_SIZE);
+    uint8 *p = (uint8 *) VARDATA(result);
+    p[0] = EWKB_NDR;
+    put_le32(p + 1, EWKB_POINT_WITH_SRID);
+    put_le32(p + 5, AIS_SRID);
+    put_le_double(p + 9, (double) lon / AIS_COORD_SCALE);
+    put_le_double(p + 17, (double) lat / AIS_COORD_SCALE);
+    PG_RETURN_BYTEA_P(result);
+}
+
+
+/**
+ * @brief Return the position as a PostGIS geometry(Point, 4326)
+ *
+ * Serializes the point in PostGIS' on-disk format, so no EWKB parsing or
+ * ST_SetSRID() call is needed. Only declared in SQL when PostGIS is present.
+ *
+ * Usage: SELECT pg_ais_geometry(sentence);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_geometry);
+Datum
+pg_ais_geometry(PG_FUNCTION_ARGS) {
+    ais *value = PG_GETARG_AIS_PP(0);
+    int32_t lon, lat;
+
+    if (!ais_datum_position(value, &lon, &lat)) PG_RETURN_NULL();
+
+    AISGeometryPoint *geom = palloc0(sizeof(AISGeometryPoint));
+    SET_VARSIZE(geom, sizeof(AISGeometryPoint));
+    geom->srid[0] = (AIS_SRID >> 16) & 0x1F;
+    geom->srid[1] = (AIS_SRID >> 8) & 0xFF;
+    geom->srid[2] = AIS_SRID & 0xFF;
+    geom->type = POSTGIS_POINTTYPE;
+    geom->npoints = 1;
+    geom->x = (double) lon / AIS_COORD_SCALE;
+    geom->y = (double) lat / AIS_COORD_SCALE;
+    PG_RETURN_POINTER(geom);
+}
+
+
+/**
+ * @brief BRIN support: describe the int8 min/max Morton summary
+ *
+ * Each range stores the lowest and highest Morton key of its messages, so an
+ * index over a z-ordered chunk is a few kilobytes.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_brin_zorder_opcinfo);
+Datum
+pg_ais_brin_zorder_opcinfo(PG_FUNCTION_ARGS) {
+    BrinOpcInfo *result = palloc0(MAXALIGN(SizeofBrinOpcInfo(2)));
+
+    result->oi_nstored = 2;
+    result->oi_regular_nulls = true;
+    result->oi_opaque = NULL;
+    result->oi_typcache[0] = result->oi_typcache[1] = lookup_type_cache(INT8OID, 0);
+
+    PG_RETURN_POINTER(result);
+}
+
+
+/**
+ * @brief BRIN support: widen a range summary with a new message
+ *
+ * Messages without a position still mark the range as non-null, but leave
+ * the key interval empty so they never widen it.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_brin_zorder_add_value);
+Datum
+pg_ais_brin_zorder_add_value(PG_FUNCTION_ARGS) {
+    BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+    Datum newval = PG_GETARG_DATUM(2);
+    int64 key;
+    bool has_key = ais_datum_zorder(DatumGetAisPP(newval), &key);
+
+    if (column->bv_allnulls) {
+        column->bv_values[0] = Int64GetDatum(has_key ? key : AIS_ZORDER_EMPTY_MIN);
+        column->bv_values[1] = Int64GetDatum(has_key ? key : AIS_ZORDER_EMPTY_MAX);
+        column->bv_allnulls = false;
+        PG_RETURN_BOOL(true);
+    }
+
+    if (!has_key) PG_RETURN_BOOL(false);
+
+    bool updated = false;
+    if (key < DatumGetInt64(column->bv_values[0])) {
+        column->bv_values[0] = Int64GetDatum(key);
+        updated = true;
+    }
+    if (key > DatumGetInt64(column->bv_values[1])) {
+        column->bv_values[1] = Int64GetDatum(key);
+        updated = true;
+    }
+    PG_RETURN_BOOL(updated);
+}
+
+
+/**
+ * @brief BRIN support: check whether a range may satisfy "<@ box"
+ */
+PG_FUNCTION_INFO_V1(pg_ais_brin_zorder_consistent);
+Datum
+pg_ais_brin_zorder_consistent(PG_FUNCTION_ARGS) {
+    BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+    ScanKey key = (ScanKey) PG_GETARG_POINTER(2);
+    int64 lo, hi;
+
+    if (key->sk_strategy != RTContainedByStrategyNumber)
+        elog(ERROR, "invalid strategy number %d", key->sk_strategy);
+
+    box_zorder_bounds(DatumGetBoxP(key->sk_argument), &lo, &hi);
+    PG_RETURN_BOOL(DatumGetInt64(column->bv_values[0]) <= hi &&
+                   DatumGetInt64(column->bv_values[1]) >= lo);
+}
+
+
+/**
+ * @brief BRIN support: merge two range summaries
+ */
+PG_FUNCTION_INFO_V1(pg_ais_brin_zorder_union);
+Datum
+pg_ais_brin_zorder_union(PG_FUNCTION_ARGS) {
+    BrinValues *col_a = (BrinValues *) PG_GETARG_POINTER(1);
+    BrinValues *col_b = (BrinValues *) PG_GETARG_POINTER(2);
+
+    if (col_b->bv_allnulls) PG_RETURN_VOID();
+    if (col_a->bv_allnulls) {
+        col_a->bv_values[0] = col_b->bv_values[0];
+        col_a->bv_values[1] = col_b->bv_values[1];
+        col_a->bv_allnulls = false;
+        PG_RETURN_VOID();
+    }
+
+    if (DatumGetInt64(col_b->bv_values[0]) < DatumGetInt64(col_a->bv_values[0]))
+        col_a->bv_values[0] = col_b->bv_values[0];
+    if (DatumGetInt64(col_b->bv_values[1]) > DatumGetInt64(col_a->bv_values[1]))
+        col_a->bv_values[1] = col_b->bv_values[1];
+    PG_RETURN_VOID();
+}
+
+
+/**
+ * @brief Btree support: compare two messages by Morton key
+ *
+ * Messages without a position sort last. Used by the non-default
+ * ais_zorder_ops opclass so CLUSTER and ORDER BY ... USING #<# can lay data
+ * out along the curve.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_zorder_cmp);
+Datum
+pg_ais_zorder_cmp(PG_FUNCTION_ARGS) {
+    int64 a = ais_datum_sort_key(PG_GETARG_DATUM(0));
+    int64 b = ais_datum_sort_key(PG_GETARG_DATUM(1));
+    PG_RETURN_INT32(a < b ? -1 : (a > b ? 1 : 0));
+}
+
+
+/**
+ * @brief Full comparator used when abbreviation is off or keys tie
+ */
+static int zorder_fastcmp(Datum x, Datum y, SortSupport ssup) {
+    int64 a = ais_datum_sort_key(x);
+    int64 b = ais_datum_sort_key(y);
+    (void) ssup;
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+
+/**
+ * @brief Abbreviate an ais datum to its Morton key
+ *
+ * The key is exact for ordering purposes, so ties only occur between messages
+ * at the same quantized position.
+ */
+static Datum zorder_abbrev_convert(Datum original, SortSupport ssup) {
+    (void) ssup;
+    return Int64GetDatum(ais_datum_sort_key(original));
+}
+
+
+/**
+ * @brief Never abort abbreviation: the Morton key is always discriminating
+ */
+static bool zorder_abbrev_abort(int memtupcount, SortSupport ssup) {
+    (void) memtupcount;
+    (void) ssup;
+    return false;
+}
+
+
+/**
+ * @brief Btree support: SortSupport with abbreviated Morton keys
+ *
+ * Computes each key once per tuple instead of twice per comparison.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_zorder_sortsupport);
+Datum
+pg_ais_zorder_sortsupport(PG_FUNCTION_ARGS) {
+    SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+    ssup->comparator = zorder_fastcmp;
+#if SIZEOF_DATUM >= 8
+    if (ssup->abbreviate) {
+        ssup->abbrev_converter = zorder_abbrev_convert;
+        ssup->abbrev_abort = zorder_abbrev_abort;
+        ssup->abbrev_full_comparator = zorder_fastcmp;
+        ssup->comparator = ssup_datum_signed_cmp;
+    }
+#endif
+    PG_RETURN_VOID();
+}
+
+
+#define ZORDER_OPERATOR(name, op) \
+    PG_FUNCTION_INFO_V1(name); \
+    Datum \
+    name(PG_FUNCTION_ARGS) { \
+        PG_RETURN_BOOL(ais_datum_sort_key(PG_GETARG_DATUM(0)) op ais_datum_sort_key(PG_GETARG_DATUM(1))); \
+    }
+
+ZORDER_OPERATOR(pg_ais_zorder_lt, <)
+ZORDER_OPERATOR(pg_ais_zorder_le, <=)
+ZORDER_OPERATOR(pg_ais_zorder_eq, ==)
+ZORDER_OPERATOR(pg_ais_zorder_ge, >=)
+ZORDER_OPERATOR(pg_ais_zorder_gt, >)
@@ -0,0 +1,129 @@
+#ifndef PG_AIS_SPATIAL_H
+#define PG_AIS_SPATIAL_H
+
+#include "postgres.h"
+#include "fmgr.h"
+
+
+/**
+ * @brief Return the 62-bit Morton (Z-order) key of a message position
+ *
+ * Usage: SELECT pg_ais_zorder(sentence);
+ */
+PGDLLEXPORT Datum pg_ais_zorder(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Return the Hilbert curve index of a message position
+ *
+ * Usage: SELECT pg_ais_hilbert(sentence, 16);
+ */
+PGDLLEXPORT Datum pg_ais_hilbert(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Test whether a message position lies inside a box (lon/lat)
+ *
+ * Backs the "ais <@ box" operator.
+ */
+PGDLLEXPORT Datum pg_ais_within_box(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Test whether a message position lies inside lon/lat bounds
+ *
+ * Usage: SELECT * FROM ais_raw WHERE pg_ais_in_bbox(sentence, 4.0, 51.5, 4.6, 52.1);
+ */
+PGDLLEXPORT Datum pg_ais_in_bbox(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Batch form of pg_ais_in_bbox() over an array of messages
+ *
+ * Usage: SELECT pg_ais_in_bbox(array_agg(sentence), 4.0, 51.5, 4.6, 52.1) FROM ais_raw;
+ */
+PGDLLEXPORT Datum pg_ais_in_bbox_array(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Return the geohash of a message position
+ *
+ * Usage: SELECT pg_ais_geohash(sentence, 7);
+ */
+PGDLLEXPORT Datum pg_ais_geohash(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Return the hierarchical grid cell id of a message position
+ *
+ * Usage: SELECT pg_ais_grid_cell(sentence, 12), count(*) FROM ais_raw GROUP BY 1;
+ */
+PGDLLEXPORT Datum pg_ais_grid_cell(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Return the enclosing cell of a grid cell at a coarser level
+ *
+ * Usage: SELECT pg_ais_grid_parent(cell, 8), sum(n) FROM density GROUP BY 1;
+ */
+PGDLLEXPORT Datum pg_ais_grid_parent(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Return the position as a little-endian EWKB point with SRID 4326
+ *
+ * Usage: SELECT pg_ais_ewkb(sentence);
+ */
+PGDLLEXPORT Datum pg_ais_ewkb(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Return the position as a PostGIS geometry(Point, 4326)
+ *
+ * Usage: SELECT pg_ais_geometry(sentence);
+ */
+PGDLLEXPORT Datum pg_ais_geometry(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief BRIN support: describe the int8 min/max Morton summary
+ */
+PGDLLEXPORT Datum pg_ais_brin_zorder_opcinfo(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief BRIN support: widen a range summary with a new message
+ */
+PGDLLEXPORT Datum pg_ais_brin_zorder_add_value(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief BRIN support: check whether a range may satisfy "<@ box"
+ */
+PGDLLEXPORT Datum pg_ais_brin_zorder_consistent(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief BRIN support: merge two range summaries
+ */
+PGDLLEXPORT Datum pg_ais_brin_zorder_union(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Btree support: compare two messages by Morton key
+ */
+PGDLLEXPORT Datum pg_ais_zorder_cmp(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Btree support: SortSupport with abbreviated Morton keys
+ */
+PGDLLEXPORT Datum pg_ais_zorder_sortsupport(PG_FUNCTION_ARGS);
+
+PGDLLEXPORT Datum pg_ais_zorder_lt(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_ais_zorder_le(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_ais_zorder_eq(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_ais_zorder_ge(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_ais_zorder_gt(PG_FUNCTION_ARGS);
+
+#endif
@@ -0,0 +1,351 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "access/htup_details.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/tuplestore.h"
+
+#include "parse_ais_msg.h"
+#include "pg_ais.h"
+#include "pg_ais_fields.h"
+#include "pg_ais_state.h"
+
+
+/* Columns of the pg_ais_vessel_states() rows; pg_ais_vessel_state() omits mmsi */
+enum {
+    S_MMSI, S_LAT, S_LON, S_SPEED, S_COURSE, S_HEADING, S_NAV_STATUS, S_TYPE, S_UPDATED_AT,
+    S_NUM_COLUMNS
+};
+
+
+int ais_state_cache_size = 0;
+
+static HTAB *state_hash = NULL;
+static LWLockPadded *state_locks = NULL;
+
+
+/**
+ * @brief Define the pg_ais.state_cache_size GUC
+ */
+void pg_ais_state_init(void) {
+    DefineCustomIntVariable("pg_ais.state_cache_size",
+                            "Vessels kept in the shared latest-state cache (0 disables it).",
+                            "Requires pg_ais in shared_preload_libraries.",
+                            &ais_state_cache_size, 0, 0, INT_MAX / 2,
+                            PGC_POSTMASTER, 0, NULL, NULL, NULL);
+}
+
+
+/**
+ * @brief Reserve shared memory and locks for the vessel state table
+ */
+void pg_ais_state_shmem_request(void) {
+    if (ais_state_cache_size == 0) return;
+    RequestAddinShmemSpace(hash_estimate_size(ais_state_cache_size, sizeof(AISVesselState)));
+    RequestNamedLWLockTranche("pg_ais state", AIS_STATE_PARTITIONS);
+}
+
+
+/**
+ * @brief Create or attach the vessel state table
+ *
+ * Called with AddinShmemInitLock held.
+ */
+void pg_ais_state_shmem_startup(void) {
+    HASHCTL info;
+
+    if (ais_state_cache_size == 0) return;
+
+    info.keysize = sizeof(uint32);
+    info.entrysize = sizeof(AISVesselState);
+    info.num_partitions = AIS_STATE_PARTITIONS;
+    state_hash = ShmemInitHash("pg_ais vessel state", ais_state_cache_size, ais_state_cache_size, &info,
+                               HASH_ELEM | HASH_BLOBS | HASH_PARTITION | HASH_FIXED_SIZE);
+    state_locks = GetNamedLWLockTranche("pg_ais state");
+}
+
+
+/**
+ * @brief Return the lock guarding the partition of a hash code
+ */
+static LWLock *state_lock(uint32 hashcode) {
+    return &state_locks[hashcode % AIS_STATE_PARTITIONS].lock;
+}
+
+
+/**
+ * @brief Build the state a decoded message reports
+ *
+ * @param msg Decoded message
+ * @param view Payload view of the (reassembled) message
+ * @param ts Time of the report
+ * @param out Output state
+ * @return false if the message has no available position
+ */
+static bool state_from_message(const AISMessage *msg, const AISPayloadView *view, TimestampTz ts,
+                               AISVesselState *out) {
+    int32_t lon, lat;
+
+    if (!ais_view_position(view, &lon, &lat)) return false;
+
+    int type = ais_view_type(view);
+    uint64 present = ais_fields_present(msg, type);
+
+    out->mmsi = (uint32) msg->mmsi;
+    out->lon = lon;
+    out->lat = lat;
+    out->speed = (present & FIELD(F_SPEED)) ? msg->speed : -1;
+    out->course = (present & FIELD(F_COURSE)) ? msg->course : -1;
+    out->heading = (present & FIELD(F_HEADING)) ? msg->heading : -1;
+    out->nav_status = (present & FIELD(F_NAV_STATUS)) ? (int8) msg->nav_status : -1;
+    out->type = (uint8) type;
+    out->updated_at = ts;
+    return true;
+}
+
+
+/**
+ * @brief Store a vessel state unless the cached one is newer
+ *
+ * A full table keeps its current vessels and drops new ones.
+ *
+ * @param state State to store
+ * @return true if the stored state was replaced
+ */
+static bool state_store(const AISVesselState *state) {
+    uint32 mmsi = state->mmsi;
+    uint32 hashcode = get_hash_value(state_hash, &mmsi);
+    LWLock *lock = state_lock(hashcode);
+    bool found;
+
+    LWLockAcquire(lock, LW_EXCLUSIVE);
+    AISVesselState *entry = hash_search_with_hash_value(state_hash, &mmsi, hashcode, HASH_ENTER_NULL, &found);
+    if (entry == NULL || (found && entry->updated_at > state->updated_at)) {
+        LWLockRelease(lock);
+        return false;
+    }
+    *entry = *state;
+    LWLockRelease(lock);
+    return true;
+}
+
+
+/**
+ * @brief Record a decoded message as its vessel's latest state
+ *
+ * Ignores messages without an available position and reports older than
+ * the stored one, so replayed or reordered input cannot move a vessel back.
+ * A full table keeps its current vessels and drops new ones.
+ *
+ * @param msg Decoded message
+ * @param view Payload view of the (reassembled) message
+ * @param ts Time of the report
+ * @return true if the stored state was replaced
+ */
+bool ais_state_observe(const AISMessage *msg, const AISPayloadView *view, TimestampTz ts) {
+    AISVesselState state;
+
+    if (state_hash == NULL || !state_from_message(msg, view, ts, &state)) return false;
+    return state_store(&state);
+}
+
+
+/**
+ * @brief Queue a decoded message for ais_state_apply()
+ *
+ * @param pending Queue, allocated in TopMemoryContext on first use
+ * @param msg Decoded message
+ * @param view Payload view of the (reassembled) message
+ * @param ts Time of the report
+ */
+void ais_state_defer(AISStatePending *pending, const AISMessage *msg, const AISPayloadView *view,
+                     TimestampTz ts) {
+    AISVesselState state;
+
+    if (state_hash == NULL || !state_from_message(msg, view, ts, &state)) return;
+
+    if (pending->count == pending->capacity) {
+        int capacity = pending->capacity ? pending->capacity * 2 : 64;
+        pending->states = pending->states
+            ? repalloc(pending->states, sizeof(AISVesselState) * capacity)
+            : MemoryContextAlloc(TopMemoryContext, sizeof(AISVesselState) * capacity);
+        pending->capacity = capacity;
+    }
+    pending->states[pending->count++] = state;
+}
+
+
+/**
+ * @brief Store queued states in arrival order and empty the queue
+ *
+ * @param pending Queue
+ * @return Number of stored states that replaced the cached one
+ */
+int ais_state_apply(AISStatePending *pending) {
+    int stored = 0;
+
+    for (int i = 0; i < pending->count; i++)
+        if (state_store(&pending->states[i])) stored++;
+    pending->count = 0;
+    return stored;
+}
+
+
+/**
+ * @brief Copy the latest state of one vessel
+ *
+ * @param mmsi Vessel MMSI
+ * @param out Output state
+ * @return false if the vessel is unknown or the cache is disabled
+ */
+bool ais_state_lookup(uint32 mmsi, AISVesselState *out) {
+    if (state_hash == NULL) return false;
+
+    uint32 hashcode = get_hash_value(state_hash, &mmsi);
+    LWLock *lock = state_lock(hashcode);
+
+    LWLockAcquire(lock, LW_SHARED);
+    AISVesselState *entry = hash_search_with_hash_value(state_hash, &mmsi, hashcode, HASH_FIND, NULL);
+    if (entry) *out = *entry;
+    LWLockRelease(lock);
+    return entry != NULL;
+}
+
+
+/**
+ * @brief Fill result columns from a vessel state
+ *
+ * @param s Vessel state
+ * @param values Output values (S_NUM_COLUMNS entries)
+ * @param nulls Output null flags
+ */
+static void state_datums(const AISVesselState *s, Datum *values, bool *nulls) {
+    memset(nulls, 0, sizeof(bool) * S_NUM_COLUMNS);
+    values[S_MMSI] = Int32GetDatum((int32) s->mmsi);
+    values[S_LAT] = Float8GetDatum((double) s->lat / AIS_COORD_SCALE);
+    values[S_LON] = Float8GetDatum((double) s->lon / AIS_COORD_SCALE);
+    values[S_SPEED] = Float8GetDatum(s->speed);
+    nulls[S_SPEED] = s->speed < 0;
+    values[S_COURSE] = Float8GetDatum(s->course);
+    nulls[S_COURSE] = s->course < 0;
+    values[S_HEADING] = Float8GetDatum(s->heading);
+    nulls[S_HEADING] = s->heading < 0;
+    values[S_NAV_STATUS] = Int32GetDatum(s->nav_status);
+    nulls[S_NAV_STATUS] = s->nav_status < 0;
+    values[S_TYPE] = Int32GetDatum(s->type);
+    values[S_UPDATED_AT] = TimestampTzGetDatum(s->updated_at);
+}
+
+
+/**
+ * @brief Latest state of every vessel in the cache
+ *
+ * Entries are copied out under shared partition locks, which are released
+ * before the result set is built.
+ *
+ * Usage: SELECT * FROM pg_ais_vessel_states();
+ */
+PG_FUNCTION_INFO_V1(pg_ais_vessel_states);
+Datum
+pg_ais_vessel_states(PG_FUNCTION_ARGS) {
+    ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    TupleDesc tupdesc;
+
+    if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo) || (rsinfo->allowedModes & SFRM_Materialize) == 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("set-valued function called in context that cannot accept a set")));
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        ereport(ERROR, (errmsg("return type must be a row type")));
+
+    MemoryContext oldcxt = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+    Tuplestorestate *tupstore = tuplestore_begin_heap(true, false, work_mem);
+    rsinfo->returnMode = SFRM_Materialize;
+    rsinfo->setResult = tupstore;
+    rsinfo->setDesc = CreateTupleDescCopy(tupdesc);
+    MemoryContextSwitchTo(oldcxt);
+
+    if (state_hash == NULL) return (Datum) 0;
+
+    AISVesselState *copy = NULL;
+    long n = 0;
+    HASH_SEQ_STATUS scan;
+    AISVesselState *entry;
+
+    for (int i = 0; i < AIS_STATE_PARTITIONS; i++) LWLockAcquire(&state_locks[i].lock, LW_SHARED);
+    copy = palloc(sizeof(AISVesselState) * Max(hash_get_num_entries(state_hash), 1));
+    hash_seq_init(&scan, state_hash);
+    while ((entry = hash_seq_search(&scan)) != NULL) copy[n++] = *entry;
+    for (int i = AIS_STATE_PARTITIONS - 1; i >= 0; i--) LWLockRelease(&state_locks[i].lock);
+
+    for (long i = 0; i < n; i++) {
+        Datum values[S_NUM_COLUMNS];
+        bool nulls[S_NUM_COLUMNS];
+
+        state_datums(&copy[i], values, nulls);
+        tuplestore_putvalues(tupstore, rsinfo->setDesc, values, nulls);
+    }
+    pfree(copy);
+    return (Datum) 0;
+}
+
+
+/**
+ * @brief Latest state of one vessel, or NULL if unknown
+ *
+ * Usage: SELECT * FROM pg_ais_vessel_state(366967064);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_vessel_state);
+Datum
+pg_ais_vessel_state(PG_FUNCTION_ARGS) {
+    AISVesselState s;
+    TupleDesc tupdesc;
+    Datum values[S_NUM_COLUMNS];
+    bool nulls[S_NUM_COLUMNS];
+
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        ereport(ERROR, (errmsg("return type must be a row type")));
+    if (!ais_state_lookup((uint32) PG_GETARG_INT32(0), &s)) PG_RETURN_NULL();
+
+    /* Same columns as pg_ais_vessel_states() without the mmsi key */
+    state_datums(&s, values, nulls);
+    HeapTuple tuple = heap_form_tuple(BlessTupleDesc(tupdesc), values + 1, nulls + 1);
+    PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+}
+
+
+/**
+ * @brief Feed one sentence into the cache, e.g. from an INSERT trigger
+ *
+ * The tag block receive time, when present, takes precedence over
+ * received_at. Multipart fragments are ignored.
+ *
+ * Usage: SELECT pg_ais_vessel_state_update(sentence, received_at);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_vessel_state_update);
+Datum
+pg_ais_vessel_state_update(PG_FUNCTION_ARGS) {
+    ais *input = PG_GETARG_AIS_PP(0);
+    TimestampTz ts = PG_GETARG_TIMESTAMPTZ(1);
+    AISPayloadView view;
+    AISMessage msg = {0};
+
+    if (state_hash == NULL) PG_RETURN_BOOL(false);
+    if (!ais_payload_view(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), &view) || view.total != 1)
+        PG_RETURN_BOOL(false);
+    if (!parse_ais_view(&msg, &view).ok) {
+        free_ais_message(&msg);
+        PG_RETURN_BOOL(false);
+    }
+
+    if (view.tags.receive_time) ts = time_t_to_timestamptz((pg_time_t) view.tags.receive_time);
+    bool updated = ais_state_observe(&msg, &view, ts);
+    free_ais_message(&msg);
+    PG_RETURN_BOOL(updated);
+}
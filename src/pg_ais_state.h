@@ -0,0 +1,148 @@
+#ifndef PG_AIS_STATE_H
+#define PG_AIS_STATE_H
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/timestamp.h"
+
+#include "ais_core.h"
+#include "ais_payload.h"
+
+
+/* Lock partitions of the vessel state table (power of two) */
+#define AIS_STATE_PARTITIONS 16
+
+
+/* GUC pg_ais.state_cache_size: vessels kept, 0 disables the cache */
+extern int ais_state_cache_size;
+
+
+/**
+ * @brief Latest known position report of one vessel
+ *
+ * Coordinates stay in the payload's fixed-point units. Speed, course and
+ * heading are negative when unavailable; nav_status is -1 when the last
+ * report type does not carry it.
+ */
+typedef struct {
+    uint32 mmsi;               /* hash key */
+    int32 lon;                 /* 1/10000 minute */
+    int32 lat;
+    float4 speed;              /* knots */
+    float4 course;             /* degrees */
+    float4 heading;            /* degrees */
+    int8 nav_status;
+    uint8 type;
+    TimestampTz updated_at;
+} AISVesselState;
+
+
+/**
+ * @brief Vessel states held back until the transaction that read them commits
+ *
+ * Lives outside any transaction context so it survives the commit; the
+ * buffer grows as needed and is reused across batches.
+ */
+typedef struct {
+    AISVesselState *states;
+    int count;
+    int capacity;
+} AISStatePending;
+
+
+/**
+ * @brief Define the pg_ais.state_cache_size GUC
+ */
+void pg_ais_state_init(void);
+
+
+/**
+ * @brief Reserve shared memory and locks for the vessel state table
+ */
+void pg_ais_state_shmem_request(void);
+
+
+/**
+ * @brief Create or attach the vessel state table
+ *
+ * Called with AddinShmemInitLock held.
+ */
+void pg_ais_state_shmem_startup(void);
+
+
+/**
+ * @brief Record a decoded message as its vessel's latest state
+ *
+ * Ignores messages without an available position and reports older than
+ * the stored one, so replayed or reordered input cannot move a vessel back.
+ *
+ * @param msg Decoded message
+ * @param view Payload view of the (reassembled) message
+ * @param ts Time of the report
+ * @return true if the stored state was replaced
+ */
+bool ais_state_observe(const AISMessage *msg, const AISPayloadView *view, TimestampTz ts);
+
+
+/**
+ * @brief Queue a decoded message for ais_state_apply()
+ *
+ * Does nothing when the cache is disabled or the message has no available
+ * position.
+ *
+ * @param pending Queue, allocated in TopMemoryContext on first use
+ * @param msg Decoded message
+ * @param view Payload view of the (reassembled) message
+ * @param ts Time of the report
+ */
+void ais_state_defer(AISStatePending *pending, const AISMessage *msg, const AISPayloadView *view,
+                     TimestampTz ts);
+
+
+/**
+ * @brief Store queued states in arrival order and empty the queue
+ *
+ * Call after the transaction that inserted the rows has committed, so an
+ * aborted batch never reaches the cache. Older reports are rejected as in
+ * ais_state_observe().
+ *
+ * @param pending Queue
+ * @return Number of stored states that replaced the cached one
+ */
+int ais_state_apply(AISStatePending *pending);
+
+
+/**
+ * @brief Copy the latest state of one vessel
+ *
+ * @param mmsi Vessel MMSI
+ * @param out Output state
+ * @return false if the vessel is unknown or the cache is disabled
+ */
+bool ais_state_lookup(uint32 mmsi, AISVesselState *out);
+
+
+/**
+ * @brief Latest state of every vessel in the cache
+ *
+ * Usage: SELECT * FROM pg_ais_vessel_states();
+ */
+PGDLLEXPORT Datum pg_ais_vessel_states(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Latest state of one vessel, or NULL if unknown
+ *
+ * Usage: SELECT * FROM pg_ais_vessel_state(366967064);
+ */
+PGDLLEXPORT Datum pg_ais_vessel_state(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Feed one sentence into the cache, e.g. from an INSERT trigger
+ *
+ * Usage: SELECT pg_ais_vessel_state_update(sentence, received_at);
+ */
+PGDLLEXPORT Datum pg_ais_vessel_state_update(PG_FUNCTION_ARGS);
+
+#endif
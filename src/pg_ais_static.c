@@ -0,0 +1,627 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "access/htup_details.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/interrupt.h"
+#include "storage/fd.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "parse_ais_msg.h"
+#include "pg_ais.h"
+#include "pg_ais_dedup.h"
+#include "pg_ais_static.h"
+
+
+/* Columns of the pg_ais_static_data() result row */
+enum {
+    T_IMO, T_VESSEL_NAME, T_CALLSIGN, T_SHIP_TYPE, T_TO_BOW, T_TO_STERN, T_TO_PORT, T_TO_STARBOARD,
+    T_DESTINATION, T_UPDATED_AT,
+    T_NUM_COLUMNS
+};
+
+
+/**
+ * @brief Header of a snapshot file, followed by count entries
+ */
+typedef struct {
+    uint32 magic;
+    uint32 version;
+    uint64 count;
+} AISStaticSnapshotHeader;
+
+
+int ais_static_cache_size = 0;
+int ais_static_snapshot_interval = 300;
+
+static HTAB *static_hash = NULL;
+static LWLockPadded *static_locks = NULL;
+
+
+/**
+ * @brief Define the static dictionary GUCs and register its snapshot worker
+ */
+void pg_ais_static_init(void) {
+    BackgroundWorker worker;
+
+    DefineCustomIntVariable("pg_ais.static_cache_size",
+                            "Vessels kept in the shared static data dictionary (0 disables it).",
+                            "Requires pg_ais in shared_preload_libraries.",
+                            &ais_static_cache_size, 0, 0, INT_MAX / 2,
+                            PGC_POSTMASTER, 0, NULL, NULL, NULL);
+    DefineCustomIntVariable("pg_ais.static_snapshot_interval",
+                            "Seconds between snapshots of the static data dictionary (0: only at shutdown).",
+                            NULL, &ais_static_snapshot_interval, 300, 0, INT_MAX / 1000,
+                            PGC_SIGHUP, GUC_UNIT_S, NULL, NULL, NULL);
+
+    if (!process_shared_preload_libraries_in_progress || ais_static_cache_size == 0) return;
+
+    memset(&worker, 0, sizeof(worker));
+    worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+    worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+    worker.bgw_restart_time = 60;
+    snprintf(worker.bgw_library_name, BGW_MAXLEN, "pg_ais");
+    snprintf(worker.bgw_function_name, BGW_MAXLEN, "pg_ais_static_snapshot_main");
+    snprintf(worker.bgw_name, BGW_MAXLEN, "pg_ais static snapshot");
+    snprintf(worker.bgw_type, BGW_MAXLEN, "pg_ais static snapshot");
+    RegisterBackgroundWorker(&worker);
+}
+
+
+/**
+ * @brief Reserve shared memory and locks for the dictionary
+ */
+void pg_ais_static_shmem_request(void) {
+    if (ais_static_cache_size == 0) return;
+    RequestAddinShmemSpace(hash_estimate_size(ais_static_cache_size, sizeof(AISStaticEntry)));
+    RequestNamedLWLockTranche("pg_ais static", AIS_STATIC_PARTITIONS);
+}
+
+
+/**
+ * @brief Return the lock guarding the partition of a hash code
+ */
+static LWLock *static_lock(uint32 hashcode) {
+    return &static_locks[hashcode % AIS_STATIC_PARTITIONS].lock;
+}
+
+
+/**
+ * @brief Copy a decoded string into a fixed-size entry field
+ *
+ * Empty strings (all padding) leave the stored value alone.
+ */
+static void copy_static_text(char *dst, size_t size, const char *src) {
+    if (src && src[0]) strlcpy(dst, src, size);
+}
+
+
+/**
+ * @brief Build the report a decoded message makes about its vessel
+ *
+ * @param msg Decoded message
+ * @param ts Time of the report
+ * @param out Output report; only the msg->static_fields values are set
+ * @return false if the message carries no static data
+ */
+static bool static_from_message(const AISMessage *msg, TimestampTz ts, AISStaticEntry *out) {
+    unsigned fields = msg->static_fields;
+
+    if (fields == 0) return false;
+
+    memset(out, 0, sizeof(*out));
+    out->mmsi = (uint32) msg->mmsi;
+    out->fields = (uint8) fields;
+    out->updated_at = ts;
+    if (fields & AIS_STATIC_NAME) copy_static_text(out->name, sizeof(out->name), msg->vessel_name);
+    if (fields & AIS_STATIC_CALLSIGN) copy_static_text(out->callsign, sizeof(out->callsign), msg->callsign);
+    if (fields & AIS_STATIC_DESTINATION)
+        copy_static_text(out->destination, sizeof(out->destination), msg->destination);
+    if (fields & AIS_STATIC_IMO) out->imo = msg->imo;
+    if (fields & AIS_STATIC_SHIP_TYPE) out->ship_type = msg->ship_type;
+    if (fields & AIS_STATIC_DIMENSIONS) {
+        out->to_bow = msg->dimension_to_bow;
+        out->to_stern = msg->dimension_to_stern;
+        out->to_port = msg->dimension_to_port;
+        out->to_starboard = msg->dimension_to_starboard;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Merge one report into the vessel's entry
+ *
+ * A report at least as new as the entry replaces the fields it carries and
+ * moves updated_at; an older one only fills fields the entry lacks. A full
+ * dictionary keeps its current vessels and drops new ones.
+ *
+ * @param r Report built by static_from_message()
+ * @return true if the entry changed
+ */
+static bool static_merge(const AISStaticEntry *r) {
+    uint32 mmsi = r->mmsi;
+    uint32 hashcode = get_hash_value(static_hash, &mmsi);
+    LWLock *lock = static_lock(hashcode);
+    bool found;
+
+    LWLockAcquire(lock, LW_EXCLUSIVE);
+    AISStaticEntry *entry = hash_search_with_hash_value(static_hash, &mmsi, hashcode, HASH_ENTER_NULL, &found);
+    if (entry == NULL) {
+        LWLockRelease(lock);
+        return false;
+    }
+    if (!found) {
+        memset((char *) entry + sizeof(uint32), 0, sizeof(AISStaticEntry) - sizeof(uint32));
+    }
+
+    bool newer = !found || r->updated_at >= entry->updated_at;
+    unsigned fields = newer ? r->fields : r->fields & ~entry->fields;
+
+    if (fields & AIS_STATIC_NAME) copy_static_text(entry->name, sizeof(entry->name), r->name);
+    if (fields & AIS_STATIC_CALLSIGN) copy_static_text(entry->callsign, sizeof(entry->callsign), r->callsign);
+    if (fields & AIS_STATIC_DESTINATION)
+        copy_static_text(entry->destination, sizeof(entry->destination), r->destination);
+    if (fields & AIS_STATIC_IMO) entry->imo = r->imo;
+    if (fields & AIS_STATIC_SHIP_TYPE) entry->ship_type = r->ship_type;
+    if (fields & AIS_STATIC_DIMENSIONS) {
+        entry->to_bow = r->to_bow;
+        entry->to_stern = r->to_stern;
+        entry->to_port = r->to_port;
+        entry->to_starboard = r->to_starboard;
+    }
+    entry->fields |= fields;
+    if (newer) entry->updated_at = r->updated_at;
+    LWLockRelease(lock);
+    return fields != 0;
+}
+
+
+/**
+ * @brief Merge the static fields of a decoded message into the dictionary
+ *
+ * @param msg Decoded message (fields from msg->static_fields)
+ * @param ts Time of the report
+ * @return true if the entry changed
+ */
+bool ais_static_observe(const AISMessage *msg, TimestampTz ts) {
+    AISStaticEntry report;
+
+    if (static_hash == NULL || !static_from_message(msg, ts, &report)) return false;
+    return static_merge(&report);
+}
+
+
+/**
+ * @brief Queue the static fields of a decoded message for ais_static_apply()
+ *
+ * @param pending Queue, allocated in TopMemoryContext on first use
+ * @param msg Decoded message
+ * @param ts Time of the report
+ */
+void ais_static_defer(AISStaticPending *pending, const AISMessage *msg, TimestampTz ts) {
+    AISStaticEntry report;
+
+    if (static_hash == NULL || !static_from_message(msg, ts, &report)) return;
+
+    if (pending->count == pending->capacity) {
+        int capacity = pending->capacity ? pending->capacity * 2 : 16;
+        pending->reports = pending->reports
+            ? repalloc(pending->reports, sizeof(AISStaticEntry) * capacity)
+            : MemoryContextAlloc(TopMemoryContext, sizeof(AISStaticEntry) * capacity);
+        pending->capacity = capacity;
+    }
+    pending->reports[pending->count++] = report;
+}
+
+
+/**
+ * @brief Merge queued reports in arrival order and empty the queue
+ *
+ * @param pending Queue
+ * @return Number of entries changed
+ */
+int ais_static_apply(AISStaticPending *pending) {
+    int changed = 0;
+
+    for (int i = 0; i < pending->count; i++)
+        if (static_merge(&pending->reports[i])) changed++;
+    pending->count = 0;
+    return changed;
+}
+
+
+/**
+ * @brief Copy every entry out, under shared partition locks if requested
+ *
+ * @param lock Take the partition locks (false only in the exiting postmaster)
+ * @param count Output number of entries
+ * @return palloc'd array of entries
+ */
+static AISStaticEntry *copy_entries(bool lock, uint64 *count) {
+    HASH_SEQ_STATUS scan;
+    AISStaticEntry *entry;
+    uint64 n = 0;
+
+    if (lock)
+        for (int i = 0; i < AIS_STATIC_PARTITIONS; i++) LWLockAcquire(&static_locks[i].lock, LW_SHARED);
+    AISStaticEntry *copy = palloc(sizeof(AISStaticEntry) * Max(hash_get_num_entries(static_hash), 1));
+    hash_seq_init(&scan, static_hash);
+    while ((entry = hash_seq_search(&scan)) != NULL) copy[n++] = *entry;
+    if (lock)
+        for (int i = AIS_STATIC_PARTITIONS - 1; i >= 0; i--) LWLockRelease(&static_locks[i].lock);
+
+    *count = n;
+    return copy;
+}
+
+
+/**
+ * @brief Write a temporary snapshot file and rename it into place
+ *
+ * A crash mid-write leaves the last complete snapshot in place. The
+ * temporary file is named after the writing process, so the snapshot
+ * worker and pg_ais_static_snapshot() never write into the same file;
+ * ones a crash leaves behind are removed at the next startup.
+ *
+ * @param lock Take the partition locks while copying entries
+ * @return Entries written, or -1 on failure (logged)
+ */
+static int64 write_snapshot(bool lock) {
+    char tmpfile[MAXPGPATH];
+    AISStaticSnapshotHeader header = {AIS_STATIC_SNAPSHOT_MAGIC, AIS_STATIC_SNAPSHOT_VERSION, 0};
+
+    snprintf(tmpfile, sizeof(tmpfile), "%s.%d.tmp", AIS_STATIC_SNAPSHOT_FILE, MyProcPid);
+    AISStaticEntry *entries = copy_entries(lock, &header.count);
+    FILE *file = AllocateFile(tmpfile, PG_BINARY_W);
+    if (file == NULL) goto error;
+    if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+        (header.count > 0 && fwrite(entries, sizeof(AISStaticEntry), header.count, file) != header.count)) {
+        FreeFile(file);
+        goto error;
+    }
+    if (FreeFile(file) != 0) goto error;
+    pfree(entries);
+
+    if (durable_rename(tmpfile, AIS_STATIC_SNAPSHOT_FILE, LOG) != 0) {
+        unlink(tmpfile);
+        return -1;
+    }
+    return (int64) header.count;
+
+error:
+    ereport(LOG,
+            (errcode_for_file_access(),
+             errmsg("could not write file \"%s\": %m", tmpfile)));
+    pfree(entries);
+    unlink(tmpfile);
+    return -1;
+}
+
+
+/**
+ * @brief Write the dictionary to its snapshot file atomically
+ *
+ * @return Entries written, or -1 if the dictionary is disabled or the
+ *         write failed (logged)
+ */
+int64 ais_static_snapshot(void) {
+    if (static_hash == NULL) return -1;
+    return write_snapshot(true);
+}
+
+
+/**
+ * @brief Load the last snapshot into a freshly created dictionary
+ *
+ * A missing file is normal; an unreadable or foreign one is logged and
+ * ignored.
+ */
+static void load_snapshot(void) {
+    AISStaticSnapshotHeader header;
+    AISStaticEntry e;
+    bool found;
+
+    FILE *file = AllocateFile(AIS_STATIC_SNAPSHOT_FILE, PG_BINARY_R);
+    if (file == NULL) {
+        if (errno != ENOENT)
+            ereport(LOG,
+                    (errcode_for_file_access(),
+                     errmsg("could not read file \"%s\": %m", AIS_STATIC_SNAPSHOT_FILE)));
+        return;
+    }
+
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        header.magic != AIS_STATIC_SNAPSHOT_MAGIC || header.version != AIS_STATIC_SNAPSHOT_VERSION) {
+        ereport(LOG, (errmsg("ignoring invalid pg_ais static snapshot \"%s\"", AIS_STATIC_SNAPSHOT_FILE)));
+        FreeFile(file);
+        return;
+    }
+
+    for (uint64 i = 0; i < header.count && fread(&e, sizeof(e), 1, file) == 1; i++) {
+        AISStaticEntry *entry = hash_search(static_hash, &e.mmsi, HASH_ENTER_NULL, &found);
+        if (entry == NULL) break;
+        *entry = e;
+    }
+    FreeFile(file);
+}
+
+
+/**
+ * @brief Remove temporary snapshot files left behind by a crash
+ *
+ * Runs before any process can write a snapshot, so every match is stale.
+ */
+static void remove_temp_snapshots(void) {
+    const char *prefix = AIS_STATIC_SNAPSHOT_FILE ".";
+    size_t prefix_len = strlen(prefix);
+    DIR *dir = AllocateDir(".");
+    struct dirent *de;
+
+    while ((de = ReadDirExtended(dir, ".", LOG)) != NULL) {
+        size_t len = strlen(de->d_name);
+
+        if (len > prefix_len + 4 && strncmp(de->d_name, prefix, prefix_len) == 0 &&
+            strcmp(de->d_name + len - 4, ".tmp") == 0 && unlink(de->d_name) != 0)
+            ereport(LOG,
+                    (errcode_for_file_access(),
+                     errmsg("could not remove file \"%s\": %m", de->d_name)));
+    }
+    FreeDir(dir);
+}
+
+
+/**
+ * @brief Postmaster exit callback: write a final snapshot
+ *
+ * No backends are left, so no locks are needed (nor possible without a
+ * PGPROC). After a crash shared memory may be inconsistent, so the previous
+ * snapshot is kept.
+ */
+static void static_shmem_shutdown(int code, Datum arg) {
+    if (code == 0) (void) write_snapshot(false);
+}
+
+
+/**
+ * @brief Create or attach the dictionary, loading the last snapshot
+ *
+ * Called with AddinShmemInitLock held. The first initialization also
+ * removes temporary snapshot files a crash left behind.
+ */
+void pg_ais_static_shmem_startup(void) {
+    HASHCTL info;
+    bool found;
+
+    if (ais_static_cache_size == 0) return;
+
+    /* Only used to detect first initialization */
+    (void) ShmemInitStruct("pg_ais static loaded", sizeof(bool), &found);
+
+    info.keysize = sizeof(uint32);
+    info.entrysize = sizeof(AISStaticEntry);
+    info.num_partitions = AIS_STATIC_PARTITIONS;
+    static_hash = ShmemInitHash("pg_ais static data", ais_static_cache_size, ais_static_cache_size, &info,
+                                HASH_ELEM | HASH_BLOBS | HASH_PARTITION | HASH_FIXED_SIZE);
+    static_locks = GetNamedLWLockTranche("pg_ais static");
+
+    if (!found) {
+        remove_temp_snapshots();
+        load_snapshot();
+    }
+    if (!IsUnderPostmaster) on_shmem_exit(static_shmem_shutdown, (Datum) 0);
+}
+
+
+/**
+ * @brief Copy the dictionary entry of one vessel
+ *
+ * @param mmsi Vessel MMSI
+ * @param out Output entry
+ * @return false if the vessel is unknown or the dictionary is disabled
+ */
+bool ais_static_lookup(uint32 mmsi, AISStaticEntry *out) {
+    if (static_hash == NULL) return false;
+
+    uint32 hashcode = get_hash_value(static_hash, &mmsi);
+    LWLock *lock = static_lock(hashcode);
+
+    LWLockAcquire(lock, LW_SHARED);
+    AISStaticEntry *entry = hash_search_with_hash_value(static_hash, &mmsi, hashcode, HASH_FIND, NULL);
+    if (entry) *out = *entry;
+    LWLockRelease(lock);
+    return entry != NULL;
+}
+
+
+/**
+ * @brief Background worker writing a snapshot every snapshot interval
+ */
+void pg_ais_static_snapshot_main(Datum arg) {
+    pqsignal(SIGHUP, SignalHandlerForConfigReload);
+    pqsignal(SIGTERM, SignalHandlerForShutdownRequest);
+    BackgroundWorkerUnblockSignals();
+
+    while (!ShutdownRequestPending) {
+        long timeout = ais_static_snapshot_interval > 0 ? ais_static_snapshot_interval * 1000L : -1;
+
+        (void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH | (timeout > 0 ? WL_TIMEOUT : 0),
+                         timeout, PG_WAIT_EXTENSION);
+        ResetLatch(MyLatch);
+        CHECK_FOR_INTERRUPTS();
+
+        if (ConfigReloadPending) {
+            ConfigReloadPending = false;
+            ProcessConfigFile(PGC_SIGHUP);
+            continue;
+        }
+        if (!ShutdownRequestPending && ais_static_snapshot_interval > 0) {
+            int64 n = ais_static_snapshot();
+            if (n >= 0) elog(DEBUG1, "pg_ais static snapshot wrote " INT64_FORMAT " vessels", n);
+        }
+    }
+    proc_exit(0);
+}
+
+
+/**
+ * @brief Build a text datum, NULL when the field was never received
+ */
+static Datum static_text(const AISStaticEntry *e, unsigned field, const char *value, bool *isnull) {
+    *isnull = (e->fields & field) == 0 || value[0] == '\0';
+    return *isnull ? (Datum) 0 : CStringGetTextDatum(value);
+}
+
+
+/**
+ * @brief Static data of one vessel, or NULL if unknown
+ *
+ * Usage: SELECT * FROM pg_ais_static_data(366053213);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_static_data);
+Datum
+pg_ais_static_data(PG_FUNCTION_ARGS) {
+    AISStaticEntry e;
+    TupleDesc tupdesc;
+    Datum values[T_NUM_COLUMNS];
+    bool nulls[T_NUM_COLUMNS];
+
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        ereport(ERROR, (errmsg("return type must be a row type")));
+    if (!ais_static_lookup((uint32) PG_GETARG_INT32(0), &e)) PG_RETURN_NULL();
+
+    bool no_dims = (e.fields & AIS_STATIC_DIMENSIONS) == 0;
+
+    values[T_IMO] = Int32GetDatum((int32) e.imo);
+    nulls[T_IMO] = (e.fields & AIS_STATIC_IMO) == 0;
+    values[T_VESSEL_NAME] = static_text(&e, AIS_STATIC_NAME, e.name, &nulls[T_VESSEL_NAME]);
+    values[T_CALLSIGN] = static_text(&e, AIS_STATIC_CALLSIGN, e.callsign, &nulls[T_CALLSIGN]);
+    values[T_SHIP_TYPE] = Int32GetDatum(e.ship_type);
+    nulls[T_SHIP_TYPE] = (e.fields & AIS_STATIC_SHIP_TYPE) == 0;
+    values[T_TO_BOW] = Int32GetDatum(e.to_bow);
+    values[T_TO_STERN] = Int32GetDatum(e.to_stern);
+    values[T_TO_PORT] = Int32GetDatum(e.to_port);
+    values[T_TO_STARBOARD] = Int32GetDatum(e.to_starboard);
+    nulls[T_TO_BOW] = nulls[T_TO_STERN] = nulls[T_TO_PORT] = nulls[T_TO_STARBOARD] = no_dims;
+    values[T_DESTINATION] = static_text(&e, AIS_STATIC_DESTINATION, e.destination, &nulls[T_DESTINATION]);
+    values[T_UPDATED_AT] = TimestampTzGetDatum(e.updated_at);
+    nulls[T_UPDATED_AT] = false;
+
+    HeapTuple tuple = heap_form_tuple(BlessTupleDesc(tupdesc), values, nulls);
+    PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+}
+
+
+/**
+ * @brief Vessel name of one MMSI, or NULL if unknown
+ *
+ * Usage: SELECT mmsi, pg_ais_vessel_name(mmsi) FROM positions;
+ */
+PG_FUNCTION_INFO_V1(pg_ais_vessel_name);
+Datum
+pg_ais_vessel_name(PG_FUNCTION_ARGS) {
+    AISStaticEntry e;
+
+    if (!ais_static_lookup((uint32) PG_GETARG_INT32(0), &e) || e.name[0] == '\0') PG_RETURN_NULL();
+    PG_RETURN_TEXT_P(cstring_to_text(e.name));
+}
+
+
+/**
+ * @brief Tag block receive time of the first fragment that has one
+ *
+ * @param parts Fragment views
+ * @param nparts Number of fragments
+ * @param ts Time to use without a tag block
+ * @return Report time
+ */
+static TimestampTz report_time(const AISPayloadView *parts, int nparts, TimestampTz ts) {
+    for (int i = 0; i < nparts; i++)
+        if (parts[i].tags.receive_time) return time_t_to_timestamptz((pg_time_t) parts[i].tags.receive_time);
+    return ts;
+}
+
+
+/**
+ * @brief Decode a complete message and merge its static fields
+ *
+ * @param parts Fragment views ordered by sequence number
+ * @param nparts Number of fragments
+ * @param ts Time to use without a tag block
+ * @return true if the entry changed
+ */
+static bool update_from_views(const AISPayloadView *parts, int nparts, TimestampTz ts) {
+    AISMessage msg = {0};
+    bool changed = false;
+
+    if (parse_ais_views(&msg, parts, nparts).ok)
+        changed = ais_static_observe(&msg, report_time(parts, nparts, ts));
+    free_ais_message(&msg);
+    return changed;
+}
+
+
+/**
+ * @brief Merge one single-part sentence, e.g. from an INSERT trigger
+ *
+ * The tag block receive time, when present, takes precedence over
+ * received_at. Multipart fragments are ignored; pass them together as an
+ * array instead.
+ *
+ * Usage: SELECT pg_ais_static_update(sentence, received_at);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_static_update);
+Datum
+pg_ais_static_update(PG_FUNCTION_ARGS) {
+    ais *input = PG_GETARG_AIS_PP(0);
+    AISPayloadView view;
+
+    if (static_hash == NULL) PG_RETURN_BOOL(false);
+    if (!ais_payload_view(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), &view) || view.total != 1)
+        PG_RETURN_BOOL(false);
+    PG_RETURN_BOOL(update_from_views(&view, 1, PG_GETARG_TIMESTAMPTZ(1)));
+}
+
+
+/**
+ * @brief Merge one multipart message given as its fragments
+ *
+ * Usage: SELECT pg_ais_static_update(ARRAY[part1, part2], received_at);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_static_update_parts);
+Datum
+pg_ais_static_update_parts(PG_FUNCTION_ARGS) {
+    AISPayloadView parts[MAX_PARTS];
+
+    if (static_hash == NULL) PG_RETURN_BOOL(false);
+
+    int nparts = pg_ais_collect_fragments(PG_GETARG_ARRAYTYPE_P(0), parts);
+    if (nparts < 0) PG_RETURN_BOOL(false);
+    PG_RETURN_BOOL(update_from_views(parts, nparts, PG_GETARG_TIMESTAMPTZ(1)));
+}
+
+
+/**
+ * @brief Write a dictionary snapshot now
+ *
+ * Usage: SELECT pg_ais_static_snapshot();
+ */
+PG_FUNCTION_INFO_V1(pg_ais_static_snapshot);
+Datum
+pg_ais_static_snapshot(PG_FUNCTION_ARGS) {
+    int64 n = ais_static_snapshot();
+
+    if (n < 0) PG_RETURN_NULL();
+    PG_RETURN_INT64(n);
+}
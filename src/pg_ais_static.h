@@ -0,0 +1,184 @@
+#ifndef PG_AIS_STATIC_H
+#define PG_AIS_STATIC_H
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/timestamp.h"
+
+#include "ais_core.h"
+
+/* Lock partitions of the static data dictionary (power of two) */
+#define AIS_STATIC_PARTITIONS 16
+
+/* Snapshot file, relative to the data directory */
+#define AIS_STATIC_SNAPSHOT_FILE "pg_ais_static.snap"
+
+/* Identifies a snapshot file and its entry layout */
+#define AIS_STATIC_SNAPSHOT_MAGIC 0x41495353
+#define AIS_STATIC_SNAPSHOT_VERSION 1
+
+
+/* GUCs */
+extern int ais_static_cache_size;
+extern int ais_static_snapshot_interval;
+
+
+/**
+ * @brief Static and voyage data of one vessel, merged from type 5/19/24
+ *
+ * Type 24 parts A and B arrive separately, so fields records which
+ * AIS_STATIC_* values have been seen; the rest are zero or empty.
+ * updated_at is the report time of the newest merged report.
+ */
+typedef struct {
+    uint32 mmsi;               /* hash key */
+    uint32 imo;
+    uint8 fields;
+    uint8 ship_type;
+    uint8 to_port;
+    uint8 to_starboard;
+    uint16 to_bow;
+    uint16 to_stern;
+    char name[21];
+    char callsign[8];
+    char destination[21];
+    TimestampTz updated_at;
+} AISStaticEntry;
+
+
+/**
+ * @brief Static reports held back until the transaction that read them commits
+ *
+ * Lives outside any transaction context so it survives the commit; the
+ * buffer grows as needed and is reused across batches.
+ */
+typedef struct {
+    AISStaticEntry *reports;
+    int count;
+    int capacity;
+} AISStaticPending;
+
+
+/**
+ * @brief Define the static dictionary GUCs and register its snapshot worker
+ */
+void pg_ais_static_init(void);
+
+
+/**
+ * @brief Reserve shared memory and locks for the dictionary
+ */
+void pg_ais_static_shmem_request(void);
+
+
+/**
+ * @brief Create or attach the dictionary, loading the last snapshot
+ *
+ * Called with AddinShmemInitLock held. The first initialization also
+ * removes temporary snapshot files a crash left behind.
+ */
+void pg_ais_static_shmem_startup(void);
+
+
+/**
+ * @brief Merge the static fields of a decoded message into the dictionary
+ *
+ * A report older than the vessel's entry only fills fields not seen yet,
+ * so replayed or reordered input cannot overwrite newer data.
+ *
+ * @param msg Decoded message (fields from msg->static_fields)
+ * @param ts Time of the report
+ * @return true if the entry changed
+ */
+bool ais_static_observe(const AISMessage *msg, TimestampTz ts);
+
+
+/**
+ * @brief Queue the static fields of a decoded message for ais_static_apply()
+ *
+ * Does nothing when the dictionary is disabled or the message carries no
+ * static data.
+ *
+ * @param pending Queue, allocated in TopMemoryContext on first use
+ * @param msg Decoded message
+ * @param ts Time of the report
+ */
+void ais_static_defer(AISStaticPending *pending, const AISMessage *msg, TimestampTz ts);
+
+
+/**
+ * @brief Merge queued reports in arrival order and empty the queue
+ *
+ * Call after the transaction that inserted the rows has committed.
+ *
+ * @param pending Queue
+ * @return Number of entries changed
+ */
+int ais_static_apply(AISStaticPending *pending);
+
+
+/**
+ * @brief Copy the dictionary entry of one vessel
+ *
+ * @param mmsi Vessel MMSI
+ * @param out Output entry
+ * @return false if the vessel is unknown or the dictionary is disabled
+ */
+bool ais_static_lookup(uint32 mmsi, AISStaticEntry *out);
+
+
+/**
+ * @brief Write the dictionary to its snapshot file atomically
+ *
+ * @return Entries written, or -1 if the dictionary is disabled or the
+ *         write failed (logged)
+ */
+int64 ais_static_snapshot(void);
+
+
+/**
+ * @brief Background worker writing a snapshot every snapshot interval
+ */
+PGDLLEXPORT void pg_ais_static_snapshot_main(Datum arg);
+
+
+/**
+ * @brief Static data of one vessel, or NULL if unknown
+ *
+ * Usage: SELECT * FROM pg_ais_static_data(366053213);
+ */
+PGDLLEXPORT Datum pg_ais_static_data(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Vessel name of one MMSI, or NULL if unknown
+ *
+ * Usage: SELECT mmsi, pg_ais_vessel_name(mmsi) FROM positions;
+ */
+PGDLLEXPORT Datum pg_ais_vessel_name(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Merge one single-part sentence, e.g. from an INSERT trigger
+ *
+ * Usage: SELECT pg_ais_static_update(sentence, received_at);
+ */
+PGDLLEXPORT Datum pg_ais_static_update(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Merge one multipart message given as its fragments
+ *
+ * Usage: SELECT pg_ais_static_update(ARRAY[part1, part2], received_at);
+ */
+PGDLLEXPORT Datum pg_ais_static_update_parts(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Write a dictionary snapshot now
+ *
+ * Usage: SELECT pg_ais_static_snapshot();
+ */
+PGDLLEXPORT Datum pg_ais_static_snapshot(PG_FUNCTION_ARGS);
+
+#endif
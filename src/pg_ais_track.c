@@ -0,0 +1,836 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "access/htup_details.h"
+#include "miscadmin.h"
+#include "datatype/timestamp.h"
+#include "catalog/pg_type.h"
+#include "utils/builtins.h"
+#include "utils/geo_decls.h"
+#include "utils/rangetypes.h"
+#include "utils/timestamp.h"
+#include "utils/tuplestore.h"
+#include "utils/typcache.h"
+#include "lib/stringinfo.h"
+
+#include <math.h>
+
+#include "pg_ais.h"
+#include "ais_payload.h"
+#include "pg_ais_track.h"
+
+
+/* Columns of the pg_ais_track_points() rows */
+enum {
+    P_TS, P_LAT, P_LON, P_SPEED, P_COURSE,
+    P_NUM_COLUMNS
+};
+
+
+/**
+ * @brief Aggregate state of pg_ais_track_agg, kept in the aggregate context
+ */
+typedef struct {
+    uint32 mmsi;
+    int32 npoints;
+    int32 lon_min;
+    int32 lat_min;
+    int32 lon_max;
+    int32 lat_max;
+    int64 t_min;
+    int64 t_max;
+    AISTrackPoint prev;
+    StringInfoData data;       /* encoded points */
+} AISTrackState;
+
+
+/**
+ * @brief Aggregate state of pg_ais_track_simplify_agg
+ */
+typedef struct {
+    AISTrackState track;       /* kept points; track.prev is the anchor */
+    double tolerance;          /* metres */
+    int64 max_gap;             /* milliseconds */
+    AISTrackPoint last;        /* last input point */
+    bool last_kept;
+} AISSimplifyState;
+
+
+/**
+ * @brief Convert a timestamp to whole milliseconds, rounding down
+ */
+static int64 timestamptz_to_ms(TimestampTz ts) {
+    if (TIMESTAMP_NOT_FINITE(ts))
+        ereport(ERROR,
+                (errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+                 errmsg("track point time must be finite")));
+    return ts >= 0 ? ts / 1000 : -((-ts + 999) / 1000);
+}
+
+
+/**
+ * @brief Check that a track's points decode and match its header
+ *
+ * @param track Track to check, 4-byte header
+ * @return true if every point decodes, the data ends with the last point
+ *         and the bounding box and time range are exact
+ */
+static bool track_is_valid(const AISTrack *track) {
+    Size size = VARSIZE(track);
+    AISTrackPoint point = {0};
+    int64 t_min = PG_INT64_MAX, t_max = PG_INT64_MIN;
+    int32 lon_min = PG_INT32_MAX, lat_min = PG_INT32_MAX, lon_max = PG_INT32_MIN, lat_max = PG_INT32_MIN;
+
+    if (size < AIS_TRACK_HEADER_SIZE || track->version != AIS_TRACK_VERSION || track->npoints < 1) return false;
+
+    const uint8 *pos = track->data;
+    const uint8 *end = (const uint8 *) track + size;
+    for (int32 i = 0; i < track->npoints; i++) {
+        if (!ais_track_decode_point(&pos, end, &point)) return false;
+        if (point.lon < -AIS_LON_LIMIT || point.lon > AIS_LON_LIMIT ||
+            point.lat < -AIS_LAT_LIMIT || point.lat > AIS_LAT_LIMIT ||
+            point.speed < -1 || point.course < -1 ||
+            point.t < MIN_TIMESTAMP / 1000 || point.t >= END_TIMESTAMP / 1000)
+            return false;
+        t_min = Min(t_min, point.t);
+        t_max = Max(t_max, point.t);
+        lon_min = Min(lon_min, point.lon);
+        lat_min = Min(lat_min, point.lat);
+        lon_max = Max(lon_max, point.lon);
+        lat_max = Max(lat_max, point.lat);
+    }
+    return pos == end && t_min == track->t_min && t_max == track->t_max &&
+           lon_min == track->lon_min && lat_min == track->lat_min &&
+           lon_max == track->lon_max && lat_max == track->lat_max;
+}
+
+
+/**
+ * @brief Input function of ais_track: hex of the encoded track
+ *
+ * The whole value is decoded and checked against its header, since the
+ * accessors trust the header.
+ */
+PG_FUNCTION_INFO_V1(ais_track_in);
+Datum
+ais_track_in(PG_FUNCTION_ARGS) {
+    char *str = PG_GETARG_CSTRING(0);
+    size_t len = strlen(str);
+
+    if (len % 2 != 0 || len / 2 < AIS_TRACK_HEADER_SIZE - VARHDRSZ || len / 2 > MaxAllocSize - VARHDRSZ)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+                 errmsg("invalid input syntax for type %s: \"%.32s...\"", "ais_track", str)));
+
+    AISTrack *track = palloc(VARHDRSZ + len / 2);
+    SET_VARSIZE(track, VARHDRSZ + hex_decode(str, len, (char *) track + VARHDRSZ));
+    if (!track_is_valid(track))
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+                 errmsg("invalid input syntax for type %s: \"%.32s...\"", "ais_track", str)));
+    PG_RETURN_POINTER(track);
+}
+
+
+/**
+ * @brief Output function of ais_track: hex of the encoded track
+ */
+PG_FUNCTION_INFO_V1(ais_track_out);
+Datum
+ais_track_out(PG_FUNCTION_ARGS) {
+    AISTrack *track = PG_GETARG_AIS_TRACK_P(0);
+    Size len = VARSIZE(track) - VARHDRSZ;
+    char *out = palloc(len * 2 + 1);
+
+    out[hex_encode((const char *) track + VARHDRSZ, len, out)] = '\0';
+    PG_RETURN_CSTRING(out);
+}
+
+
+/**
+ * @brief Read the point of one transition call's message
+ *
+ * @param fcinfo Transition call: (state, ais, timestamptz)
+ * @param point Output point
+ * @param mmsi Output MMSI
+ * @return false if the message has no position or no time
+ */
+static bool track_input_point(FunctionCallInfo fcinfo, AISTrackPoint *point, uint32 *mmsi) {
+    AISPayloadView view;
+
+    if (PG_ARGISNULL(1)) return false;
+    ais *value = PG_GETARG_AIS_PP(1);
+    if (!ais_payload_view(VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value), &view) ||
+        !ais_view_uint(&view, 8, 30, mmsi) || !ais_view_position(&view, &point->lon, &point->lat))
+        return false;
+
+    if (!PG_ARGISNULL(2))
+        point->t = timestamptz_to_ms(PG_GETARG_TIMESTAMPTZ(2));
+    else if (view.tags.receive_time)
+        point->t = timestamptz_to_ms(time_t_to_timestamptz((pg_time_t) view.tags.receive_time));
+    else
+        return false;
+    ais_view_motion(&view, &point->speed, &point->course);
+    return true;
+}
+
+
+/**
+ * @brief Allocate an aggregate state in the aggregate context
+ *
+ * @param aggcontext Aggregate memory context
+ * @param size Size of the state struct, starting with an AISTrackState
+ * @param mmsi Vessel of the track
+ * @return Zeroed state with an empty point buffer
+ */
+static AISTrackState *track_state_create(MemoryContext aggcontext, Size size, uint32 mmsi) {
+    MemoryContext oldcxt = MemoryContextSwitchTo(aggcontext);
+    AISTrackState *state = palloc0(size);
+    initStringInfo(&state->data);
+    MemoryContextSwitchTo(oldcxt);
+
+    state->mmsi = mmsi;
+    state->lon_min = state->lat_min = PG_INT32_MAX;
+    state->lon_max = state->lat_max = PG_INT32_MIN;
+    state->t_min = PG_INT64_MAX;
+    state->t_max = PG_INT64_MIN;
+    return state;
+}
+
+
+/**
+ * @brief Reject a point of another vessel
+ */
+static void track_state_check_mmsi(const AISTrackState *state, uint32 mmsi) {
+    if (mmsi != state->mmsi)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("track aggregate input mixes MMSI %u and %u", state->mmsi, mmsi),
+                 errhint("Group the input by MMSI.")));
+}
+
+
+/**
+ * @brief Encode a point after the previous one and widen the summary
+ */
+static void track_state_append(AISTrackState *state, const AISTrackPoint *point) {
+    enlargeStringInfo(&state->data, AIS_TRACK_POINT_MAX);
+    state->data.len += (int) ais_track_encode_point(&state->prev, point,
+                                                    (uint8 *) state->data.data + state->data.len);
+    state->data.data[state->data.len] = '\0';
+    state->prev = *point;
+    state->npoints++;
+    state->lon_min = Min(state->lon_min, point->lon);
+    state->lat_min = Min(state->lat_min, point->lat);
+    state->lon_max = Max(state->lon_max, point->lon);
+    state->lat_max = Max(state->lat_max, point->lat);
+    state->t_min = Min(state->t_min, point->t);
+    state->t_max = Max(state->t_max, point->t);
+}
+
+
+/**
+ * @brief Build the ais_track varlena of an aggregate state
+ *
+ * @param state Aggregate state, left unchanged
+ * @param extra Point to append after the state's points, or NULL
+ * @return New ais_track
+ */
+static AISTrack *track_state_build(const AISTrackState *state, const AISTrackPoint *extra) {
+    AISTrack *track = palloc(AIS_TRACK_HEADER_SIZE + state->data.len + AIS_TRACK_POINT_MAX);
+    Size len = state->data.len;
+
+    track->version = AIS_TRACK_VERSION;
+    track->mmsi = state->mmsi;
+    track->npoints = state->npoints;
+    track->lon_min = state->lon_min;
+    track->lat_min = state->lat_min;
+    track->lon_max = state->lon_max;
+    track->lat_max = state->lat_max;
+    track->t_min = state->t_min;
+    track->t_max = state->t_max;
+    memcpy(track->data, state->data.data, len);
+
+    if (extra) {
+        len += ais_track_encode_point(&state->prev, extra, track->data + len);
+        track->npoints++;
+        track->lon_min = Min(track->lon_min, extra->lon);
+        track->lat_min = Min(track->lat_min, extra->lat);
+        track->lon_max = Max(track->lon_max, extra->lon);
+        track->lat_max = Max(track->lat_max, extra->lat);
+        track->t_min = Min(track->t_min, extra->t);
+        track->t_max = Max(track->t_max, extra->t);
+    }
+    SET_VARSIZE(track, AIS_TRACK_HEADER_SIZE + len);
+    return track;
+}
+
+
+/**
+ * @brief Return the aggregate state, or NULL before the first point
+ */
+#define PG_RETURN_TRACK_STATE(state) \
+    do { \
+        if ((state) == NULL) PG_RETURN_NULL(); \
+        PG_RETURN_POINTER(state); \
+    } while (0)
+
+
+/**
+ * @brief Fetch the aggregate context, rejecting calls outside an aggregate
+ */
+static MemoryContext track_agg_context(FunctionCallInfo fcinfo) {
+    MemoryContext aggcontext;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("track aggregate function called in non-aggregate context")));
+    return aggcontext;
+}
+
+
+/**
+ * @brief pg_ais_track_agg transition: append one message's position
+ *
+ * The time is the ts argument, or the tag block receive time when ts is
+ * NULL. Messages without a position or a time are skipped; every message
+ * must come from the same MMSI, so group by vessel.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_track_agg_transfn);
+Datum
+pg_ais_track_agg_transfn(PG_FUNCTION_ARGS) {
+    MemoryContext aggcontext = track_agg_context(fcinfo);
+    AISTrackState *state = PG_ARGISNULL(0) ? NULL : (AISTrackState *) PG_GETARG_POINTER(0);
+    AISTrackPoint point;
+    uint32 mmsi;
+
+    if (!track_input_point(fcinfo, &point, &mmsi)) PG_RETURN_TRACK_STATE(state);
+
+    if (state == NULL) state = track_state_create(aggcontext, sizeof(AISTrackState), mmsi);
+    track_state_check_mmsi(state, mmsi);
+    track_state_append(state, &point);
+    PG_RETURN_POINTER(state);
+}
+
+
+/**
+ * @brief pg_ais_track_agg final function: build the ais_track
+ *
+ * Returns NULL when no message had a position and a time.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_track_agg_finalfn);
+Datum
+pg_ais_track_agg_finalfn(PG_FUNCTION_ARGS) {
+    if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+    PG_RETURN_POINTER(track_state_build((AISTrackState *) PG_GETARG_POINTER(0), NULL));
+}
+
+
+/**
+ * @brief Convert an interval to milliseconds, using 30-day months
+ */
+static int64 interval_to_ms(const Interval *span) {
+    return (span->time + ((int64) span->month * DAYS_PER_MONTH + span->day) * USECS_PER_DAY) / 1000;
+}
+
+
+/**
+ * @brief pg_ais_track_simplify_agg transition: keep only informative points
+ *
+ * Dead reckoning from the last kept point: a point is kept when it lies
+ * more than tolerance metres from where the kept point's speed and course
+ * predict the vessel. Both ends of a time gap longer than max_gap are kept,
+ * and the final function adds the last point. Tolerance and gap are read
+ * from the first row.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_track_simplify_transfn);
+Datum
+pg_ais_track_simplify_transfn(PG_FUNCTION_ARGS) {
+    MemoryContext aggcontext = track_agg_context(fcinfo);
+    AISSimplifyState *state = PG_ARGISNULL(0) ? NULL : (AISSimplifyState *) PG_GETARG_POINTER(0);
+    AISTrackPoint point;
+    uint32 mmsi;
+
+    if (!track_input_point(fcinfo, &point, &mmsi)) PG_RETURN_TRACK_STATE(state);
+
+    if (state == NULL) {
+        if (PG_ARGISNULL(3) || PG_ARGISNULL(4))
+            ereport(ERROR,
+                    (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                     errmsg("tolerance and max_gap must not be NULL")));
+        if (!(PG_GETARG_FLOAT8(3) >= 0))
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("tolerance must be a non-negative number of metres")));
+
+        state = (AISSimplifyState *) track_state_create(aggcontext, sizeof(AISSimplifyState), mmsi);
+        state->tolerance = PG_GETARG_FLOAT8(3);
+        state->max_gap = interval_to_ms(PG_GETARG_INTERVAL_P(4));
+        track_state_append(&state->track, &point);
+        state->last = point;
+        state->last_kept = true;
+        PG_RETURN_POINTER(state);
+    }
+    track_state_check_mmsi(&state->track, mmsi);
+
+    bool keep;
+    if (point.t - state->last.t > state->max_gap) {
+        /* Close the segment before the gap so it is not drawn across it */
+        if (!state->last_kept) track_state_append(&state->track, &state->last);
+        keep = true;
+    } else {
+        keep = ais_track_deviates(&state->track.prev, &point, state->tolerance);
+    }
+    if (keep) track_state_append(&state->track, &point);
+    state->last = point;
+    state->last_kept = keep;
+    PG_RETURN_POINTER(state);
+}
+
+
+/**
+ * @brief pg_ais_track_simplify_agg final function: add the last point
+ *
+ * The state is left unchanged, so the aggregate also works over windows.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_track_simplify_finalfn);
+Datum
+pg_ais_track_simplify_finalfn(PG_FUNCTION_ARGS) {
+    if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+
+    AISSimplifyState *state = (AISSimplifyState *) PG_GETARG_POINTER(0);
+    PG_RETURN_POINTER(track_state_build(&state->track, state->last_kept ? NULL : &state->last));
+}
+
+
+/* Windowed rates tracked by pg_ais_kinematics, each with a running maximum */
+enum {
+    RATE_IMPLIED_SPEED, RATE_TURN,
+    NUM_RATES
+};
+
+/* Columns of the ais_kinematics result */
+enum {
+    K_FIXES, K_DISTANCE, K_AVG_SPEED, K_MAX_TURN_RATE, K_MAX_IMPLIED_SPEED,
+    K_NUM_COLUMNS
+};
+
+#define KINEMATICS_INITIAL_CAPACITY 16
+
+#define MS_PER_HOUR 3600000.0
+#define METRES_PER_NM 1852.0
+
+
+/**
+ * @brief One position of a kinematics window and the segment ending at it
+ */
+typedef struct {
+    AISTrackPoint point;
+    int64 distance;            /* millimetres from the previous fix */
+    float8 rate[NUM_RATES];    /* knots and degrees per minute, -1 if n/a */
+} AISKinematicsFix;
+
+
+/**
+ * @brief Monotonic deque of fix sequence numbers with decreasing rates
+ *
+ * Its front is the maximum of the window; positions wrap like the fixes.
+ */
+typedef struct {
+    int64 *seq;
+    int64 head;
+    int64 tail;
+} AISRateDeque;
+
+
+/**
+ * @brief Aggregate state of pg_ais_kinematics
+ *
+ * Fixes are numbered in arrival order and kept in a ring indexed by
+ * sequence & mask. The segments counted are those ending at the fixes after
+ * head, so dropping the oldest fix also drops the segment that left it.
+ * Only the moving-aggregate form keeps the whole window; the plain form
+ * has a ring of one and running maxima, and its head stays at zero.
+ */
+typedef struct {
+    uint32 mmsi;
+    bool has_mmsi;
+    bool moving;
+    int64 head;                /* sequence number of the oldest fix */
+    int64 tail;                /* one past the newest fix */
+    int64 t_first;             /* time of the oldest fix, milliseconds */
+    int64 distance;            /* millimetres over the counted segments */
+    int64 mask;                /* ring capacity - 1 */
+    AISKinematicsFix *fixes;
+    AISRateDeque max[NUM_RATES];   /* moving form */
+    float8 top[NUM_RATES];         /* plain form */
+} AISKinematicsState;
+
+
+/**
+ * @brief Allocate an empty kinematics state in the aggregate context
+ */
+static AISKinematicsState *kinematics_state_create(MemoryContext aggcontext, bool moving) {
+    Size capacity = moving ? KINEMATICS_INITIAL_CAPACITY : 1;
+    MemoryContext oldcxt = MemoryContextSwitchTo(aggcontext);
+    AISKinematicsState *state = palloc0(sizeof(AISKinematicsState));
+
+    state->moving = moving;
+    state->mask = (int64) capacity - 1;
+    state->fixes = palloc(sizeof(AISKinematicsFix) * capacity);
+    for (int r = 0; r < NUM_RATES; r++) {
+        if (moving) state->max[r].seq = palloc(sizeof(int64) * capacity);
+        state->top[r] = -1;
+    }
+    MemoryContextSwitchTo(oldcxt);
+    return state;
+}
+
+
+/**
+ * @brief Double the ring capacity, keeping every position at sequence & mask
+ */
+static void kinematics_state_grow(AISKinematicsState *state) {
+    int64 mask = state->mask * 2 + 1;
+    AISKinematicsFix *fixes = MemoryContextAlloc(GetMemoryChunkContext(state->fixes),
+                                                 sizeof(AISKinematicsFix) * (mask + 1));
+
+    for (int64 seq = state->head; seq < state->tail; seq++) fixes[seq & mask] = state->fixes[seq & state->mask];
+    pfree(state->fixes);
+    state->fixes = fixes;
+
+    for (int r = 0; r < NUM_RATES; r++) {
+        AISRateDeque *dq = &state->max[r];
+        int64 *seq = MemoryContextAlloc(GetMemoryChunkContext(dq->seq), sizeof(int64) * (mask + 1));
+
+        for (int64 pos = dq->head; pos < dq->tail; pos++) seq[pos & mask] = dq->seq[pos & state->mask];
+        pfree(dq->seq);
+        dq->seq = seq;
+    }
+    state->mask = mask;
+}
+
+
+/**
+ * @brief Rate of a fix by sequence number
+ */
+static inline float8 kinematics_rate(const AISKinematicsState *state, int64 seq, int r) {
+    return state->fixes[seq & state->mask].rate[r];
+}
+
+
+/**
+ * @brief Add a fix after the newest one
+ *
+ * Implied speed needs a positive time step and turn rate also both
+ * courses; otherwise the segment still counts towards the distance.
+ */
+static void kinematics_push(AISKinematicsState *state, const AISTrackPoint *point) {
+    AISKinematicsFix fix = {.point = *point, .distance = 0, .rate = {-1, -1}};
+
+    if (state->tail > state->head) {
+        const AISTrackPoint *prev = &state->fixes[(state->tail - 1) & state->mask].point;
+        double metres = ais_track_distance(prev, point);
+        int32 turn = ais_track_turn(prev, point);
+        int64 dt = point->t - prev->t;
+
+        fix.distance = (int64) rint(metres * 1000.0);
+        if (dt > 0) {
+            fix.rate[RATE_IMPLIED_SPEED] = metres / METRES_PER_NM / (dt / MS_PER_HOUR);
+            if (turn >= 0) fix.rate[RATE_TURN] = turn / 10.0 / (dt / 60000.0);
+        }
+        state->distance += fix.distance;
+    } else {
+        state->t_first = point->t;
+    }
+
+    /* The plain form never removes fixes, so it keeps only the last one and the maxima */
+    if (state->moving && state->tail - state->head > state->mask) kinematics_state_grow(state);
+    state->fixes[state->tail & state->mask] = fix;
+    for (int r = 0; r < NUM_RATES; r++) {
+        AISRateDeque *dq = &state->max[r];
+
+        if (!state->moving) {
+            state->top[r] = Max(state->top[r], fix.rate[r]);
+            continue;
+        }
+        if (fix.rate[r] < 0) continue;
+        while (dq->tail > dq->head && kinematics_rate(state, dq->seq[(dq->tail - 1) & state->mask], r) <= fix.rate[r])
+            dq->tail--;
+        dq->seq[dq->tail++ & state->mask] = state->tail;
+    }
+    state->tail++;
+}
+
+
+/**
+ * @brief Remove the oldest fix and the segment leaving it
+ */
+static void kinematics_pop(AISKinematicsState *state) {
+    if (state->tail == state->head) return;
+
+    state->head++;
+    if (state->head == state->tail) {
+        state->distance = 0;
+        for (int r = 0; r < NUM_RATES; r++) state->max[r].head = state->max[r].tail = 0;
+        return;
+    }
+
+    /* The new oldest fix no longer has its incoming segment in the window */
+    const AISKinematicsFix *first = &state->fixes[state->head & state->mask];
+    state->distance -= first->distance;
+    state->t_first = first->point.t;
+    for (int r = 0; r < NUM_RATES; r++) {
+        AISRateDeque *dq = &state->max[r];
+
+        while (dq->tail > dq->head && dq->seq[dq->head & state->mask] <= state->head) dq->head++;
+    }
+}
+
+
+/**
+ * @brief Maximum of a rate over the counted segments, or -1 if none
+ */
+static float8 kinematics_max(const AISKinematicsState *state, int r) {
+    const AISRateDeque *dq = &state->max[r];
+
+    if (!state->moving) return state->top[r];
+    return dq->tail > dq->head ? kinematics_rate(state, dq->seq[dq->head & state->mask], r) : -1;
+}
+
+
+/**
+ * @brief Shared transition of the plain and moving forms
+ *
+ * The state is created on the first row even if it has no position, so
+ * the inverse transition never meets a NULL state.
+ */
+static Datum kinematics_transfn(FunctionCallInfo fcinfo, bool moving) {
+    MemoryContext aggcontext = track_agg_context(fcinfo);
+    AISKinematicsState *state = PG_ARGISNULL(0) ? NULL : (AISKinematicsState *) PG_GETARG_POINTER(0);
+    AISTrackPoint point;
+    uint32 mmsi;
+
+    if (state == NULL) state = kinematics_state_create(aggcontext, moving);
+    if (!track_input_point(fcinfo, &point, &mmsi)) PG_RETURN_POINTER(state);
+
+    if (!state->has_mmsi) {
+        state->mmsi = mmsi;
+        state->has_mmsi = true;
+    } else if (mmsi != state->mmsi) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("kinematics aggregate input mixes MMSI %u and %u", state->mmsi, mmsi),
+                 errhint("Partition the window by MMSI.")));
+    }
+    kinematics_push(state, &point);
+    PG_RETURN_POINTER(state);
+}
+
+
+/**
+ * @brief pg_ais_kinematics transition: add one message's position
+ *
+ * Rows must arrive in time order; messages without a position or a time
+ * are skipped.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_kinematics_transfn);
+Datum
+pg_ais_kinematics_transfn(PG_FUNCTION_ARGS) {
+    return kinematics_transfn(fcinfo, false);
+}
+
+
+/**
+ * @brief pg_ais_kinematics moving-aggregate transition: add one message's position
+ *
+ * Keeps the fixes of the window frame and a monotonic deque per rate, so a
+ * sliding frame costs amortised O(1) per row.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_kinematics_moving_transfn);
+Datum
+pg_ais_kinematics_moving_transfn(PG_FUNCTION_ARGS) {
+    return kinematics_transfn(fcinfo, true);
+}
+
+
+/**
+ * @brief pg_ais_kinematics inverse transition: drop the oldest row of the frame
+ *
+ * The window machinery removes rows in the order they were added, so the
+ * row leaving is the oldest fix unless it was skipped on the way in.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_kinematics_inverse_transfn);
+Datum
+pg_ais_kinematics_inverse_transfn(PG_FUNCTION_ARGS) {
+    AISTrackPoint point;
+    uint32 mmsi;
+
+    track_agg_context(fcinfo);
+    if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+
+    AISKinematicsState *state = (AISKinematicsState *) PG_GETARG_POINTER(0);
+    if (track_input_point(fcinfo, &point, &mmsi)) kinematics_pop(state);
+    PG_RETURN_POINTER(state);
+}
+
+
+/**
+ * @brief pg_ais_kinematics final function: build the ais_kinematics row
+ *
+ * Returns NULL when no row had a position and a time. Rates are NULL
+ * without a segment that defines them.
+ */
+PG_FUNCTION_INFO_V1(pg_ais_kinematics_finalfn);
+Datum
+pg_ais_kinematics_finalfn(PG_FUNCTION_ARGS) {
+    TupleDesc tupdesc;
+    Datum values[K_NUM_COLUMNS];
+    bool nulls[K_NUM_COLUMNS] = {0};
+
+    if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+    AISKinematicsState *state = (AISKinematicsState *) PG_GETARG_POINTER(0);
+    if (state->tail == state->head) PG_RETURN_NULL();
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        ereport(ERROR, (errmsg("return type must be a row type")));
+
+    const AISTrackPoint *last = &state->fixes[(state->tail - 1) & state->mask].point;
+    double metres = state->distance / 1000.0;
+    int64 elapsed = last->t - state->t_first;
+
+    values[K_FIXES] = Int32GetDatum((int32) (state->tail - state->head));
+    values[K_DISTANCE] = Float8GetDatum(metres);
+    values[K_AVG_SPEED] = Float8GetDatum(elapsed > 0 ? metres / METRES_PER_NM / (elapsed / MS_PER_HOUR) : 0);
+    nulls[K_AVG_SPEED] = elapsed <= 0;
+    for (int r = 0; r < NUM_RATES; r++) {
+        int column = r == RATE_TURN ? K_MAX_TURN_RATE : K_MAX_IMPLIED_SPEED;
+        float8 max = kinematics_max(state, r);
+
+        values[column] = Float8GetDatum(max);
+        nulls[column] = max < 0;
+    }
+    PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(BlessTupleDesc(tupdesc), values, nulls)));
+}
+
+
+/**
+ * @brief MMSI of a track
+ *
+ * Usage: SELECT pg_ais_track_mmsi(track);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_track_mmsi);
+Datum
+pg_ais_track_mmsi(PG_FUNCTION_ARGS) {
+    AISTrack *track = PG_GETARG_AIS_TRACK_HEADER(0);
+    PG_RETURN_INT32((int32) track->mmsi);
+}
+
+
+/**
+ * @brief Number of points in a track
+ *
+ * Reads only the header of a toasted track.
+ *
+ * Usage: SELECT pg_ais_track_length(track);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_track_length);
+Datum
+pg_ais_track_length(PG_FUNCTION_ARGS) {
+    AISTrack *track = PG_GETARG_AIS_TRACK_HEADER(0);
+    PG_RETURN_INT32(track->npoints);
+}
+
+
+/**
+ * @brief Bounding box of a track (x = longitude, y = latitude)
+ *
+ * Usage: SELECT pg_ais_track_bbox(track);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_track_bbox);
+Datum
+pg_ais_track_bbox(PG_FUNCTION_ARGS) {
+    AISTrack *track = PG_GETARG_AIS_TRACK_HEADER(0);
+    BOX *box = palloc(sizeof(BOX));
+
+    box->low.x = (double) track->lon_min / AIS_COORD_SCALE;
+    box->low.y = (double) track->lat_min / AIS_COORD_SCALE;
+    box->high.x = (double) track->lon_max / AIS_COORD_SCALE;
+    box->high.y = (double) track->lat_max / AIS_COORD_SCALE;
+    PG_RETURN_BOX_P(box);
+}
+
+
+/**
+ * @brief Time range covered by a track, both ends inclusive
+ *
+ * Usage: SELECT pg_ais_track_time_range(track);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_track_time_range);
+Datum
+pg_ais_track_time_range(PG_FUNCTION_ARGS) {
+    AISTrack *track = PG_GETARG_AIS_TRACK_HEADER(0);
+    TypeCacheEntry *typcache = lookup_type_cache(TSTZRANGEOID, TYPECACHE_RANGE_INFO);
+    RangeBound lower, upper;
+
+    lower.val = TimestampTzGetDatum(track->t_min * 1000);
+    lower.infinite = false;
+    lower.inclusive = true;
+    lower.lower = true;
+    upper.val = TimestampTzGetDatum(track->t_max * 1000);
+    upper.infinite = false;
+    upper.inclusive = true;
+    upper.lower = false;
+    PG_RETURN_RANGE_P(make_range(typcache, &lower, &upper, false));
+}
+
+
+/**
+ * @brief Expand a track into its points, in aggregation order
+ *
+ * Speed and course are NULL where the message did not report them.
+ *
+ * Usage: SELECT * FROM pg_ais_track_points(track);
+ */
+PG_FUNCTION_INFO_V1(pg_ais_track_points);
+Datum
+pg_ais_track_points(PG_FUNCTION_ARGS) {
+    ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    AISTrack *track = PG_GETARG_AIS_TRACK_P(0);
+    AISTrackPoint point = {0};
+    TupleDesc tupdesc;
+
+    if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo) || (rsinfo->allowedModes & SFRM_Materialize) == 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("set-valued function called in context that cannot accept a set")));
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        ereport(ERROR, (errmsg("return type must be a row type")));
+
+    MemoryContext oldcxt = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+    Tuplestorestate *tupstore = tuplestore_begin_heap(true, false, work_mem);
+    rsinfo->returnMode = SFRM_Materialize;
+    rsinfo->setResult = tupstore;
+    rsinfo->setDesc = CreateTupleDescCopy(tupdesc);
+    MemoryContextSwitchTo(oldcxt);
+
+    const uint8 *pos = track->data;
+    const uint8 *end = (const uint8 *) track + VARSIZE(track);
+    for (int32 i = 0; i < track->npoints; i++) {
+        Datum values[P_NUM_COLUMNS];
+        bool nulls[P_NUM_COLUMNS] = {false};
+
+        if (!ais_track_decode_point(&pos, end, &point))
+            ereport(ERROR, (errcode(ERRCODE_DATA_CORRUPTED), errmsg("corrupted ais_track value")));
+
+        values[P_TS] = TimestampTzGetDatum(point.t * 1000);
+        values[P_LAT] = Float8GetDatum((double) point.lat / AIS_COORD_SCALE);
+        values[P_LON] = Float8GetDatum((double) point.lon / AIS_COORD_SCALE);
+        values[P_SPEED] = Float8GetDatum(point.speed / 10.0);
+        nulls[P_SPEED] = point.speed < 0;
+        values[P_COURSE] = Float8GetDatum(point.course / 10.0);
+        nulls[P_COURSE] = point.course < 0;
+        tuplestore_putvalues(tupstore, rsinfo->setDesc, values, nulls);
+    }
+    return (Datum) 0;
+}
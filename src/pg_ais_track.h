@@ -0,0 +1,146 @@
+#ifndef PG_AIS_TRACK_H
+#define PG_AIS_TRACK_H
+
+#include "postgres.h"
+#include "fmgr.h"
+
+#include "ais_track.h"
+
+
+/* Layout version stored in every ais_track */
+#define AIS_TRACK_VERSION 1
+
+
+/**
+ * @brief ais_track varlena: one vessel's points, delta and varint encoded
+ *
+ * The fixed header carries everything the summary accessors need, so they
+ * only fetch a slice of a toasted value. Times are kept to the millisecond.
+ */
+typedef struct {
+    int32 vl_len_;             /* varlena header */
+    uint32 version;
+    uint32 mmsi;
+    int32 npoints;
+    int32 lon_min;             /* bounding box, fixed point */
+    int32 lat_min;
+    int32 lon_max;
+    int32 lat_max;
+    int64 t_min;               /* time range, milliseconds since 2000-01-01 */
+    int64 t_max;
+    uint8 data[FLEXIBLE_ARRAY_MEMBER];  /* AISTrackPoint deltas */
+} AISTrack;
+
+#define AIS_TRACK_HEADER_SIZE offsetof(AISTrack, data)
+
+#define DatumGetAisTrackP(d) ((AISTrack *) PG_DETOAST_DATUM(d))
+#define PG_GETARG_AIS_TRACK_P(n) DatumGetAisTrackP(PG_GETARG_DATUM(n))
+
+/* Header only, without detoasting the points */
+#define PG_GETARG_AIS_TRACK_HEADER(n) \
+    ((AISTrack *) PG_DETOAST_DATUM_SLICE(PG_GETARG_DATUM(n), 0, AIS_TRACK_HEADER_SIZE))
+
+
+/**
+ * @brief Input function of ais_track: hex of the encoded track
+ */
+PGDLLEXPORT Datum ais_track_in(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Output function of ais_track: hex of the encoded track
+ */
+PGDLLEXPORT Datum ais_track_out(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief pg_ais_track_agg transition: append one message's position
+ */
+PGDLLEXPORT Datum pg_ais_track_agg_transfn(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief pg_ais_track_agg final function: build the ais_track
+ */
+PGDLLEXPORT Datum pg_ais_track_agg_finalfn(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief pg_ais_track_simplify_agg transition: keep only informative points
+ */
+PGDLLEXPORT Datum pg_ais_track_simplify_transfn(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief pg_ais_track_simplify_agg final function: add the last point
+ */
+PGDLLEXPORT Datum pg_ais_track_simplify_finalfn(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief pg_ais_kinematics transition: add one message's position
+ */
+PGDLLEXPORT Datum pg_ais_kinematics_transfn(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief pg_ais_kinematics moving-aggregate transition: add one message's position
+ */
+PGDLLEXPORT Datum pg_ais_kinematics_moving_transfn(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief pg_ais_kinematics inverse transition: drop the oldest row of the frame
+ */
+PGDLLEXPORT Datum pg_ais_kinematics_inverse_transfn(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief pg_ais_kinematics final function: build the ais_kinematics row
+ *
+ * Usage: SELECT pg_ais_kinematics(sentence, ts) OVER (PARTITION BY mmsi ORDER BY ts
+ *                ROWS BETWEEN 10 PRECEDING AND CURRENT ROW) FROM positions;
+ */
+PGDLLEXPORT Datum pg_ais_kinematics_finalfn(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief MMSI of a track
+ *
+ * Usage: SELECT pg_ais_track_mmsi(track);
+ */
+PGDLLEXPORT Datum pg_ais_track_mmsi(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Number of points in a track
+ *
+ * Usage: SELECT pg_ais_track_length(track);
+ */
+PGDLLEXPORT Datum pg_ais_track_length(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Bounding box of a track (x = longitude, y = latitude)
+ *
+ * Usage: SELECT pg_ais_track_bbox(track);
+ */
+PGDLLEXPORT Datum pg_ais_track_bbox(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Time range covered by a track
+ *
+ * Usage: SELECT pg_ais_track_time_range(track);
+ */
+PGDLLEXPORT Datum pg_ais_track_time_range(PG_FUNCTION_ARGS);
+
+
+/**
+ * @brief Expand a track into its points
+ *
+ * Usage: SELECT * FROM pg_ais_track_points(track);
+ */
+PGDLLEXPORT Datum pg_ais_track_points(PG_FUNCTION_ARGS);
+
+#endif
@@ -1,5 +1,6 @@
 #include "bitfield.h"
 #include "pg_ais.h"
+#include "ais_core.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
@@ -48,7 +49,7 @@ bool parse_bin_payload(const char *payload, int start, int len_bits, char **out,
 
     for (int i = 0; i < num_bytes; i++) {
         uint32_t val;
-        if (!parse_uint_safe(payload, start + i * 8, 8, &val)) {
+        if (parse_uint_safe(payload, start + i * 8, 8, &val).code != PARSE_OK) {
             free(buf);
             return false;
         }
@@ -58,4 +59,31 @@ bool parse_bin_payload(const char *payload, int start, int len_bits, char **out,
     *out = buf;
     *out_len = num_bytes;
     return true;
-}
\ No newline at end of file
+}
+
+
+/**
+ * @brief Free heap-allocated components of an AISMessage struct
+ *
+ * Releases memory from dynamic fields (callsign, vessel_name, destination, bin_data).
+ *
+ * @param msg Pointer to AISMessage with heap fields to release
+ */
+void free_ais_message(AISMessage *msg) {
+    if (msg->callsign) {
+        free(msg->callsign);
+        msg->callsign = NULL;
+    }
+    if (msg->vessel_name) {
+        free(msg->vessel_name);
+        msg->vessel_name = NULL;
+    }
+    if (msg->destination) {
+        free(msg->destination);
+        msg->destination = NULL;
+    }
+    if (msg->bin_data) {
+        free(msg->bin_data);
+        msg->bin_data = NULL;
+    }
+}
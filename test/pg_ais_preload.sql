@@ -0,0 +1,72 @@
+-- Features that need pg_ais in shared_preload_libraries; see pg_ais_preload.conf
+CREATE EXTENSION IF NOT EXISTS pg_ais;
+
+-- Poll a condition for up to a minute, re-reading pg_stat_activity each time
+CREATE FUNCTION pg_ais_test_wait(condition text) RETURNS boolean
+LANGUAGE plpgsql AS $$
+DECLARE
+    ok boolean;
+BEGIN
+    FOR i IN 1..600 LOOP
+        PERFORM pg_stat_clear_snapshot();
+        EXECUTE 'SELECT ' || condition INTO ok;
+        IF ok THEN
+            RETURN true;
+        END IF;
+        PERFORM pg_sleep(0.1);
+    END LOOP;
+    RETURN false;
+END $$;
+
+-- FIFO ingest: the worker connects once this database exists and creates the FIFO
+CREATE TABLE ais_ingest (type integer, mmsi integer, vessel_name text, receive_time timestamptz, sentence text);
+SELECT pg_ais_test_wait($$EXISTS (SELECT FROM pg_stat_activity WHERE backend_type = 'pg_ais ingest')
+                          AND (pg_stat_file('/tmp/pg_ais_preload.fifo', true)).size IS NOT NULL$$) AS worker_ready;
+COPY (SELECT line FROM (
+  VALUES (1, '\c:1717200000*5B\!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'),
+       (2, '!AIVDM,2,1,3,A,53`l7@02A9IU0@48000pu8@T>1A84@E800000016BhN<>5V>NEDSm51DQ0C@,0*78'),
+       (3, '!AIVDM,2,2,3,A,00000000000,2*27'),
+       (4, '!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*09'),
+       (5, '!AIVDM,1,1,,A,H52K5MA<D61=@58000000000000,2*16')) AS v(n, line) ORDER BY n)
+TO '/tmp/pg_ais_preload.fifo' WITH (FORMAT csv, DELIMITER E'\t', QUOTE '|');
+SELECT pg_ais_test_wait('(SELECT count(*) FROM ais_ingest) >= 3') AS ingested;
+SELECT type, mmsi, vessel_name, extract(epoch FROM receive_time)::bigint - 1717200000 AS seconds,
+       sentence IS NULL AS reassembled
+FROM ais_ingest ORDER BY type;
+SELECT metric, value FROM pg_stat_ais WHERE metric IN ('sentences', 'bad_checksum') ORDER BY metric;
+
+-- Vessel state cache: committed ingest rows are stored at their tag block time
+SELECT pg_ais_test_wait('(pg_ais_vessel_state(366437922)).lat IS NOT NULL') AS cached;
+SELECT lat, heading, type, updated_at = to_timestamp(1717200000) AS at_tag_time
+FROM pg_ais_vessel_state(366437922);
+
+-- An older report is rejected, a newer one replaces the state
+SELECT pg_ais_vessel_state_update('!AIVDM,1,1,,A,15MMV8U000p3MAh8UD@<69b`01A5,0*23', to_timestamp(1717199000)) AS stale;
+SELECT lat, updated_at = to_timestamp(1717200000) AS unchanged FROM pg_ais_vessel_state(366437922);
+SELECT pg_ais_vessel_state_update('!AIVDM,1,1,,A,15MMV8U000p3MAh8UD@<69b`01A5,0*23', to_timestamp(1717201000)) AS newer;
+SELECT lat, updated_at = to_timestamp(1717201000) AS updated FROM pg_ais_vessel_state(366437922);
+
+-- Static data dictionary: committed ingest rows are merged
+SELECT pg_ais_test_wait('pg_ais_vessel_name(244123456) IS NOT NULL AND pg_ais_vessel_name(338085237) IS NOT NULL') AS merged;
+SELECT pg_ais_vessel_name(244123456) AS type5, pg_ais_vessel_name(338085237) AS type24a;
+
+-- Type 5, then type 24 parts A and B: newer reports replace the fields they carry
+SELECT pg_ais_static_update(ARRAY['!AIVDM,2,1,7,A,539>Jh@2<r8L@48?400HU9=B0p4lD00000000016<PD8<0000@B0C@UDQh00,0*3B',
+                                   '!AIVDM,2,2,7,A,00000000000,2*23']::ais[],
+                            to_timestamp(1717200000)) AS type5;
+SELECT pg_ais_static_update('!AIVDM,1,1,,A,H39>JhA<D<tpB0p4lD000000000,2*55'::ais, to_timestamp(1717200100)) AS part_a;
+SELECT pg_ais_static_update('!AIVDM,1,1,,B,H39>JhDU000000042jklm01@5230,0*19'::ais, to_timestamp(1717200200)) AS part_b;
+SELECT imo, vessel_name, callsign, ship_type, to_bow, to_stern, to_port, to_starboard, destination,
+       updated_at = to_timestamp(1717200200) AS at_part_b
+FROM pg_ais_static_data(211000001);
+
+-- An older report does not overwrite newer data, but fills fields not seen yet
+SELECT pg_ais_static_update(ARRAY['!AIVDM,2,1,7,A,539>Jh@2<r8L@48?400HU9=B0p4lD00000000016<PD8<0000@B0C@UDQh00,0*3B',
+                                   '!AIVDM,2,2,7,A,00000000000,2*23']::ais[],
+                            to_timestamp(1717100000)) AS stale;
+SELECT vessel_name, callsign, ship_type, updated_at = to_timestamp(1717200200) AS unchanged
+FROM pg_ais_static_data(211000001);
+SELECT pg_ais_static_update('!AIVDM,1,1,,B,H39>JhTT000000043klmn00p3120,0*38'::ais, to_timestamp(1717200200)) AS part_b;
+SELECT pg_ais_static_update('!AIVDM,1,1,,A,H39>JhPh5@F0p4lD00000000000,2*1D'::ais, to_timestamp(1717200100)) AS late_part_a;
+SELECT vessel_name, callsign, updated_at = to_timestamp(1717200200) AS unchanged
+FROM pg_ais_static_data(211000002);
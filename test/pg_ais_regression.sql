@@ -67,7 +67,199 @@ SELECT pg_ais_get_bool_field(sentence, 'accuracy') FROM test_text_field;
 SELECT pg_ais_get_bool_field(sentence, 'foobar') FROM test_text_field;
 
 
--- Metrics collection
-SELECT * FROM pg_ais_metrics();
+-- Metrics collection: earlier statements were counted too, so start from a reset
 SELECT pg_ais_reset_metrics();
 SELECT * FROM pg_ais_metrics();
+SELECT pg_ais_parse_full('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08') IS NOT NULL AS decoded;
+SELECT metric, label, value FROM pg_stat_ais WHERE value > 0;
+SELECT count(*) AS counters FROM pg_stat_ais;
+SELECT count(*) AS timed FROM pg_ais_timing();
+SET pg_ais.track_timing = on;
+SELECT pg_ais_parse_full('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08') IS NOT NULL AS decoded;
+SELECT stage, type, count FROM pg_ais_timing() ORDER BY stage, type;
+RESET pg_ais.track_timing;
+SELECT line FROM regexp_split_to_table(pg_ais_metrics_prometheus(), E'\n') AS line
+WHERE line LIKE 'pg_ais_decoded_total{type="1"}%' OR line LIKE 'pg_ais_stage_duration_seconds_count%';
+
+
+-- Space-filling curve keys and BRIN box operator
+SELECT pg_ais_zorder('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais) > 0 AS has_key;
+SELECT '!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais <@ box '((-112,15),(-111,16))' AS inside;
+SELECT '!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais <@ box '((-71,42),(-70,43))' AS inside;
+SELECT pg_ais_in_bbox('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais, -112, 15, -111, 16) AS inside,
+       pg_ais_in_bbox('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais, 170, 15, -170, 16) AS across_antimeridian;
+SELECT pg_ais_in_bbox(ARRAY['!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08', NULL,
+                            '!AIVDM,1,1,,B,55NBsv02>tNDBL@E,0*00']::ais[], -112, 15, -111, 16) AS batch;
+SELECT pg_ais_geohash('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais, 7) AS geohash,
+       pg_ais_grid_cell('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais, 16) AS cell,
+       pg_ais_grid_parent(pg_ais_grid_cell('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais, 16), 8) AS parent;
+SELECT encode(pg_ais_ewkb('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais), 'hex') AS ewkb;
+
+-- Payload equality ignores channel and sequence id
+SELECT '!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais = '!AIVDM,1,1,,B,15MMV8U000p3MAh8uu2t69b`01A5,0*0B'::ais AS same_payload;
+SELECT pg_ais_hash64('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais) = pg_ais_hash64('!AIVDM,1,1,,B,15MMV8U000p3MAh8uu2t69b`01A5,0*0B'::ais) AS same_hash;
+
+-- Fingerprints ignore the receiver; a multipart message needs all of its fragments
+SELECT pg_ais_fingerprint('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais) = pg_ais_fingerprint('!AIVDM,1,1,,B,15MMV8U000p3MAh8uu2t69b`01A5,0*0B'::ais) AS same_fingerprint,
+       pg_ais_fingerprint('!AIVDM,2,1,2,B,53aGowP000001@D;E@E=:qD00000,0*00'::ais) IS NULL AS fragment_alone;
+SELECT pg_ais_fingerprint(ARRAY['!AIVDM,2,2,2,B,00000000000,2*25', '!AIVDM,2,1,2,B,53aGowP000001@D;E@E=:qD00000,0*00']::ais[]) =
+       pg_ais_fingerprint(ARRAY['!AIVDM,2,1,9,A,53aGowP000001@D;E@E=:qD00000,0*08', '!AIVDM,2,2,9,A,00000000000,2*2D']::ais[]) AS same_message,
+       pg_ais_fingerprint(ARRAY['!AIVDM,2,1,2,B,53aGowP000001@D;E@E=:qD00000,0*00', '!AIVDM,2,2,9,B,00000000000,2*2E']::ais[]) IS NULL AS mixed_ids,
+       pg_ais_fingerprint(ARRAY['!AIVDM,2,1,2,B,53aGowP000001@D;E@E=:qD00000,0*00', '!AIVDM,2,2,2,A,00000000000,2*26']::ais[]) IS NULL AS mixed_channels,
+       pg_ais_fingerprint(ARRAY['!AIVDM,2,1,2,B,53aGowP000001@D;E@E=:qD00000,0*00']::ais[]) IS NULL AS incomplete;
+SELECT pg_ais_fingerprint(s, '2024-06-01 00:00:10+00', '1 minute') = pg_ais_fingerprint(s, '2024-06-01 00:00:50+00', '1 minute') AS same_bucket,
+       pg_ais_fingerprint(s, '2024-06-01 00:00:50+00', '1 minute') = pg_ais_fingerprint(s, '2024-06-01 00:01:10+00', '1 minute') AS next_bucket
+FROM (SELECT '!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais AS s) t;
+
+-- Typed projection: fields a type does not carry are NULL
+SELECT (f).mmsi, (f).callsign IS NULL AS no_callsign
+FROM (SELECT pg_ais_fields('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08') AS f) s;
+-- Class B static reports: each type and part has its own columns; text input works too
+SELECT (f).type, (f).mmsi, (f).vessel_name, (f).callsign, (f).ship_type, (f).lat IS NULL AS no_lat, (f).radio IS NULL AS no_radio
+FROM (SELECT n, pg_ais_fields(s) AS f
+      FROM (VALUES (1, '!AIVDM,1,1,,B,C5Mwqlh0==ks:05J4L0p@e?0@2T4NU0PBHN`00000000I0h41QRP,0*59'::text),
+                   (2, '!AIVDM,1,1,,A,H52K5MA<D61=@58000000000000,2*16'),
+                   (3, '!AIVDM,1,1,,A,H52K5MDU13=5000G45ijkl188330,0*32')) AS v(n, s)) t
+ORDER BY n;
+-- Type 5 voyage data
+SELECT j->>'destination' AS destination, j->'draught' AS draught, j->'ship_type' AS ship_type, j->'fix_type' AS fix_type
+FROM (SELECT pg_ais_parse_full(ARRAY['!AIVDM,2,1,3,A,53`l7@02A9IU0@48000pu8@T>1A84@E800000016BhN<>5V>NEDSm51DQ0C@,0*78',
+                                     '!AIVDM,2,2,3,A,00000000000,2*27']::ais[]) AS j) s;
+
+-- JSONB output carries native numbers; unavailable values are null
+SELECT j->'mmsi' AS mmsi, jsonb_typeof(j->'speed') AS speed_type, j->'lat' AS lat, j->'heading' AS heading
+FROM (SELECT pg_ais_parse_full('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08') AS j) s;
+
+-- NMEA 4.0 tag blocks: station, receive time and line count
+SELECT pg_ais_station(s), extract(epoch FROM pg_ais_receive_time(s)) AS receive_time, pg_ais_line_count(s),
+       (pg_ais_fields(s)).mmsi, (pg_ais_fields(s)).station AS field_station
+FROM (SELECT '\s:station42,c:1718000000,n:17*31\!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais AS s) t;
+SELECT pg_ais_station('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08') IS NULL AS untagged;
+
+-- Sorted batch inserts: physical row order follows (mmsi, receive time) or the Z-order key
+COPY (SELECT line FROM (
+  VALUES (1, '\c:1717200040*5F\!AIVDM,1,1,,A,H52K5MA<D61=@58000000000000,2*16'),
+       (2, '\c:1717200030*58\!AIVDM,1,1,,A,10001;001TPeid0LW3P3Q2lt0000,0*70'),
+       (3, '\c:1717200020*59\!AIVDM,1,1,,A,10000I001TrwT<0Fpn03Q2lt0000,0*46'),
+       (4, '\c:1717200010*5A\!AIVDM,1,1,,A,10001;001TPf>w0Lbep3Q2lt0000,0*74'),
+       (5, '\c:1717200000*5B\!AIVDM,1,1,,A,10000j001Tb0o`1fmGP3Q2lt0000,0*20'),
+       (6, '\c:1717200010*5A\!AIVDM,1,1,,A,10000I001Trw6q0FtPH3Q2lt0000,0*2B')) AS v(n, line) ORDER BY n)
+TO '/tmp/pg_ais_sort_test.nmea' WITH (FORMAT csv, DELIMITER E'\t', QUOTE '|');
+CREATE TABLE sorted_ais (mmsi integer, receive_time timestamptz, lon double precision, lat double precision);
+SELECT rows, sentences FROM pg_ais_load_file('/tmp/pg_ais_sort_test.nmea', 'sorted_ais', 100, 'mmsi_time');
+SELECT mmsi, extract(epoch FROM receive_time)::bigint - 1717200000 AS seconds, lat IS NULL AS no_position
+FROM sorted_ais ORDER BY ctid;
+TRUNCATE sorted_ais;
+SELECT rows, sentences FROM pg_ais_load_file('/tmp/pg_ais_sort_test.nmea', 'sorted_ais', 100, 'spatial');
+SELECT mmsi, extract(epoch FROM receive_time)::bigint - 1717200000 AS seconds, lat IS NULL AS no_position
+FROM sorted_ais ORDER BY ctid;
+DROP TABLE sorted_ais;
+-- Bulk load: valid, reassembled, undecodable and rejected lines are counted separately
+COPY (SELECT line FROM (
+  VALUES (1, '# receiver restarted'),
+       (2, '!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'),
+       (3, '!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*09'),
+       (4, '!AIVDM,1,1,,A,,0*26'),
+       (5, '!AIVDM,1,1,,A,15Muq60001G?tTpE>Gbk0?wN0<0,0*4B'),
+       (6, '!AIVDM,2,1,3,A,53`l7@02A9IU0@48000pu8@T>1A84@E800000016BhN<>5V>NEDSm51DQ0C@,0*78'),
+       (7, '!AIVDM,2,2,3,A,00000000000,2*27'),
+       (8, '!AIVDM,2,1,7,B,53aGowP000001@D;E@E=:qD00000,0*05'),
+       (9, '!AIVDM,1,1,,A,H52K5MA<D61=@58000000000000,2*16')) AS v(n, line) ORDER BY n)
+TO '/tmp/pg_ais_load_test.nmea' WITH (FORMAT csv, DELIMITER E'\t', QUOTE '|');
+CREATE TABLE loaded_ais (type integer, mmsi integer, vessel_name text, sentence ais);
+SELECT * FROM pg_ais_load_file('/tmp/pg_ais_load_test.nmea', 'loaded_ais');
+SELECT type, mmsi, vessel_name, sentence IS NULL AS reassembled FROM loaded_ais ORDER BY type;
+DROP TABLE loaded_ais;
+-- Foreign tables over log files: header filters run before decoding, undecodable messages keep their header
+COPY (SELECT line FROM (
+  VALUES (1, '!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'),
+       (2, '!AIVDM,2,1,3,A,53`l7@02A9IU0@48000pu8@T>1A84@E800000016BhN<>5V>NEDSm51DQ0C@,0*78'),
+       (3, '!AIVDM,2,2,3,A,00000000000,2*27'),
+       (4, '!AIVDM,1,1,,A,15Muq60001G?tTpE>Gbk0?wN0<0,0*4B')) AS v(n, line) ORDER BY n)
+TO '/tmp/pg_ais_fdw_a.aisfdw' WITH (FORMAT csv, DELIMITER E'\t', QUOTE '|');
+COPY (SELECT line FROM (
+  VALUES (1, '\s:rx1*72\!AIVDM,1,1,,A,H52K5MA<D61=@58000000000000,2*16'),
+       (2, '!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*09')) AS v(n, line) ORDER BY n)
+TO '/tmp/pg_ais_fdw_b.aisfdw' WITH (FORMAT csv, DELIMITER E'\t', QUOTE '|');
+CREATE SERVER pg_ais_test_logs FOREIGN DATA WRAPPER pg_ais_fdw;
+CREATE FOREIGN TABLE ais_log_test (
+  type integer,
+  mmsi integer,
+  lat double precision,
+  lon double precision,
+  speed double precision,
+  vessel_name text,
+  station text,
+  filename text
+) SERVER pg_ais_test_logs OPTIONS (directory '/tmp', suffix '.aisfdw');
+SELECT filename, type, mmsi, round(lat::numeric, 5) AS lat, speed, vessel_name, station
+FROM ais_log_test ORDER BY filename, type, mmsi;
+SELECT mmsi FROM ais_log_test WHERE type IN (5, 24) ORDER BY mmsi;
+SELECT mmsi FROM ais_log_test WHERE lat BETWEEN 15 AND 16 AND lon BETWEEN -112 AND -111;
+SELECT type, mmsi, speed IS NULL AS no_speed, lat IS NOT NULL AS has_position
+FROM ais_log_test WHERE mmsi = 366967064;
+SELECT count(*) AS messages, count(speed) AS decoded_speeds FROM ais_log_test;
+DROP FOREIGN TABLE ais_log_test;
+DROP SERVER pg_ais_test_logs;
+
+-- The ingest pipeline only runs when preloaded and configured
+SELECT count(*) AS pipeline_rings FROM pg_ais_ingest_stats();
+
+-- The vessel state cache is disabled unless preloaded with a size
+SELECT pg_ais_vessel_state_update('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08') AS cached,
+       (pg_ais_vessel_state(366437922)).lat IS NULL AS unknown;
+
+-- The static data dictionary is disabled unless preloaded with a size
+SELECT pg_ais_static_update('!AIVDM,1,1,,A,H52K5MA<D61=@58000000000000,2*16'::ais) AS merged,
+       pg_ais_vessel_name(338085237) IS NULL AS unknown,
+       pg_ais_static_snapshot() IS NULL AS no_snapshot;
+
+-- Track aggregate: delta-encoded positions of one vessel, surviving a text round trip
+WITH t AS (
+  SELECT pg_ais_track_agg(sentence, ts ORDER BY ts) AS track
+  FROM (VALUES ('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais, '2024-06-01 00:00:00+00'::timestamptz),
+               ('!AIVDM,1,1,,B,15MMV8U000p3MAh8uu2t69b`01A5,0*0B'::ais, '2024-06-01 00:00:10+00')) AS v(sentence, ts)
+)
+SELECT pg_ais_track_mmsi(track) AS mmsi, pg_ais_track_length(track::text::ais_track) AS points,
+       extract(epoch FROM upper(pg_ais_track_time_range(track)) - lower(pg_ais_track_time_range(track)))::integer AS seconds
+FROM t;
+WITH t AS (
+  SELECT pg_ais_track_agg(sentence, ts ORDER BY ts) AS track
+  FROM (VALUES ('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais, '2024-06-01 00:00:00+00'::timestamptz),
+               ('!AIVDM,1,1,,B,15MMV8U000p3MAh8uu2t69b`01A5,0*0B'::ais, '2024-06-01 00:00:10+00')) AS v(sentence, ts)
+)
+SELECT extract(epoch FROM p.ts)::bigint AS epoch, round(p.lat::numeric, 5) AS lat, round(p.lon::numeric, 5) AS lon,
+       p.speed, p.course
+FROM t, pg_ais_track_points(t.track) AS p;
+
+-- Simplification drops points on the predicted course but keeps both ends of a gap
+WITH v(sentence, ts) AS (
+  VALUES ('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08'::ais, '2024-06-01 00:00:00+00'::timestamptz),
+         ('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08', '2024-06-01 00:00:10+00'),
+         ('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08', '2024-06-01 00:00:20+00'),
+         ('!AIVDM,1,1,,A,15MMV8U000p3MAh8uu2t69b`01A5,0*08', '2024-06-01 01:00:00+00')
+)
+SELECT extract(epoch FROM p.ts)::bigint - 1717200000 AS seconds
+FROM (SELECT pg_ais_track_simplify_agg(sentence, ts, 50, '10 minutes' ORDER BY ts) AS track FROM v) t,
+     pg_ais_track_points(t.track) AS p;
+
+-- Kinematics over a sliding window: one nautical mile north at 10 knots, then a jump east at 479
+WITH v(sentence, ts) AS (
+  VALUES ('!AIVDM,1,1,,A,15Muq60P1TGAQl0E:vh00?wp0000,0*0A'::ais, '2024-06-01 00:00:00+00'::timestamptz),
+         ('!AIVDM,1,1,,A,15Muq60P1TGAQl0E;Ul00?wp0000,0*2C', '2024-06-01 00:06:00+00'),
+         ('!AIVDM,1,1,,A,15Muq60P1TGF6j0E;Ul3Q?wp0000,0*28', '2024-06-01 00:12:00+00')
+)
+SELECT extract(epoch FROM ts)::bigint - 1717200000 AS seconds, (k).fixes, round((k).distance::numeric, 1) AS distance,
+       round((k).avg_speed::numeric, 1) AS avg_speed, round((k).max_turn_rate::numeric, 1) AS max_turn_rate,
+       round((k).max_implied_speed::numeric, 1) AS max_implied_speed
+FROM (SELECT ts, pg_ais_kinematics(sentence, ts) OVER (ORDER BY ts ROWS BETWEEN 1 PRECEDING AND CURRENT ROW) AS k
+      FROM v) w
+ORDER BY ts;
+WITH v(sentence, ts) AS (
+  VALUES ('!AIVDM,1,1,,A,15Muq60P1TGAQl0E:vh00?wp0000,0*0A'::ais, '2024-06-01 00:00:00+00'::timestamptz),
+         ('!AIVDM,1,1,,A,15Muq60P1TGAQl0E;Ul00?wp0000,0*2C', '2024-06-01 00:06:00+00'),
+         ('!AIVDM,1,1,,A,15Muq60P1TGF6j0E;Ul3Q?wp0000,0*28', '2024-06-01 00:12:00+00')
+)
+SELECT (k).fixes, round((k).distance::numeric, 1) AS distance, round((k).avg_speed::numeric, 1) AS avg_speed,
+       round((k).max_turn_rate::numeric, 1) AS max_turn_rate, round((k).max_implied_speed::numeric, 1) AS max_implied_speed
+FROM (SELECT pg_ais_kinematics(sentence, ts ORDER BY ts) AS k FROM v) a;
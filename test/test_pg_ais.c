@@ -5,6 +5,7 @@
 #include <cmocka.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 
 #include "utils/geo_decls.h"
 #include "utils/builtins.h"
@@ -12,6 +13,16 @@
 #include "../src/parse_ais.h"
 #include "../src/parse_ais_msg.h"
 #include "../src/bitfield.h"
+#include "../src/ais_payload.h"
+#include "../src/ais_hash.h"
+#include "../src/ais_stream.h"
+#include "../src/ais_reader.h"
+#include "../src/ais_track.h"
+#include "../src/ais_histogram.h"
+
+#ifdef AIS_WITH_ZLIB
+#include <zlib.h>
+#endif
 
 #define MAX_LINE 1024
 
@@ -171,6 +182,447 @@ static void test_individual_message_types(void **state) {
     }
 }
 
+/**
+ * @brief Test zero-copy payload view, fixed-point position and curve keys
+ *
+ * The view must read the same MMSI as the full decoder, and the Morton key
+ * must grow monotonically along each axis so BRIN box bounds stay valid.
+ */
+static void test_payload_view_position(void **state) {
+    (void)state;
+    const char *sentence = "!AIVDM,1,1,,A,15Muq60001G?tTpE>Gbk0?wN0<0,0*4B";
+    AISPayloadView view;
+    uint32_t mmsi;
+    int32_t lon, lat;
+
+    assert_true(ais_payload_view(sentence, strlen(sentence), &view));
+    assert_int_equal(ais_view_type(&view), 1);
+    assert_true(ais_view_uint(&view, 8, 30, &mmsi));
+    assert_int_equal(mmsi, 366967064);
+    assert_true(ais_view_position(&view, &lon, &lat));
+    assert_in_range(lon, -122.35 * AIS_COORD_SCALE, -122.34 * AIS_COORD_SCALE);
+
+    uint64_t k = ais_morton_key(ais_quantize_lon(lon), ais_quantize_lat(lat));
+    assert_true(ais_morton_key(ais_quantize_lon(lon + 600), ais_quantize_lat(lat)) > k);
+    assert_true(ais_morton_key(ais_quantize_lon(lon), ais_quantize_lat(lat + 600)) > k);
+    assert_true(ais_morton_key(ais_quantize_lon(AIS_LON_LIMIT), ais_quantize_lat(AIS_LAT_LIMIT)) <= (uint64_t)INT64_MAX);
+
+    // Non-position types and truncated sentences yield no position
+    assert_false(ais_payload_view("!AIVDM,1,1", 10, &view));
+}
+
+/**
+ * @brief Test geohash encoding and grid cell hierarchy on fixed-point input
+ */
+static void test_geohash_grid(void **state) {
+    (void)state;
+    char hash[AIS_GEOHASH_MAX + 1];
+
+    // Reference value: 42.6 N, 5.6 W
+    ais_geohash(-56 * AIS_COORD_SCALE / 10, 426 * AIS_COORD_SCALE / 10, 5, hash);
+    assert_string_equal(hash, "ezs42");
+    ais_geohash(AIS_LON_LIMIT, AIS_LAT_LIMIT, AIS_GEOHASH_MAX, hash);
+    assert_string_equal(hash, "zzzzzzzzzzzz");
+
+    uint32_t qx = ais_quantize_lon(-73407332), qy = ais_quantize_lat(22255531);
+    uint64_t cell = ais_grid_cell(qx, qy, 16);
+    assert_int_equal(cell >> AIS_GRID_LEVEL_SHIFT, 16);
+    assert_true(ais_grid_parent(cell, 8) == ais_grid_cell(qx, qy, 8));
+    assert_true(ais_grid_parent(cell, 0) == 0);
+    assert_true(ais_grid_cell(qx, qy, AIS_GRID_MAX_LEVEL) <= (uint64_t)INT64_MAX);
+}
+
+/**
+ * @brief Test that track points round-trip through delta varint encoding
+ *
+ * Typical 10 s steps must take a handful of bytes; negative time steps and
+ * unavailable (-1) speed and course must survive.
+ */
+static void test_track_codec(void **state) {
+    (void)state;
+    const AISTrackPoint points[] = {
+        {768800000000, -73407332, 22255531, 1, 768},
+        {768800010000, -73407062, 22255801, 102, 770},
+        {768800005000, -73407062, 22255801, -1, -1},
+        {768800020000, AIS_LON_LIMIT, -AIS_LAT_LIMIT, 1022, 3599},
+    };
+    uint8_t buf[4 * AIS_TRACK_POINT_MAX];
+    AISTrackPoint prev = {0}, decoded = {0};
+    size_t len = 0, step = 0;
+
+    for (size_t i = 0; i < 4; i++) {
+        size_t n = ais_track_encode_point(&prev, &points[i], buf + len);
+        assert_true(n <= AIS_TRACK_POINT_MAX);
+        if (i == 1) step = n;
+        len += n;
+        prev = points[i];
+    }
+    assert_true(step <= 10);
+
+    const uint8_t *pos = buf;
+    for (size_t i = 0; i < 4; i++) {
+        assert_true(ais_track_decode_point(&pos, buf + len, &decoded));
+        assert_memory_equal(&decoded, &points[i], sizeof(decoded));
+    }
+    assert_ptr_equal(pos, buf + len);
+
+    // Truncated data
+    pos = buf;
+    decoded = (AISTrackPoint){0};
+    assert_false(ais_track_decode_point(&pos, buf + 2, &decoded));
+}
+
+/**
+ * @brief Test the dead-reckoning deviation used by track simplification
+ */
+static void test_track_deviates(void **state) {
+    (void)state;
+    // 10 knots due east for 60 s on the equator: about 308.7 m, 1667 units
+    AISTrackPoint anchor = {0, 0, 0, 100, 900};
+    AISTrackPoint on_course = {60000, 1667, 0, 100, 900};
+    AISTrackPoint off_course = {60000, 1667, 270, 100, 900};
+
+    assert_false(ais_track_deviates(&anchor, &on_course, 5.0));
+    assert_true(ais_track_deviates(&anchor, &off_course, 40.0));
+    assert_false(ais_track_deviates(&anchor, &off_course, 60.0));
+
+    // Without speed the anchor stays put
+    anchor.speed = -1;
+    assert_true(ais_track_deviates(&anchor, &on_course, 300.0));
+    assert_false(ais_track_deviates(&anchor, &on_course, 320.0));
+}
+
+/**
+ * @brief Test haversine distances and course changes between track points
+ */
+static void test_track_distance_turn(void **state) {
+    (void)state;
+    // One minute of latitude is about one nautical mile on the mean sphere
+    AISTrackPoint a = {0, 0, 0, 100, 3550};
+    AISTrackPoint b = {60000, 0, 10000, 100, 50};
+    AISTrackPoint east = {0, 180 * 600000, 0, -1, -1};
+    AISTrackPoint west = {0, -180 * 600000 + 10000, 0, -1, -1};
+
+    assert_true(fabs(ais_track_distance(&a, &b) - 1853.25) < 0.01);
+    assert_true(ais_track_distance(&a, &a) == 0.0);
+    // Across the antimeridian
+    assert_true(fabs(ais_track_distance(&east, &west) - 1853.25) < 0.01);
+
+    // 355 to 5 degrees is a 10 degree turn, not 350
+    assert_int_equal(ais_track_turn(&a, &b), 100);
+    assert_int_equal(ais_track_turn(&b, &a), 100);
+    assert_int_equal(ais_track_turn(&a, &east), -1);
+}
+
+/**
+ * @brief Test log-linear histogram buckets and quantile estimates
+ */
+static void test_histogram(void **state) {
+    (void)state;
+    uint64_t counts[AIS_HISTOGRAM_BUCKETS] = {0};
+
+    // Exact below 16, then eight buckets per power of two
+    assert_int_equal(ais_histogram_bucket(7), 7);
+    assert_int_equal(ais_histogram_bucket(15), 15);
+    assert_int_equal(ais_histogram_bucket(16), 16);
+    assert_int_equal(ais_histogram_bucket(17), 16);
+    assert_int_equal(ais_histogram_bucket(UINT64_MAX), AIS_HISTOGRAM_BUCKETS - 1);
+    for (uint64_t v = 1; v < (1ULL << 32); v = v * 3 + 1) {
+        int b = ais_histogram_bucket(v);
+        assert_true(ais_histogram_lower(b) <= v && v < ais_histogram_upper(b));
+        assert_true(ais_histogram_upper(b) - ais_histogram_lower(b) <= ais_histogram_lower(b) / 8 + 1);
+    }
+
+    assert_true(ais_histogram_quantile(counts, 0.5) == 0.0);
+    // 90 fast values and 10 slow ones
+    counts[ais_histogram_bucket(1000)] = 90;
+    counts[ais_histogram_bucket(100000)] = 10;
+    int fast = ais_histogram_bucket(1000), slow = ais_histogram_bucket(100000);
+    assert_true(ais_histogram_quantile(counts, 0.5) == (ais_histogram_lower(fast) + ais_histogram_upper(fast)) / 2.0);
+    assert_true(ais_histogram_quantile(counts, 0.9) == (ais_histogram_lower(fast) + ais_histogram_upper(fast)) / 2.0);
+    assert_true(ais_histogram_quantile(counts, 0.91) == (ais_histogram_lower(slow) + ais_histogram_upper(slow)) / 2.0);
+}
+
+/**
+ * @brief Test the 64-bit payload hash against XXH64 reference values
+ */
+static void test_hash64(void **state) {
+    (void)state;
+    assert_true(ais_hash64("", 0, 0) == 0xef46db3751d8e999ULL);
+    assert_true(ais_hash64("abc", 3, 0) == 0x44bc2cf5ad770999ULL);
+    const char *long_input = "Nobody inspects the spammish repetition";
+    assert_true(ais_hash64(long_input, strlen(long_input), 0) == 0xfbcea83c8a378bf1ULL);
+    assert_true(ais_hash64("abc", 3, 1) != ais_hash64("abc", 3, 0));
+}
+
+/**
+ * @brief Test that canonical bit packing ignores fragment boundaries
+ *
+ * A two-part type 5 and the same payload sent as one sentence on another
+ * channel must pack to identical bits, which is what the fingerprint hashes.
+ */
+static void test_pack_bits_canonical(void **state) {
+    (void)state;
+    const char *part1 = "!AIVDM,2,1,3,A,55?MbV02;H;s<HtKR20EHE:0@T4@Dn2222222216L961O5Gf0NSQEp6ClRp8,0*1C";
+    const char *part2 = "!AIVDM,2,2,3,A,88888888880,2*25";
+    const char *whole = "!AIVDM,1,1,,B,55?MbV02;H;s<HtKR20EHE:0@T4@Dn2222222216L961O5Gf0NSQEp6ClRp888888888880,2*00";
+    AISPayloadView parts[2], single;
+    uint8_t a[128], b[128];
+
+    assert_true(ais_payload_view(part1, strlen(part1), &parts[0]));
+    assert_true(ais_payload_view(part2, strlen(part2), &parts[1]));
+    assert_true(ais_payload_view(whole, strlen(whole), &single));
+
+    int na = ais_view_pack_bits(parts, 2, a, sizeof(a));
+    int nb = ais_view_pack_bits(&single, 1, b, sizeof(b));
+    assert_int_equal(na, 424);
+    assert_int_equal(na, nb);
+    assert_memory_equal(a, b, (na + 7) / 8);
+
+    // Output buffer too small
+    assert_int_equal(ais_view_pack_bits(&single, 1, b, 4), -1);
+}
+
+static void test_stream_reassembly(void **state) {
+    (void)state;
+    static AISStream stream;
+    AISStreamMessage msg;
+    const char *single = "1718000000 !AIVDM,1,1,,A,15Muq60001G?tTpE>Gbk0?wN0<0,0*4B\r";
+    const char *corrupt = "!AIVDM,1,1,,A,15Muq60001G?tTpE>Gbk0?wN0<0,0*4C";
+    const char *part1 = "!AIVDM,2,1,3,B,55P5TL01VIaAL@7WKO@mBplU@<PDhh000000001S;AJ::4A80?4i@E53,0*3E";
+    const char *part2 = "!AIVDM,2,2,3,B,1@0000000000000,2*55";
+
+    ais_stream_init(&stream);
+    assert_int_equal(ais_stream_push(&stream, single, strlen(single), &msg), AIS_STREAM_MESSAGE);
+    assert_string_equal(msg.payload, "15Muq60001G?tTpE>Gbk0?wN0<0");
+    assert_non_null(msg.sentence);
+    assert_int_equal(ais_stream_push(&stream, corrupt, strlen(corrupt), &msg), AIS_STREAM_BAD_CHECKSUM);
+    assert_int_equal(ais_stream_push(&stream, "", 0, &msg), AIS_STREAM_SKIPPED);
+
+    // Fragments out of order
+    assert_int_equal(ais_stream_push(&stream, part2, strlen(part2), &msg), AIS_STREAM_PENDING);
+    assert_int_equal(ais_stream_push(&stream, part1, strlen(part1), &msg), AIS_STREAM_MESSAGE);
+    assert_int_equal(msg.nparts, 2);
+    assert_int_equal(msg.fill_bits, 2);
+    assert_int_equal(msg.len, 71);
+    assert_null(msg.sentence);
+
+    assert_int_equal(stream.messages, 2);
+    assert_int_equal(stream.reassembled, 1);
+    assert_int_equal(stream.bad_checksum, 1);
+}
+
+static void test_tag_block(void **state) {
+    (void)state;
+    static AISStream stream;
+    AISStreamMessage msg;
+    AISTagBlock tags;
+    size_t consumed;
+    const char *tagged = "\\s:station42,c:1718000000,n:17*31\\!AIVDM,1,1,,A,15Muq60001G?tTpE>Gbk0?wN0<0,0*4B";
+    const char *bad_tag = "\\s:station42,c:1718000000*4E\\!AIVDM,1,1,,A,15Muq60001G?tTpE>Gbk0?wN0<0,0*4B";
+    const char *part1 = "\\g:1-2-73,s:station42,c:1718000001*38\\!AIVDM,2,1,3,B,55P5TL01VIaAL@7WKO@mBplU@<PDhh000000001S;AJ::4A80?4i@E53,0*3E";
+    const char *other = "\\s:r2,c:1718000005*76\\!AIVDM,2,2,3,B,1@0000000000000,2*55";
+    const char *part2 = "!AIVDM,2,2,3,B,1@0000000000000,2*55";
+
+    assert_true(ais_tag_block_view(tagged, strlen(tagged), &tags, &consumed));
+    assert_int_equal(consumed, 34);
+    assert_int_equal(tags.station_len, 9);
+    assert_memory_equal(tags.station, "station42", 9);
+    assert_int_equal(tags.receive_time, 1718000000);
+    assert_int_equal(tags.line_count, 17);
+    assert_false(ais_tag_block_view(bad_tag, strlen(bad_tag), &tags, &consumed));
+
+    AISPayloadView view;
+    assert_true(ais_payload_view(tagged, strlen(tagged), &view));
+    assert_int_equal(view.len, 27);
+    assert_int_equal(view.tags.receive_time, 1718000000);
+
+    ais_stream_init(&stream);
+    assert_int_equal(ais_stream_push(&stream, tagged, strlen(tagged), &msg), AIS_STREAM_MESSAGE);
+    assert_int_equal(msg.tags.line_count, 17);
+    assert_ptr_equal(msg.sentence, tagged);
+    assert_int_equal(ais_stream_push(&stream, bad_tag, strlen(bad_tag), &msg), AIS_STREAM_BAD_CHECKSUM);
+
+    // Same sequence id from another station must not complete the message
+    assert_int_equal(ais_stream_push(&stream, part1, strlen(part1), &msg), AIS_STREAM_PENDING);
+    assert_int_equal(ais_stream_push(&stream, other, strlen(other), &msg), AIS_STREAM_PENDING);
+    assert_int_equal(ais_stream_push(&stream, part2, strlen(part2), &msg), AIS_STREAM_MESSAGE);
+    assert_int_equal(msg.len, 71);
+    assert_memory_equal(msg.tags.station, "station42", 9);
+    assert_int_equal(msg.tags.receive_time, 1718000001);
+    assert_int_equal(ais_stream_pending(&stream), 1);
+
+    // Routing sees tagged and prefixed fragments like bare ones
+    const char *prefixed = "1718000001 \\s:station42,c:1718000001*4E\\!AIVDM,2,2,3,B,1@0000000000000,2*55";
+    AISPayloadView bare;
+    assert_true(ais_stream_sentence_view(part1, strlen(part1), &view));
+    assert_true(ais_stream_sentence_view(part2, strlen(part2), &bare));
+    assert_int_equal(view.total, 2);
+    assert_int_equal(view.channel, bare.channel);
+    assert_int_equal(view.message_id_len, bare.message_id_len);
+    assert_memory_equal(view.message_id, bare.message_id, bare.message_id_len);
+    assert_memory_equal(view.tags.station, "station42", 9);
+    assert_true(ais_stream_sentence_view(prefixed, strlen(prefixed), &view));
+    assert_int_equal(view.seq, 2);
+    assert_int_equal(view.channel, 'B');
+    assert_memory_equal(view.message_id, "3", 1);
+    assert_int_equal(view.tags.receive_time, 1718000001);
+    assert_false(ais_stream_sentence_view("1718000001 no sentence", 22, &view));
+}
+
+/**
+ * @brief Read a whole file through an AISReader into buf
+ */
+static size_t read_all(const char *path, uint64_t offset, uint64_t limit, char *buf, size_t cap) {
+    char err[256];
+    AISReader *reader = ais_reader_open(path, offset, limit, err, sizeof(err));
+    size_t total = 0, n;
+
+    assert_non_null(reader);
+    while ((n = ais_reader_read(reader, buf + total, cap - total > 1000 ? 1000 : cap - total)) > 0)
+        total += n;
+    assert_null(ais_reader_error(reader));
+    ais_reader_close(reader);
+    return total;
+}
+
+static void test_reader(void **state) {
+    (void)state;
+    const char *line = "!AIVDM,1,1,,A,15Muq60001G?tTpE>Gbk0?wN0<0,0*4B\n";
+    size_t line_len = strlen(line);
+    static char buf[AIS_READER_BLOCK_SIZE * 3];
+    char path[] = "/tmp/pg_ais_reader_XXXXXX";
+    int lines = (AIS_READER_BLOCK_SIZE * 2) / (int)line_len;
+    int fd = mkstemp(path);
+    AISReaderFormat format;
+
+    // Plain file spanning several blocks, then a byte range of it
+    assert_true(fd >= 0);
+    FILE *fp = fdopen(fd, "w");
+    for (int i = 0; i < lines; i++) fputs(line, fp);
+    fclose(fp);
+
+    assert_true(ais_reader_detect(path, &format));
+    assert_int_equal(format, AIS_FORMAT_PLAIN);
+    assert_int_equal(read_all(path, 0, 0, buf, sizeof(buf)), lines * line_len);
+    assert_memory_equal(buf + (lines - 1) * line_len, line, line_len);
+    assert_int_equal(read_all(path, line_len, line_len, buf, sizeof(buf)), line_len);
+    assert_memory_equal(buf, line, line_len);
+
+#ifdef AIS_WITH_ZLIB
+    // Two concatenated gzip members read back as one stream
+    for (int member = 0; member < 2; member++) {
+        gzFile gz = gzopen(path, member == 0 ? "wb" : "ab");
+        for (int i = 0; i < 1000; i++) gzputs(gz, line);
+        gzclose(gz);
+    }
+    assert_true(ais_reader_detect(path, &format));
+    assert_int_equal(format, AIS_FORMAT_GZIP);
+    assert_int_equal(read_all(path, 0, 0, buf, sizeof(buf)), 2000 * line_len);
+    assert_memory_equal(buf + 1999 * line_len, line, line_len);
+#endif
+
+    remove(path);
+}
+
+/**
+ * @brief Set len bits of a one-bit-per-byte buffer, most significant first
+ */
+static void put_bits(uint8_t *bits, int start, int len, uint32_t value) {
+    for (int i = 0; i < len; i++) bits[start + i] = (value >> (len - 1 - i)) & 1;
+}
+
+/**
+ * @brief Encode text as 6-bit characters, padding with '@'
+ */
+static void put_text(uint8_t *bits, int start, int len, const char *text) {
+    for (int i = 0; i < len / 6; i++) {
+        int c = i < (int)strlen(text) ? text[i] : '@';
+        put_bits(bits, start + i * 6, 6, c >= 64 ? c - 64 : c);
+    }
+}
+
+/**
+ * @brief Armor a bit buffer into an NMEA payload string
+ */
+static void armor_bits(const uint8_t *bits, int nbits, char *out) {
+    int n = (nbits + 5) / 6;
+    for (int i = 0; i < n; i++) {
+        uint32_t v = 0;
+        for (int b = 0; b < 6; b++) v = (v << 1) | (i * 6 + b < nbits ? bits[i * 6 + b] : 0);
+        out[i] = (char)(v < 40 ? v + 48 : v + 56);
+    }
+    out[n] = '\0';
+}
+
+/**
+ * @brief Test that type 5 and both type 24 parts record their static fields
+ *
+ * Part A carries only the name and part B only the callsign, ship type and
+ * dimensions; a full type 5 carries everything including the destination.
+ */
+static void test_static_data(void **state) {
+    (void)state;
+    uint8_t bits[432];
+    char payload[80];
+    AISMessage msg;
+
+    memset(bits, 0, sizeof(bits));
+    put_bits(bits, 0, 6, 24);
+    put_bits(bits, 8, 30, 366053213);
+    put_bits(bits, 38, 2, 0);
+    put_text(bits, 40, 120, "OCEAN STAR");
+    armor_bits(bits, 168, payload);
+    memset(&msg, 0, sizeof(msg));
+    assert_true(parse_ais_payload(&msg, payload, 0).ok);
+    assert_int_equal(msg.static_fields, AIS_STATIC_NAME);
+    assert_int_equal(msg.mmsi, 366053213);
+    assert_string_equal(msg.vessel_name, "OCEAN STAR");
+    free_ais_message(&msg);
+
+    memset(bits, 0, sizeof(bits));
+    put_bits(bits, 0, 6, 24);
+    put_bits(bits, 8, 30, 366053213);
+    put_bits(bits, 38, 2, 1);
+    put_bits(bits, 40, 8, 37);
+    put_text(bits, 90, 42, "WDC1234");
+    put_bits(bits, 132, 9, 12);
+    armor_bits(bits, 168, payload);
+    memset(&msg, 0, sizeof(msg));
+    assert_true(parse_ais_payload(&msg, payload, 0).ok);
+    assert_int_equal(msg.static_fields, AIS_STATIC_CALLSIGN | AIS_STATIC_SHIP_TYPE | AIS_STATIC_DIMENSIONS);
+    assert_string_equal(msg.callsign, "WDC1234");
+    assert_int_equal(msg.ship_type, 37);
+    assert_int_equal(msg.dimension_to_bow, 12);
+    free_ais_message(&msg);
+
+    memset(bits, 0, sizeof(bits));
+    put_bits(bits, 0, 6, 5);
+    put_bits(bits, 8, 30, 477553000);
+    put_bits(bits, 40, 30, 9134270);
+    put_text(bits, 70, 42, "VRDN9");
+    put_text(bits, 112, 120, "ARUNA CIHAN");
+    put_bits(bits, 232, 8, 70);
+    put_bits(bits, 240, 9, 150);
+    put_text(bits, 302, 120, "NLRTM");
+    armor_bits(bits, 426, payload);
+    memset(&msg, 0, sizeof(msg));
+    assert_true(parse_ais_payload(&msg, payload, 2).ok);
+    assert_int_equal(msg.static_fields, AIS_STATIC_NAME | AIS_STATIC_CALLSIGN | AIS_STATIC_IMO |
+                                        AIS_STATIC_SHIP_TYPE | AIS_STATIC_DIMENSIONS | AIS_STATIC_DESTINATION);
+    assert_string_equal(msg.vessel_name, "ARUNA CIHAN");
+    assert_string_equal(msg.destination, "NLRTM");
+    assert_int_equal(msg.ship_type, 70);
+    assert_int_equal(msg.dimension_to_bow, 150);
+    free_ais_message(&msg);
+
+    // Position reports carry no static data
+    memset(&msg, 0, sizeof(msg));
+    assert_true(parse_ais_payload(&msg, "15MMV8U000p3MAh8uu2t69b`01A5", 0).ok);
+    assert_int_equal(msg.static_fields, 0);
+    free_ais_message(&msg);
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_parse_from_fixture),
@@ -180,6 +632,18 @@ int main(void) {
         cmocka_unit_test(test_parse_string_utf8),
         cmocka_unit_test(test_geo_helpers),
         cmocka_unit_test(test_individual_message_types),
+        cmocka_unit_test(test_payload_view_position),
+        cmocka_unit_test(test_geohash_grid),
+        cmocka_unit_test(test_track_codec),
+        cmocka_unit_test(test_track_deviates),
+        cmocka_unit_test(test_track_distance_turn),
+        cmocka_unit_test(test_histogram),
+        cmocka_unit_test(test_hash64),
+        cmocka_unit_test(test_pack_bits_canonical),
+        cmocka_unit_test(test_stream_reassembly),
+        cmocka_unit_test(test_tag_block),
+        cmocka_unit_test(test_reader),
+        cmocka_unit_test(test_static_data),
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }